@@ -1,4 +1,5 @@
 #include "CloneTreeCreator.hpp"
+#include "BulletInverseDynamics/IDMath.hpp"
 
 #include <cstdio>
 
@@ -49,7 +50,17 @@ int CloneTreeCreator::getBody(const int body_index, int* parent_index, JointType
 	TRY(m_reference->getBodyTParentRef(body_index, body_T_parent_ref));
 	TRY(m_reference->getBodyAxisOfMotion(body_index, body_axis_of_motion));
 	TRY(m_reference->getBodyMass(body_index, mass));
-	TRY(m_reference->getBodyFirstMassMoment(body_index, body_r_body_com));
+	// the tree stores mass * com, but addBody expects the com itself
+	vec3 first_mass_moment;
+	TRY(m_reference->getBodyFirstMassMoment(body_index, &first_mass_moment));
+	if (*mass > 0)
+	{
+		*body_r_body_com = first_mass_moment / *mass;
+	}
+	else
+	{
+		setZero(*body_r_body_com);
+	}
 	TRY(m_reference->getBodySecondMassMoment(body_index, body_I_body));
 	TRY(m_reference->getUserInt(body_index, user_int));
 	TRY(m_reference->getUserPtr(body_index, user_ptr));
@@ -0,0 +1,306 @@
+#include "MultiBodyTreeBatch.hpp"
+#include "CloneTreeCreator.hpp"
+
+namespace btInverseDynamics
+{
+MultiBodyTreeBatch::MultiBodyTreeBatch()
+	: m_reference(0x0), m_has_gravity(false)
+{
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); i++)
+	{
+		m_threadTrees[i] = 0x0;
+	}
+}
+
+MultiBodyTreeBatch::~MultiBodyTreeBatch()
+{
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); i++)
+	{
+		delete m_threadTrees[i];
+	}
+	delete m_reference;
+}
+
+int MultiBodyTreeBatch::initialize(const MultiBodyTreeCreator& creator)
+{
+	if (0x0 != m_reference)
+	{
+		bt_id_error_message("batch already initialized\n");
+		return -1;
+	}
+	m_reference = CreateMultiBodyTree(creator);
+	if (0x0 == m_reference)
+	{
+		bt_id_error_message("error creating reference tree\n");
+		return -1;
+	}
+	return 0;
+}
+
+int MultiBodyTreeBatch::numDoFs() const
+{
+	return m_reference ? m_reference->numDoFs() : 0;
+}
+
+int MultiBodyTreeBatch::numBodies() const
+{
+	return m_reference ? m_reference->numBodies() : 0;
+}
+
+int MultiBodyTreeBatch::setGravityInWorldFrame(const vec3& gravity)
+{
+	if (0x0 == m_reference)
+	{
+		return -1;
+	}
+	m_gravity = gravity;
+	m_has_gravity = true;
+	int result = 0;
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); i++)
+	{
+		if (m_threadTrees[i] && -1 == m_threadTrees[i]->setGravityInWorldFrame(m_gravity))
+		{
+			result = -1;
+		}
+	}
+	return result;
+}
+
+MultiBodyTree* MultiBodyTreeBatch::getThreadTree()
+{
+#if BT_THREADSAFE
+	const unsigned int thread_index = btGetCurrentThreadIndex();
+#else
+	const unsigned int thread_index = 0;
+#endif
+	if (0x0 == m_reference || thread_index >= BT_MAX_THREAD_COUNT)
+	{
+		return 0x0;
+	}
+	MultiBodyTree* tree = m_threadTrees[thread_index];
+	if (0x0 == tree)
+	{
+		// the reference tree is only read while cloning, but creation itself
+		// goes through the shared allocator, so keep it serialized
+		btMutexLock(&m_mutex);
+		CloneTreeCreator clone(m_reference);
+		tree = CreateMultiBodyTree(clone);
+		if (tree && m_has_gravity)
+		{
+			tree->setGravityInWorldFrame(m_gravity);
+		}
+		m_threadTrees[thread_index] = tree;
+		btMutexUnlock(&m_mutex);
+	}
+	return tree;
+}
+
+// evaluates one kind of quantity for a range of configurations,
+// failures are counted instead of aborting the other configurations
+struct MultiBodyTreeBatchLoop : public btIParallelForBody
+{
+	enum Mode
+	{
+		INVERSE_DYNAMICS,
+		MASS_MATRIX,
+		JACOBIANS
+	};
+
+	MultiBodyTreeBatch* m_batch;
+	Mode m_mode;
+	int m_num_dofs;
+	const idScalar* m_q;
+	const idScalar* m_u;
+	const idScalar* m_dot_u;
+	idScalar* m_out0;
+	idScalar* m_out1;
+	int m_body_index;
+	vec3 m_body_point;
+	mutable btSpinMutex m_mutex;
+	mutable int m_num_failed;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		MultiBodyTree* tree = m_batch->getThreadTree();
+		const int n = m_num_dofs;
+		int num_failed = 0;
+		if (0x0 == tree)
+		{
+			num_failed = iEnd - iBegin;
+		}
+		else
+		{
+			vecx q(n), u(n), dot_u(n), joint_forces(n);
+			for (int config = iBegin; config < iEnd; config++)
+			{
+				for (int i = 0; i < n; i++)
+				{
+					q(i) = m_q[config * n + i];
+				}
+				switch (m_mode)
+				{
+					case INVERSE_DYNAMICS:
+					{
+						for (int i = 0; i < n; i++)
+						{
+							u(i) = m_u[config * n + i];
+							dot_u(i) = m_dot_u[config * n + i];
+						}
+						if (-1 == tree->calculateInverseDynamics(q, u, dot_u, &joint_forces))
+						{
+							num_failed++;
+							break;
+						}
+						for (int i = 0; i < n; i++)
+						{
+							m_out0[config * n + i] = joint_forces(i);
+						}
+						break;
+					}
+					case MASS_MATRIX:
+					{
+						matxx mass_matrix(n, n);
+						if (-1 == tree->calculateMassMatrix(q, &mass_matrix))
+						{
+							num_failed++;
+							break;
+						}
+						idScalar* out = &m_out0[config * n * n];
+						for (int i = 0; i < n; i++)
+						{
+							for (int j = 0; j < n; j++)
+							{
+								out[i * n + j] = mass_matrix(i, j);
+							}
+						}
+						break;
+					}
+					case JACOBIANS:
+					{
+#if (defined BT_ID_HAVE_MAT3X) && (defined BT_ID_WITH_JACOBIANS)
+						mat3x jac_t(3, n), jac_r(3, n);
+						mat33 world_T_body;
+						// calculateJacobians relies on the body transforms of the last kinematics update
+						if (-1 == tree->calculatePositionKinematics(q) ||
+							-1 == tree->calculateJacobians(q) ||
+							-1 == tree->getBodyJacobianTrans(m_body_index, &jac_t) ||
+							-1 == tree->getBodyJacobianRot(m_body_index, &jac_r) ||
+							-1 == tree->getBodyTransform(m_body_index, &world_T_body))
+						{
+							num_failed++;
+							break;
+						}
+						// v_pt = J_t * u + (J_r * u) x pt, so J_t_pt = J_t - skew(pt) * J_r
+						const vec3 world_point = world_T_body * m_body_point;
+						idScalar* out_t = &m_out0[config * 3 * n];
+						idScalar* out_r = &m_out1[config * 3 * n];
+						for (int j = 0; j < n; j++)
+						{
+							const idScalar r0 = jac_r(0, j), r1 = jac_r(1, j), r2 = jac_r(2, j);
+							out_t[0 * n + j] = jac_t(0, j) - (world_point(1) * r2 - world_point(2) * r1);
+							out_t[1 * n + j] = jac_t(1, j) - (world_point(2) * r0 - world_point(0) * r2);
+							out_t[2 * n + j] = jac_t(2, j) - (world_point(0) * r1 - world_point(1) * r0);
+							out_r[0 * n + j] = r0;
+							out_r[1 * n + j] = r1;
+							out_r[2 * n + j] = r2;
+						}
+#else
+						num_failed++;
+#endif
+						break;
+					}
+				}
+			}
+		}
+		if (num_failed)
+		{
+			btMutexLock(&m_mutex);
+			m_num_failed += num_failed;
+			btMutexUnlock(&m_mutex);
+		}
+	}
+};
+
+static int runBatchLoop(MultiBodyTreeBatchLoop& loop, int num_configs)
+{
+	loop.m_num_failed = 0;
+	// a handful of configurations per task keeps the scheduling overhead low
+	// compared to a single evaluation
+	const int grain_size = 4;
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		btParallelFor(0, num_configs, grain_size, loop);
+	}
+	else
+	{
+		loop.forLoop(0, num_configs);
+	}
+#else
+	loop.forLoop(0, num_configs);
+#endif
+	return loop.m_num_failed ? -1 : 0;
+}
+
+int MultiBodyTreeBatch::calculateInverseDynamics(int num_configs, const idScalar* q, const idScalar* u,
+												 const idScalar* dot_u, idScalar* joint_forces)
+{
+	if (0x0 == m_reference || num_configs < 0)
+	{
+		return -1;
+	}
+	MultiBodyTreeBatchLoop loop;
+	loop.m_batch = this;
+	loop.m_mode = MultiBodyTreeBatchLoop::INVERSE_DYNAMICS;
+	loop.m_num_dofs = numDoFs();
+	loop.m_q = q;
+	loop.m_u = u;
+	loop.m_dot_u = dot_u;
+	loop.m_out0 = joint_forces;
+	loop.m_out1 = 0x0;
+	loop.m_body_index = 0;
+	return runBatchLoop(loop, num_configs);
+}
+
+int MultiBodyTreeBatch::calculateMassMatrices(int num_configs, const idScalar* q, idScalar* mass_matrices)
+{
+	if (0x0 == m_reference || num_configs < 0)
+	{
+		return -1;
+	}
+	MultiBodyTreeBatchLoop loop;
+	loop.m_batch = this;
+	loop.m_mode = MultiBodyTreeBatchLoop::MASS_MATRIX;
+	loop.m_num_dofs = numDoFs();
+	loop.m_q = q;
+	loop.m_u = 0x0;
+	loop.m_dot_u = 0x0;
+	loop.m_out0 = mass_matrices;
+	loop.m_out1 = 0x0;
+	loop.m_body_index = 0;
+	return runBatchLoop(loop, num_configs);
+}
+
+#if (defined BT_ID_HAVE_MAT3X) && (defined BT_ID_WITH_JACOBIANS)
+int MultiBodyTreeBatch::calculateJacobians(int num_configs, const idScalar* q, int body_index, const vec3& body_point,
+										   idScalar* jac_trans, idScalar* jac_rot)
+{
+	if (0x0 == m_reference || num_configs < 0 || body_index < 0 || body_index >= numBodies())
+	{
+		return -1;
+	}
+	MultiBodyTreeBatchLoop loop;
+	loop.m_batch = this;
+	loop.m_mode = MultiBodyTreeBatchLoop::JACOBIANS;
+	loop.m_num_dofs = numDoFs();
+	loop.m_q = q;
+	loop.m_u = 0x0;
+	loop.m_dot_u = 0x0;
+	loop.m_out0 = jac_trans;
+	loop.m_out1 = jac_rot;
+	loop.m_body_index = body_index;
+	loop.m_body_point = body_point;
+	return runBatchLoop(loop, num_configs);
+}
+#endif
+}  // namespace btInverseDynamics
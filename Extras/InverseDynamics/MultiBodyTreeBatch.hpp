@@ -0,0 +1,83 @@
+#ifndef MULTIBODYTREEBATCH_HPP_
+#define MULTIBODYTREEBATCH_HPP_
+
+#include "BulletInverseDynamics/IDConfig.hpp"
+#include "BulletInverseDynamics/MultiBodyTree.hpp"
+#include "LinearMath/btThreads.h"
+#include "MultiBodyTreeCreator.hpp"
+
+namespace btInverseDynamics
+{
+/// Evaluates inverse dynamics, Jacobians and mass matrices of one system
+/// for many configurations at once.
+/// A MultiBodyTree holds the kinematic state of the last evaluation, so the
+/// batch keeps a private copy of the tree per worker thread and distributes
+/// the configurations with btParallelFor, or evaluates them in order when
+/// there is no task scheduler.
+/// All arrays are flat and hold the configurations one after another;
+/// q, u and dot_u use the MultiBodyTree coordinates (numDoFs() entries each).
+class MultiBodyTreeBatch
+{
+public:
+	/// ctor
+	MultiBodyTreeBatch();
+	/// dtor
+	~MultiBodyTreeBatch();
+	/// create the reference tree
+	/// @param creator object describing the system
+	/// @return 0 on success, -1 on error
+	int initialize(const MultiBodyTreeCreator& creator);
+	/// @return true if initialize succeeded
+	bool isInitialized() const { return 0x0 != m_reference; }
+	/// @return number of degrees of freedom of the system
+	int numDoFs() const;
+	/// @return number of bodies of the system
+	int numBodies() const;
+	/// set gravity for all trees, @sa MultiBodyTree::setGravityInWorldFrame
+	/// @return 0 on success, -1 on error
+	int setGravityInWorldFrame(const vec3& gravity);
+	/// calculate generalized forces for every configuration
+	/// @param num_configs number of configurations
+	/// @param q generalized positions, num_configs x numDoFs()
+	/// @param u generalized velocities, num_configs x numDoFs()
+	/// @param dot_u generalized accelerations, num_configs x numDoFs()
+	/// @param joint_forces output, num_configs x numDoFs()
+	/// @return 0 on success, -1 if any configuration failed
+	int calculateInverseDynamics(int num_configs, const idScalar* q, const idScalar* u,
+								 const idScalar* dot_u, idScalar* joint_forces);
+	/// calculate the mass matrix for every configuration
+	/// @param num_configs number of configurations
+	/// @param q generalized positions, num_configs x numDoFs()
+	/// @param mass_matrices output, num_configs row-major numDoFs() x numDoFs() matrices
+	/// @return 0 on success, -1 if any configuration failed
+	int calculateMassMatrices(int num_configs, const idScalar* q, idScalar* mass_matrices);
+#if (defined BT_ID_HAVE_MAT3X) && (defined BT_ID_WITH_JACOBIANS)
+	/// calculate the world frame Jacobians of a point on a body for every configuration
+	/// @param num_configs number of configurations
+	/// @param q generalized positions, num_configs x numDoFs()
+	/// @param body_index index of the body
+	/// @param body_point point in body-fixed coordinates
+	/// @param jac_trans output, num_configs row-major 3 x numDoFs() matrices
+	/// @param jac_rot output, num_configs row-major 3 x numDoFs() matrices
+	/// @return 0 on success, -1 if any configuration failed
+	int calculateJacobians(int num_configs, const idScalar* q, int body_index, const vec3& body_point,
+						   idScalar* jac_trans, idScalar* jac_rot);
+#endif
+
+	/// get the tree used by the calling thread (created on demand)
+	MultiBodyTree* getThreadTree();
+
+private:
+	MultiBodyTreeBatch(const MultiBodyTreeBatch&);
+	MultiBodyTreeBatch& operator=(const MultiBodyTreeBatch&);
+
+	// never used for evaluation, only as the source of the per-thread copies
+	MultiBodyTree* m_reference;
+	MultiBodyTree* m_threadTrees[BT_MAX_THREAD_COUNT];
+	btSpinMutex m_mutex;
+	vec3 m_gravity;
+	bool m_has_gravity;
+};
+}  // namespace btInverseDynamics
+
+#endif  // MULTIBODYTREEBATCH_HPP_
@@ -92,11 +92,19 @@ btCompoundShape* btFractureBody::shiftTransform(btCompoundShape* boxCompound, bt
 #else
 #ifdef CHANGE_COMPOUND_INPLACE
 	newBoxCompound = boxCompound;
-	for (int i = 0; i < boxCompound->getNumChildShapes(); i++)
 	{
-		btTransform newChildTransform = principal.inverse() * boxCompound->getChildTransform(i);
-		///updateChildTransform is really slow, because it re-calculates the AABB each time. todo: add option to disable this update
-		boxCompound->updateChildTransform(i, newChildTransform);
+		///update all children in one batch, so the dynamic aabb tree and local AABB are only refitted once
+		btAlignedObjectArray<int> childIndices;
+		btAlignedObjectArray<btTransform> newChildTransforms;
+		childIndices.resize(boxCompound->getNumChildShapes());
+		newChildTransforms.resize(boxCompound->getNumChildShapes());
+		for (int i = 0; i < boxCompound->getNumChildShapes(); i++)
+		{
+			childIndices[i] = i;
+			newChildTransforms[i] = principal.inverse() * boxCompound->getChildTransform(i);
+		}
+		if (childIndices.size())
+			boxCompound->updateChildTransforms(childIndices.size(), &childIndices[0], &newChildTransforms[0]);
 	}
 	bool isDynamic = (mass != 0.f);
 	btVector3 localInertia(0, 0, 0);
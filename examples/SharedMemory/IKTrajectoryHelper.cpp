@@ -19,12 +19,37 @@ struct IKTrajectoryHelperInternalData
 
 	b3AlignedObjectArray<Node*> m_ikNodes;
 
+	//the Jacobian and its work space are kept between calls, they are only
+	//reallocated when the number of degrees of freedom or the task size changes
+	Jacobian* m_ikJacobian;
+	bool m_ikJacobianUsesAngularPart;
+	VectorRn m_deltaC;
+	MatrixRmn m_completeJacobian;
+
 	IKTrajectoryHelperInternalData()
+		: m_ikJacobian(0),
+		  m_ikJacobianUsesAngularPart(false)
 	{
 		m_endEffectorTargetPosition.SetZero();
 		m_nullSpaceVelocity.SetZero();
 		m_dampingCoeff.SetZero();
 	}
+
+	~IKTrajectoryHelperInternalData()
+	{
+		delete m_ikJacobian;
+	}
+
+	Jacobian& getJacobian(bool useAngularPart, int numQ)
+	{
+		if (m_ikJacobian == 0 || m_ikJacobianUsesAngularPart != useAngularPart || m_ikJacobian->GetNumCols() != numQ)
+		{
+			delete m_ikJacobian;
+			m_ikJacobian = new Jacobian(useAngularPart, numQ);
+			m_ikJacobianUsesAngularPart = useAngularPart;
+		}
+		return *m_ikJacobian;
+	}
 };
 
 IKTrajectoryHelper::IKTrajectoryHelper()
@@ -46,7 +71,7 @@ bool IKTrajectoryHelper::computeIK(const double endEffectorTargetPosition[3],
 {
 	bool useAngularPart = (ikMethod == IK2_VEL_DLS_WITH_ORIENTATION || ikMethod == IK2_VEL_DLS_WITH_ORIENTATION_NULLSPACE || ikMethod == IK2_VEL_SDLS_WITH_ORIENTATION) ? true : false;
 
-	Jacobian ikJacobian(useAngularPart, numQ);
+	Jacobian& ikJacobian = m_data->getJacobian(useAngularPart, numQ);
 
 	ikJacobian.Reset();
 
@@ -97,10 +122,12 @@ bool IKTrajectoryHelper::computeIK(const double endEffectorTargetPosition[3],
 	}
 
 	{
+		VectorRn& deltaC = m_data->m_deltaC;
+		MatrixRmn& completeJacobian = m_data->m_completeJacobian;
 		if (useAngularPart)
 		{
-			VectorRn deltaC(6);
-			MatrixRmn completeJacobian(6, numQ);
+			deltaC.SetLength(6);
+			completeJacobian.SetSize(6, numQ);
 			for (int i = 0; i < 3; ++i)
 			{
 				deltaC.Set(i, deltaS[i]);
@@ -116,8 +143,8 @@ bool IKTrajectoryHelper::computeIK(const double endEffectorTargetPosition[3],
 		}
 		else
 		{
-			VectorRn deltaC(3);
-			MatrixRmn completeJacobian(3, numQ);
+			deltaC.SetLength(3);
+			completeJacobian.SetSize(3, numQ);
 			for (int i = 0; i < 3; ++i)
 			{
 				deltaC.Set(i, deltaS[i]);
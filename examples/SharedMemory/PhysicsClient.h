@@ -73,6 +73,10 @@ public:
 
 	virtual void getCachedMassMatrix(int dofCountCheck, double* massMatrix) = 0;
 
+	virtual void getCachedDynamicsBatch(int numValuesCheck, double* values) = 0;
+
+	virtual void getCachedInverseKinematicsBatch(int numValuesCheck, double* values) = 0;
+
 	virtual void setTimeOut(double timeOutInSeconds) = 0;
 	virtual double getTimeOut() const = 0;
 
@@ -5,6 +5,7 @@
 #include "Bullet3Common/b3Matrix3x3.h"
 #include "Bullet3Common/b3Transform.h"
 #include "Bullet3Common/b3TransformUtil.h"
+#include "Bullet3Common/b3AlignedObjectArray.h"
 
 #include <string.h>
 #include "SharedMemoryCommands.h"
@@ -4548,6 +4549,148 @@ B3_SHARED_API int b3GetStatusMassMatrix(b3PhysicsClientHandle physClient, b3Shar
 	return true;
 }
 
+B3_SHARED_API b3SharedMemoryCommandHandle b3CalculateDynamicsBatchCommandInit(b3PhysicsClientHandle physClient, int bodyUniqueId, int numConfigurations,
+																			const double* jointPositionsQ, int dofCountQ,
+																			const double* jointVelocitiesQdot, const double* jointAccelerations, int dofCountQdot)
+{
+	PhysicsClient* cl = (PhysicsClient*)physClient;
+	b3Assert(cl);
+	b3Assert(cl->canSubmitCommand());
+	struct SharedMemoryCommand* command = cl->getAvailableSharedMemoryCommand();
+	b3Assert(command);
+
+	command->m_type = CMD_CALCULATE_DYNAMICS_BATCH;
+	command->m_updateFlags = 0;
+	command->m_calculateDynamicsBatchArguments.m_bodyUniqueId = bodyUniqueId;
+	command->m_calculateDynamicsBatchArguments.m_flags = 0;
+	command->m_calculateDynamicsBatchArguments.m_numConfigurations = numConfigurations;
+	command->m_calculateDynamicsBatchArguments.m_dofCountQ = dofCountQ;
+	command->m_calculateDynamicsBatchArguments.m_dofCountQdot = dofCountQdot;
+	command->m_calculateDynamicsBatchArguments.m_linkIndex = -1;
+	command->m_calculateDynamicsBatchArguments.m_localPosition[0] = 0;
+	command->m_calculateDynamicsBatchArguments.m_localPosition[1] = 0;
+	command->m_calculateDynamicsBatchArguments.m_localPosition[2] = 0;
+
+	//stream q, qdot and qdot-dot of all configurations to the server
+	int numQ = numConfigurations * dofCountQ;
+	int numQdot = numConfigurations * dofCountQdot;
+	b3AlignedObjectArray<double> streamData;
+	streamData.resize(numQ + 2 * numQdot);
+	for (int i = 0; i < numQ; i++)
+	{
+		streamData[i] = jointPositionsQ[i];
+	}
+	for (int i = 0; i < numQdot; i++)
+	{
+		streamData[numQ + i] = jointVelocitiesQdot ? jointVelocitiesQdot[i] : 0;
+		streamData[numQ + numQdot + i] = jointAccelerations ? jointAccelerations[i] : 0;
+	}
+	if (streamData.size())
+	{
+		cl->uploadBulletFileToSharedMemory((const char*)&streamData[0], streamData.size() * sizeof(double));
+	}
+
+	return (b3SharedMemoryCommandHandle)command;
+}
+
+B3_SHARED_API void b3CalculateDynamicsBatchRequestInverseDynamics(b3SharedMemoryCommandHandle commandHandle)
+{
+	struct SharedMemoryCommand* command = (struct SharedMemoryCommand*)commandHandle;
+	b3Assert(command);
+	b3Assert(command->m_type == CMD_CALCULATE_DYNAMICS_BATCH);
+	command->m_calculateDynamicsBatchArguments.m_flags |= DYNAMICS_BATCH_INVERSE_DYNAMICS;
+}
+
+B3_SHARED_API void b3CalculateDynamicsBatchRequestJacobians(b3SharedMemoryCommandHandle commandHandle, int linkIndex, const double localPosition[])
+{
+	struct SharedMemoryCommand* command = (struct SharedMemoryCommand*)commandHandle;
+	b3Assert(command);
+	b3Assert(command->m_type == CMD_CALCULATE_DYNAMICS_BATCH);
+	command->m_calculateDynamicsBatchArguments.m_flags |= DYNAMICS_BATCH_JACOBIANS;
+	command->m_calculateDynamicsBatchArguments.m_linkIndex = linkIndex;
+	command->m_calculateDynamicsBatchArguments.m_localPosition[0] = localPosition[0];
+	command->m_calculateDynamicsBatchArguments.m_localPosition[1] = localPosition[1];
+	command->m_calculateDynamicsBatchArguments.m_localPosition[2] = localPosition[2];
+}
+
+B3_SHARED_API void b3CalculateDynamicsBatchRequestMassMatrices(b3SharedMemoryCommandHandle commandHandle)
+{
+	struct SharedMemoryCommand* command = (struct SharedMemoryCommand*)commandHandle;
+	b3Assert(command);
+	b3Assert(command->m_type == CMD_CALCULATE_DYNAMICS_BATCH);
+	command->m_calculateDynamicsBatchArguments.m_flags |= DYNAMICS_BATCH_MASS_MATRICES;
+}
+
+B3_SHARED_API int b3GetStatusDynamicsBatch(b3PhysicsClientHandle physClient, b3SharedMemoryStatusHandle statusHandle, int* numConfigurations, int* dofCount,
+										   double* jointForces, double* linearJacobians, double* angularJacobians, double* massMatrices)
+{
+	PhysicsClient* cl = (PhysicsClient*)physClient;
+	b3Assert(cl);
+
+	const SharedMemoryStatus* status = (const SharedMemoryStatus*)statusHandle;
+	if (status == 0)
+		return false;
+
+	btAssert(status->m_type == CMD_CALCULATED_DYNAMICS_BATCH_COMPLETED);
+	if (status->m_type != CMD_CALCULATED_DYNAMICS_BATCH_COMPLETED)
+		return false;
+
+	const CalculateDynamicsBatchResultArgs& args = status->m_dynamicsBatchResultArgs;
+	if (numConfigurations)
+	{
+		*numConfigurations = args.m_numConfigurations;
+	}
+	if (dofCount)
+	{
+		*dofCount = args.m_dofCount;
+	}
+
+	b3AlignedObjectArray<double> values;
+	values.resize(args.m_numValues);
+	if (args.m_numValues)
+	{
+		cl->getCachedDynamicsBatch(args.m_numValues, &values[0]);
+	}
+
+	//the results are stored one block after another, in the order of b3DynamicsBatchFlags
+	int offset = 0;
+	if (args.m_flags & DYNAMICS_BATCH_INVERSE_DYNAMICS)
+	{
+		int sz = args.m_numConfigurations * args.m_dofCount;
+		for (int i = 0; jointForces && i < sz; i++)
+		{
+			jointForces[i] = values[offset + i];
+		}
+		offset += sz;
+	}
+	if (args.m_flags & DYNAMICS_BATCH_JACOBIANS)
+	{
+		int sz = args.m_numConfigurations * 3 * args.m_dofCount;
+		for (int i = 0; linearJacobians && i < sz; i++)
+		{
+			linearJacobians[i] = values[offset + i];
+		}
+		offset += sz;
+		for (int i = 0; angularJacobians && i < sz; i++)
+		{
+			angularJacobians[i] = values[offset + i];
+		}
+		offset += sz;
+	}
+	if (args.m_flags & DYNAMICS_BATCH_MASS_MATRICES)
+	{
+		int sz = args.m_numConfigurations * args.m_dofCount * args.m_dofCount;
+		for (int i = 0; massMatrices && i < sz; i++)
+		{
+			massMatrices[i] = values[offset + i];
+		}
+		offset += sz;
+	}
+	btAssert(offset == args.m_numValues);
+
+	return true;
+}
+
 B3_SHARED_API b3SharedMemoryCommandHandle b3CollisionFilterCommandInit(b3PhysicsClientHandle physClient)
 {
 	PhysicsClient* cl = (PhysicsClient*)physClient;
@@ -4773,6 +4916,156 @@ B3_SHARED_API int b3GetStatusInverseKinematicsJointPositions(b3SharedMemoryStatu
 	return 1;
 }
 
+B3_SHARED_API b3SharedMemoryCommandHandle b3CalculateInverseKinematicsBatchCommandInit(b3PhysicsClientHandle physClient, int bodyUniqueId, int endEffectorLinkIndex, int numTargets,
+																					 const double* targetPositions, const double* targetOrientations,
+																					 const double* seedPositions, int dofCount)
+{
+	PhysicsClient* cl = (PhysicsClient*)physClient;
+	b3Assert(cl);
+	b3Assert(cl->canSubmitCommand());
+	struct SharedMemoryCommand* command = cl->getAvailableSharedMemoryCommand();
+	b3Assert(command);
+
+	command->m_type = CMD_CALCULATE_INVERSE_KINEMATICS_BATCH;
+	command->m_updateFlags = IK_HAS_TARGET_POSITION;
+	command->m_calculateInverseKinematicsBatchArguments.m_bodyUniqueId = bodyUniqueId;
+	command->m_calculateInverseKinematicsBatchArguments.m_endEffectorLinkIndex = endEffectorLinkIndex;
+	command->m_calculateInverseKinematicsBatchArguments.m_numTargets = numTargets;
+	command->m_calculateInverseKinematicsBatchArguments.m_dofCount = dofCount;
+	command->m_calculateInverseKinematicsBatchArguments.m_maxNumIterations = 20;
+	command->m_calculateInverseKinematicsBatchArguments.m_residualThreshold = 1e-4;
+	if (targetOrientations)
+	{
+		command->m_updateFlags |= IK_HAS_TARGET_ORIENTATION;
+	}
+	if (seedPositions)
+	{
+		command->m_updateFlags |= IK_HAS_CURRENT_JOINT_POSITIONS;
+	}
+
+	//stream positions, orientations and seeds of all targets to the server
+	int numPositions = 3 * numTargets;
+	int numOrientations = targetOrientations ? 4 * numTargets : 0;
+	int numSeeds = seedPositions ? numTargets * dofCount : 0;
+	b3AlignedObjectArray<double> streamData;
+	streamData.resize(numPositions + numOrientations + numSeeds);
+	for (int i = 0; i < numPositions; i++)
+	{
+		streamData[i] = targetPositions[i];
+	}
+	for (int i = 0; i < numOrientations; i++)
+	{
+		streamData[numPositions + i] = targetOrientations[i];
+	}
+	for (int i = 0; i < numSeeds; i++)
+	{
+		streamData[numPositions + numOrientations + i] = seedPositions[i];
+	}
+	if (streamData.size())
+	{
+		cl->uploadBulletFileToSharedMemory((const char*)&streamData[0], streamData.size() * sizeof(double));
+	}
+
+	return (b3SharedMemoryCommandHandle)command;
+}
+
+B3_SHARED_API void b3CalculateInverseKinematicsBatchSetJointDamping(b3SharedMemoryCommandHandle commandHandle, int numDof, const double* jointDampingCoeff)
+{
+	struct SharedMemoryCommand* command = (struct SharedMemoryCommand*)commandHandle;
+	b3Assert(command);
+	b3Assert(command->m_type == CMD_CALCULATE_INVERSE_KINEMATICS_BATCH);
+	command->m_updateFlags |= IK_HAS_JOINT_DAMPING;
+
+	for (int i = 0; i < numDof && i < MAX_DEGREE_OF_FREEDOM; ++i)
+	{
+		command->m_calculateInverseKinematicsBatchArguments.m_jointDamping[i] = jointDampingCoeff[i];
+	}
+}
+
+B3_SHARED_API void b3CalculateInverseKinematicsBatchSelectSolver(b3SharedMemoryCommandHandle commandHandle, int solver)
+{
+	struct SharedMemoryCommand* command = (struct SharedMemoryCommand*)commandHandle;
+	b3Assert(command);
+	b3Assert(command->m_type == CMD_CALCULATE_INVERSE_KINEMATICS_BATCH);
+	command->m_updateFlags |= solver;
+}
+
+B3_SHARED_API void b3CalculateInverseKinematicsBatchSetMaxNumIterations(b3SharedMemoryCommandHandle commandHandle, int maxNumIterations)
+{
+	struct SharedMemoryCommand* command = (struct SharedMemoryCommand*)commandHandle;
+	b3Assert(command);
+	b3Assert(command->m_type == CMD_CALCULATE_INVERSE_KINEMATICS_BATCH);
+	command->m_updateFlags |= IK_HAS_MAX_ITERATIONS;
+	command->m_calculateInverseKinematicsBatchArguments.m_maxNumIterations = maxNumIterations;
+}
+
+B3_SHARED_API void b3CalculateInverseKinematicsBatchSetResidualThreshold(b3SharedMemoryCommandHandle commandHandle, double residualThreshold)
+{
+	struct SharedMemoryCommand* command = (struct SharedMemoryCommand*)commandHandle;
+	b3Assert(command);
+	b3Assert(command->m_type == CMD_CALCULATE_INVERSE_KINEMATICS_BATCH);
+	command->m_updateFlags |= IK_HAS_RESIDUAL_THRESHOLD;
+	command->m_calculateInverseKinematicsBatchArguments.m_residualThreshold = residualThreshold;
+}
+
+B3_SHARED_API int b3GetStatusInverseKinematicsBatch(b3PhysicsClientHandle physClient, b3SharedMemoryStatusHandle statusHandle, int* numTargets, int* dofCount,
+													double* jointPositions, double* residuals, int* numIterations, int* converged)
+{
+	PhysicsClient* cl = (PhysicsClient*)physClient;
+	b3Assert(cl);
+
+	const SharedMemoryStatus* status = (const SharedMemoryStatus*)statusHandle;
+	if (status == 0)
+		return false;
+
+	btAssert(status->m_type == CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_COMPLETED);
+	if (status->m_type != CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_COMPLETED)
+		return false;
+
+	const CalculateInverseKinematicsBatchResultArgs& args = status->m_inverseKinematicsBatchResultArgs;
+	if (numTargets)
+	{
+		*numTargets = args.m_numTargets;
+	}
+	if (dofCount)
+	{
+		*dofCount = args.m_dofCount;
+	}
+
+	b3AlignedObjectArray<double> values;
+	values.resize(args.m_numValues);
+	if (args.m_numValues)
+	{
+		cl->getCachedInverseKinematicsBatch(args.m_numValues, &values[0]);
+	}
+
+	//joint positions of all targets, then residuals, then iteration counts
+	int numPositions = args.m_numTargets * args.m_dofCount;
+	btAssert(numPositions + 2 * args.m_numTargets == args.m_numValues);
+	for (int i = 0; jointPositions && i < numPositions; i++)
+	{
+		jointPositions[i] = values[i];
+	}
+	for (int i = 0; i < args.m_numTargets; i++)
+	{
+		double residual = values[numPositions + i];
+		if (residuals)
+		{
+			residuals[i] = residual;
+		}
+		if (numIterations)
+		{
+			numIterations[i] = int(values[numPositions + args.m_numTargets + i]);
+		}
+		if (converged)
+		{
+			converged[i] = residual <= args.m_residualThreshold ? 1 : 0;
+		}
+	}
+
+	return true;
+}
+
 B3_SHARED_API b3SharedMemoryCommandHandle b3RequestVREventsCommandInit(b3PhysicsClientHandle physClient)
 {
 	PhysicsClient* cl = (PhysicsClient*)physClient;
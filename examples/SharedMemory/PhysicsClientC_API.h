@@ -402,6 +402,23 @@ extern "C"
 	///the mass matrix is stored in column-major layout of size dofCount*dofCount
 	B3_SHARED_API int b3GetStatusMassMatrix(b3PhysicsClientHandle physClient, b3SharedMemoryStatusHandle statusHandle, int* dofCount, double* massMatrix);
 
+	///evaluate inverse dynamics, Jacobians and/or mass matrices of one body for many configurations in a single command.
+	///The configurations are stored one after another: numConfigurations*dofCountQ joint positions and
+	///numConfigurations*dofCountQdot joint velocities and accelerations (velocities and accelerations may be NULL for zero).
+	///For a floating base, q starts with the base position and quaternion and qdot with the base linear and angular velocity,
+	///as in b3CalculateInverseDynamicsCommandInit2. The configurations are evaluated in parallel on the server.
+	B3_SHARED_API b3SharedMemoryCommandHandle b3CalculateDynamicsBatchCommandInit(b3PhysicsClientHandle physClient, int bodyUniqueId, int numConfigurations,
+																				const double* jointPositionsQ, int dofCountQ,
+																				const double* jointVelocitiesQdot, const double* jointAccelerations, int dofCountQdot);
+	B3_SHARED_API void b3CalculateDynamicsBatchRequestInverseDynamics(b3SharedMemoryCommandHandle commandHandle);
+	///Jacobians of a point given in the link frame, use linkIndex -1 for the base
+	B3_SHARED_API void b3CalculateDynamicsBatchRequestJacobians(b3SharedMemoryCommandHandle commandHandle, int linkIndex, const double localPosition[/*3*/]);
+	B3_SHARED_API void b3CalculateDynamicsBatchRequestMassMatrices(b3SharedMemoryCommandHandle commandHandle);
+	///results are stored per configuration: dofCount joint forces, row-major 3*dofCount Jacobians, row-major dofCount*dofCount mass matrices.
+	///pass NULL for results that were not requested
+	B3_SHARED_API int b3GetStatusDynamicsBatch(b3PhysicsClientHandle physClient, b3SharedMemoryStatusHandle statusHandle, int* numConfigurations, int* dofCount,
+											   double* jointForces, double* linearJacobians, double* angularJacobians, double* massMatrices);
+
 	///compute the joint positions to move the end effector to a desired target using inverse kinematics
 	B3_SHARED_API b3SharedMemoryCommandHandle b3CalculateInverseKinematicsCommandInit(b3PhysicsClientHandle physClient, int bodyUniqueId);
 	B3_SHARED_API void b3CalculateInverseKinematicsAddTargetPurePosition(b3SharedMemoryCommandHandle commandHandle, int endEffectorLinkIndex, const double targetPosition[/*3*/]);
@@ -419,6 +436,22 @@ extern "C"
 	B3_SHARED_API void b3CalculateInverseKinematicsSetMaxNumIterations(b3SharedMemoryCommandHandle commandHandle, int maxNumIterations);
 	B3_SHARED_API void b3CalculateInverseKinematicsSetResidualThreshold(b3SharedMemoryCommandHandle commandHandle, double residualThreshold);
 
+	///solve inverse kinematics of one end effector for many targets in a single command.
+	///targetPositions holds numTargets world positions, targetOrientations numTargets world quaternions (x,y,z,w) or NULL for position-only targets.
+	///seedPositions holds numTargets*dofCount joint positions to start from, or NULL to start every target from the current joint positions.
+	///The targets are solved in parallel on the server, with damped least squares unless b3CalculateInverseKinematicsBatchSelectSolver picks IK_SDLS.
+	B3_SHARED_API b3SharedMemoryCommandHandle b3CalculateInverseKinematicsBatchCommandInit(b3PhysicsClientHandle physClient, int bodyUniqueId, int endEffectorLinkIndex, int numTargets,
+																						 const double* targetPositions, const double* targetOrientations,
+																						 const double* seedPositions, int dofCount);
+	B3_SHARED_API void b3CalculateInverseKinematicsBatchSetJointDamping(b3SharedMemoryCommandHandle commandHandle, int numDof, const double* jointDampingCoeff);
+	B3_SHARED_API void b3CalculateInverseKinematicsBatchSelectSolver(b3SharedMemoryCommandHandle commandHandle, int solver);
+	B3_SHARED_API void b3CalculateInverseKinematicsBatchSetMaxNumIterations(b3SharedMemoryCommandHandle commandHandle, int maxNumIterations);
+	B3_SHARED_API void b3CalculateInverseKinematicsBatchSetResidualThreshold(b3SharedMemoryCommandHandle commandHandle, double residualThreshold);
+	///results are stored per target: dofCount joint positions, the remaining distance to the target position,
+	///the number of iterations used and whether that distance is below the residual threshold. pass NULL for results that are not needed
+	B3_SHARED_API int b3GetStatusInverseKinematicsBatch(b3PhysicsClientHandle physClient, b3SharedMemoryStatusHandle statusHandle, int* numTargets, int* dofCount,
+														double* jointPositions, double* residuals, int* numIterations, int* converged);
+
 	B3_SHARED_API b3SharedMemoryCommandHandle b3CollisionFilterCommandInit(b3PhysicsClientHandle physClient);
 	B3_SHARED_API void b3SetCollisionFilterPair(b3SharedMemoryCommandHandle commandHandle, int bodyUniqueIdA,
 												int bodyUniqueIdB, int linkIndexA, int linkIndexB, int enableCollision);
@@ -57,6 +57,8 @@ struct PhysicsClientSharedMemoryInternalData
 	btAlignedObjectArray<b3KeyboardEvent> m_cachedKeyboardEvents;
 	btAlignedObjectArray<b3MouseEvent> m_cachedMouseEvents;
 	btAlignedObjectArray<double> m_cachedMassMatrix;
+	btAlignedObjectArray<double> m_cachedDynamicsBatch;
+	btAlignedObjectArray<double> m_cachedInverseKinematicsBatch;
 	btAlignedObjectArray<b3RayHitInfo> m_raycastHits;
 
 	btAlignedObjectArray<int> m_bodyIdsRequestInfo;
@@ -1329,6 +1331,36 @@ const SharedMemoryStatus* PhysicsClientSharedMemory::processServerStatus()
 				}
 				break;
 			}
+			case CMD_CALCULATED_DYNAMICS_BATCH_FAILED:
+			{
+				b3Warning("calculate dynamics batch failed");
+				break;
+			}
+			case CMD_CALCULATED_DYNAMICS_BATCH_COMPLETED:
+			{
+				double* batchData = (double*)&this->m_data->m_testBlock1->m_bulletStreamDataServerToClientRefactor[0];
+				m_data->m_cachedDynamicsBatch.resize(serverCmd.m_dynamicsBatchResultArgs.m_numValues);
+				for (int i = 0; i < serverCmd.m_dynamicsBatchResultArgs.m_numValues; i++)
+				{
+					m_data->m_cachedDynamicsBatch[i] = batchData[i];
+				}
+				break;
+			}
+			case CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_FAILED:
+			{
+				b3Warning("calculate inverse kinematics batch failed");
+				break;
+			}
+			case CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_COMPLETED:
+			{
+				double* ikData = (double*)&this->m_data->m_testBlock1->m_bulletStreamDataServerToClientRefactor[0];
+				m_data->m_cachedInverseKinematicsBatch.resize(serverCmd.m_inverseKinematicsBatchResultArgs.m_numValues);
+				for (int i = 0; i < serverCmd.m_inverseKinematicsBatchResultArgs.m_numValues; i++)
+				{
+					m_data->m_cachedInverseKinematicsBatch[i] = ikData[i];
+				}
+				break;
+			}
 			case CMD_REQUEST_PHYSICS_SIMULATION_PARAMETERS_COMPLETED:
 			{
 				break;
@@ -1862,6 +1894,28 @@ void PhysicsClientSharedMemory::getCachedMassMatrix(int dofCountCheck, double* m
 	}
 }
 
+void PhysicsClientSharedMemory::getCachedDynamicsBatch(int numValuesCheck, double* values)
+{
+	if (numValuesCheck == m_data->m_cachedDynamicsBatch.size())
+	{
+		for (int i = 0; i < numValuesCheck; i++)
+		{
+			values[i] = m_data->m_cachedDynamicsBatch[i];
+		}
+	}
+}
+
+void PhysicsClientSharedMemory::getCachedInverseKinematicsBatch(int numValuesCheck, double* values)
+{
+	if (numValuesCheck == m_data->m_cachedInverseKinematicsBatch.size())
+	{
+		for (int i = 0; i < numValuesCheck; i++)
+		{
+			values[i] = m_data->m_cachedInverseKinematicsBatch[i];
+		}
+	}
+}
+
 void PhysicsClientSharedMemory::getCachedVisualShapeInformation(struct b3VisualShapeInformation* visualShapesInfo)
 {
 	visualShapesInfo->m_numVisualShapes = m_data->m_cachedVisualShapes.size();
@@ -104,6 +104,10 @@ public:
 
 	virtual void getCachedMassMatrix(int dofCountCheck, double* massMatrix);
 
+	virtual void getCachedDynamicsBatch(int numValuesCheck, double* values);
+
+	virtual void getCachedInverseKinematicsBatch(int numValuesCheck, double* values);
+
 	//the following APIs are for internal use for visualization:
 	virtual bool connect(struct GUIHelperInterface* guiHelper);
 	virtual void renderScene();
@@ -218,6 +218,16 @@ void PhysicsLoopBack::getCachedMassMatrix(int dofCountCheck, double* massMatrix)
 	m_data->m_physicsClient->getCachedMassMatrix(dofCountCheck, massMatrix);
 }
 
+void PhysicsLoopBack::getCachedDynamicsBatch(int numValuesCheck, double* values)
+{
+	m_data->m_physicsClient->getCachedDynamicsBatch(numValuesCheck, values);
+}
+
+void PhysicsLoopBack::getCachedInverseKinematicsBatch(int numValuesCheck, double* values)
+{
+	m_data->m_physicsClient->getCachedInverseKinematicsBatch(numValuesCheck, values);
+}
+
 void PhysicsLoopBack::setTimeOut(double timeOutInSeconds)
 {
 	m_data->m_physicsClient->setTimeOut(timeOutInSeconds);
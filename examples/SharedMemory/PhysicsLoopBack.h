@@ -84,6 +84,10 @@ public:
 
 	virtual void getCachedMassMatrix(int dofCountCheck, double* massMatrix);
 
+	virtual void getCachedDynamicsBatch(int numValuesCheck, double* values);
+
+	virtual void getCachedInverseKinematicsBatch(int numValuesCheck, double* values);
+
 	virtual void setTimeOut(double timeOutInSeconds);
 	virtual double getTimeOut() const;
 
@@ -33,6 +33,7 @@
 #include "../Utils/ChromeTraceUtil.h"
 #include "stb_image/stb_image.h"
 #include "BulletInverseDynamics/MultiBodyTree.hpp"
+#include "../Extras/InverseDynamics/MultiBodyTreeBatch.hpp"
 #include "IKTrajectoryHelper.h"
 #include "btBulletDynamicsCommon.h"
 #include "../Utils/RobotLoggingUtil.h"
@@ -1607,7 +1608,10 @@ struct PhysicsServerCommandProcessorInternalData
 	btScalar m_numSimulationSubSteps;
 	btAlignedObjectArray<btMultiBodyJointFeedback*> m_multiBodyJointFeedbacks;
 	b3HashMap<btHashPtr, btInverseDynamics::MultiBodyTree*> m_inverseDynamicsBodies;
+	b3HashMap<btHashPtr, btInverseDynamics::MultiBodyTreeBatch*> m_inverseDynamicsBatches;
 	b3HashMap<btHashPtr, IKTrajectoryHelper*> m_inverseKinematicsHelpers;
+	//one helper per worker thread for CMD_CALCULATE_INVERSE_KINEMATICS_BATCH, shared by all bodies
+	IKTrajectoryHelper* m_inverseKinematicsThreadHelpers[BT_MAX_THREAD_COUNT];
 
 	int m_userConstraintUIDGenerator;
 	b3HashMap<btHashInt, InteralUserConstraintData> m_userConstraints;
@@ -1715,6 +1719,10 @@ struct PhysicsServerCommandProcessorInternalData
 		  m_threadPool(0),
 		  m_defaultCollisionMargin(0.001)
 	{
+		for (int i = 0; i < int(BT_MAX_THREAD_COUNT); i++)
+		{
+			m_inverseKinematicsThreadHelpers[i] = 0;
+		}
 		{
 			//register static plugins:
 #ifdef STATIC_LINK_VR_PLUGIN
@@ -1816,6 +1824,38 @@ struct PhysicsServerCommandProcessorInternalData
 
 		return tree;
 	}
+
+	btInverseDynamics::MultiBodyTreeBatch* findOrCreateTreeBatch(btMultiBody* multiBody)
+	{
+		btInverseDynamics::MultiBodyTreeBatch* batch = 0;
+
+		btInverseDynamics::MultiBodyTreeBatch** batchPtrPtr =
+			m_inverseDynamicsBatches.find(multiBody);
+
+		if (batchPtrPtr)
+		{
+			batch = *batchPtrPtr;
+		}
+		else
+		{
+			btInverseDynamics::btMultiBodyTreeCreator id_creator;
+			if (-1 != id_creator.createFromBtMultiBody(multiBody, false))
+			{
+				batch = new btInverseDynamics::MultiBodyTreeBatch;
+				if (-1 == batch->initialize(id_creator))
+				{
+					delete batch;
+					batch = 0;
+				}
+				else
+				{
+					m_inverseDynamicsBatches.insert(multiBody, batch);
+				}
+			}
+		}
+
+		return batch;
+	}
 };
 
 void PhysicsServerCommandProcessor::setGuiHelper(struct GUIHelperInterface* guiHelper)
@@ -2535,6 +2575,12 @@ void PhysicsServerCommandProcessor::deleteCachedInverseKinematicsBodies()
 		}
 	}
 	m_data->m_inverseKinematicsHelpers.clear();
+
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); i++)
+	{
+		delete m_data->m_inverseKinematicsThreadHelpers[i];
+		m_data->m_inverseKinematicsThreadHelpers[i] = 0;
+	}
 }
 void PhysicsServerCommandProcessor::deleteCachedInverseDynamicsBodies()
 {
@@ -2548,6 +2594,17 @@ void PhysicsServerCommandProcessor::deleteCachedInverseDynamicsBodies()
 		}
 	}
 	m_data->m_inverseDynamicsBodies.clear();
+
+	for (int i = 0; i < m_data->m_inverseDynamicsBatches.size(); i++)
+	{
+		btInverseDynamics::MultiBodyTreeBatch** batchPtrPtr = m_data->m_inverseDynamicsBatches.getAtIndex(i);
+		if (batchPtrPtr)
+		{
+			btInverseDynamics::MultiBodyTreeBatch* batch = *batchPtrPtr;
+			delete batch;
+		}
+	}
+	m_data->m_inverseDynamicsBatches.clear();
 }
 
 void PhysicsServerCommandProcessor::deleteDynamicsWorld()
@@ -8731,6 +8788,206 @@ bool PhysicsServerCommandProcessor::processCalculateMassMatrixCommand(const stru
 	return hasStatus;
 }
 
+bool PhysicsServerCommandProcessor::processCalculateDynamicsBatchCommand(const struct SharedMemoryCommand& clientCmd, struct SharedMemoryStatus& serverStatusOut, char* bufferServerToClient, int bufferSizeInBytes)
+{
+	bool hasStatus = true;
+	BT_PROFILE("CMD_CALCULATE_DYNAMICS_BATCH");
+
+	SharedMemoryStatus& serverCmd = serverStatusOut;
+	serverCmd.m_type = CMD_CALCULATED_DYNAMICS_BATCH_FAILED;
+	const CalculateDynamicsBatchArgs& args = clientCmd.m_calculateDynamicsBatchArguments;
+	InternalBodyHandle* bodyHandle = m_data->m_bodyHandles.getHandle(args.m_bodyUniqueId);
+	if (bodyHandle == 0 || bodyHandle->m_multiBody == 0 || args.m_numConfigurations < 0)
+	{
+		return hasStatus;
+	}
+
+	btMultiBody* mb = bodyHandle->m_multiBody;
+	btInverseDynamics::MultiBodyTreeBatch* batch = m_data->findOrCreateTreeBatch(mb);
+
+	const int baseDofQ = mb->hasFixedBase() ? 0 : 7;
+	const int baseDofQdot = mb->hasFixedBase() ? 0 : 6;
+	const int numDofs = mb->getNumDofs();
+	const int totDofs = numDofs + baseDofQdot;
+	const int numConfigs = args.m_numConfigurations;
+
+	if (batch == 0 || batch->numDoFs() != totDofs ||
+		args.m_dofCountQ != (baseDofQ + numDofs) || args.m_dofCountQdot != totDofs ||
+		args.m_linkIndex < -1 || args.m_linkIndex >= mb->getNumLinks())
+	{
+		return hasStatus;
+	}
+
+	//the client streams q, qdot and qdot-dot through the same buffer that receives the results,
+	//so copy them first
+	const int numQ = numConfigs * args.m_dofCountQ;
+	const int numQdot = numConfigs * totDofs;
+	if ((numQ + 2 * numQdot) * int(sizeof(double)) > bufferSizeInBytes)
+	{
+		return hasStatus;
+	}
+	const double* inputQ = (const double*)bufferServerToClient;
+	const double* inputQdot = inputQ + numQ;
+	const double* inputQdotdot = inputQdot + numQdot;
+
+	//for a floating base, inverse dynamics uses angular before linear coordinates
+	//and euler angles x,y,z followed by the position for the base, see processInverseDynamicsCommand
+	btAlignedObjectArray<int> perm;
+	perm.resize(totDofs);
+	for (int i = 0; i < totDofs; i++)
+	{
+		perm[i] = i;
+	}
+	if (baseDofQdot)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			perm[i] = i + 3;
+			perm[i + 3] = i;
+		}
+	}
+
+	btAlignedObjectArray<idScalar> q, qdot, qdotdot;
+	q.resize(numConfigs * totDofs);
+	qdot.resize(numQdot);
+	qdotdot.resize(numQdot);
+	for (int c = 0; c < numConfigs; c++)
+	{
+		const double* srcQ = &inputQ[c * args.m_dofCountQ];
+		idScalar* dstQ = &q[c * totDofs];
+		if (baseDofQ)
+		{
+			btQuaternion orn(srcQ[3], srcQ[4], srcQ[5], srcQ[6]);
+			btScalar yawZ, pitchY, rollX;
+			orn.getEulerZYX(yawZ, pitchY, rollX);
+			dstQ[0] = rollX;
+			dstQ[1] = pitchY;
+			dstQ[2] = yawZ;
+			dstQ[3] = srcQ[0];
+			dstQ[4] = srcQ[1];
+			dstQ[5] = srcQ[2];
+		}
+		for (int i = 0; i < numDofs; i++)
+		{
+			dstQ[baseDofQdot + i] = srcQ[baseDofQ + i];
+		}
+		for (int i = 0; i < totDofs; i++)
+		{
+			qdot[c * totDofs + perm[i]] = inputQdot[c * totDofs + i];
+			qdotdot[c * totDofs + perm[i]] = inputQdotdot[c * totDofs + i];
+		}
+	}
+
+	btInverseDynamics::vec3 id_grav(m_data->m_dynamicsWorld->getGravity());
+	if (-1 == batch->setGravityInWorldFrame(id_grav))
+	{
+		return hasStatus;
+	}
+
+	int numValues = 0;
+	if (args.m_flags & DYNAMICS_BATCH_INVERSE_DYNAMICS)
+	{
+		numValues += numConfigs * totDofs;
+	}
+	if (args.m_flags & DYNAMICS_BATCH_JACOBIANS)
+	{
+		numValues += 2 * numConfigs * 3 * totDofs;
+	}
+	if (args.m_flags & DYNAMICS_BATCH_MASS_MATRICES)
+	{
+		numValues += numConfigs * totDofs * totDofs;
+	}
+	if (numValues * int(sizeof(double)) > bufferSizeInBytes)
+	{
+		return hasStatus;
+	}
+
+	//results are written one block after another, in the order of b3DynamicsBatchFlags
+	double* sharedBuf = (double*)bufferServerToClient;
+	int offset = 0;
+	if (args.m_flags & DYNAMICS_BATCH_INVERSE_DYNAMICS)
+	{
+		btAlignedObjectArray<idScalar> jointForces;
+		jointForces.resize(numConfigs * totDofs);
+		if (numConfigs && -1 == batch->calculateInverseDynamics(numConfigs, &q[0], &qdot[0], &qdotdot[0], &jointForces[0]))
+		{
+			return hasStatus;
+		}
+		for (int c = 0; c < numConfigs; c++)
+		{
+			for (int i = 0; i < totDofs; i++)
+			{
+				sharedBuf[offset + c * totDofs + i] = jointForces[c * totDofs + perm[i]];
+			}
+		}
+		offset += numConfigs * totDofs;
+	}
+	if (args.m_flags & DYNAMICS_BATCH_JACOBIANS)
+	{
+#if (defined BT_ID_HAVE_MAT3X) && (defined BT_ID_WITH_JACOBIANS)
+		const int jacSize = 3 * totDofs;
+		btAlignedObjectArray<idScalar> jacTrans, jacRot;
+		jacTrans.resize(numConfigs * jacSize);
+		jacRot.resize(numConfigs * jacSize);
+		btInverseDynamics::vec3 localPosition;
+		localPosition(0) = args.m_localPosition[0];
+		localPosition(1) = args.m_localPosition[1];
+		localPosition(2) = args.m_localPosition[2];
+		//the tree stores the base as body 0
+		if (numConfigs && -1 == batch->calculateJacobians(numConfigs, &q[0], args.m_linkIndex + 1, localPosition, &jacTrans[0], &jacRot[0]))
+		{
+			return hasStatus;
+		}
+		for (int c = 0; c < numConfigs; c++)
+		{
+			for (int r = 0; r < 3; r++)
+			{
+				for (int i = 0; i < totDofs; i++)
+				{
+					sharedBuf[offset + c * jacSize + r * totDofs + i] = jacTrans[c * jacSize + r * totDofs + perm[i]];
+					sharedBuf[offset + numConfigs * jacSize + c * jacSize + r * totDofs + i] = jacRot[c * jacSize + r * totDofs + perm[i]];
+				}
+			}
+		}
+		offset += 2 * numConfigs * jacSize;
+#else
+		return hasStatus;
+#endif
+	}
+	if (args.m_flags & DYNAMICS_BATCH_MASS_MATRICES)
+	{
+		const int massSize = totDofs * totDofs;
+		btAlignedObjectArray<idScalar> massMatrices;
+		massMatrices.resize(numConfigs * massSize);
+		if (numConfigs && -1 == batch->calculateMassMatrices(numConfigs, &q[0], &massMatrices[0]))
+		{
+			return hasStatus;
+		}
+		for (int c = 0; c < numConfigs; c++)
+		{
+			for (int i = 0; i < totDofs; i++)
+			{
+				for (int j = 0; j < totDofs; j++)
+				{
+					sharedBuf[offset + c * massSize + i * totDofs + j] = massMatrices[c * massSize + perm[i] * totDofs + perm[j]];
+				}
+			}
+		}
+		offset += numConfigs * massSize;
+	}
+	btAssert(offset == numValues);
+
+	serverCmd.m_dynamicsBatchResultArgs.m_bodyUniqueId = args.m_bodyUniqueId;
+	serverCmd.m_dynamicsBatchResultArgs.m_flags = args.m_flags;
+	serverCmd.m_dynamicsBatchResultArgs.m_numConfigurations = numConfigs;
+	serverCmd.m_dynamicsBatchResultArgs.m_dofCount = totDofs;
+	serverCmd.m_dynamicsBatchResultArgs.m_numValues = numValues;
+	serverCmd.m_numDataStreamBytes = numValues * sizeof(double);
+	serverCmd.m_type = CMD_CALCULATED_DYNAMICS_BATCH_COMPLETED;
+
+	return hasStatus;
+}
+
 bool PhysicsServerCommandProcessor::processApplyExternalForceCommand(const struct SharedMemoryCommand& clientCmd, struct SharedMemoryStatus& serverStatusOut, char* bufferServerToClient, int bufferSizeInBytes)
 {
 	bool hasStatus = true;
@@ -9774,6 +10031,339 @@ bool PhysicsServerCommandProcessor::processCalculateInverseKinematicsCommand(con
 	return hasStatus;
 }
 
+//solves the inverse kinematics of a range of targets, each worker thread uses its own
+//copy of the MultiBodyTree and its own IKTrajectoryHelper, so the Jacobian work space
+//is allocated once per thread and reused for all targets and iterations
+struct InverseKinematicsBatchLoop : public btIParallelForBody
+{
+	btInverseDynamics::MultiBodyTreeBatch* m_batch;
+	IKTrajectoryHelper** m_threadHelpers;
+	int m_numDofs;
+	int m_baseDofs;
+	int m_endEffectorLinkIndex;
+	int m_ikMethod;
+	int m_maxNumIterations;
+	double m_residualThreshold;
+	const double* m_jointDamping;
+	//targets in base coordinates
+	const double* m_targetPositions;
+	const double* m_targetOrientations;
+	const double* m_seeds;
+	double* m_jointPositions;
+	double* m_residuals;
+	double* m_numIterations;
+	mutable btSpinMutex m_mutex;
+	mutable int m_numFailed;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		btInverseDynamics::MultiBodyTree* tree = m_batch->getThreadTree();
+#if BT_THREADSAFE
+		const unsigned int threadIndex = btGetCurrentThreadIndex();
+#else
+		const unsigned int threadIndex = 0;
+#endif
+		IKTrajectoryHelper* ikHelper = 0;
+		if (tree && threadIndex < BT_MAX_THREAD_COUNT)
+		{
+			//only this thread uses this slot
+			if (m_threadHelpers[threadIndex] == 0)
+			{
+				m_threadHelpers[threadIndex] = new IKTrajectoryHelper;
+			}
+			ikHelper = m_threadHelpers[threadIndex];
+		}
+		int numFailed = 0;
+		if (ikHelper == 0)
+		{
+			numFailed = iEnd - iBegin;
+		}
+		else
+		{
+			const int numDofs = m_numDofs;
+			const int totDofs = numDofs + m_baseDofs;
+			//the body index of the tree is shifted by one, the base is body 0
+			const int bodyIndex = m_endEffectorLinkIndex + 1;
+			ikHelper->setDampingCoeff(numDofs, m_jointDamping);
+
+			btInverseDynamics::vecx q(totDofs);
+			for (int i = 0; i < totDofs; i++)
+			{
+				q(i) = 0;
+			}
+			btInverseDynamics::mat3x jac_t(3, totDofs);
+			btInverseDynamics::mat3x jac_r(3, totDofs);
+			btAlignedObjectArray<double> jacobian_linear, jacobian_angular, q_current, q_new;
+			jacobian_linear.resize(3 * numDofs);
+			jacobian_angular.resize(3 * numDofs);
+			q_current.resize(numDofs);
+			q_new.resize(numDofs);
+			double targetDampCoeff[6] = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+			const double identity[4] = {0, 0, 0, 1};
+
+			for (int t = iBegin; t < iEnd; t++)
+			{
+				const double* targetPos = &m_targetPositions[3 * t];
+				const double* targetOrn = m_targetOrientations ? &m_targetOrientations[4 * t] : identity;
+				for (int i = 0; i < numDofs; i++)
+				{
+					q_current[i] = m_seeds[t * numDofs + i];
+				}
+
+				int iteration = 0;
+				double residual = 0;
+				bool failed = false;
+				for (;;)
+				{
+					for (int i = 0; i < numDofs; i++)
+					{
+						q(m_baseDofs + i) = q_current[i];
+					}
+					btInverseDynamics::vec3 world_origin;
+					btInverseDynamics::mat33 world_rot;
+					if (-1 == tree->calculatePositionKinematics(q) ||
+						-1 == tree->calculateJacobians(q) ||
+						-1 == tree->getBodyJacobianTrans(bodyIndex, &jac_t) ||
+						-1 == tree->getBodyJacobianRot(bodyIndex, &jac_r) ||
+						-1 == tree->getBodyOrigin(bodyIndex, &world_origin) ||
+						-1 == tree->getBodyTransform(bodyIndex, &world_rot))
+					{
+						failed = true;
+						break;
+					}
+
+					btVector3 endEffectorPos = world_origin;
+					residual = (endEffectorPos - btVector3(targetPos[0], targetPos[1], targetPos[2])).length();
+					if (residual <= m_residualThreshold || iteration >= m_maxNumIterations)
+					{
+						break;
+					}
+
+					for (int i = 0; i < 3; ++i)
+					{
+						for (int j = 0; j < numDofs; ++j)
+						{
+							jacobian_linear[i * numDofs + j] = jac_t(i, (m_baseDofs + j));
+							jacobian_angular[i * numDofs + j] = jac_r(i, (m_baseDofs + j));
+						}
+					}
+					btQuaternion endEffectorOrn;
+					world_rot.getRotation(endEffectorOrn);
+					double endEffectorWorldPosition[3] = {endEffectorPos[0], endEffectorPos[1], endEffectorPos[2]};
+					double endEffectorWorldOrientation[4] = {endEffectorOrn[0], endEffectorOrn[1], endEffectorOrn[2], endEffectorOrn[3]};
+
+					ikHelper->computeIK(targetPos, targetOrn, endEffectorWorldPosition, endEffectorWorldOrientation,
+										&q_current[0], numDofs, m_endEffectorLinkIndex,
+										&q_new[0], m_ikMethod, &jacobian_linear[0], &jacobian_angular[0], 2 * 3 * numDofs, targetDampCoeff);
+					for (int i = 0; i < numDofs; i++)
+					{
+						q_current[i] = q_new[i];
+					}
+					iteration++;
+				}
+
+				if (failed)
+				{
+					numFailed++;
+					continue;
+				}
+				for (int i = 0; i < numDofs; i++)
+				{
+					m_jointPositions[t * numDofs + i] = q_current[i];
+				}
+				m_residuals[t] = residual;
+				m_numIterations[t] = iteration;
+			}
+		}
+		if (numFailed)
+		{
+			btMutexLock(&m_mutex);
+			m_numFailed += numFailed;
+			btMutexUnlock(&m_mutex);
+		}
+	}
+};
+
+bool PhysicsServerCommandProcessor::processCalculateInverseKinematicsBatchCommand(const struct SharedMemoryCommand& clientCmd, struct SharedMemoryStatus& serverStatusOut, char* bufferServerToClient, int bufferSizeInBytes)
+{
+	bool hasStatus = true;
+	BT_PROFILE("CMD_CALCULATE_INVERSE_KINEMATICS_BATCH");
+
+	SharedMemoryStatus& serverCmd = serverStatusOut;
+	serverCmd.m_type = CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_FAILED;
+	const CalculateInverseKinematicsBatchArgs& args = clientCmd.m_calculateInverseKinematicsBatchArguments;
+	InternalBodyHandle* bodyHandle = m_data->m_bodyHandles.getHandle(args.m_bodyUniqueId);
+	if (bodyHandle == 0 || bodyHandle->m_multiBody == 0 || args.m_numTargets < 0)
+	{
+		return hasStatus;
+	}
+
+	btMultiBody* mb = bodyHandle->m_multiBody;
+	const int numDofs = mb->getNumDofs();
+	const int baseDofs = mb->hasFixedBase() ? 0 : 6;
+	const int numTargets = args.m_numTargets;
+	btInverseDynamics::MultiBodyTreeBatch* batch = m_data->findOrCreateTreeBatch(mb);
+	if (batch == 0 || batch->numDoFs() != numDofs + baseDofs || args.m_dofCount != numDofs || numDofs > MAX_DEGREE_OF_FREEDOM ||
+		args.m_endEffectorLinkIndex < 0 || args.m_endEffectorLinkIndex >= mb->getNumLinks())
+	{
+		return hasStatus;
+	}
+
+	//the client streams the targets through the same buffer that receives the results,
+	//so copy them first
+	const bool hasOrientations = (clientCmd.m_updateFlags & IK_HAS_TARGET_ORIENTATION) != 0;
+	const bool hasSeeds = (clientCmd.m_updateFlags & IK_HAS_CURRENT_JOINT_POSITIONS) != 0;
+	const int numPositions = 3 * numTargets;
+	const int numOrientations = hasOrientations ? 4 * numTargets : 0;
+	const int numSeeds = hasSeeds ? numTargets * numDofs : 0;
+	const int numValues = numTargets * numDofs + 2 * numTargets;
+	if ((numPositions + numOrientations + numSeeds) * int(sizeof(double)) > bufferSizeInBytes ||
+		numValues * int(sizeof(double)) > bufferSizeInBytes)
+	{
+		return hasStatus;
+	}
+	const double* inputPositions = (const double*)bufferServerToClient;
+	const double* inputOrientations = inputPositions + numPositions;
+	const double* inputSeeds = inputOrientations + numOrientations;
+
+	//inverse kinematics works in base coordinates, see processCalculateInverseKinematicsCommand
+	btTransform baseInv = mb->getBaseWorldTransform().inverse();
+	btAlignedObjectArray<double> targetPositions, targetOrientations, seeds;
+	targetPositions.resize(numPositions);
+	targetOrientations.resize(numOrientations);
+	seeds.resize(numTargets * numDofs);
+	for (int t = 0; t < numTargets; t++)
+	{
+		btTransform targetWorld;
+		targetWorld.setIdentity();
+		targetWorld.setOrigin(btVector3(inputPositions[3 * t], inputPositions[3 * t + 1], inputPositions[3 * t + 2]));
+		if (hasOrientations)
+		{
+			targetWorld.setRotation(btQuaternion(inputOrientations[4 * t], inputOrientations[4 * t + 1], inputOrientations[4 * t + 2], inputOrientations[4 * t + 3]));
+		}
+		btTransform targetBaseCoord = baseInv * targetWorld;
+		for (int i = 0; i < 3; i++)
+		{
+			targetPositions[3 * t + i] = targetBaseCoord.getOrigin()[i];
+		}
+		if (hasOrientations)
+		{
+			btQuaternion orn = targetBaseCoord.getRotation();
+			for (int i = 0; i < 4; i++)
+			{
+				targetOrientations[4 * t + i] = orn[i];
+			}
+		}
+	}
+	if (hasSeeds)
+	{
+		for (int i = 0; i < numSeeds; i++)
+		{
+			seeds[i] = inputSeeds[i];
+		}
+	}
+	else
+	{
+		btAlignedObjectArray<double> currentPositions;
+		for (int i = 0; i < mb->getNumLinks(); ++i)
+		{
+			// 0, 1, 2 represent revolute, prismatic, and spherical joint types respectively. Skip the fixed joints.
+			if (mb->getLink(i).m_jointType >= 0 && mb->getLink(i).m_jointType <= 2)
+			{
+				currentPositions.push_back(mb->getJointPos(i));
+			}
+		}
+		if (currentPositions.size() != numDofs)
+		{
+			return hasStatus;
+		}
+		for (int t = 0; t < numTargets; t++)
+		{
+			for (int i = 0; i < numDofs; i++)
+			{
+				seeds[t * numDofs + i] = currentPositions[i];
+			}
+		}
+	}
+
+	btAlignedObjectArray<double> jointDamping;
+	jointDamping.resize(numDofs, 0.5);
+	if (clientCmd.m_updateFlags & IK_HAS_JOINT_DAMPING)
+	{
+		for (int i = 0; i < numDofs; ++i)
+		{
+			jointDamping[i] = args.m_jointDamping[i];
+		}
+	}
+
+	int ikMethod = IK2_VEL_DLS;
+	if (hasOrientations)
+	{
+		ikMethod = (clientCmd.m_updateFlags & IK_SDLS) ? IK2_VEL_SDLS_WITH_ORIENTATION : IK2_VEL_DLS_WITH_ORIENTATION;
+	}
+	else if (clientCmd.m_updateFlags & IK_SDLS)
+	{
+		ikMethod = IK2_VEL_SDLS;
+	}
+
+	btInverseDynamics::vec3 id_grav(m_data->m_dynamicsWorld->getGravity());
+	if (-1 == batch->setGravityInWorldFrame(id_grav))
+	{
+		return hasStatus;
+	}
+
+	//results are written to the shared buffer directly, the inputs have been copied
+	double* sharedBuf = (double*)bufferServerToClient;
+	InverseKinematicsBatchLoop loop;
+	loop.m_batch = batch;
+	loop.m_threadHelpers = m_data->m_inverseKinematicsThreadHelpers;
+	loop.m_numDofs = numDofs;
+	loop.m_baseDofs = baseDofs;
+	loop.m_endEffectorLinkIndex = args.m_endEffectorLinkIndex;
+	loop.m_ikMethod = ikMethod;
+	loop.m_maxNumIterations = (clientCmd.m_updateFlags & IK_HAS_MAX_ITERATIONS) ? args.m_maxNumIterations : 20;
+	loop.m_residualThreshold = (clientCmd.m_updateFlags & IK_HAS_RESIDUAL_THRESHOLD) ? args.m_residualThreshold : 1e-4;
+	loop.m_jointDamping = numDofs ? &jointDamping[0] : 0;
+	loop.m_targetPositions = numPositions ? &targetPositions[0] : 0;
+	loop.m_targetOrientations = numOrientations ? &targetOrientations[0] : 0;
+	loop.m_seeds = seeds.size() ? &seeds[0] : 0;
+	loop.m_jointPositions = sharedBuf;
+	loop.m_residuals = sharedBuf + numTargets * numDofs;
+	loop.m_numIterations = sharedBuf + numTargets * numDofs + numTargets;
+	loop.m_numFailed = 0;
+	if (numTargets && numDofs)
+	{
+		//every target runs several iterations, so small chunks already outweigh the scheduling cost
+		const int grainSize = 1;
+#if BT_THREADSAFE
+		if (btGetTaskScheduler())
+		{
+			btParallelFor(0, numTargets, grainSize, loop);
+		}
+		else
+		{
+			loop.forLoop(0, numTargets);
+		}
+#else
+		loop.forLoop(0, numTargets);
+#endif
+	}
+	if (loop.m_numFailed || (numTargets && numDofs == 0))
+	{
+		return hasStatus;
+	}
+
+	serverCmd.m_inverseKinematicsBatchResultArgs.m_bodyUniqueId = args.m_bodyUniqueId;
+	serverCmd.m_inverseKinematicsBatchResultArgs.m_numTargets = numTargets;
+	serverCmd.m_inverseKinematicsBatchResultArgs.m_dofCount = numDofs;
+	serverCmd.m_inverseKinematicsBatchResultArgs.m_residualThreshold = loop.m_residualThreshold;
+	serverCmd.m_inverseKinematicsBatchResultArgs.m_numValues = numValues;
+	serverCmd.m_numDataStreamBytes = numValues * sizeof(double);
+	serverCmd.m_type = CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_COMPLETED;
+
+	return hasStatus;
+}
+
 //		PyModule_AddIntConstant(m, "GEOM_SPHERE", GEOM_SPHERE);
 //		PyModule_AddIntConstant(m, "GEOM_BOX", GEOM_BOX);
 //		PyModule_AddIntConstant(m, "GEOM_CYLINDER", GEOM_CYLINDER);
@@ -10772,6 +11362,16 @@ bool PhysicsServerCommandProcessor::processCommand(const struct SharedMemoryComm
 			hasStatus = processCalculateMassMatrixCommand(clientCmd, serverStatusOut, bufferServerToClient, bufferSizeInBytes);
 			break;
 		}
+		case CMD_CALCULATE_DYNAMICS_BATCH:
+		{
+			hasStatus = processCalculateDynamicsBatchCommand(clientCmd, serverStatusOut, bufferServerToClient, bufferSizeInBytes);
+			break;
+		}
+		case CMD_CALCULATE_INVERSE_KINEMATICS_BATCH:
+		{
+			hasStatus = processCalculateInverseKinematicsBatchCommand(clientCmd, serverStatusOut, bufferServerToClient, bufferSizeInBytes);
+			break;
+		}
 		case CMD_APPLY_EXTERNAL_FORCE:
 		{
 			hasStatus = processApplyExternalForceCommand(clientCmd, serverStatusOut, bufferServerToClient, bufferSizeInBytes);
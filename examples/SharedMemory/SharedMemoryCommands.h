@@ -700,6 +700,29 @@ struct CalculateMassMatrixResultArgs
 	int m_dofCount;
 };
 
+//the joint positions, velocities and accelerations of all configurations are streamed,
+//see b3CalculateDynamicsBatchCommandInit
+struct CalculateDynamicsBatchArgs
+{
+	int m_bodyUniqueId;
+	int m_flags;
+	int m_numConfigurations;
+	int m_dofCountQ;
+	int m_dofCountQdot;
+	int m_linkIndex;
+	double m_localPosition[3];
+};
+
+//the results are streamed, forces first, then linear and angular Jacobians, then mass matrices
+struct CalculateDynamicsBatchResultArgs
+{
+	int m_bodyUniqueId;
+	int m_flags;
+	int m_numConfigurations;
+	int m_dofCount;
+	int m_numValues;
+};
+
 enum b3EnumCollisionFilterFlags
 {
 	B3_COLLISION_FILTER_PAIR = 1,
@@ -741,6 +764,29 @@ struct CalculateInverseKinematicsResultArgs
 	double m_jointPositions[MAX_DEGREE_OF_FREEDOM];
 };
 
+//the target positions, orientations and seeds of all targets are streamed,
+//see b3CalculateInverseKinematicsBatchCommandInit
+struct CalculateInverseKinematicsBatchArgs
+{
+	int m_bodyUniqueId;
+	int m_endEffectorLinkIndex;
+	int m_numTargets;
+	int m_dofCount;
+	double m_jointDamping[MAX_DEGREE_OF_FREEDOM];
+	int m_maxNumIterations;
+	double m_residualThreshold;
+};
+
+//the results are streamed, joint positions of all targets first, then residuals, then iteration counts
+struct CalculateInverseKinematicsBatchResultArgs
+{
+	int m_bodyUniqueId;
+	int m_numTargets;
+	int m_dofCount;
+	double m_residualThreshold;
+	int m_numValues;
+};
+
 enum EnumUserConstraintFlags
 {
 	USER_CONSTRAINT_ADD_CONSTRAINT = 1,
@@ -1071,6 +1117,7 @@ struct SharedMemoryCommand
 		struct CalculateInverseDynamicsArgs m_calculateInverseDynamicsArguments;
 		struct CalculateJacobianArgs m_calculateJacobianArguments;
 		struct CalculateMassMatrixArgs m_calculateMassMatrixArguments;
+		struct CalculateDynamicsBatchArgs m_calculateDynamicsBatchArguments;
 		struct b3UserConstraint m_userConstraintArguments;
 		struct RequestContactDataArgs m_requestContactPointArguments;
 		struct RequestOverlappingObjectsArgs m_requestOverlappingObjectsArgs;
@@ -1078,6 +1125,7 @@ struct SharedMemoryCommand
 		struct UpdateVisualShapeDataArgs m_updateVisualShapeDataArguments;
 		struct LoadTextureArgs m_loadTextureArguments;
 		struct CalculateInverseKinematicsArgs m_calculateInverseKinematicsArguments;
+		struct CalculateInverseKinematicsBatchArgs m_calculateInverseKinematicsBatchArguments;
 		struct UserDebugDrawArgs m_userDebugDrawArgs;
 		struct RequestRaycastIntersections m_requestRaycastIntersections;
 		struct LoadSoftBodyArgs m_loadSoftBodyArguments;
@@ -1145,9 +1193,11 @@ struct SharedMemoryStatus
 		struct CalculateInverseDynamicsResultArgs m_inverseDynamicsResultArgs;
 		struct CalculateJacobianResultArgs m_jacobianResultArgs;
 		struct CalculateMassMatrixResultArgs m_massMatrixResultArgs;
+		struct CalculateDynamicsBatchResultArgs m_dynamicsBatchResultArgs;
 		struct SendContactDataArgs m_sendContactPointArgs;
 		struct SendOverlappingObjectsArgs m_sendOverlappingObjectsArgs;
 		struct CalculateInverseKinematicsResultArgs m_inverseKinematicsResultArgs;
+		struct CalculateInverseKinematicsBatchResultArgs m_inverseKinematicsBatchResultArgs;
 		struct SendVisualShapeDataArgs m_sendVisualShapeArgs;
 		struct UserDebugDrawResultArgs m_userDebugDrawArgs;
 		struct b3UserConstraint m_userConstraintResultArgs;
@@ -8,7 +8,9 @@
 //instead, only ADD a new one at the top, comment-out previous one
 
 
-#define SHARED_MEMORY_MAGIC_NUMBER   201811260
+#define SHARED_MEMORY_MAGIC_NUMBER 201812060
+//#define SHARED_MEMORY_MAGIC_NUMBER 201812040
+//#define SHARED_MEMORY_MAGIC_NUMBER   201811260
 //#define SHARED_MEMORY_MAGIC_NUMBER   201810250
 //#define SHARED_MEMORY_MAGIC_NUMBER 201809030
 //#define SHARED_MEMORY_MAGIC_NUMBER 201809010
@@ -99,6 +101,8 @@ enum EnumSharedMemoryClientCommand
 	CMD_ADD_USER_DATA,
 	CMD_REMOVE_USER_DATA,
 	CMD_COLLISION_FILTER,
+	CMD_CALCULATE_DYNAMICS_BATCH,
+	CMD_CALCULATE_INVERSE_KINEMATICS_BATCH,
 
 	//don't go beyond this command!
 	CMD_MAX_CLIENT_COMMANDS,
@@ -217,10 +221,22 @@ enum EnumSharedMemoryServerStatus
 	CMD_ADD_USER_DATA_FAILED,
 	CMD_REMOVE_USER_DATA_COMPLETED,
 	CMD_REMOVE_USER_DATA_FAILED,
+	CMD_CALCULATED_DYNAMICS_BATCH_COMPLETED,
+	CMD_CALCULATED_DYNAMICS_BATCH_FAILED,
+	CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_COMPLETED,
+	CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_FAILED,
 	//don't go beyond 'CMD_MAX_SERVER_COMMANDS!
 	CMD_MAX_SERVER_COMMANDS
 };
 
+///quantities computed by CMD_CALCULATE_DYNAMICS_BATCH, see b3CalculateDynamicsBatchCommandInit
+enum b3DynamicsBatchFlags
+{
+	DYNAMICS_BATCH_INVERSE_DYNAMICS = 1,
+	DYNAMICS_BATCH_JACOBIANS = 2,
+	DYNAMICS_BATCH_MASS_MATRICES = 4,
+};
+
 enum JointInfoFlags
 {
 	JOINT_HAS_MOTORIZED_POWER = 1,
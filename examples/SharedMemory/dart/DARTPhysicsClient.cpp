@@ -65,6 +65,8 @@ struct DARTPhysicsDirectInternalData
 
 	char m_bulletStreamDataServerToClient[SHARED_MEMORY_MAX_STREAM_CHUNK_SIZE];
 	btAlignedObjectArray<double> m_cachedMassMatrix;
+	btAlignedObjectArray<double> m_cachedDynamicsBatch;
+	btAlignedObjectArray<double> m_cachedInverseKinematicsBatch;
 	int m_cachedCameraPixelsWidth;
 	int m_cachedCameraPixelsHeight;
 	btAlignedObjectArray<unsigned char> m_cachedCameraPixelsRGBA;
@@ -1031,6 +1033,36 @@ void DARTPhysicsClient::postProcessStatus(const struct SharedMemoryStatus& serve
 			}
 			break;
 		}
+		case CMD_CALCULATED_DYNAMICS_BATCH_FAILED:
+		{
+			b3Warning("calculate dynamics batch failed");
+			break;
+		}
+		case CMD_CALCULATED_DYNAMICS_BATCH_COMPLETED:
+		{
+			double* batchData = (double*)&m_data->m_bulletStreamDataServerToClient[0];
+			m_data->m_cachedDynamicsBatch.resize(serverCmd.m_dynamicsBatchResultArgs.m_numValues);
+			for (int i = 0; i < serverCmd.m_dynamicsBatchResultArgs.m_numValues; i++)
+			{
+				m_data->m_cachedDynamicsBatch[i] = batchData[i];
+			}
+			break;
+		}
+		case CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_FAILED:
+		{
+			b3Warning("calculate inverse kinematics batch failed");
+			break;
+		}
+		case CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_COMPLETED:
+		{
+			double* ikData = (double*)&m_data->m_bulletStreamDataServerToClient[0];
+			m_data->m_cachedInverseKinematicsBatch.resize(serverCmd.m_inverseKinematicsBatchResultArgs.m_numValues);
+			for (int i = 0; i < serverCmd.m_inverseKinematicsBatchResultArgs.m_numValues; i++)
+			{
+				m_data->m_cachedInverseKinematicsBatch[i] = ikData[i];
+			}
+			break;
+		}
 		case CMD_ACTUAL_STATE_UPDATE_COMPLETED:
 		{
 			break;
@@ -1446,6 +1478,28 @@ void DARTPhysicsClient::getCachedMassMatrix(int dofCountCheck, double* massMatri
 	}
 }
 
+void DARTPhysicsClient::getCachedDynamicsBatch(int numValuesCheck, double* values)
+{
+	if (numValuesCheck == m_data->m_cachedDynamicsBatch.size())
+	{
+		for (int i = 0; i < numValuesCheck; i++)
+		{
+			values[i] = m_data->m_cachedDynamicsBatch[i];
+		}
+	}
+}
+
+void DARTPhysicsClient::getCachedInverseKinematicsBatch(int numValuesCheck, double* values)
+{
+	if (numValuesCheck == m_data->m_cachedInverseKinematicsBatch.size())
+	{
+		for (int i = 0; i < numValuesCheck; i++)
+		{
+			values[i] = m_data->m_cachedInverseKinematicsBatch[i];
+		}
+	}
+}
+
 void DARTPhysicsClient::setTimeOut(double timeOutInSeconds)
 {
 	m_data->m_timeOutInSeconds = timeOutInSeconds;
@@ -66,6 +66,8 @@ struct MuJoCoPhysicsDirectInternalData
 
 	char m_bulletStreamDataServerToClient[SHARED_MEMORY_MAX_STREAM_CHUNK_SIZE];
 	btAlignedObjectArray<double> m_cachedMassMatrix;
+	btAlignedObjectArray<double> m_cachedDynamicsBatch;
+	btAlignedObjectArray<double> m_cachedInverseKinematicsBatch;
 	int m_cachedCameraPixelsWidth;
 	int m_cachedCameraPixelsHeight;
 	btAlignedObjectArray<unsigned char> m_cachedCameraPixelsRGBA;
@@ -1032,6 +1034,36 @@ void MuJoCoPhysicsClient::postProcessStatus(const struct SharedMemoryStatus& ser
 			}
 			break;
 		}
+		case CMD_CALCULATED_DYNAMICS_BATCH_FAILED:
+		{
+			b3Warning("calculate dynamics batch failed");
+			break;
+		}
+		case CMD_CALCULATED_DYNAMICS_BATCH_COMPLETED:
+		{
+			double* batchData = (double*)&m_data->m_bulletStreamDataServerToClient[0];
+			m_data->m_cachedDynamicsBatch.resize(serverCmd.m_dynamicsBatchResultArgs.m_numValues);
+			for (int i = 0; i < serverCmd.m_dynamicsBatchResultArgs.m_numValues; i++)
+			{
+				m_data->m_cachedDynamicsBatch[i] = batchData[i];
+			}
+			break;
+		}
+		case CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_FAILED:
+		{
+			b3Warning("calculate inverse kinematics batch failed");
+			break;
+		}
+		case CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_COMPLETED:
+		{
+			double* ikData = (double*)&m_data->m_bulletStreamDataServerToClient[0];
+			m_data->m_cachedInverseKinematicsBatch.resize(serverCmd.m_inverseKinematicsBatchResultArgs.m_numValues);
+			for (int i = 0; i < serverCmd.m_inverseKinematicsBatchResultArgs.m_numValues; i++)
+			{
+				m_data->m_cachedInverseKinematicsBatch[i] = ikData[i];
+			}
+			break;
+		}
 		case CMD_ACTUAL_STATE_UPDATE_COMPLETED:
 		{
 			break;
@@ -1447,6 +1479,28 @@ void MuJoCoPhysicsClient::getCachedMassMatrix(int dofCountCheck, double* massMat
 	}
 }
 
+void MuJoCoPhysicsClient::getCachedDynamicsBatch(int numValuesCheck, double* values)
+{
+	if (numValuesCheck == m_data->m_cachedDynamicsBatch.size())
+	{
+		for (int i = 0; i < numValuesCheck; i++)
+		{
+			values[i] = m_data->m_cachedDynamicsBatch[i];
+		}
+	}
+}
+
+void MuJoCoPhysicsClient::getCachedInverseKinematicsBatch(int numValuesCheck, double* values)
+{
+	if (numValuesCheck == m_data->m_cachedInverseKinematicsBatch.size())
+	{
+		for (int i = 0; i < numValuesCheck; i++)
+		{
+			values[i] = m_data->m_cachedInverseKinematicsBatch[i];
+		}
+	}
+}
+
 void MuJoCoPhysicsClient::setTimeOut(double timeOutInSeconds)
 {
 	m_data->m_timeOutInSeconds = timeOutInSeconds;
@@ -295,7 +295,7 @@ void Jacobian::CalcDeltaThetasPseudoinverse()
 	// Compute Singular Value Decomposition
 	//	This an inefficient way to do Pseudoinverse, but it is convenient since we need SVD anyway
 
-	J.ComputeSVD(U, w, V);
+	J.ComputeSVD(U, w, V, SvdWork);
 
 	// Next line for debugging only
 	assert(J.DebugCheckSVD(U, w, V));
@@ -341,7 +341,7 @@ void Jacobian::CalcDeltaThetasDLSwithNullspace(const VectorRn& desiredV)
 	// J.MultiplyTranspose( dTextra, dTheta );
 
 	// Use these two lines for the traditional DLS method
-	U.Solve(dS, &dT1);
+	U.Solve(dS, &dT1, SolveWork);
 	J.MultiplyTranspose(dT1, dTheta);
 
 	// Compute JInv in damped least square form
@@ -393,7 +393,7 @@ void Jacobian::CalcDeltaThetasDLS()
 	// J.MultiplyTranspose( dTextra, dTheta );
 
 	// Use these two lines for the traditional DLS method
-	U.Solve(dS, &dT1);
+	U.Solve(dS, &dT1, SolveWork);
 	J.MultiplyTranspose(dT1, dTheta);
 
 	// Scale back to not exceed maximum angle changes
@@ -408,13 +408,15 @@ void Jacobian::CalcDeltaThetasDLS2(const VectorRn& dVec)
 {
 	const MatrixRmn& J = ActiveJacobian();
 
-	U.SetSize(J.GetNumColumns(), J.GetNumColumns());
-	MatrixRmn::TransposeMultiply(J, J, U);
-	U.AddToDiagonal(dVec);
+	// Work in joint space: (J^T * J + diag(dVec)) * dTheta = J^T * dS.
+	// JTJ and JTdS keep U and dT1 at the sizes the other methods expect.
+	JTJ.SetSize(J.GetNumColumns(), J.GetNumColumns());
+	MatrixRmn::TransposeMultiply(J, J, JTJ);
+	JTJ.AddToDiagonal(dVec);
 
-	dT1.SetLength(J.GetNumColumns());
-	J.MultiplyTranspose(dS, dT1);
-	U.Solve(dT1, &dTheta);
+	JTdS.SetLength(J.GetNumColumns());
+	J.MultiplyTranspose(dS, JTdS);
+	JTJ.Solve(JTdS, &dTheta, SolveWork);
 
 	// Scale back to not exceed maximum angle changes
 	double maxChange = dTheta.MaxAbs();
@@ -431,7 +433,7 @@ void Jacobian::CalcDeltaThetasDLSwithSVD()
 	// Compute Singular Value Decomposition
 	//	This an inefficient way to do DLS, but it is convenient since we need SVD anyway
 
-	J.ComputeSVD(U, w, V);
+	J.ComputeSVD(U, w, V, SvdWork);
 
 	// Next line for debugging only
 	assert(J.DebugCheckSVD(U, w, V));
@@ -464,7 +466,7 @@ void Jacobian::CalcDeltaThetasSDLS()
 
 	// Compute Singular Value Decomposition
 
-	J.ComputeSVD(U, w, V);
+	J.ComputeSVD(U, w, V, SvdWork);
 
 	// Next line for debugging only
 	assert(J.DebugCheckSVD(U, w, V));
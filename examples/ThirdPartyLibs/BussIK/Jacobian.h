@@ -123,6 +123,12 @@ public:
 
 	VectorRn errorArray;  // Distance of end effectors from target after updating
 
+	// Work space owned by this Jacobian, so that separate Jacobian objects can be used from separate threads
+	MatrixRmn JTJ;        // J^T * J plus damping (DLS2 only)
+	VectorRn JTdS;        // J^T * dS (DLS2 only)
+	MatrixRmn SolveWork;  // Augmented matrix for MatrixRmn::Solve
+	VectorRn SvdWork;     // Super diagonal for MatrixRmn::ComputeSVD
+
 	// Parameters for pseudoinverses
 	static const double PseudoInverseThresholdFactor;  // Threshold for treating eigenvalue as zero (fraction of largest eigenvalue)
 
@@ -355,11 +355,16 @@ MatrixRmn& MatrixRmn::MultiplyTranspose(const MatrixRmn& A, const MatrixRmn& B,
 // Uses row operations.  Assumes *this is square and invertible.
 // No error checking for divide by zero or instability (except with asserts)
 void MatrixRmn::Solve(const VectorRn& b, VectorRn* xVec) const
+{
+	Solve(b, xVec, GetWorkMatrix());
+}
+
+void MatrixRmn::Solve(const VectorRn& b, VectorRn* xVec, MatrixRmn& AugMat) const
 {
 	assert(NumRows == NumCols && NumCols == xVec->GetLength() && NumRows == b.GetLength());
 
 	// Copy this matrix and b into an Augmented Matrix
-	MatrixRmn& AugMat = GetWorkMatrix(NumRows, NumCols + 1);
+	AugMat.SetSize(NumRows, NumCols + 1);
 	AugMat.LoadAsSubmatrix(*this);
 	AugMat.SetColumn(NumRows, b);
 
@@ -530,11 +535,16 @@ void MatrixRmn::PostApplyGivens(double c, double s, long idx1, long idx2)
 //		sorting the eigenvalues by magnitude.)
 // ********************************************************************************************
 void MatrixRmn::ComputeSVD(MatrixRmn& U, VectorRn& w, MatrixRmn& V) const
+{
+	ComputeSVD(U, w, V, VectorRn::GetWorkVector());
+}
+
+void MatrixRmn::ComputeSVD(MatrixRmn& U, VectorRn& w, MatrixRmn& V, VectorRn& superDiag) const
 {
 	assert(U.NumRows == NumRows && V.NumCols == NumCols && U.NumRows == U.NumCols && V.NumRows == V.NumCols && w.GetLength() == Min(NumRows, NumCols));
 
 	//	double temp=0.0;
-	VectorRn& superDiag = VectorRn::GetWorkVector(w.GetLength() - 1);  // Some extra work space.  Will get passed around.
+	superDiag.SetLength(w.GetLength() - 1);  // Some extra work space.  Will get passed around.
 
 	// Choose larger of U, V to hold intermediate results
 	// If U is larger than V, use U to store intermediate results
@@ -118,6 +118,8 @@ public:
 
 	// Solving systems of linear equations
 	void Solve(const VectorRn& b, VectorRn* x) const;  // Solves the equation   (*this)*x = b;    Uses row operations.  Assumes *this is invertible.
+	// Same, but uses the caller's work matrix instead of the shared static one, so it is safe to call from several threads
+	void Solve(const VectorRn& b, VectorRn* x, MatrixRmn& workMatrix) const;
 
 	// Row Echelon Form and Reduced Row Echelon Form routines
 	// Row echelon form here allows non-negative entries (instead of 1's) in the positions of lead variables.
@@ -132,6 +134,8 @@ public:
 
 	// Singular value decomposition
 	void ComputeSVD(MatrixRmn& U, VectorRn& w, MatrixRmn& V) const;
+	// Same, but uses the caller's work vector instead of the shared static one
+	void ComputeSVD(MatrixRmn& U, VectorRn& w, MatrixRmn& V, VectorRn& workVector) const;
 	// Good for debugging SVD computations (I recommend this be used for any new application to check for bugs/instability).
 	bool DebugCheckSVD(const MatrixRmn& U, const VectorRn& w, const MatrixRmn& V) const;
 	// Compute inverse of a matrix, the result is written in R
@@ -179,6 +179,7 @@ sources = ["examples/pybullet/pybullet.c"]\
 +["src/LinearMath/btPolarDecomposition.cpp"]\
 +["src/LinearMath/btSerializer64.cpp"]\
 +["src/LinearMath/btConvexHullComputer.cpp"]\
++["src/LinearMath/btFrameArena.cpp"]\
 +["src/LinearMath/btQuickprof.cpp"]\
 +["src/LinearMath/btThreads.cpp"]\
 +["src/LinearMath/TaskScheduler/btTaskScheduler.cpp"]\
@@ -214,6 +215,7 @@ sources = ["examples/pybullet/pybullet.c"]\
 +["src/BulletCollision/CollisionDispatch/btCollisionObject.cpp"]\
 +["src/BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.cpp"]\
 +["src/BulletCollision/CollisionDispatch/btSphereTriangleCollisionAlgorithm.cpp"]\
++["src/BulletCollision/CollisionDispatch/btTriggerManager.cpp"]\
 +["src/BulletCollision/CollisionDispatch/btCollisionWorld.cpp"]\
 +["src/BulletCollision/CollisionDispatch/btEmptyCollisionAlgorithm.cpp"]\
 +["src/BulletCollision/CollisionDispatch/btUnionFind.cpp"]\
@@ -307,6 +309,7 @@ sources = ["examples/pybullet/pybullet.c"]\
 +["src/BulletDynamics/MLCPSolvers/btLemkeAlgorithm.cpp"]\
 +["src/BulletDynamics/MLCPSolvers/btMLCPSolver.cpp"]\
 +["src/BulletDynamics/Featherstone/btMultiBody.cpp"]\
++["src/BulletDynamics/Featherstone/btMultiBodyBatchedDynamics.cpp"]\
 +["src/BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.cpp"]\
 +["src/BulletDynamics/Featherstone/btMultiBodyJointMotor.cpp"]\
 +["src/BulletDynamics/Featherstone/btMultiBodyGearConstraint.cpp"]\
@@ -319,8 +322,10 @@ sources = ["examples/pybullet/pybullet.c"]\
 +["src/BulletDynamics/Featherstone/btMultiBodySliderConstraint.cpp"]\
 +["src/BulletDynamics/Featherstone/btMultiBodySphericalJointMotor.cpp"]\
 +["src/BulletDynamics/Vehicle/btRaycastVehicle.cpp"]\
++["src/BulletDynamics/Vehicle/btRaycastVehicleFleet.cpp"]\
 +["src/BulletDynamics/Vehicle/btWheelInfo.cpp"]\
 +["src/BulletDynamics/Character/btKinematicCharacterController.cpp"]\
++["src/BulletDynamics/Character/btKinematicCharacterCrowd.cpp"]\
 +["src/Bullet3Common/b3AlignedAllocator.cpp"]\
 +["src/Bullet3Common/b3Logging.cpp"]\
 +["src/Bullet3Common/b3Vector3.cpp"]\
@@ -337,6 +342,7 @@ sources = ["examples/pybullet/pybullet.c"]\
 +["Extras/InverseDynamics/CloneTreeCreator.cpp"]\
 +["Extras/InverseDynamics/IDRandomUtil.cpp"]\
 +["Extras/InverseDynamics/MultiBodyTreeDebugGraph.cpp"]\
++["Extras/InverseDynamics/MultiBodyTreeBatch.cpp"]\
 +["Extras/InverseDynamics/User2InternalIndex.cpp"]\
 +["Extras/InverseDynamics/CoilCreator.cpp"]\
 +["Extras/InverseDynamics/MultiBodyNameMap.cpp"]\
@@ -614,6 +614,29 @@ void btDbvt::remove(btDbvtNode* leaf)
 	--m_leaves;
 }
 
+//
+void btDbvt::refit()
+{
+	if (m_root && m_root->isinternal())
+	{
+		tNodeArray nodes;
+		nodes.reserve(m_leaves);
+		nodes.push_back(m_root);
+		for (int i = 0; i < nodes.size(); ++i)
+		{
+			btDbvtNode* n = nodes[i];
+			if (n->childs[0]->isinternal()) nodes.push_back(n->childs[0]);
+			if (n->childs[1]->isinternal()) nodes.push_back(n->childs[1]);
+		}
+		/* children always follow their parent, so a reverse sweep is bottom-up	*/
+		for (int i = nodes.size() - 1; i >= 0; --i)
+		{
+			btDbvtNode* n = nodes[i];
+			Merge(n->childs[0]->volume, n->childs[1]->volume, n->volume);
+		}
+	}
+}
+
 //
 void btDbvt::write(IWriter* iwriter) const
 {
@@ -283,6 +283,8 @@ struct btDbvt
 	bool update(btDbvtNode* leaf, btDbvtVolume& volume, const btVector3& velocity);
 	bool update(btDbvtNode* leaf, btDbvtVolume& volume, btScalar margin);
 	void remove(btDbvtNode* leaf);
+	///recompute the volumes of all internal nodes bottom-up, after leaf volumes have been modified in place. The topology is left unchanged.
+	void refit();
 	void write(IWriter* iwriter) const;
 	void clone(btDbvt& dest, IClone* iclone = 0) const;
 	static int maxdepth(const btDbvtNode* node);
@@ -783,7 +785,7 @@ inline void btDbvt::collideTT(const btDbvtNode* root0,
 	{
 		int depth = 1;
 		int treshold = DOUBLE_STACKSIZE - 4;
-		btAlignedObjectArray<sStkNN> stkStack;
+		btSmallAlignedObjectArray<sStkNN, DOUBLE_STACKSIZE> stkStack;
 		stkStack.resize(DOUBLE_STACKSIZE);
 		stkStack[0] = sStkNN(root0, root1);
 		do
@@ -1183,7 +1185,7 @@ inline void btDbvt::collideKDOP(const btDbvtNode* root,
 	if (root)
 	{
 		const int inside = (1 << count) - 1;
-		btAlignedObjectArray<sStkNP> stack;
+		btSmallAlignedObjectArray<sStkNP, SIMPLE_STACKSIZE> stack;
 		int signs[sizeof(unsigned) * 8];
 		btAssert(count < int(sizeof(signs) / sizeof(signs[0])));
 		for (int i = 0; i < count; ++i)
@@ -1192,7 +1194,6 @@ inline void btDbvt::collideKDOP(const btDbvtNode* root,
 					   ((normals[i].y() >= 0) ? 2 : 0) +
 					   ((normals[i].z() >= 0) ? 4 : 0);
 		}
-		stack.reserve(SIMPLE_STACKSIZE);
 		stack.push_back(sStkNP(root, 0));
 		do
 		{
@@ -1248,9 +1249,9 @@ inline void btDbvt::collideOCL(const btDbvtNode* root,
 								 (sortaxis[1] >= 0 ? 2 : 0) +
 								 (sortaxis[2] >= 0 ? 4 : 0);
 		const int inside = (1 << count) - 1;
-		btAlignedObjectArray<sStkNPS> stock;
-		btAlignedObjectArray<int> ifree;
-		btAlignedObjectArray<int> stack;
+		btSmallAlignedObjectArray<sStkNPS, SIMPLE_STACKSIZE> stock;
+		btSmallAlignedObjectArray<int, SIMPLE_STACKSIZE> ifree;
+		btSmallAlignedObjectArray<int, SIMPLE_STACKSIZE> stack;
 		int signs[sizeof(unsigned) * 8];
 		btAssert(count < int(sizeof(signs) / sizeof(signs[0])));
 		for (int i = 0; i < count; ++i)
@@ -1259,9 +1260,6 @@ inline void btDbvt::collideOCL(const btDbvtNode* root,
 					   ((normals[i].y() >= 0) ? 2 : 0) +
 					   ((normals[i].z() >= 0) ? 4 : 0);
 		}
-		stock.reserve(SIMPLE_STACKSIZE);
-		stack.reserve(SIMPLE_STACKSIZE);
-		ifree.reserve(SIMPLE_STACKSIZE);
 		stack.push_back(allocate(ifree, stock, sStkNPS(root, 0, root->volume.ProjectMinimum(sortaxis, srtsgns))));
 		do
 		{
@@ -1360,8 +1358,7 @@ inline void btDbvt::collideTU(const btDbvtNode* root,
 	DBVT_CHECKTYPE
 	if (root)
 	{
-		btAlignedObjectArray<const btDbvtNode*> stack;
-		stack.reserve(SIMPLE_STACKSIZE);
+		btSmallAlignedObjectArray<const btDbvtNode*, SIMPLE_STACKSIZE> stack;
 		stack.push_back(root);
 		do
 		{
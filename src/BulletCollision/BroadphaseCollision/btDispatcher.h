@@ -26,6 +26,7 @@ struct btCollisionObjectWrapper;
 
 class btPersistentManifold;
 class btPoolAllocator;
+class btFrameArena;
 
 struct btDispatcherInfo
 {
@@ -47,7 +48,8 @@ struct btDispatcherInfo
 		  m_allowedCcdPenetration(btScalar(0.04)),
 		  m_useConvexConservativeDistanceUtil(false),
 		  m_convexConservativeDistanceThreshold(0.0f),
-		  m_deterministicOverlappingPairs(false)
+		  m_deterministicOverlappingPairs(false),
+		  m_frameArena(0)
 	{
 	}
 	btScalar m_timeStep;
@@ -63,6 +65,19 @@ struct btDispatcherInfo
 	bool m_useConvexConservativeDistanceUtil;
 	btScalar m_convexConservativeDistanceThreshold;
 	bool m_deterministicOverlappingPairs;
+	///temporary memory that stays valid until the end of the collision detection pass, can be 0. See btDiscreteDynamicsWorld::setFrameArena
+	btFrameArena* m_frameArena;
+};
+
+///Narrowphase work that a collision algorithm hands to the dispatcher while the pairs are dispatched concurrently, see btDispatcher::deferCollisionWork
+struct btDeferredCollisionWork
+{
+	virtual ~btDeferredCollisionWork() {}
+
+	virtual int getNumWorkItems() const = 0;
+
+	///processes the items [iBegin, iEnd). Disjoint ranges of the same work can be processed by several threads at once
+	virtual void processWorkItems(int iBegin, int iEnd, const btDispatcherInfo& dispatchInfo) const = 0;
 };
 
 enum ebtDispatcherQueryType
@@ -105,6 +120,21 @@ public:
 	virtual void* allocateCollisionAlgorithm(int size) = 0;
 
 	virtual void freeCollisionAlgorithm(void* ptr) = 0;
+
+	///returns true while findAlgorithm, getNewManifold, releaseManifold and the algorithm allocators may be called from several threads at once,
+	///so a collision algorithm is allowed to split the work for a single pair with deferCollisionWork
+	virtual bool isConcurrentDispatchAllowed() const
+	{
+		return false;
+	}
+
+	///queues work that is processed once all pairs have been dispatched, together with the work of the other pairs in a single parallel loop.
+	///The work must stay valid until dispatchAllCollisionPairs returns. Returns false if the work was not queued, the caller then processes it itself
+	virtual bool deferCollisionWork(btDeferredCollisionWork* work)
+	{
+		(void)work;
+		return false;
+	}
 };
 
 #endif  //BT_DISPATCHER_H
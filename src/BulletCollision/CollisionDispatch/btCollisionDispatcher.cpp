@@ -30,7 +30,9 @@ subject to the following restrictions:
 #endif
 
 btCollisionDispatcher::btCollisionDispatcher(btCollisionConfiguration* collisionConfiguration) : m_dispatcherFlags(btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD),
-																								 m_collisionConfiguration(collisionConfiguration)
+																								 m_collisionConfiguration(collisionConfiguration),
+																								 m_manifoldPoolOverflows(0),
+																								 m_algorithmPoolOverflows(0)
 {
 	int i;
 
@@ -83,6 +85,7 @@ btPersistentManifold* btCollisionDispatcher::getNewManifold(const btCollisionObj
 		if ((m_dispatcherFlags & CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION) == 0)
 		{
 			mem = btAlignedAlloc(sizeof(btPersistentManifold), 16);
+			++m_manifoldPoolOverflows;
 		}
 		else
 		{
@@ -271,6 +274,7 @@ void* btCollisionDispatcher::allocateCollisionAlgorithm(int size)
 	if (NULL == mem)
 	{
 		//warn user for overflow?
+		++m_algorithmPoolOverflows;
 		return btAlignedAlloc(static_cast<size_t>(size), 16);
 	}
 	return mem;
@@ -60,6 +60,10 @@ protected:
 
 	btCollisionConfiguration* m_collisionConfiguration;
 
+	///number of manifolds and algorithms that did not fit in their pool and came from the heap
+	int m_manifoldPoolOverflows;
+	int m_algorithmPoolOverflows;
+
 public:
 	enum DispatcherFlags
 	{
@@ -153,6 +157,22 @@ public:
 		m_collisionConfiguration = config;
 	}
 
+	int getManifoldPoolOverflows() const
+	{
+		return m_manifoldPoolOverflows;
+	}
+
+	int getAlgorithmPoolOverflows() const
+	{
+		return m_algorithmPoolOverflows;
+	}
+
+	void resetPoolOverflows()
+	{
+		m_manifoldPoolOverflows = 0;
+		m_algorithmPoolOverflows = 0;
+	}
+
 	virtual btPoolAllocator* getInternalManifoldPool()
 	{
 		return m_persistentManifoldPoolAllocator;
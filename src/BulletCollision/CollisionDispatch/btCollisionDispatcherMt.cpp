@@ -25,11 +25,142 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionDispatch/btCollisionConfiguration.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 
+static inline int currentThreadListIndex()
+{
+#if BT_THREADSAFE
+	return btGetCurrentThreadIndex();
+#else
+	return 0;
+#endif
+}
+
+//number of deferred work items handled by a single task
+#define BT_DEFERRED_COLLISION_WORK_GRAIN_SIZE 16
+
+static void dispatcherParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		btParallelFor(iBegin, iEnd, grainSize, body);
+		return;
+	}
+#endif
+	body.forLoop(iBegin, iEnd);
+}
+
 btCollisionDispatcherMt::btCollisionDispatcherMt(btCollisionConfiguration* config, int grainSize)
 	: btCollisionDispatcher(config)
 {
 	m_batchUpdating = false;
+	m_processingDeferredWork = false;
 	m_grainSize = grainSize;  // iterations per task
+	m_cacheBatchSize = 16;
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); ++i)
+	{
+		m_manifoldCache.m_threadLists[i].m_head = 0;
+		m_manifoldCache.m_threadLists[i].m_count = 0;
+		m_algorithmCache.m_threadLists[i].m_head = 0;
+		m_algorithmCache.m_threadLists[i].m_count = 0;
+	}
+}
+
+btCollisionDispatcherMt::~btCollisionDispatcherMt()
+{
+	releaseCachedBlocks();
+}
+
+void* btCollisionDispatcherMt::allocateBlock(BlockCache& cache, btPoolAllocator* pool, int& overflows, bool allowHeap)
+{
+	ThreadFreeList& list = cache.m_threadLists[currentThreadListIndex()];
+	if (NULL == list.m_head && !allowHeap)
+	{
+		// without the heap the pool is all there is, do not park free blocks where other threads cannot reach them
+		return pool->allocate(pool->getElementSize());
+	}
+	if (NULL == list.m_head)
+	{
+		// refill a batch from the pool
+		int count = 0;
+		while (count < m_cacheBatchSize)
+		{
+			void* block = pool->allocate(pool->getElementSize());
+			if (NULL == block)
+			{
+				break;
+			}
+			*(void**)block = list.m_head;
+			list.m_head = block;
+			++count;
+		}
+		list.m_count += count;
+		if (count == 0)
+		{
+			if (!allowHeap)
+			{
+				return 0;
+			}
+			// the pool is exhausted, grow from the heap. freeBlock hands the block back to the heap
+			btMutexLock(&cache.m_mutex);
+			++overflows;
+			btMutexUnlock(&cache.m_mutex);
+			return btAlignedAlloc(static_cast<size_t>(pool->getElementSize()), 16);
+		}
+	}
+	void* mem = list.m_head;
+	list.m_head = *(void**)mem;
+	--list.m_count;
+	return mem;
+}
+
+void btCollisionDispatcherMt::freeBlock(BlockCache& cache, btPoolAllocator* pool, void* ptr, bool cacheBlock)
+{
+	if (!pool->validPtr(ptr))
+	{
+		btAlignedFree(ptr);
+		return;
+	}
+	if (!cacheBlock)
+	{
+		pool->freeMemory(ptr);
+		return;
+	}
+	ThreadFreeList& list = cache.m_threadLists[currentThreadListIndex()];
+	*(void**)ptr = list.m_head;
+	list.m_head = ptr;
+	++list.m_count;
+	if (list.m_count > 2 * m_cacheBatchSize)
+	{
+		// this thread frees more than it allocates, hand a batch back to the pool
+		for (int i = 0; i < m_cacheBatchSize; ++i)
+		{
+			void* block = list.m_head;
+			list.m_head = *(void**)block;
+			pool->freeMemory(block);
+		}
+		list.m_count -= m_cacheBatchSize;
+	}
+}
+
+void btCollisionDispatcherMt::releaseBlocks(BlockCache& cache, btPoolAllocator* pool)
+{
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); ++i)
+	{
+		ThreadFreeList& list = cache.m_threadLists[i];
+		while (list.m_head)
+		{
+			void* block = list.m_head;
+			list.m_head = *(void**)block;
+			pool->freeMemory(block);
+		}
+		list.m_count = 0;
+	}
+}
+
+void btCollisionDispatcherMt::releaseCachedBlocks()
+{
+	releaseBlocks(m_manifoldCache, m_persistentManifoldPoolAllocator);
+	releaseBlocks(m_algorithmCache, m_collisionAlgorithmPoolAllocator);
 }
 
 btPersistentManifold* btCollisionDispatcherMt::getNewManifold(const btCollisionObject* body0, const btCollisionObject* body1)
@@ -41,20 +172,14 @@ btPersistentManifold* btCollisionDispatcherMt::getNewManifold(const btCollisionO
 
 	btScalar contactProcessingThreshold = btMin(body0->getContactProcessingThreshold(), body1->getContactProcessingThreshold());
 
-	void* mem = m_persistentManifoldPoolAllocator->allocate(sizeof(btPersistentManifold));
+	//on a pool memory overflow, by default we fallback to dynamically allocate memory. If we require a contiguous contact pool then assert.
+	bool allowHeap = (m_dispatcherFlags & CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION) == 0;
+	void* mem = allocateBlock(m_manifoldCache, m_persistentManifoldPoolAllocator, m_manifoldPoolOverflows, allowHeap);
 	if (NULL == mem)
 	{
-		//we got a pool memory overflow, by default we fallback to dynamically allocate memory. If we require a contiguous contact pool then assert.
-		if ((m_dispatcherFlags & CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION) == 0)
-		{
-			mem = btAlignedAlloc(sizeof(btPersistentManifold), 16);
-		}
-		else
-		{
-			btAssert(0);
-			//make sure to increase the m_defaultMaxPersistentManifoldPoolSize in the btDefaultCollisionConstructionInfo/btDefaultCollisionConfiguration
-			return 0;
-		}
+		btAssert(0);
+		//make sure to increase the m_defaultMaxPersistentManifoldPoolSize in the btDefaultCollisionConstructionInfo/btDefaultCollisionConfiguration
+		return 0;
 	}
 	btPersistentManifold* manifold = new (mem) btPersistentManifold(body0, body1, 0, contactBreakingThreshold, contactProcessingThreshold);
 	if (!m_batchUpdating)
@@ -85,13 +210,27 @@ void btCollisionDispatcherMt::releaseManifold(btPersistentManifold* manifold)
 	}
 
 	manifold->~btPersistentManifold();
-	if (m_persistentManifoldPoolAllocator->validPtr(manifold))
+	freeBlock(m_manifoldCache, m_persistentManifoldPoolAllocator, manifold, (m_dispatcherFlags & CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION) == 0);
+}
+
+void* btCollisionDispatcherMt::allocateCollisionAlgorithm(int size)
+{
+	if (size > m_collisionAlgorithmPoolAllocator->getElementSize())
 	{
-		m_persistentManifoldPoolAllocator->freeMemory(manifold);
+		// larger than any pool block, freeCollisionAlgorithm returns it to the heap
+		btMutexLock(&m_algorithmCache.m_mutex);
+		++m_algorithmPoolOverflows;
+		btMutexUnlock(&m_algorithmCache.m_mutex);
+		return btAlignedAlloc(static_cast<size_t>(size), 16);
 	}
-	else
+	return allocateBlock(m_algorithmCache, m_collisionAlgorithmPoolAllocator, m_algorithmPoolOverflows, true);
+}
+
+void btCollisionDispatcherMt::freeCollisionAlgorithm(void* ptr)
+{
+	if (ptr)
 	{
-		btAlignedFree(manifold);
+		freeBlock(m_algorithmCache, m_collisionAlgorithmPoolAllocator, ptr, true);
 	}
 }
 
@@ -119,6 +258,75 @@ struct CollisionDispatcherUpdater : public btIParallelForBody
 	}
 };
 
+///runs the items of all deferred work as one range, a task can span the end of one work and the start of the next
+struct DeferredCollisionWorkUpdater : public btIParallelForBody
+{
+	btDeferredCollisionWork* const* m_work;
+	const int* m_offsets;
+	int m_numWork;
+	const btDispatcherInfo* m_info;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		// find the last work that starts at or before iBegin
+		int lo = 0;
+		int hi = m_numWork - 1;
+		while (lo < hi)
+		{
+			int mid = (lo + hi + 1) / 2;
+			if (m_offsets[mid] <= iBegin)
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+		for (int w = lo; iBegin < iEnd; ++w)
+		{
+			int end = btMin(iEnd, m_offsets[w + 1]);
+			if (end > iBegin)
+			{
+				m_work[w]->processWorkItems(iBegin - m_offsets[w], end - m_offsets[w], *m_info);
+			}
+			iBegin = end;
+		}
+	}
+};
+
+bool btCollisionDispatcherMt::deferCollisionWork(btDeferredCollisionWork* work)
+{
+	if (!m_batchUpdating || m_processingDeferredWork)
+	{
+		return false;
+	}
+	btMutexLock(&m_deferredWorkMutex);
+	m_deferredWork.push_back(work);
+	btMutexUnlock(&m_deferredWorkMutex);
+	return true;
+}
+
+void btCollisionDispatcherMt::processDeferredWork(const btDispatcherInfo& info)
+{
+	BT_PROFILE("processDeferredWork");
+	// the order in which pairs queued their work does not matter, every item writes only to its own manifold
+	const int numWork = m_deferredWork.size();
+	m_deferredWorkOffsets.resizeNoInitialize(numWork + 1);
+	m_deferredWorkOffsets[0] = 0;
+	for (int i = 0; i < numWork; ++i)
+	{
+		m_deferredWorkOffsets[i + 1] = m_deferredWorkOffsets[i] + m_deferredWork[i]->getNumWorkItems();
+	}
+
+	DeferredCollisionWorkUpdater updater;
+	updater.m_work = &m_deferredWork[0];
+	updater.m_offsets = &m_deferredWorkOffsets[0];
+	updater.m_numWork = numWork;
+	updater.m_info = &info;
+
+	m_processingDeferredWork = true;
+	dispatcherParallelFor(0, m_deferredWorkOffsets[numWork], BT_DEFERRED_COLLISION_WORK_GRAIN_SIZE, updater);
+	m_processingDeferredWork = false;
+	m_deferredWork.resizeNoInitialize(0);
+}
+
 void btCollisionDispatcherMt::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& info, btDispatcher* dispatcher)
 {
 	int pairCount = pairCache->getNumOverlappingPairs();
@@ -133,7 +341,11 @@ void btCollisionDispatcherMt::dispatchAllCollisionPairs(btOverlappingPairCache*
 	updater.mInfo = &info;
 
 	m_batchUpdating = true;
-	btParallelFor(0, pairCount, m_grainSize, updater);
+	dispatcherParallelFor(0, pairCount, m_grainSize, updater);
+	if (m_deferredWork.size())
+	{
+		processDeferredWork(info);
+	}
 	m_batchUpdating = false;
 
 	// reconstruct the manifolds array to ensure determinism
@@ -19,18 +19,85 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
 #include "LinearMath/btThreads.h"
 
+class btPoolAllocator;
+
+///btCollisionDispatcherMt dispatches the overlapping pairs with btParallelFor, serially when no task scheduler is set.
+///Manifolds and collision algorithms are taken from per-thread free lists that are refilled in batches
+///from the pools of the collision configuration, so contact churn takes no lock in the common case.
+///A thread list holds at most two batches, the surplus goes back to the pool it came from.
+///When a pool is exhausted blocks come from the heap and are freed directly, see getManifoldPoolOverflows.
+///With CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION manifolds bypass the thread lists, so that every free block of the
+///pool stays available to all threads. Set the flag before stepping, or call releaseCachedBlocks after setting it.
 class btCollisionDispatcherMt : public btCollisionDispatcher
 {
 public:
 	btCollisionDispatcherMt(btCollisionConfiguration* config, int grainSize = 40);
 
+	///returns the cached blocks to the pools, so the collision configuration must be deleted after the dispatcher
+	virtual ~btCollisionDispatcherMt();
+
 	virtual btPersistentManifold* getNewManifold(const btCollisionObject* body0, const btCollisionObject* body1) BT_OVERRIDE;
 	virtual void releaseManifold(btPersistentManifold* manifold) BT_OVERRIDE;
 
+	virtual void* allocateCollisionAlgorithm(int size) BT_OVERRIDE;
+	virtual void freeCollisionAlgorithm(void* ptr) BT_OVERRIDE;
+
 	virtual void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& info, btDispatcher* dispatcher) BT_OVERRIDE;
 
+	virtual bool isConcurrentDispatchAllowed() const BT_OVERRIDE
+	{
+		// manifolds and algorithms come from per-thread free lists, and the manifold array is rebuilt after a batch update
+		return m_batchUpdating && !m_processingDeferredWork;
+	}
+
+	///the deferred work of all pairs is processed in one btParallelFor after the pairs, so it is never nested in the loop over the pairs
+	virtual bool deferCollisionWork(btDeferredCollisionWork* work) BT_OVERRIDE;
+
+	///number of blocks moved between a thread free list and the shared pools at once
+	void setCacheBatchSize(int batchSize)
+	{
+		m_cacheBatchSize = btMax(1, batchSize);
+	}
+
+	int getCacheBatchSize() const
+	{
+		return m_cacheBatchSize;
+	}
+
+	///return the blocks held by the thread free lists to the pools, so that their used counts only
+	///include live manifolds and algorithms. Must not be called while pairs are dispatched
+	void releaseCachedBlocks();
+
 protected:
+	struct ThreadFreeList
+	{
+		void* m_head;
+		int m_count;
+		// keep the lists of different threads on different cache lines
+		char m_padding[64 - sizeof(void*) - sizeof(int)];
+	};
+
+	struct BlockCache
+	{
+		ThreadFreeList m_threadLists[BT_MAX_THREAD_COUNT];
+		// protects the overflow counters
+		btSpinMutex m_mutex;
+	};
+
+	void* allocateBlock(BlockCache& cache, btPoolAllocator* pool, int& overflows, bool allowHeap);
+	void freeBlock(BlockCache& cache, btPoolAllocator* pool, void* ptr, bool cacheBlock);
+	void releaseBlocks(BlockCache& cache, btPoolAllocator* pool);
+
+	void processDeferredWork(const btDispatcherInfo& info);
+
+	BlockCache m_manifoldCache;
+	BlockCache m_algorithmCache;
+	btAlignedObjectArray<btDeferredCollisionWork*> m_deferredWork;
+	btAlignedObjectArray<int> m_deferredWorkOffsets;
+	btSpinMutex m_deferredWorkMutex;
+	int m_cacheBatchSize;
 	bool m_batchUpdating;
+	bool m_processingDeferredWork;
 	int m_grainSize;
 };
 
@@ -33,6 +33,7 @@ subject to the following restrictions:
 #include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btQuickprof.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btAllocatorContext.h"
 #include "BulletCollision/CollisionShapes/btConvexPolyhedron.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 
@@ -67,7 +68,8 @@ btCollisionWorld::btCollisionWorld(btDispatcher* dispatcher, btBroadphaseInterfa
 	: m_dispatcher1(dispatcher),
 	  m_broadphasePairCache(pairCache),
 	  m_debugDrawer(0),
-	  m_forceUpdateAllAabbs(true)
+	  m_forceUpdateAllAabbs(true),
+	  m_allocatorContext(btGetCurrentAllocatorContext())
 {
 }
 
@@ -123,6 +125,7 @@ void btCollisionWorld::refreshBroadphaseProxy(btCollisionObject* collisionObject
 void btCollisionWorld::addCollisionObject(btCollisionObject* collisionObject, int collisionFilterGroup, int collisionFilterMask)
 {
 	btAssert(collisionObject);
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 
 	//check that the object isn't already added
 	btAssert(m_collisionObjects.findLinearSearch(collisionObject) == m_collisionObjects.size());
@@ -220,6 +223,7 @@ void btCollisionWorld::computeOverlappingPairs()
 void btCollisionWorld::performDiscreteCollisionDetection()
 {
 	BT_PROFILE("performDiscreteCollisionDetection");
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 
 	btDispatcherInfo& dispatchInfo = getDispatchInfo();
 
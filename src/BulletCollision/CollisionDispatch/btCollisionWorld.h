@@ -73,6 +73,7 @@ class btCollisionShape;
 class btConvexShape;
 class btBroadphaseInterface;
 class btSerializer;
+class btAllocatorContext;
 
 #include "LinearMath/btVector3.h"
 #include "LinearMath/btTransform.h"
@@ -99,12 +100,15 @@ protected:
 	///it is true by default, because it is error-prone (setting the position of static objects wouldn't update their AABB)
 	bool m_forceUpdateAllAabbs;
 
+	btAllocatorContext* m_allocatorContext;
+
 	void serializeCollisionObjects(btSerializer* serializer);
 
 	void serializeContactManifolds(btSerializer* serializer);
 
 public:
 	//this constructor doesn't own the dispatcher and paircache/broadphase
+	//the world keeps the allocator context that is current on the calling thread, see setAllocatorContext
 	btCollisionWorld(btDispatcher* dispatcher, btBroadphaseInterface* broadphasePairCache, btCollisionConfiguration* collisionConfiguration);
 
 	virtual ~btCollisionWorld();
@@ -506,6 +510,20 @@ public:
 		m_forceUpdateAllAabbs = forceUpdateAllAabbs;
 	}
 
+	///the world makes its allocator context current while it adds objects and runs collision detection or
+	///simulation steps, so everything it allocates there comes from the context. Create the configuration,
+	///dispatcher, broadphase, solver, shapes and world inside a btAllocatorContextScope to allocate them
+	///from the same context. 0 uses the allocator context of the calling thread
+	void setAllocatorContext(btAllocatorContext* allocatorContext)
+	{
+		m_allocatorContext = allocatorContext;
+	}
+
+	btAllocatorContext* getAllocatorContext() const
+	{
+		return m_allocatorContext;
+	}
+
 	///Preliminary serialization test for Bullet 2.76. Loading those files requires a separate parser (Bullet/Demos/SerializeDemo)
 	virtual void serialize(btSerializer* serializer);
 };
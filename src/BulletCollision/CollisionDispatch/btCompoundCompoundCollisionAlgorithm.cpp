@@ -29,6 +29,8 @@ subject to the following restrictions:
 
 btShapePairCallback gCompoundCompoundChildShapePairCallback = 0;
 
+int gCompoundCompoundParallelChildPairThreshold = 64;
+
 btCompoundCompoundCollisionAlgorithm::btCompoundCompoundCollisionAlgorithm(const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool isSwapped)
 	: btCompoundCollisionAlgorithm(ci, body0Wrap, body1Wrap, isSwapped)
 {
@@ -100,14 +102,18 @@ struct btCompoundCompoundLeafCallback : btDbvt::ICollide
 
 	btPersistentManifold* m_sharedManifold;
 
+	///when set, overlapping child pairs and their algorithms are only gathered here, and processed afterwards (possibly in parallel)
+	btSimplePairArray* m_gatheredChildPairs;
+
 	btCompoundCompoundLeafCallback(const btCollisionObjectWrapper* compound1ObjWrap,
 								   const btCollisionObjectWrapper* compound0ObjWrap,
 								   btDispatcher* dispatcher,
 								   const btDispatcherInfo& dispatchInfo,
 								   btManifoldResult* resultOut,
 								   btHashedSimplePairCache* childAlgorithmsCache,
-								   btPersistentManifold* sharedManifold)
-		: m_numOverlapPairs(0), m_compound0ColObjWrap(compound1ObjWrap), m_compound1ColObjWrap(compound0ObjWrap), m_dispatcher(dispatcher), m_dispatchInfo(dispatchInfo), m_resultOut(resultOut), m_childCollisionAlgorithmCache(childAlgorithmsCache), m_sharedManifold(sharedManifold)
+								   btPersistentManifold* sharedManifold,
+								   btSimplePairArray* gatheredChildPairs = 0)
+		: m_numOverlapPairs(0), m_compound0ColObjWrap(compound1ObjWrap), m_compound1ColObjWrap(compound0ObjWrap), m_dispatcher(dispatcher), m_dispatchInfo(dispatchInfo), m_resultOut(resultOut), m_childCollisionAlgorithmCache(childAlgorithmsCache), m_sharedManifold(sharedManifold), m_gatheredChildPairs(gatheredChildPairs)
 	{
 	}
 
@@ -186,6 +192,15 @@ struct btCompoundCompoundLeafCallback : btDbvt::ICollide
 
 			btAssert(colAlgo);
 
+			if (m_gatheredChildPairs)
+			{
+				btAssert(!removePair);
+				btSimplePair gathered(childIndex0, childIndex1);
+				gathered.m_userPointer = colAlgo;
+				m_gatheredChildPairs->push_back(gathered);
+				return;
+			}
+
 			const btCollisionObjectWrapper* tmpWrap0 = 0;
 			const btCollisionObjectWrapper* tmpWrap1 = 0;
 
@@ -212,6 +227,34 @@ struct btCompoundCompoundLeafCallback : btDbvt::ICollide
 	}
 };
 
+void btCompoundCompoundChildPairWork::processWorkItems(int iBegin, int iEnd, const btDispatcherInfo& dispatchInfo) const
+{
+	const btCompoundShape* compoundShape0 = static_cast<const btCompoundShape*>(m_shape0);
+	const btCompoundShape* compoundShape1 = static_cast<const btCompoundShape*>(m_shape1);
+	btCollisionObjectWrapper compoundObjWrap0(0, m_shape0, m_body0, m_worldTrans0, -1, -1);
+	btCollisionObjectWrapper compoundObjWrap1(0, m_shape1, m_body1, m_worldTrans1, -1, -1);
+
+	for (int i = iBegin; i < iEnd; ++i)
+	{
+		const btSimplePair& pair = m_childPairs[i];
+		int childIndex0 = pair.m_indexA;
+		int childIndex1 = pair.m_indexB;
+		btCollisionAlgorithm* colAlgo = (btCollisionAlgorithm*)pair.m_userPointer;
+
+		btTransform newChildWorldTrans0 = m_worldTrans0 * compoundShape0->getChildTransform(childIndex0);
+		btTransform newChildWorldTrans1 = m_worldTrans1 * compoundShape1->getChildTransform(childIndex1);
+
+		btCollisionObjectWrapper compoundWrap0(&compoundObjWrap0, compoundShape0->getChildShape(childIndex0), m_body0, newChildWorldTrans0, -1, childIndex0);
+		btCollisionObjectWrapper compoundWrap1(&compoundObjWrap1, compoundShape1->getChildShape(childIndex1), m_body1, newChildWorldTrans1, -1, childIndex1);
+
+		btManifoldResult childResult(&compoundWrap0, &compoundWrap1);
+		childResult.setShapeIdentifiersA(-1, childIndex0);
+		childResult.setShapeIdentifiersB(-1, childIndex1);
+
+		colAlgo->processCollision(&compoundWrap0, &compoundWrap1, dispatchInfo, &childResult);
+	}
+}
+
 static DBVT_INLINE bool MyIntersect(const btDbvtAabbMm& a,
 									const btDbvtAabbMm& b, const btTransform& xform, btScalar distanceThreshold)
 {
@@ -339,11 +382,35 @@ void btCompoundCompoundCollisionAlgorithm::processCollision(const btCollisionObj
 		}
 	}
 
-	btCompoundCompoundLeafCallback callback(col0ObjWrap, col1ObjWrap, this->m_dispatcher, dispatchInfo, resultOut, this->m_childCollisionAlgorithmCache, m_sharedManifold);
+	///with a dispatcher that allows concurrent dispatch, the overlapping child pairs are only gathered while the trees are walked,
+	///which creates the child algorithms serially so the pair cache stays deterministic. A large batch is handed to the dispatcher,
+	///which processes the child pairs of all compound pairs in one parallel loop once every pair has been dispatched.
+	///The gathered pairs pass the aabb test below, so their algorithms stay alive until then
+	const bool gatherChildPairs = m_dispatcher->isConcurrentDispatchAllowed() && (resultOut->m_closestPointDistanceThreshold == btScalar(0)) &&
+								  !col0ObjWrap->m_parent && !col1ObjWrap->m_parent;
+	btSimplePairArray& childPairs = m_childPairWork.m_childPairs;
+	childPairs.resizeNoInitialize(0);
+
+	btCompoundCompoundLeafCallback callback(col0ObjWrap, col1ObjWrap, this->m_dispatcher, dispatchInfo, resultOut, this->m_childCollisionAlgorithmCache, m_sharedManifold, gatherChildPairs ? &childPairs : 0);
 
 	const btTransform xform = col0ObjWrap->getWorldTransform().inverse() * col1ObjWrap->getWorldTransform();
 	MycollideTT(tree0->m_root, tree1->m_root, xform, &callback, resultOut->m_closestPointDistanceThreshold);
 
+	if (childPairs.size())
+	{
+		m_childPairWork.m_body0 = col0ObjWrap->getCollisionObject();
+		m_childPairWork.m_body1 = col1ObjWrap->getCollisionObject();
+		m_childPairWork.m_shape0 = compoundShape0;
+		m_childPairWork.m_shape1 = compoundShape1;
+		m_childPairWork.m_worldTrans0 = col0ObjWrap->getWorldTransform();
+		m_childPairWork.m_worldTrans1 = col1ObjWrap->getWorldTransform();
+		if (childPairs.size() < gCompoundCompoundParallelChildPairThreshold || !m_dispatcher->deferCollisionWork(&m_childPairWork))
+		{
+			BT_PROFILE("btCompoundCompoundCollisionAlgorithm::processChildPairs");
+			m_childPairWork.processWorkItems(0, childPairs.size(), dispatchInfo);
+		}
+	}
+
 	//printf("#compound-compound child/leaf overlap =%d                      \r",callback.m_numOverlapPairs);
 
 	//remove non-overlapping child pairs
@@ -36,11 +36,36 @@ class btCollisionShape;
 
 extern btShapePairCallback gCompoundCompoundChildShapePairCallback;
 
+///minimum number of overlapping child pairs before the child-vs-child narrowphase of a single compound pair is handed to the dispatcher,
+///which processes the child pairs of all compound pairs in one parallel loop. See btDispatcher::deferCollisionWork
+extern int gCompoundCompoundParallelChildPairThreshold;
+
+///the overlapping child pairs of a compound pair, with the compound objects they belong to. Each child algorithm owns its
+///contact manifold, so disjoint ranges of child pairs can be processed by different threads
+struct btCompoundCompoundChildPairWork : public btDeferredCollisionWork
+{
+	btSimplePairArray m_childPairs;
+	const btCollisionObject* m_body0;
+	const btCollisionObject* m_body1;
+	const btCollisionShape* m_shape0;
+	const btCollisionShape* m_shape1;
+	btTransform m_worldTrans0;
+	btTransform m_worldTrans1;
+
+	virtual int getNumWorkItems() const
+	{
+		return m_childPairs.size();
+	}
+
+	virtual void processWorkItems(int iBegin, int iEnd, const btDispatcherInfo& dispatchInfo) const;
+};
+
 /// btCompoundCompoundCollisionAlgorithm  supports collision between two btCompoundCollisionShape shapes
 class btCompoundCompoundCollisionAlgorithm : public btCompoundCollisionAlgorithm
 {
 	class btHashedSimplePairCache* m_childCollisionAlgorithmCache;
 	btSimplePairArray m_removePairs;
+	btCompoundCompoundChildPairWork m_childPairWork;
 
 	int m_compoundShapeRevision0;  //to keep track of changes, so that childAlgorithm array can be updated
 	int m_compoundShapeRevision1;
@@ -27,6 +27,7 @@ subject to the following restrictions:
 #include "BulletCollision/NarrowPhaseCollision/btSubSimplexConvexCast.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 #include "BulletCollision/CollisionShapes/btSdfCollisionShape.h"
+#include "LinearMath/btFrameArena.h"
 
 btConvexConcaveCollisionAlgorithm::btConvexConcaveCollisionAlgorithm(const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool isSwapped)
 	: btActivatingCollisionAlgorithm(ci, body0Wrap, body1Wrap),
@@ -196,6 +197,10 @@ void btConvexConcaveCollisionAlgorithm::processCollision(const btCollisionObject
 				if (convex->isPolyhedral())
 				{
 					btPolyhedralConvexShape* poly = (btPolyhedralConvexShape*)convex;
+					if (dispatchInfo.m_frameArena)
+					{
+						dispatchInfo.m_frameArena->initializeArray(queryVertices, poly->getNumVertices());
+					}
 					for (int v = 0; v < poly->getNumVertices(); v++)
 					{
 						btVector3 vtx;
@@ -28,6 +28,10 @@ struct btDefaultCollisionConstructionInfo
 	int m_defaultMaxCollisionAlgorithmPoolSize;
 	int m_customCollisionAlgorithmMaxElementSize;
 	int m_useEpaPenetrationAlgorithm;
+	///when set, the default pools add slabs when they are exhausted instead of falling back to the heap for each element,
+	///so the default sizes above are only the initial sizes. See btPoolAllocator::shrink and getHighWaterMark.
+	///Off by default, CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION and the pool overflow counters expect fixed size pools
+	bool m_useGrowablePools;
 
 	btDefaultCollisionConstructionInfo()
 		: m_persistentManifoldPool(0),
@@ -35,7 +39,8 @@ struct btDefaultCollisionConstructionInfo
 		  m_defaultMaxPersistentManifoldPoolSize(4096),
 		  m_defaultMaxCollisionAlgorithmPoolSize(4096),
 		  m_customCollisionAlgorithmMaxElementSize(0),
-		  m_useEpaPenetrationAlgorithm(true)
+		  m_useEpaPenetrationAlgorithm(true),
+		  m_useGrowablePools(false)
 	{
 	}
 };
@@ -0,0 +1,235 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btTriggerManager.h"
+#include "btCollisionWorld.h"
+#include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+#include "BulletCollision/BroadphaseCollision/btCollisionAlgorithm.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+
+class btTriggerOverlapSortPredicate
+{
+public:
+	SIMD_FORCE_INLINE bool operator()(const btTriggerOverlap& a, const btTriggerOverlap& b) const
+	{
+		if (a.m_triggerUid != b.m_triggerUid)
+			return a.m_triggerUid < b.m_triggerUid;
+		if (a.m_objectUid != b.m_objectUid)
+			return a.m_objectUid < b.m_objectUid;
+		//the broadphase can reuse the unique id of a removed proxy, the objects tell such overlaps apart
+		if (a.m_trigger != b.m_trigger)
+			return size_t(a.m_trigger) < size_t(b.m_trigger);
+		return size_t(a.m_object) < size_t(b.m_object);
+	}
+};
+
+static bool btTriggerPairHasContact(const btBroadphasePair* pair, btManifoldArray& manifoldArray)
+{
+	if (!pair->m_algorithm)
+		return false;
+
+	manifoldArray.resize(0);
+	pair->m_algorithm->getAllContactManifolds(manifoldArray);
+	for (int m = 0; m < manifoldArray.size(); m++)
+	{
+		const btPersistentManifold* manifold = manifoldArray[m];
+		for (int p = 0; p < manifold->getNumContacts(); p++)
+		{
+			if (manifold->getContactPoint(p).getDistance() <= btScalar(0.))
+				return true;
+		}
+	}
+	return false;
+}
+
+struct btTriggerConfirmationLoop : public btIParallelForBody
+{
+	const btBroadphasePair* const* m_pairs;
+	int* m_confirmed;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		btManifoldArray manifoldArray;
+		btPersistentManifold* localManifolds[4];
+		manifoldArray.initializeFromBuffer(&localManifolds, 0, 4);
+
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			m_confirmed[i] = btTriggerPairHasContact(m_pairs[i], manifoldArray) ? 1 : 0;
+		}
+	}
+};
+
+btTriggerManager::btTriggerManager()
+	: m_narrowphaseConfirmation(false),
+	  m_confirmationGrainSize(64)
+{
+}
+
+btTriggerManager::~btTriggerManager()
+{
+}
+
+void btTriggerManager::addTrigger(btCollisionObject* trigger)
+{
+	if (isTrigger(trigger))
+		return;
+	m_triggerIndices.insert(trigger, m_triggers.size());
+	m_triggers.push_back(trigger);
+}
+
+void btTriggerManager::removeTrigger(btCollisionObject* trigger)
+{
+	const int* indexPtr = m_triggerIndices.find(trigger);
+	if (!indexPtr)
+		return;
+
+	int index = *indexPtr;
+	m_triggerIndices.remove(trigger);
+	m_triggers.swap(index, m_triggers.size() - 1);
+	m_triggers.pop_back();
+	if (index < m_triggers.size())
+	{
+		m_triggerIndices.insert(m_triggers[index], index);
+	}
+
+	//drop the overlaps of this trigger, so no exit events are reported for it
+	int numOverlaps = 0;
+	for (int i = 0; i < m_overlaps.size(); i++)
+	{
+		if (m_overlaps[i].m_trigger != trigger)
+		{
+			m_overlaps[numOverlaps++] = m_overlaps[i];
+		}
+	}
+	m_overlaps.resize(numOverlaps);
+}
+
+void btTriggerManager::gatherOverlaps(btCollisionWorld* world)
+{
+	m_overlaps.resize(0);
+	m_overlapPairs.resize(0);
+
+	btOverlappingPairCache* pairCache = world->getPairCache();
+	int numPairs = pairCache->getNumOverlappingPairs();
+	if (!numPairs || !m_triggers.size())
+		return;
+
+	const btBroadphasePair* pairs = pairCache->getOverlappingPairArrayPtr();
+	for (int i = 0; i < numPairs; i++)
+	{
+		const btBroadphasePair& pair = pairs[i];
+		btCollisionObject* colObj0 = (btCollisionObject*)pair.m_pProxy0->m_clientObject;
+		btCollisionObject* colObj1 = (btCollisionObject*)pair.m_pProxy1->m_clientObject;
+
+		if (isTrigger(colObj0))
+		{
+			btTriggerOverlap& overlap = m_overlaps.expandNonInitializing();
+			overlap.m_trigger = colObj0;
+			overlap.m_object = colObj1;
+			overlap.m_triggerUid = pair.m_pProxy0->m_uniqueId;
+			overlap.m_objectUid = pair.m_pProxy1->m_uniqueId;
+			m_overlapPairs.push_back(&pair);
+		}
+		if (isTrigger(colObj1))
+		{
+			btTriggerOverlap& overlap = m_overlaps.expandNonInitializing();
+			overlap.m_trigger = colObj1;
+			overlap.m_object = colObj0;
+			overlap.m_triggerUid = pair.m_pProxy1->m_uniqueId;
+			overlap.m_objectUid = pair.m_pProxy0->m_uniqueId;
+			m_overlapPairs.push_back(&pair);
+		}
+	}
+}
+
+void btTriggerManager::confirmOverlaps()
+{
+	BT_PROFILE("btTriggerManager::confirmOverlaps");
+	int numOverlaps = m_overlaps.size();
+	if (!numOverlaps)
+		return;
+
+	m_confirmed.resize(numOverlaps);
+
+	btTriggerConfirmationLoop loop;
+	loop.m_pairs = &m_overlapPairs[0];
+	loop.m_confirmed = &m_confirmed[0];
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		btParallelFor(0, numOverlaps, m_confirmationGrainSize, loop);
+	}
+	else
+	{
+		loop.forLoop(0, numOverlaps);
+	}
+#else
+	loop.forLoop(0, numOverlaps);
+#endif
+
+	int numConfirmed = 0;
+	for (int i = 0; i < numOverlaps; i++)
+	{
+		if (m_confirmed[i])
+		{
+			m_overlaps[numConfirmed++] = m_overlaps[i];
+		}
+	}
+	m_overlaps.resize(numConfirmed);
+}
+
+void btTriggerManager::updateTriggers(btCollisionWorld* world)
+{
+	BT_PROFILE("btTriggerManager::updateTriggers");
+
+	m_previousOverlaps = m_overlaps;
+	m_enterEvents.resize(0);
+	m_exitEvents.resize(0);
+
+	gatherOverlaps(world);
+
+	if (m_narrowphaseConfirmation)
+	{
+		confirmOverlaps();
+	}
+	m_overlapPairs.resize(0);
+
+	btTriggerOverlapSortPredicate less;
+	m_overlaps.quickSort(less);
+
+	//both arrays are sorted, so the enter and exit events follow from a single merge pass
+	int i = 0;
+	int j = 0;
+	while (i < m_overlaps.size() || j < m_previousOverlaps.size())
+	{
+		if (j == m_previousOverlaps.size() || (i < m_overlaps.size() && less(m_overlaps[i], m_previousOverlaps[j])))
+		{
+			m_enterEvents.push_back(m_overlaps[i++]);
+		}
+		else if (i == m_overlaps.size() || less(m_previousOverlaps[j], m_overlaps[i]))
+		{
+			m_exitEvents.push_back(m_previousOverlaps[j++]);
+		}
+		else
+		{
+			//still overlapping
+			i++;
+			j++;
+		}
+	}
+}
@@ -0,0 +1,142 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_TRIGGER_MANAGER_H
+#define BT_TRIGGER_MANAGER_H
+
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btHashMap.h"
+
+class btCollisionObject;
+class btCollisionWorld;
+struct btBroadphasePair;
+
+///btTriggerOverlap is an overlap between a trigger and another collision object, it is also used for the enter and exit events
+struct btTriggerOverlap
+{
+	btCollisionObject* m_trigger;
+	btCollisionObject* m_object;
+	///broadphase proxy unique ids, used to keep the overlaps sorted in a deterministic order.
+	///Overlaps are identified by the ids together with the objects, because the broadphase can reuse the id of a removed proxy.
+	int m_triggerUid;
+	int m_objectUid;
+};
+
+///The btTriggerManager reports objects entering and leaving trigger volumes (sensors).
+///Unlike btPairCachingGhostObject it does not keep a pair cache per trigger and does not need a btGhostPairCallback:
+///the overlaps are collected from the broadphase pair array in a single pass after collision detection,
+///and compared against the overlaps of the previous update to generate the events.
+///A trigger is a regular btCollisionObject, typically with the CF_NO_CONTACT_RESPONSE flag set.
+///Call updateTriggers after btCollisionWorld::performDiscreteCollisionDetection, or after stepSimulation.
+///Exit events for objects that were removed from the world refer to the removed object, so read them before deleting objects.
+class btTriggerManager
+{
+protected:
+	btAlignedObjectArray<btCollisionObject*> m_triggers;
+	btHashMap<btHashPtr, int> m_triggerIndices;
+
+	btAlignedObjectArray<btTriggerOverlap> m_overlaps;
+	btAlignedObjectArray<btTriggerOverlap> m_previousOverlaps;
+	btAlignedObjectArray<btTriggerOverlap> m_enterEvents;
+	btAlignedObjectArray<btTriggerOverlap> m_exitEvents;
+
+	///broadphase pairs and narrowphase results of the current overlaps, only used during updateTriggers
+	btAlignedObjectArray<const btBroadphasePair*> m_overlapPairs;
+	btAlignedObjectArray<int> m_confirmed;
+
+	bool m_narrowphaseConfirmation;
+	int m_confirmationGrainSize;
+
+	void gatherOverlaps(btCollisionWorld* world);
+	void confirmOverlaps();
+
+public:
+	btTriggerManager();
+
+	virtual ~btTriggerManager();
+
+	void addTrigger(btCollisionObject* trigger);
+
+	///removes the trigger and its overlaps, without generating exit events
+	void removeTrigger(btCollisionObject* trigger);
+
+	int getNumTriggers() const
+	{
+		return m_triggers.size();
+	}
+
+	btCollisionObject* getTrigger(int index)
+	{
+		return m_triggers[index];
+	}
+
+	bool isTrigger(const btCollisionObject* colObj) const
+	{
+		return m_triggerIndices.find(colObj) != 0;
+	}
+
+	///by default an overlap is based on the broadphase AABB. With narrowphase confirmation enabled, an overlap only counts
+	///when the collision algorithm of the pair has a contact point with non-positive distance. The confirmation of all
+	///candidate overlaps runs as a btParallelFor in BT_THREADSAFE builds with a task scheduler, and serially otherwise.
+	void setNarrowphaseConfirmation(bool confirm)
+	{
+		m_narrowphaseConfirmation = confirm;
+	}
+
+	bool getNarrowphaseConfirmation() const
+	{
+		return m_narrowphaseConfirmation;
+	}
+
+	void setConfirmationGrainSize(int grainSize)
+	{
+		m_confirmationGrainSize = grainSize;
+	}
+
+	///computes the current overlaps from the broadphase pair array, and the enter/exit events relative to the previous update
+	void updateTriggers(btCollisionWorld* world);
+
+	int getNumOverlaps() const
+	{
+		return m_overlaps.size();
+	}
+
+	const btTriggerOverlap& getOverlap(int index) const
+	{
+		return m_overlaps[index];
+	}
+
+	int getNumEnterEvents() const
+	{
+		return m_enterEvents.size();
+	}
+
+	const btTriggerOverlap& getEnterEvent(int index) const
+	{
+		return m_enterEvents[index];
+	}
+
+	int getNumExitEvents() const
+	{
+		return m_exitEvents.size();
+	}
+
+	const btTriggerOverlap& getExitEvent(int index) const
+	{
+		return m_exitEvents[index];
+	}
+};
+
+#endif  //BT_TRIGGER_MANAGER_H
@@ -100,7 +100,38 @@ void btCompoundShape::updateChildTransform(int childIndex, const btTransform& ne
 
 	if (shouldRecalculateLocalAabb)
 	{
-		recalculateLocalAabb();
+		updateLocalAabb();
+	}
+}
+
+void btCompoundShape::updateChildTransforms(int numChildren, const int* childIndices, const btTransform* newChildTransforms, bool shouldRecalculateLocalAabb)
+{
+	for (int i = 0; i < numChildren; i++)
+	{
+		btAssert(childIndices[i] >= 0 && childIndices[i] < m_children.size());
+		btCompoundShapeChild& child = m_children[childIndices[i]];
+		child.m_transform = newChildTransforms[i];
+		setChildLeafVolume(child);
+	}
+
+	if (m_dynamicAabbTree)
+	{
+		m_dynamicAabbTree->refit();
+	}
+
+	if (shouldRecalculateLocalAabb)
+	{
+		updateLocalAabb();
+	}
+}
+
+void btCompoundShape::setChildLeafVolume(btCompoundShapeChild& child)
+{
+	if (m_dynamicAabbTree)
+	{
+		btVector3 localAabbMin, localAabbMax;
+		child.m_childShape->getAabb(child.m_transform, localAabbMin, localAabbMax);
+		child.m_node->volume = btDbvtVolume::FromMM(localAabbMin, localAabbMax);
 	}
 }
 
@@ -116,6 +147,10 @@ void btCompoundShape::removeChildShapeByIndex(int childShapeIndex)
 	if (m_dynamicAabbTree)
 		m_children[childShapeIndex].m_node->dataAsInt = childShapeIndex;
 	m_children.pop_back();
+
+	//the tree root already bounds the remaining children, so keeping the local aabb tight is cheap
+	if (m_dynamicAabbTree)
+		updateLocalAabb();
 }
 
 void btCompoundShape::removeChildShape(btCollisionShape* shape)
@@ -131,7 +166,7 @@ void btCompoundShape::removeChildShape(btCollisionShape* shape)
 		}
 	}
 
-	recalculateLocalAabb();
+	updateLocalAabb();
 }
 
 void btCompoundShape::recalculateLocalAabb()
@@ -157,6 +192,26 @@ void btCompoundShape::recalculateLocalAabb()
 	}
 }
 
+void btCompoundShape::updateLocalAabb()
+{
+	if (!m_dynamicAabbTree)
+	{
+		recalculateLocalAabb();
+		return;
+	}
+
+	if (m_dynamicAabbTree->m_root)
+	{
+		m_localAabbMin = m_dynamicAabbTree->m_root->volume.Mins();
+		m_localAabbMax = m_dynamicAabbTree->m_root->volume.Maxs();
+	}
+	else
+	{
+		m_localAabbMin = btVector3(btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT), btScalar(BT_LARGE_FLOAT));
+		m_localAabbMax = btVector3(btScalar(-BT_LARGE_FLOAT), btScalar(-BT_LARGE_FLOAT), btScalar(-BT_LARGE_FLOAT));
+	}
+}
+
 ///getAabb's default implementation is brute force, expected derived classes to implement a fast dedicated version
 void btCompoundShape::getAabb(const btTransform& trans, btVector3& aabbMin, btVector3& aabbMax) const
 {
@@ -269,11 +324,17 @@ void btCompoundShape::setLocalScaling(const btVector3& scaling)
 		childScale = childScale * scaling / m_localScaling;
 		m_children[i].m_childShape->setLocalScaling(childScale);
 		childTrans.setOrigin((childTrans.getOrigin()) * scaling / m_localScaling);
-		updateChildTransform(i, childTrans, false);
+		m_children[i].m_transform = childTrans;
+		setChildLeafVolume(m_children[i]);
+	}
+
+	if (m_dynamicAabbTree)
+	{
+		m_dynamicAabbTree->refit();
 	}
 
 	m_localScaling = scaling;
-	recalculateLocalAabb();
+	updateLocalAabb();
 }
 
 void btCompoundShape::createAabbTreeFromChildren()
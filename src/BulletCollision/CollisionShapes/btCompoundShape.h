@@ -69,6 +69,12 @@ protected:
 
 	btVector3 m_localScaling;
 
+	///update the cached local aabb, using the root of the dynamic aabb tree when available instead of iterating over all children
+	void updateLocalAabb();
+
+	///set the leaf volume of a child in the dynamic aabb tree without changing the tree topology, requires a refit of the tree afterwards
+	void setChildLeafVolume(btCompoundShapeChild & child);
+
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
 
@@ -109,6 +115,11 @@ public:
 	///set a new transform for a child, and update internal data structures (local aabb and dynamic tree)
 	void updateChildTransform(int childIndex, const btTransform& newChildTransform, bool shouldRecalculateLocalAabb = true);
 
+	///set new transforms for a batch of children. The leaves of the dynamic aabb tree are updated in place and the tree is refitted once,
+	///which is much cheaper than calling updateChildTransform for each child of a large compound. The tree topology is not changed,
+	///so call getDynamicAabbTree()->optimizeIncremental occasionally when children move far from their original location.
+	void updateChildTransforms(int numChildren, const int* childIndices, const btTransform* newChildTransforms, bool shouldRecalculateLocalAabb = true);
+
 	btCompoundShapeChild* getChildList()
 	{
 		return &m_children[0];
@@ -126,36 +126,41 @@ SIMD_FORCE_INLINE const char* btTriangleInfoMap::serialize(void* dataBuffer, btS
 	tmapData->m_edgeDistanceThreshold = (float)m_edgeDistanceThreshold;
 	tmapData->m_zeroAreaThreshold = (float)m_zeroAreaThreshold;
 
-	tmapData->m_hashTableSize = m_hashTable.size();
-
-	tmapData->m_hashTablePtr = tmapData->m_hashTableSize ? (int*)serializer->getUniquePointer((void*)&m_hashTable[0]) : 0;
-	if (tmapData->m_hashTablePtr)
+	// the open addressing index is rebuilt on load, older versions read this chained index with a
+	// bucket per pair, like their own btHashMap after resizing the arrays to the number of pairs
+	const int numBuckets = m_keyArray.size();
+	tmapData->m_hashTableSize = numBuckets;
+	tmapData->m_nextSize = numBuckets;
+	tmapData->m_hashTablePtr = numBuckets ? (int*)serializer->getUniquePointer((void*)&m_hashTable[0]) : 0;
+	tmapData->m_nextPtr = numBuckets ? (int*)serializer->getUniquePointer((void*)&m_hashValues[0]) : 0;
+	if (numBuckets)
 	{
-		//serialize an int buffer
-		int sz = sizeof(int);
-		int numElem = tmapData->m_hashTableSize;
-		btChunk* chunk = serializer->allocate(sz, numElem);
+		btAlignedObjectArray<int> buckets;
+		btAlignedObjectArray<int> next;
+		buckets.resize(numBuckets, BT_HASH_NULL);
+		next.resize(numBuckets);
+		for (int i = 0; i < numBuckets; i++)
+		{
+			int bucket = m_hashValues[i] & (numBuckets - 1);
+			next[i] = buckets[bucket];
+			buckets[bucket] = i;
+		}
+
+		btChunk* chunk = serializer->allocate(sizeof(int), numBuckets);
 		int* memPtr = (int*)chunk->m_oldPtr;
-		for (int i = 0; i < numElem; i++, memPtr++)
+		for (int i = 0; i < numBuckets; i++, memPtr++)
 		{
-			*memPtr = m_hashTable[i];
+			*memPtr = buckets[i];
 		}
 		serializer->finalizeChunk(chunk, "int", BT_ARRAY_CODE, (void*)&m_hashTable[0]);
-	}
 
-	tmapData->m_nextSize = m_next.size();
-	tmapData->m_nextPtr = tmapData->m_nextSize ? (int*)serializer->getUniquePointer((void*)&m_next[0]) : 0;
-	if (tmapData->m_nextPtr)
-	{
-		int sz = sizeof(int);
-		int numElem = tmapData->m_nextSize;
-		btChunk* chunk = serializer->allocate(sz, numElem);
-		int* memPtr = (int*)chunk->m_oldPtr;
-		for (int i = 0; i < numElem; i++, memPtr++)
+		chunk = serializer->allocate(sizeof(int), numBuckets);
+		memPtr = (int*)chunk->m_oldPtr;
+		for (int i = 0; i < numBuckets; i++, memPtr++)
 		{
-			*memPtr = m_next[i];
+			*memPtr = next[i];
 		}
-		serializer->finalizeChunk(chunk, "int", BT_ARRAY_CODE, (void*)&m_next[0]);
+		serializer->finalizeChunk(chunk, "int", BT_ARRAY_CODE, (void*)&m_hashValues[0]);
 	}
 
 	tmapData->m_numValues = m_valueArray.size();
@@ -208,30 +213,16 @@ SIMD_FORCE_INLINE void btTriangleInfoMap::deSerialize(btTriangleInfoMapData& tma
 	m_equalVertexThreshold = tmapData.m_equalVertexThreshold;
 	m_edgeDistanceThreshold = tmapData.m_edgeDistanceThreshold;
 	m_zeroAreaThreshold = tmapData.m_zeroAreaThreshold;
-	m_hashTable.resize(tmapData.m_hashTableSize);
-	int i = 0;
-	for (i = 0; i < tmapData.m_hashTableSize; i++)
-	{
-		m_hashTable[i] = tmapData.m_hashTablePtr[i];
-	}
-	m_next.resize(tmapData.m_nextSize);
-	for (i = 0; i < tmapData.m_nextSize; i++)
-	{
-		m_next[i] = tmapData.m_nextPtr[i];
-	}
-	m_valueArray.resize(tmapData.m_numValues);
-	for (i = 0; i < tmapData.m_numValues; i++)
-	{
-		m_valueArray[i].m_edgeV0V1Angle = tmapData.m_valueArrayPtr[i].m_edgeV0V1Angle;
-		m_valueArray[i].m_edgeV1V2Angle = tmapData.m_valueArrayPtr[i].m_edgeV1V2Angle;
-		m_valueArray[i].m_edgeV2V0Angle = tmapData.m_valueArrayPtr[i].m_edgeV2V0Angle;
-		m_valueArray[i].m_flags = tmapData.m_valueArrayPtr[i].m_flags;
-	}
-
-	m_keyArray.resize(tmapData.m_numKeys, btHashInt(0));
-	for (i = 0; i < tmapData.m_numKeys; i++)
+	// the stored chained index is not used, the pairs are inserted again
+	clear();
+	for (int i = 0; i < tmapData.m_numKeys && i < tmapData.m_numValues; i++)
 	{
-		m_keyArray[i].setUid1(tmapData.m_keyArrayPtr[i]);
+		btTriangleInfo info;
+		info.m_edgeV0V1Angle = tmapData.m_valueArrayPtr[i].m_edgeV0V1Angle;
+		info.m_edgeV1V2Angle = tmapData.m_valueArrayPtr[i].m_edgeV1V2Angle;
+		info.m_edgeV2V0Angle = tmapData.m_valueArrayPtr[i].m_edgeV2V0Angle;
+		info.m_flags = tmapData.m_valueArrayPtr[i].m_flags;
+		insert(btHashInt(tmapData.m_keyArrayPtr[i]), info);
 	}
 }
 
@@ -30,6 +30,7 @@ Concave-Concave Collision
 #include "btGImpactCollisionAlgorithm.h"
 #include "btContactProcessing.h"
 #include "LinearMath/btQuickprof.h"
+#include "LinearMath/btFrameArena.h"
 
 //! Class for accessing the plane equation
 class btPlaneShape : public btStaticPlaneShape
@@ -344,6 +345,56 @@ void btGImpactCollisionAlgorithm::collide_gjk_triangles(const btCollisionObjectW
 	shape1->unlockChildShapes();
 }
 
+bool gGImpactMergeTriangleContacts = false;
+
+//! Tests if all the vertices of a triangle are in front of a plane, the distances of the three vertices are computed with a single dot3
+SIMD_FORCE_INLINE bool bt_triangle_in_front_of_plane(const btVector4& plane, const btVector3* vertices, btScalar margin)
+{
+	btVector3 distances = plane.dot3(vertices[0], vertices[1], vertices[2]);
+	btScalar min_distance = btMin(btMin(distances[0], distances[1]), distances[2]);
+	return min_distance - plane[3] - margin > btScalar(0.);
+}
+
+class btTriangleIndexComp
+{
+public:
+	SIMD_FORCE_INLINE bool operator()(int a, int b) const
+	{
+		return a < b;
+	}
+};
+
+//! Sorts the triangle indices and removes duplicates
+static void bt_unique_triangle_indices(btAlignedObjectArray<int>& indices)
+{
+	if (indices.size() == 0) return;
+	indices.quickSort(btTriangleIndexComp());
+	int count = 1;
+	for (int i = 1; i < indices.size(); i++)
+	{
+		if (indices[i] != indices[count - 1])
+		{
+			indices[count++] = indices[i];
+		}
+	}
+	indices.resize(count);
+}
+
+//! Transforms the referenced triangles of a mesh part and builds their planes, once per triangle instead of once per pair
+static void bt_prepare_primitive_triangles(const btGImpactMeshShapePart* shape, const btTransform& trans,
+										   const btAlignedObjectArray<int>& triangle_indices,
+										   btAlignedObjectArray<btPrimitiveTriangle>& triangles)
+{
+	triangles.resize(triangle_indices.size());
+	for (int i = 0; i < triangle_indices.size(); i++)
+	{
+		btPrimitiveTriangle& ptri = triangles[i];
+		shape->getPrimitiveTriangle(triangle_indices[i], ptri);
+		ptri.applyTransform(trans);
+		ptri.buildTriPlane();
+	}
+}
+
 void btGImpactCollisionAlgorithm::collide_sat_triangles(const btCollisionObjectWrapper* body0Wrap,
 														const btCollisionObjectWrapper* body1Wrap,
 														const btGImpactMeshShapePart* shape0,
@@ -353,40 +404,79 @@ void btGImpactCollisionAlgorithm::collide_sat_triangles(const btCollisionObjectW
 	btTransform orgtrans0 = body0Wrap->getWorldTransform();
 	btTransform orgtrans1 = body1Wrap->getWorldTransform();
 
-	btPrimitiveTriangle ptri0;
-	btPrimitiveTriangle ptri1;
 	GIM_TRIANGLE_CONTACT contact_data;
 
 	shape0->lockChildShapes();
 	shape1->lockChildShapes();
 
-	const int* pair_pointer = pairs;
+	//gather the triangles referenced by the pairs, a triangle usually overlaps several triangles of the other mesh
+	btAlignedObjectArray<int> triangle_indices0;
+	btAlignedObjectArray<int> triangle_indices1;
+	btAlignedObjectArray<btPrimitiveTriangle> triangles0;
+	btAlignedObjectArray<btPrimitiveTriangle> triangles1;
+	btAlignedObjectArray<GIM_PAIR> candidates;
+	if (btFrameArena* arena = m_dispatchInfo->m_frameArena)
+	{
+		arena->initializeArray(triangle_indices0, pair_count);
+		arena->initializeArray(triangle_indices1, pair_count);
+		arena->initializeArray(triangles0, pair_count);
+		arena->initializeArray(triangles1, pair_count);
+		arena->initializeArray(candidates, pair_count);
+	}
+	triangle_indices0.resize(pair_count);
+	triangle_indices1.resize(pair_count);
+	int i;
+	for (i = 0; i < pair_count; i++)
+	{
+		triangle_indices0[i] = pairs[i * 2];
+		triangle_indices1[i] = pairs[i * 2 + 1];
+	}
+	bt_unique_triangle_indices(triangle_indices0);
+	bt_unique_triangle_indices(triangle_indices1);
 
-	while (pair_count--)
+	bt_prepare_primitive_triangles(shape0, orgtrans0, triangle_indices0, triangles0);
+	bt_prepare_primitive_triangles(shape1, orgtrans1, triangle_indices1, triangles1);
+
+	//conservative plane tests for all pairs in one pass, only the surviving pairs are clipped
+	candidates.reserve(pair_count);
+	for (i = 0; i < pair_count; i++)
 	{
-		m_triface0 = *(pair_pointer);
-		m_triface1 = *(pair_pointer + 1);
-		pair_pointer += 2;
+		int slot0 = triangle_indices0.findBinarySearch(pairs[i * 2]);
+		int slot1 = triangle_indices1.findBinarySearch(pairs[i * 2 + 1]);
+		const btPrimitiveTriangle& ptri0 = triangles0[slot0];
+		const btPrimitiveTriangle& ptri1 = triangles1[slot1];
+		btScalar total_margin = ptri0.m_margin + ptri1.m_margin;
 
-		shape0->getPrimitiveTriangle(m_triface0, ptri0);
-		shape1->getPrimitiveTriangle(m_triface1, ptri1);
+		if (bt_triangle_in_front_of_plane(ptri0.m_plane, ptri1.m_vertices, total_margin) ||
+			bt_triangle_in_front_of_plane(ptri1.m_plane, ptri0.m_vertices, total_margin))
+		{
+			continue;
+		}
+		candidates.push_back(GIM_PAIR(slot0, slot1));
+	}
 
+	//clip the candidate pairs, they are still in pair order
+	btContactArray contacts;
+	for (i = 0; i < candidates.size(); i++)
+	{
 #ifdef TRI_COLLISION_PROFILING
 		bt_begin_gim02_tri_time();
 #endif
+		btPrimitiveTriangle& ptri0 = triangles0[candidates[i].m_index1];
+		btPrimitiveTriangle& ptri1 = triangles1[candidates[i].m_index2];
 
-		ptri0.applyTransform(orgtrans0);
-		ptri1.applyTransform(orgtrans1);
-
-		//build planes
-		ptri0.buildTriPlane();
-		ptri1.buildTriPlane();
-		// test conservative
-
-		if (ptri0.overlap_test_conservative(ptri1))
+		if (ptri0.find_triangle_collision_clip_method(ptri1, contact_data))
 		{
-			if (ptri0.find_triangle_collision_clip_method(ptri1, contact_data))
+			if (gGImpactMergeTriangleContacts)
+			{
+				contacts.push_triangle_contacts(contact_data,
+												triangle_indices0[candidates[i].m_index1],
+												triangle_indices1[candidates[i].m_index2]);
+			}
+			else
 			{
+				m_triface0 = triangle_indices0[candidates[i].m_index1];
+				m_triface1 = triangle_indices1[candidates[i].m_index2];
 				int j = contact_data.m_point_count;
 				while (j--)
 				{
@@ -397,12 +487,29 @@ void btGImpactCollisionAlgorithm::collide_sat_triangles(const btCollisionObjectW
 				}
 			}
 		}
-
 #ifdef TRI_COLLISION_PROFILING
 		bt_end_gim02_tri_time();
 #endif
 	}
 
+	if (gGImpactMergeTriangleContacts)
+	{
+		//reduce the contacts of all pairs before they reach the manifold
+		btContactArray merged_contacts;
+		merged_contacts.merge_contacts(contacts);
+
+		for (i = 0; i < merged_contacts.size(); i++)
+		{
+			const GIM_CONTACT& contact = merged_contacts[i];
+			m_triface0 = contact.m_feature1;
+			m_triface1 = contact.m_feature2;
+			addContactPoint(body0Wrap, body1Wrap,
+							contact.m_point,
+							contact.m_normal,
+							-contact.m_depth);
+		}
+	}
+
 	shape0->unlockChildShapes();
 	shape1->unlockChildShapes();
 }
@@ -42,6 +42,10 @@ class btDispatcher;
 #include "LinearMath/btIDebugDraw.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 
+///When true, mesh vs mesh collision reduces the triangle contacts of all pairs with btContactArray::merge_contacts
+///before they reach the manifold. Off by default, contacts are then generated per triangle pair as before.
+extern bool gGImpactMergeTriangleContacts;
+
 //! Collision Algorithm for GImpact Shapes
 /*!
 For register this algorithm in Bullet, proceed as following:
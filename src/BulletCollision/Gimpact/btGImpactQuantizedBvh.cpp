@@ -376,91 +376,66 @@ SIMD_FORCE_INLINE bool _quantized_node_collision(
 	//	return box0.has_collision(box1);
 }
 
-//stackless recursive collision routine
-static void _find_quantized_collision_pairs_recursive(
+//collision routine with an explicit stack of node pairs instead of recursion, node pairs are visited in the same order as the former recursive version
+#define GIM_QUANTIZED_BVH_STACK_SIZE 128
+
+static void _find_quantized_collision_pairs(
 	const btGImpactQuantizedBvh* boxset0, const btGImpactQuantizedBvh* boxset1,
 	btPairSet* collision_pairs,
-	const BT_BOX_BOX_TRANSFORM_CACHE& trans_cache_1to0,
-	int node0, int node1, bool complete_primitive_tests)
+	const BT_BOX_BOX_TRANSFORM_CACHE& trans_cache_1to0)
 {
-	if (_quantized_node_collision(
-			boxset0, boxset1, trans_cache_1to0,
-			node0, node1, complete_primitive_tests) == false) return;  //avoid colliding internal nodes
+	btAlignedObjectArray<GIM_PAIR> stack;
+	GIM_PAIR localStack[GIM_QUANTIZED_BVH_STACK_SIZE];
+	stack.initializeFromBuffer(localStack, 0, GIM_QUANTIZED_BVH_STACK_SIZE);
 
-	if (boxset0->isLeafNode(node0))
+	//only the root nodes need the complete primitive tests
+	bool complete_primitive_tests = true;
+	stack.push_back(GIM_PAIR(0, 0));
+
+	while (stack.size())
 	{
-		if (boxset1->isLeafNode(node1))
+		GIM_PAIR nodes = stack[stack.size() - 1];
+		stack.pop_back();
+		int node0 = nodes.m_index1;
+		int node1 = nodes.m_index2;
+
+		bool overlap = _quantized_node_collision(
+			boxset0, boxset1, trans_cache_1to0,
+			node0, node1, complete_primitive_tests);
+		complete_primitive_tests = false;
+		if (!overlap) continue;  //avoid colliding internal nodes
+
+		//children are pushed in reverse order, so the left nodes are processed first
+		if (boxset0->isLeafNode(node0))
 		{
-			// collision result
-			collision_pairs->push_pair(
-				boxset0->getNodeData(node0), boxset1->getNodeData(node1));
-			return;
+			if (boxset1->isLeafNode(node1))
+			{
+				// collision result
+				collision_pairs->push_pair(
+					boxset0->getNodeData(node0), boxset1->getNodeData(node1));
+			}
+			else
+			{
+				stack.push_back(GIM_PAIR(node0, boxset1->getRightNode(node1)));
+				stack.push_back(GIM_PAIR(node0, boxset1->getLeftNode(node1)));
+			}
 		}
 		else
 		{
-			//collide left recursive
-
-			_find_quantized_collision_pairs_recursive(
-				boxset0, boxset1,
-				collision_pairs, trans_cache_1to0,
-				node0, boxset1->getLeftNode(node1), false);
-
-			//collide right recursive
-			_find_quantized_collision_pairs_recursive(
-				boxset0, boxset1,
-				collision_pairs, trans_cache_1to0,
-				node0, boxset1->getRightNode(node1), false);
+			if (boxset1->isLeafNode(node1))
+			{
+				stack.push_back(GIM_PAIR(boxset0->getRightNode(node0), node1));
+				stack.push_back(GIM_PAIR(boxset0->getLeftNode(node0), node1));
+			}
+			else
+			{
+				stack.push_back(GIM_PAIR(boxset0->getRightNode(node0), boxset1->getRightNode(node1)));
+				stack.push_back(GIM_PAIR(boxset0->getRightNode(node0), boxset1->getLeftNode(node1)));
+				stack.push_back(GIM_PAIR(boxset0->getLeftNode(node0), boxset1->getRightNode(node1)));
+				stack.push_back(GIM_PAIR(boxset0->getLeftNode(node0), boxset1->getLeftNode(node1)));
+			}
 		}
 	}
-	else
-	{
-		if (boxset1->isLeafNode(node1))
-		{
-			//collide left recursive
-			_find_quantized_collision_pairs_recursive(
-				boxset0, boxset1,
-				collision_pairs, trans_cache_1to0,
-				boxset0->getLeftNode(node0), node1, false);
-
-			//collide right recursive
-
-			_find_quantized_collision_pairs_recursive(
-				boxset0, boxset1,
-				collision_pairs, trans_cache_1to0,
-				boxset0->getRightNode(node0), node1, false);
-		}
-		else
-		{
-			//collide left0 left1
-
-			_find_quantized_collision_pairs_recursive(
-				boxset0, boxset1,
-				collision_pairs, trans_cache_1to0,
-				boxset0->getLeftNode(node0), boxset1->getLeftNode(node1), false);
-
-			//collide left0 right1
-
-			_find_quantized_collision_pairs_recursive(
-				boxset0, boxset1,
-				collision_pairs, trans_cache_1to0,
-				boxset0->getLeftNode(node0), boxset1->getRightNode(node1), false);
-
-			//collide right0 left1
-
-			_find_quantized_collision_pairs_recursive(
-				boxset0, boxset1,
-				collision_pairs, trans_cache_1to0,
-				boxset0->getRightNode(node0), boxset1->getLeftNode(node1), false);
-
-			//collide right0 right1
-
-			_find_quantized_collision_pairs_recursive(
-				boxset0, boxset1,
-				collision_pairs, trans_cache_1to0,
-				boxset0->getRightNode(node0), boxset1->getRightNode(node1), false);
-
-		}  // else if node1 is not a leaf
-	}      // else if node0 is not a leaf
 }
 
 void btGImpactQuantizedBvh::find_collision(const btGImpactQuantizedBvh* boxset0, const btTransform& trans0,
@@ -477,9 +452,9 @@ void btGImpactQuantizedBvh::find_collision(const btGImpactQuantizedBvh* boxset0,
 	bt_begin_gim02_q_tree_time();
 #endif  //TRI_COLLISION_PROFILING
 
-	_find_quantized_collision_pairs_recursive(
+	_find_quantized_collision_pairs(
 		boxset0, boxset1,
-		&collision_pairs, trans_cache_1to0, 0, 0, true);
+		&collision_pairs, trans_cache_1to0);
 #ifdef TRI_COLLISION_PROFILING
 	bt_end_gim02_q_tree_time();
 #endif  //TRI_COLLISION_PROFILING
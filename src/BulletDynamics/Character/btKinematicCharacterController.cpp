@@ -157,6 +157,8 @@ btKinematicCharacterController::btKinematicCharacterController(btPairCachingGhos
 	m_maxPenetrationDepth = 0.2;
 	full_drop = false;
 	bounce_fix = false;
+	m_deferGhostUpdates = false;
+	m_deferredTransform.setIdentity();
 	m_linearDamping = btScalar(0.0);
 	m_angularDamping = btScalar(0.0);
 
@@ -174,6 +176,19 @@ btPairCachingGhostObject* btKinematicCharacterController::getGhostObject()
 	return m_ghostObject;
 }
 
+const btTransform& btKinematicCharacterController::getCharacterTransform() const
+{
+	return m_deferGhostUpdates ? m_deferredTransform : m_ghostObject->getWorldTransform();
+}
+
+void btKinematicCharacterController::setCharacterTransform(const btTransform& xform)
+{
+	if (m_deferGhostUpdates)
+		m_deferredTransform = xform;
+	else
+		m_ghostObject->setWorldTransform(xform);
+}
+
 bool btKinematicCharacterController::recoverFromPenetration(btCollisionWorld* collisionWorld)
 {
 	// Here we must refresh the overlapping paircache as the penetrating movement itself or the
@@ -303,14 +318,15 @@ void btKinematicCharacterController::stepUp(btCollisionWorld* world)
 				m_currentPosition = m_targetPosition;
 		}
 
-		btTransform& xform = m_ghostObject->getWorldTransform();
+		btTransform xform = getCharacterTransform();
 		xform.setOrigin(m_currentPosition);
-		m_ghostObject->setWorldTransform(xform);
+		setCharacterTransform(xform);
 
 		// fix penetration if we hit a ceiling for example
+		// (a deferred step leaves this to commitDeferredStep)
 		int numPenetrationLoops = 0;
 		m_touchingContact = false;
-		while (recoverFromPenetration(world))
+		while (!m_deferGhostUpdates && recoverFromPenetration(world))
 		{
 			numPenetrationLoops++;
 			m_touchingContact = true;
@@ -320,7 +336,7 @@ void btKinematicCharacterController::stepUp(btCollisionWorld* world)
 				break;
 			}
 		}
-		m_targetPosition = m_ghostObject->getWorldTransform().getOrigin();
+		m_targetPosition = getCharacterTransform().getOrigin();
 		m_currentPosition = m_targetPosition;
 
 		if (m_verticalOffset > 0)
@@ -721,18 +737,18 @@ void btKinematicCharacterController::playerStep(btCollisionWorld* collisionWorld
 	if (m_AngVel.length2() > 0.0f)
 	{
 		btTransform xform;
-		xform = m_ghostObject->getWorldTransform();
+		xform = getCharacterTransform();
 
 		btQuaternion rot(m_AngVel.normalized(), m_AngVel.length() * dt);
 
 		btQuaternion orn = rot * xform.getRotation();
 
 		xform.setRotation(orn);
-		m_ghostObject->setWorldTransform(xform);
+		setCharacterTransform(xform);
 
-		m_currentPosition = m_ghostObject->getWorldTransform().getOrigin();
+		m_currentPosition = getCharacterTransform().getOrigin();
 		m_targetPosition = m_currentPosition;
-		m_currentOrientation = m_ghostObject->getWorldTransform().getRotation();
+		m_currentOrientation = getCharacterTransform().getRotation();
 		m_targetOrientation = m_currentOrientation;
 	}
 
@@ -769,7 +785,7 @@ void btKinematicCharacterController::playerStep(btCollisionWorld* collisionWorld
 	m_verticalOffset = m_verticalVelocity * dt;
 
 	btTransform xform;
-	xform = m_ghostObject->getWorldTransform();
+	xform = getCharacterTransform();
 
 	//	printf("walkDirection(%f,%f,%f)\n",walkDirection[0],walkDirection[1],walkDirection[2]);
 	//	printf("walkSpeed=%f\n",walkSpeed);
@@ -833,7 +849,10 @@ void btKinematicCharacterController::playerStep(btCollisionWorld* collisionWorld
 	// printf("\n");
 
 	xform.setOrigin(m_currentPosition);
-	m_ghostObject->setWorldTransform(xform);
+	setCharacterTransform(xform);
+
+	if (m_deferGhostUpdates)
+		return;
 
 	int numPenetrationLoops = 0;
 	m_touchingContact = false;
@@ -849,6 +868,33 @@ void btKinematicCharacterController::playerStep(btCollisionWorld* collisionWorld
 	}
 }
 
+void btKinematicCharacterController::deferredPlayerStep(btCollisionWorld* collisionWorld, btScalar dt)
+{
+	m_deferredTransform = m_ghostObject->getWorldTransform();
+	m_deferGhostUpdates = true;
+	preStep(collisionWorld);
+	playerStep(collisionWorld, dt);
+	m_deferGhostUpdates = false;
+}
+
+void btKinematicCharacterController::commitDeferredStep(btCollisionWorld* collisionWorld)
+{
+	m_ghostObject->setWorldTransform(m_deferredTransform);
+
+	// recoverFromPenetration also moves the ghost object's broadphase AABB to the committed transform
+	int numPenetrationLoops = 0;
+	m_touchingContact = false;
+	while (recoverFromPenetration(collisionWorld))
+	{
+		numPenetrationLoops++;
+		m_touchingContact = true;
+		if (numPenetrationLoops > 4)
+		{
+			break;
+		}
+	}
+}
+
 void btKinematicCharacterController::setFallSpeed(btScalar fallSpeed)
 {
 	m_fallSpeed = fallSpeed;
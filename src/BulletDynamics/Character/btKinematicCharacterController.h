@@ -95,6 +95,13 @@ protected:
 	bool full_drop;
 	bool bounce_fix;
 
+	///when set, the step works on m_deferredTransform and leaves the ghost object and broadphase untouched
+	bool m_deferGhostUpdates;
+	btTransform m_deferredTransform;
+
+	const btTransform& getCharacterTransform() const;
+	void setCharacterTransform(const btTransform& xform);
+
 	btVector3 computeReflectionDirection(const btVector3& direction, const btVector3& normal);
 	btVector3 parallelComponent(const btVector3& direction, const btVector3& normal);
 	btVector3 perpindicularComponent(const btVector3& direction, const btVector3& normal);
@@ -163,6 +170,15 @@ public:
 	void preStep(btCollisionWorld * collisionWorld);
 	void playerStep(btCollisionWorld * collisionWorld, btScalar dt);
 
+	///deferredPlayerStep runs preStep and playerStep against a read-only world: the ghost object transform,
+	///broadphase and pair caches are not modified, so several characters can be stepped concurrently.
+	///The result is applied by commitDeferredStep, which also performs the penetration recovery.
+	///playerStep also recovers from penetration after stepping up, the deferred step skips that recovery since
+	///it updates the pair cache, so after stepping up into a ceiling the forward sweep starts from inside the
+	///ceiling and the character can end the step at a slightly different height than with playerStep.
+	void deferredPlayerStep(btCollisionWorld * collisionWorld, btScalar dt);
+	void commitDeferredStep(btCollisionWorld * collisionWorld);
+
 	void setStepHeight(btScalar h);
 	btScalar getStepHeight() const { return m_stepHeight; }
 	void setFallSpeed(btScalar fallSpeed);
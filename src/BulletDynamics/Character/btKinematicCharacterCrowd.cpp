@@ -0,0 +1,103 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2008 Erwin Coumans  http://bulletphysics.com
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btKinematicCharacterCrowd.h"
+#include "btKinematicCharacterController.h"
+#include "LinearMath/btThreads.h"
+
+struct btCrowdCharacterStepLoop : public btIParallelForBody
+{
+	btKinematicCharacterController** m_characters;
+	btCollisionWorld* m_collisionWorld;
+	btScalar m_timeStep;
+
+	btCrowdCharacterStepLoop(btKinematicCharacterController** characters, btCollisionWorld* collisionWorld, btScalar timeStep)
+		: m_characters(characters), m_collisionWorld(collisionWorld), m_timeStep(timeStep)
+	{
+	}
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			m_characters[i]->deferredPlayerStep(m_collisionWorld, m_timeStep);
+		}
+	}
+};
+
+btKinematicCharacterCrowd::btKinematicCharacterCrowd()
+	: m_grainSize(32)
+{
+}
+
+btKinematicCharacterCrowd::~btKinematicCharacterCrowd()
+{
+}
+
+void btKinematicCharacterCrowd::addCharacter(btKinematicCharacterController* character)
+{
+	btAssert(m_characters.findLinearSearch(character) == m_characters.size());
+	m_characters.push_back(character);
+}
+
+void btKinematicCharacterCrowd::removeCharacter(btKinematicCharacterController* character)
+{
+	// keep the insertion order, the commit phase depends on it
+	int index = m_characters.findLinearSearch(character);
+	if (index < m_characters.size())
+	{
+		for (int i = index + 1; i < m_characters.size(); i++)
+		{
+			m_characters[i - 1] = m_characters[i];
+		}
+		m_characters.pop_back();
+	}
+}
+
+void btKinematicCharacterCrowd::updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep)
+{
+	int numCharacters = m_characters.size();
+	if (numCharacters == 0)
+		return;
+
+	// phase 1: sweep every character against the world as it was at the start of the step
+	btCrowdCharacterStepLoop stepLoop(&m_characters[0], collisionWorld, deltaTimeStep);
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		btParallelFor(0, numCharacters, m_grainSize, stepLoop);
+	}
+	else
+	{
+		stepLoop.forLoop(0, numCharacters);
+	}
+#else
+	stepLoop.forLoop(0, numCharacters);
+#endif
+
+	// phase 2: apply the results in a fixed order
+	for (int i = 0; i < numCharacters; i++)
+	{
+		m_characters[i]->commitDeferredStep(collisionWorld);
+	}
+}
+
+void btKinematicCharacterCrowd::debugDraw(btIDebugDraw* debugDrawer)
+{
+	for (int i = 0; i < m_characters.size(); i++)
+	{
+		m_characters[i]->debugDraw(debugDrawer);
+	}
+}
@@ -0,0 +1,70 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2008 Erwin Coumans  http://bulletphysics.com
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_KINEMATIC_CHARACTER_CROWD_H
+#define BT_KINEMATIC_CHARACTER_CROWD_H
+
+#include "BulletDynamics/Dynamics/btActionInterface.h"
+#include "LinearMath/btAlignedObjectArray.h"
+
+class btKinematicCharacterController;
+
+///btKinematicCharacterCrowd updates a group of btKinematicCharacterController in two phases.
+///First every character sweeps against a read-only view of the world (in parallel when BT_THREADSAFE is enabled
+///and a task scheduler is set, serially otherwise),
+///so each character sees the other characters where they were at the start of the step.
+///Then the results are committed one character at a time, in the order they were added, which performs the
+///penetration recovery and broadphase update. The outcome does not depend on the number of threads.
+///The recovery after stepping up is deferred to the commit as well, see btKinematicCharacterController::deferredPlayerStep.
+///Characters added to a crowd should not also be registered as actions with the world.
+class btKinematicCharacterCrowd : public btActionInterface
+{
+	btAlignedObjectArray<btKinematicCharacterController*> m_characters;
+	int m_grainSize;
+
+public:
+	btKinematicCharacterCrowd();
+	virtual ~btKinematicCharacterCrowd();
+
+	void addCharacter(btKinematicCharacterController* character);
+	void removeCharacter(btKinematicCharacterController* character);
+
+	int getNumCharacters() const
+	{
+		return m_characters.size();
+	}
+	btKinematicCharacterController* getCharacter(int index)
+	{
+		return m_characters[index];
+	}
+
+	///number of characters stepped per task
+	void setGrainSize(int grainSize)
+	{
+		m_grainSize = grainSize > 0 ? grainSize : 1;
+	}
+	int getGrainSize() const
+	{
+		return m_grainSize;
+	}
+
+	///btActionInterface interface
+	virtual void updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep);
+
+	///btActionInterface interface
+	virtual void debugDraw(btIDebugDraw* debugDrawer);
+};
+
+#endif  //BT_KINEMATIC_CHARACTER_CROWD_H
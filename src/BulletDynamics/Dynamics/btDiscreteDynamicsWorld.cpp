@@ -45,6 +45,8 @@ subject to the following restrictions:
 #include "LinearMath/btMotionState.h"
 
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btFrameArena.h"
+#include "LinearMath/btAllocatorContext.h"
 
 #if 0
 btAlignedObjectArray<btVector3> debugContacts;
@@ -199,7 +201,10 @@ btDiscreteDynamicsWorld::btDiscreteDynamicsWorld(btDispatcher* dispatcher, btBro
 	  m_synchronizeAllMotionStates(false),
 	  m_applySpeculativeContactRestitution(false),
 	  m_profileTimings(0),
-	  m_latencyMotionStateInterpolation(true)
+	  m_latencyMotionStateInterpolation(true),
+	  m_frameArena(0),
+	  m_lastStepHeapAllocations(0),
+	  m_lastStepHeapBytes(0)
 
 {
 	if (!m_constraintSolver)
@@ -382,6 +387,10 @@ void btDiscreteDynamicsWorld::synchronizeMotionStates()
 int btDiscreteDynamicsWorld::stepSimulation(btScalar timeStep, int maxSubSteps, btScalar fixedTimeStep)
 {
 	startProfiling(timeStep);
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
+
+	size_t heapAllocationsBefore, heapBytesBefore;
+	btAlignedAllocGetCounters(&heapAllocationsBefore, &heapBytesBefore);
 
 	int numSimulationSubSteps = 0;
 
@@ -442,6 +451,11 @@ int btDiscreteDynamicsWorld::stepSimulation(btScalar timeStep, int maxSubSteps,
 
 	clearForces();
 
+	size_t heapAllocationsAfter, heapBytesAfter;
+	btAlignedAllocGetCounters(&heapAllocationsAfter, &heapBytesAfter);
+	m_lastStepHeapAllocations = heapAllocationsAfter - heapAllocationsBefore;
+	m_lastStepHeapBytes = heapBytesAfter - heapBytesBefore;
+
 #ifndef BT_NO_PROFILE
 	CProfileManager::Increment_Frame_Counter();
 #endif  //BT_NO_PROFILE
@@ -449,6 +463,19 @@ int btDiscreteDynamicsWorld::stepSimulation(btScalar timeStep, int maxSubSteps,
 	return numSimulationSubSteps;
 }
 
+void btDiscreteDynamicsWorld::performDiscreteCollisionDetection()
+{
+	// queries outside of this call, such as contactTest, do not see the arena and use the heap
+	btDispatcherInfo& dispatchInfo = getDispatchInfo();
+	dispatchInfo.m_frameArena = m_frameArena;
+	btCollisionWorld::performDiscreteCollisionDetection();
+	dispatchInfo.m_frameArena = 0;
+	if (m_frameArena)
+	{
+		m_frameArena->reset();
+	}
+}
+
 void btDiscreteDynamicsWorld::internalSingleStepSimulation(btScalar timeStep)
 {
 	BT_PROFILE("internalSingleStepSimulation");
@@ -536,6 +563,7 @@ void btDiscreteDynamicsWorld::removeRigidBody(btRigidBody* body)
 
 void btDiscreteDynamicsWorld::addRigidBody(btRigidBody* body)
 {
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 	if (!body->isStaticOrKinematicObject() && !(body->getFlags() & BT_DISABLE_WORLD_GRAVITY))
 	{
 		body->setGravity(m_gravity);
@@ -562,6 +590,7 @@ void btDiscreteDynamicsWorld::addRigidBody(btRigidBody* body)
 
 void btDiscreteDynamicsWorld::addRigidBody(btRigidBody* body, int group, int mask)
 {
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 	if (!body->isStaticOrKinematicObject() && !(body->getFlags() & BT_DISABLE_WORLD_GRAVITY))
 	{
 		body->setGravity(m_gravity);
@@ -630,6 +659,7 @@ void btDiscreteDynamicsWorld::updateActivationState(btScalar timeStep)
 
 void btDiscreteDynamicsWorld::addConstraint(btTypedConstraint* constraint, bool disableCollisionsBetweenLinkedBodies)
 {
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 	m_constraints.push_back(constraint);
 	//Make sure the two bodies of a type constraint are different (possibly add this to the btTypedConstraint constructor?)
 	btAssert(&constraint->getRigidBodyA() != &constraint->getRigidBodyB());
@@ -650,6 +680,7 @@ void btDiscreteDynamicsWorld::removeConstraint(btTypedConstraint* constraint)
 
 void btDiscreteDynamicsWorld::addAction(btActionInterface* action)
 {
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 	m_actions.push_back(action);
 }
 
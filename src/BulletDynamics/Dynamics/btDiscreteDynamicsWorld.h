@@ -26,6 +26,7 @@ class btTypedConstraint;
 class btActionInterface;
 class btPersistentManifold;
 class btIDebugDraw;
+class btFrameArena;
 struct InplaceSolverIslandCallback;
 
 #include "LinearMath/btAlignedObjectArray.h"
@@ -69,6 +70,10 @@ protected:
 	btAlignedObjectArray<btPersistentManifold*> m_predictiveManifolds;
 	btSpinMutex m_predictiveManifoldsMutex;  // used to synchronize threads creating predictive contacts
 
+	btFrameArena* m_frameArena;
+	size_t m_lastStepHeapAllocations;
+	size_t m_lastStepHeapBytes;
+
 	virtual void predictUnconstraintMotion(btScalar timeStep);
 
 	void integrateTransformsInternal(btRigidBody * *bodies, int numBodies, btScalar timeStep);  // can be called in parallel
@@ -150,6 +155,9 @@ public:
 	///removeCollisionObject will first check if it is a rigid body, if so call removeRigidBody otherwise call btCollisionWorld::removeCollisionObject
 	virtual void removeCollisionObject(btCollisionObject * collisionObject);
 
+	///the frame arena is handed to the narrowphase for the duration of the call and reset afterwards
+	virtual void performDiscreteCollisionDetection();
+
 	virtual void debugDrawConstraint(btTypedConstraint * constraint);
 
 	virtual void debugDrawWorld();
@@ -227,6 +235,31 @@ public:
 	{
 		return m_latencyMotionStateInterpolation;
 	}
+
+	///temporary data of the narrowphase is taken from the arena when one is set, see btDispatcherInfo::m_frameArena.
+	///The arena is reset at the end of each performDiscreteCollisionDetection, the world does not own it
+	void setFrameArena(btFrameArena * arena)
+	{
+		m_frameArena = arena;
+	}
+
+	btFrameArena* getFrameArena()
+	{
+		return m_frameArena;
+	}
+
+	///number of btAlignedAlloc calls made during the last stepSimulation, by any thread.
+	///The counters are process-wide, allocations of other worlds or threads running at the same time are included
+	size_t getLastStepHeapAllocations() const
+	{
+		return m_lastStepHeapAllocations;
+	}
+
+	///bytes requested with btAlignedAlloc during the last stepSimulation, by any thread, process-wide like getLastStepHeapAllocations
+	size_t getLastStepHeapBytes() const
+	{
+		return m_lastStepHeapBytes;
+	}
 };
 
 #endif  //BT_DISCRETE_DYNAMICS_WORLD_H
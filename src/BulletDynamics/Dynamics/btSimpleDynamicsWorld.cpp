@@ -20,6 +20,7 @@ subject to the following restrictions:
 #include "BulletDynamics/Dynamics/btRigidBody.h"
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
 #include "BulletDynamics/ConstraintSolver/btContactSolverInfo.h"
+#include "LinearMath/btAllocatorContext.h"
 
 /*
   Make sure this dummy function never changes so that it
@@ -50,6 +51,7 @@ int btSimpleDynamicsWorld::stepSimulation(btScalar timeStep, int maxSubSteps, bt
 {
 	(void)fixedTimeStep;
 	(void)maxSubSteps;
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 
 	///apply gravity, predict motion
 	predictUnconstraintMotion(timeStep);
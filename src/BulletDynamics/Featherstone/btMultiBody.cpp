@@ -869,6 +869,8 @@ void btMultiBody::computeAccelerationsArticulatedBodyAlgorithmMultiDof(btScalar
 	for (int i = 0; i < num_links; ++i)
 	{
 		const int parent = m_links[i].m_parent;
+		const int dofOffset = m_links[i].m_dofOffset;
+		const btSpatialMotionVector *axes = m_links[i].m_axes;
 		rot_from_parent[i + 1] = btMatrix3x3(m_links[i].m_cachedRotParentToThis);
 		rot_from_world[i + 1] = rot_from_parent[i + 1] * rot_from_world[parent + 1];
 
@@ -883,8 +885,9 @@ void btMultiBody::computeAccelerationsArticulatedBodyAlgorithmMultiDof(btScalar
 		{
 			spatJointVel.setZero();
 
+			const btScalar *jointVel = &m_realBuf[6 + dofOffset];
 			for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
-				spatJointVel += m_links[i].m_axes[dof] * getJointVelMultiDof(i)[dof];
+				spatJointVel += axes[dof] * jointVel[dof];
 
 			// remember vhat_i is really vhat_p(i) (but in current frame) at this point	=> we need to add velocity across the inboard joint
 			spatVel[i + 1] += spatJointVel;
@@ -968,105 +971,109 @@ void btMultiBody::computeAccelerationsArticulatedBodyAlgorithmMultiDof(btScalar
 	for (int i = num_links - 1; i >= 0; --i)
 	{
 		const int parent = m_links[i].m_parent;
+		const int dofOffset = m_links[i].m_dofOffset;
+		const int dofCount = m_links[i].m_dofCount;
+		const btSpatialMotionVector *axes = m_links[i].m_axes;
 		fromParent.m_rotMat = rot_from_parent[i + 1];
 		fromParent.m_trnVec = m_links[i].m_cachedRVector;
 
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
+		for (int dof = 0; dof < dofCount; ++dof)
 		{
-			btSpatialForceVector &hDof = h[m_links[i].m_dofOffset + dof];
+			btSpatialForceVector &hDof = h[dofOffset + dof];
 			//
-			hDof = spatInertia[i + 1] * m_links[i].m_axes[dof];
+			hDof = spatInertia[i + 1] * axes[dof];
 			//
-			Y[m_links[i].m_dofOffset + dof] = m_links[i].m_jointTorque[dof] - m_links[i].m_axes[dof].dot(zeroAccSpatFrc[i + 1]) - spatCoriolisAcc[i].dot(hDof);
+			Y[dofOffset + dof] = m_links[i].m_jointTorque[dof] - axes[dof].dot(zeroAccSpatFrc[i + 1]) - spatCoriolisAcc[i].dot(hDof);
 		}
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
+
+		btScalar *invDi = &invD[dofOffset * dofOffset];
+		dyadTemp = spatInertia[i + 1];
+
+		if (dofCount == 1)
 		{
-			btScalar *D_row = &D[dof * m_links[i].m_dofCount];
-			for (int dof2 = 0; dof2 < m_links[i].m_dofCount; ++dof2)
-			{
-				const btSpatialForceVector &hDof2 = h[m_links[i].m_dofOffset + dof2];
-				D_row[dof2] = m_links[i].m_axes[dof].dot(hDof2);
-			}
-		}
+			//revolute and prismatic joints: D is a scalar, so skip the dense dof x dof path
+			const btSpatialForceVector &hDof = h[dofOffset];
+			const btScalar D0 = axes[0].dot(hDof);
+			invDi[0] = D0 >= SIMD_EPSILON ? btScalar(1.) / D0 : btScalar(0.);
 
-		btScalar *invDi = &invD[m_links[i].m_dofOffset * m_links[i].m_dofOffset];
-		switch (m_links[i].m_jointType)
+			//determine (h*D^{-1}) * h^{T}
+			dyadTemp -= symmetricSpatialOuterProduct(hDof, hDof * invDi[0]);
+		}
+		else
 		{
-			case btMultibodyLink::ePrismatic:
-			case btMultibodyLink::eRevolute:
+			for (int dof = 0; dof < dofCount; ++dof)
 			{
-				if (D[0] >= SIMD_EPSILON)
+				btScalar *D_row = &D[dof * dofCount];
+				for (int dof2 = 0; dof2 < dofCount; ++dof2)
 				{
-					invDi[0] = 1.0f / D[0];
+					const btSpatialForceVector &hDof2 = h[dofOffset + dof2];
+					D_row[dof2] = axes[dof].dot(hDof2);
 				}
-				else
-				{
-					invDi[0] = 0;
-				}
-				break;
 			}
-			case btMultibodyLink::eSpherical:
-			case btMultibodyLink::ePlanar:
-			{
-				const btMatrix3x3 D3x3(D[0], D[1], D[2], D[3], D[4], D[5], D[6], D[7], D[8]);
-				const btMatrix3x3 invD3x3(D3x3.inverse());
 
-				//unroll the loop?
-				for (int row = 0; row < 3; ++row)
+			switch (m_links[i].m_jointType)
+			{
+				case btMultibodyLink::eSpherical:
+				case btMultibodyLink::ePlanar:
 				{
-					for (int col = 0; col < 3; ++col)
+					const btMatrix3x3 D3x3(D[0], D[1], D[2], D[3], D[4], D[5], D[6], D[7], D[8]);
+					const btMatrix3x3 invD3x3(D3x3.inverse());
+
+					//unroll the loop?
+					for (int row = 0; row < 3; ++row)
 					{
-						invDi[row * 3 + col] = invD3x3[row][col];
+						for (int col = 0; col < 3; ++col)
+						{
+							invDi[row * 3 + col] = invD3x3[row][col];
+						}
 					}
-				}
 
-				break;
+					break;
+				}
+				default:
+				{
+				}
 			}
-			default:
+
+			//determine h*D^{-1}
+			for (int dof = 0; dof < dofCount; ++dof)
 			{
-			}
-		}
+				spatForceVecTemps[dof].setZero();
 
-		//determine h*D^{-1}
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
-		{
-			spatForceVecTemps[dof].setZero();
+				for (int dof2 = 0; dof2 < dofCount; ++dof2)
+				{
+					const btSpatialForceVector &hDof2 = h[dofOffset + dof2];
+					//
+					spatForceVecTemps[dof] += hDof2 * invDi[dof2 * dofCount + dof];
+				}
+			}
 
-			for (int dof2 = 0; dof2 < m_links[i].m_dofCount; ++dof2)
+			//determine (h*D^{-1}) * h^{T}
+			for (int dof = 0; dof < dofCount; ++dof)
 			{
-				const btSpatialForceVector &hDof2 = h[m_links[i].m_dofOffset + dof2];
+				const btSpatialForceVector &hDof = h[dofOffset + dof];
 				//
-				spatForceVecTemps[dof] += hDof2 * invDi[dof2 * m_links[i].m_dofCount + dof];
+				dyadTemp -= symmetricSpatialOuterProduct(hDof, spatForceVecTemps[dof]);
 			}
 		}
 
-		dyadTemp = spatInertia[i + 1];
-
-		//determine (h*D^{-1}) * h^{T}
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
-		{
-			const btSpatialForceVector &hDof = h[m_links[i].m_dofOffset + dof];
-			//
-			dyadTemp -= symmetricSpatialOuterProduct(hDof, spatForceVecTemps[dof]);
-		}
-
 		fromParent.transformInverse(dyadTemp, spatInertia[parent + 1], btSpatialTransformationMatrix::Add);
 
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
+		for (int dof = 0; dof < dofCount; ++dof)
 		{
 			invD_times_Y[dof] = 0.f;
 
-			for (int dof2 = 0; dof2 < m_links[i].m_dofCount; ++dof2)
+			for (int dof2 = 0; dof2 < dofCount; ++dof2)
 			{
-				invD_times_Y[dof] += invDi[dof * m_links[i].m_dofCount + dof2] * Y[m_links[i].m_dofOffset + dof2];
+				invD_times_Y[dof] += invDi[dof * dofCount + dof2] * Y[dofOffset + dof2];
 			}
 		}
 
 		spatForceVecTemps[0] = zeroAccSpatFrc[i + 1] + spatInertia[i + 1] * spatCoriolisAcc[i];
 
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
+		for (int dof = 0; dof < dofCount; ++dof)
 		{
-			const btSpatialForceVector &hDof = h[m_links[i].m_dofOffset + dof];
+			const btSpatialForceVector &hDof = h[dofOffset + dof];
 			//
 			spatForceVecTemps[0] += hDof * invD_times_Y[dof];
 		}
@@ -1108,26 +1115,29 @@ void btMultiBody::computeAccelerationsArticulatedBodyAlgorithmMultiDof(btScalar
 		//	a = apar + Sqdd
 
 		const int parent = m_links[i].m_parent;
+		const int dofOffset = m_links[i].m_dofOffset;
+		const int dofCount = m_links[i].m_dofCount;
+		const btSpatialMotionVector *axes = m_links[i].m_axes;
 		fromParent.m_rotMat = rot_from_parent[i + 1];
 		fromParent.m_trnVec = m_links[i].m_cachedRVector;
 
 		fromParent.transform(spatAcc[parent + 1], spatAcc[i + 1]);
 
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
+		for (int dof = 0; dof < dofCount; ++dof)
 		{
-			const btSpatialForceVector &hDof = h[m_links[i].m_dofOffset + dof];
+			const btSpatialForceVector &hDof = h[dofOffset + dof];
 			//
-			Y_minus_hT_a[dof] = Y[m_links[i].m_dofOffset + dof] - spatAcc[i + 1].dot(hDof);
+			Y_minus_hT_a[dof] = Y[dofOffset + dof] - spatAcc[i + 1].dot(hDof);
 		}
 
-		btScalar *invDi = &invD[m_links[i].m_dofOffset * m_links[i].m_dofOffset];
+		btScalar *invDi = &invD[dofOffset * dofOffset];
 		//D^{-1} * (Y - h^{T}*apar)
-		mulMatrix(invDi, Y_minus_hT_a, m_links[i].m_dofCount, m_links[i].m_dofCount, m_links[i].m_dofCount, 1, &joint_accel[m_links[i].m_dofOffset]);
+		mulMatrix(invDi, Y_minus_hT_a, dofCount, dofCount, dofCount, 1, &joint_accel[dofOffset]);
 
 		spatAcc[i + 1] += spatCoriolisAcc[i];
 
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
-			spatAcc[i + 1] += m_links[i].m_axes[dof] * joint_accel[m_links[i].m_dofOffset + dof];
+		for (int dof = 0; dof < dofCount; ++dof)
+			spatAcc[i + 1] += axes[dof] * joint_accel[dofOffset + dof];
 
 		if (m_links[i].m_jointFeedback)
 		{
@@ -1484,33 +1494,36 @@ void btMultiBody::calcAccelerationDeltasMultiDof(const btScalar *force, btScalar
 	for (int i = num_links - 1; i >= 0; --i)
 	{
 		const int parent = m_links[i].m_parent;
+		const int dofOffset = m_links[i].m_dofOffset;
+		const int dofCount = m_links[i].m_dofCount;
+		const btSpatialMotionVector *axes = m_links[i].m_axes;
 		fromParent.m_rotMat = rot_from_parent[i + 1];
 		fromParent.m_trnVec = m_links[i].m_cachedRVector;
 
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
+		for (int dof = 0; dof < dofCount; ++dof)
 		{
-			Y[m_links[i].m_dofOffset + dof] = force[6 + m_links[i].m_dofOffset + dof] - m_links[i].m_axes[dof].dot(zeroAccSpatFrc[i + 1]);
+			Y[dofOffset + dof] = force[6 + dofOffset + dof] - axes[dof].dot(zeroAccSpatFrc[i + 1]);
 		}
 
 		btVector3 in_top, in_bottom, out_top, out_bottom;
-		const btScalar *invDi = &invD[m_links[i].m_dofOffset * m_links[i].m_dofOffset];
+		const btScalar *invDi = &invD[dofOffset * dofOffset];
 
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
+		for (int dof = 0; dof < dofCount; ++dof)
 		{
 			invD_times_Y[dof] = 0.f;
 
-			for (int dof2 = 0; dof2 < m_links[i].m_dofCount; ++dof2)
+			for (int dof2 = 0; dof2 < dofCount; ++dof2)
 			{
-				invD_times_Y[dof] += invDi[dof * m_links[i].m_dofCount + dof2] * Y[m_links[i].m_dofOffset + dof2];
+				invD_times_Y[dof] += invDi[dof * dofCount + dof2] * Y[dofOffset + dof2];
 			}
 		}
 
 		// Zp += pXi * (Zi + hi*Yi/Di)
 		spatForceVecTemps[0] = zeroAccSpatFrc[i + 1];
 
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
+		for (int dof = 0; dof < dofCount; ++dof)
 		{
-			const btSpatialForceVector &hDof = h[m_links[i].m_dofOffset + dof];
+			const btSpatialForceVector &hDof = h[dofOffset + dof];
 			//
 			spatForceVecTemps[0] += hDof * invD_times_Y[dof];
 		}
@@ -1540,23 +1553,26 @@ void btMultiBody::calcAccelerationDeltasMultiDof(const btScalar *force, btScalar
 	for (int i = 0; i < num_links; ++i)
 	{
 		const int parent = m_links[i].m_parent;
+		const int dofOffset = m_links[i].m_dofOffset;
+		const int dofCount = m_links[i].m_dofCount;
+		const btSpatialMotionVector *axes = m_links[i].m_axes;
 		fromParent.m_rotMat = rot_from_parent[i + 1];
 		fromParent.m_trnVec = m_links[i].m_cachedRVector;
 
 		fromParent.transform(spatAcc[parent + 1], spatAcc[i + 1]);
 
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
+		for (int dof = 0; dof < dofCount; ++dof)
 		{
-			const btSpatialForceVector &hDof = h[m_links[i].m_dofOffset + dof];
+			const btSpatialForceVector &hDof = h[dofOffset + dof];
 			//
-			Y_minus_hT_a[dof] = Y[m_links[i].m_dofOffset + dof] - spatAcc[i + 1].dot(hDof);
+			Y_minus_hT_a[dof] = Y[dofOffset + dof] - spatAcc[i + 1].dot(hDof);
 		}
 
-		const btScalar *invDi = &invD[m_links[i].m_dofOffset * m_links[i].m_dofOffset];
-		mulMatrix(const_cast<btScalar *>(invDi), Y_minus_hT_a, m_links[i].m_dofCount, m_links[i].m_dofCount, m_links[i].m_dofCount, 1, &joint_accel[m_links[i].m_dofOffset]);
+		const btScalar *invDi = &invD[dofOffset * dofOffset];
+		mulMatrix(const_cast<btScalar *>(invDi), Y_minus_hT_a, dofCount, dofCount, dofCount, 1, &joint_accel[dofOffset]);
 
-		for (int dof = 0; dof < m_links[i].m_dofCount; ++dof)
-			spatAcc[i + 1] += m_links[i].m_axes[dof] * joint_accel[m_links[i].m_dofOffset + dof];
+		for (int dof = 0; dof < dofCount; ++dof)
+			spatAcc[i + 1] += axes[dof] * joint_accel[dofOffset + dof];
 	}
 
 	// transform base accelerations back to the world frame.
@@ -344,6 +344,10 @@ public:
 	// improvement, at least on Windows (where dynamic memory
 	// allocation appears to be fairly slow).
 	//
+	// The pass walks the link tree one link at a time. Bodies that share a link tree
+	// can be run through it together with btMultiBodyBatchedDynamics, which stores
+	// the per-link quantities lane-wise so the loops vectorize across the bodies.
+	//
 
 	void computeAccelerationsArticulatedBodyAlgorithmMultiDof(btScalar dt,
 															  btAlignedObjectArray<btScalar> & scratch_r,
@@ -619,6 +623,9 @@ public:
 
 
 private:
+	///btMultiBodyBatchedDynamics runs the articulated body algorithm for many bodies at once and fills the same caches
+	friend class btMultiBodyBatchedDynamics;
+
 	btMultiBody(const btMultiBody &);     // not implemented
 	void operator=(const btMultiBody &);  // not implemented
 
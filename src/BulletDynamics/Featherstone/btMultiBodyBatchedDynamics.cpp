@@ -0,0 +1,716 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btMultiBodyBatchedDynamics.h"
+#include "btMultiBody.h"
+#include "LinearMath/btQuickprof.h"
+
+#define BT_LANES BT_MULTIBODY_BATCH_WIDTH
+
+// Lane-wise storage: component c of lane l lives at m_c[c][l], so every loop over l
+// touches contiguous memory and performs the same operation for all instances.
+struct btLaneVector3
+{
+	btScalar m_c[3][BT_LANES];
+};
+
+struct btLaneMatrix3x3
+{
+	btScalar m_c[3][3][BT_LANES];
+};
+
+// Per body (base at index 0, link i at index i+1) data of BT_LANES instances.
+// Spatial motion vectors use top = angular, bottom = linear; spatial force vectors
+// use top = linear, bottom = angular, matching btSpatialMotionVector/btSpatialForceVector.
+struct btMultiBodyBatchLaneData
+{
+	// inputs
+	btLaneMatrix3x3 m_rotFromParent;
+	btLaneVector3 m_rVector;
+	btLaneVector3 m_axisTop;
+	btLaneVector3 m_axisBottom;
+	btLaneVector3 m_appliedForce;
+	btLaneVector3 m_appliedTorque;
+	btLaneVector3 m_inertiaLocal;
+	btScalar m_mass[BT_LANES];
+	btScalar m_jointVel[BT_LANES];
+	btScalar m_jointTorque[BT_LANES];
+	btScalar m_linearDamping[BT_LANES];
+	btScalar m_angularDamping[BT_LANES];
+
+	// articulated body algorithm state
+	btLaneMatrix3x3 m_rotFromWorld;
+	btLaneVector3 m_velTop, m_velBottom;
+	btLaneVector3 m_zeroAccTop, m_zeroAccBottom;
+	btLaneVector3 m_coriolisTop, m_coriolisBottom;
+	btLaneMatrix3x3 m_inertiaTopLeft, m_inertiaTopRight, m_inertiaBottomLeft;
+	btLaneVector3 m_hTop, m_hBottom;
+	btLaneVector3 m_accTop, m_accBottom;
+	btScalar m_Y[BT_LANES];
+	btScalar m_invD[BT_LANES];
+	btScalar m_jointAccel[BT_LANES];
+};
+
+static SIMD_FORCE_INLINE void laneSetVector(btLaneVector3& out, int l, const btVector3& v)
+{
+	out.m_c[0][l] = v[0];
+	out.m_c[1][l] = v[1];
+	out.m_c[2][l] = v[2];
+}
+
+static SIMD_FORCE_INLINE btVector3 laneGetVector(const btLaneVector3& v, int l)
+{
+	return btVector3(v.m_c[0][l], v.m_c[1][l], v.m_c[2][l]);
+}
+
+static SIMD_FORCE_INLINE void laneSetMatrix(btLaneMatrix3x3& out, int l, const btMatrix3x3& m)
+{
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			out.m_c[i][j][l] = m[i][j];
+}
+
+static SIMD_FORCE_INLINE btMatrix3x3 laneGetMatrix(const btLaneMatrix3x3& m, int l)
+{
+	return btMatrix3x3(m.m_c[0][0][l], m.m_c[0][1][l], m.m_c[0][2][l],
+					   m.m_c[1][0][l], m.m_c[1][1][l], m.m_c[1][2][l],
+					   m.m_c[2][0][l], m.m_c[2][1][l], m.m_c[2][2][l]);
+}
+
+static SIMD_FORCE_INLINE void laneSetZero(btLaneVector3& out)
+{
+	for (int c = 0; c < 3; c++)
+		for (int l = 0; l < BT_LANES; l++)
+			out.m_c[c][l] = 0;
+}
+
+//out = a * b
+static SIMD_FORCE_INLINE void laneMatMul(const btLaneMatrix3x3& a, const btLaneMatrix3x3& b, btLaneMatrix3x3& out)
+{
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			for (int l = 0; l < BT_LANES; l++)
+				out.m_c[i][j][l] = a.m_c[i][0][l] * b.m_c[0][j][l] + a.m_c[i][1][l] * b.m_c[1][j][l] + a.m_c[i][2][l] * b.m_c[2][j][l];
+}
+
+//out = a^T * b
+static SIMD_FORCE_INLINE void laneMatTransposeMul(const btLaneMatrix3x3& a, const btLaneMatrix3x3& b, btLaneMatrix3x3& out)
+{
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			for (int l = 0; l < BT_LANES; l++)
+				out.m_c[i][j][l] = a.m_c[0][i][l] * b.m_c[0][j][l] + a.m_c[1][i][l] * b.m_c[1][j][l] + a.m_c[2][i][l] * b.m_c[2][j][l];
+}
+
+//out = m * v
+static SIMD_FORCE_INLINE void laneMatVec(const btLaneMatrix3x3& m, const btLaneVector3& v, btLaneVector3& out)
+{
+	for (int i = 0; i < 3; i++)
+		for (int l = 0; l < BT_LANES; l++)
+			out.m_c[i][l] = m.m_c[i][0][l] * v.m_c[0][l] + m.m_c[i][1][l] * v.m_c[1][l] + m.m_c[i][2][l] * v.m_c[2][l];
+}
+
+//out = m^T * v
+static SIMD_FORCE_INLINE void laneMatTransposeVec(const btLaneMatrix3x3& m, const btLaneVector3& v, btLaneVector3& out)
+{
+	for (int i = 0; i < 3; i++)
+		for (int l = 0; l < BT_LANES; l++)
+			out.m_c[i][l] = m.m_c[0][i][l] * v.m_c[0][l] + m.m_c[1][i][l] * v.m_c[1][l] + m.m_c[2][i][l] * v.m_c[2][l];
+}
+
+//out = a x b
+static SIMD_FORCE_INLINE void laneCross(const btLaneVector3& a, const btLaneVector3& b, btLaneVector3& out)
+{
+	for (int l = 0; l < BT_LANES; l++)
+	{
+		const btScalar x = a.m_c[1][l] * b.m_c[2][l] - a.m_c[2][l] * b.m_c[1][l];
+		const btScalar y = a.m_c[2][l] * b.m_c[0][l] - a.m_c[0][l] * b.m_c[2][l];
+		const btScalar z = a.m_c[0][l] * b.m_c[1][l] - a.m_c[1][l] * b.m_c[0][l];
+		out.m_c[0][l] = x;
+		out.m_c[1][l] = y;
+		out.m_c[2][l] = z;
+	}
+}
+
+//spatial motion . spatial force
+static SIMD_FORCE_INLINE btScalar laneSpatialDot(const btLaneVector3& motionTop, const btLaneVector3& motionBottom,
+												 const btLaneVector3& forceTop, const btLaneVector3& forceBottom, int l)
+{
+	return motionBottom.m_c[0][l] * forceTop.m_c[0][l] + motionBottom.m_c[1][l] * forceTop.m_c[1][l] + motionBottom.m_c[2][l] * forceTop.m_c[2][l] +
+		   motionTop.m_c[0][l] * forceBottom.m_c[0][l] + motionTop.m_c[1][l] * forceBottom.m_c[1][l] + motionTop.m_c[2][l] * forceBottom.m_c[2][l];
+}
+
+//force = I * motion, see btSymmetricSpatialDyad::operator*
+static SIMD_FORCE_INLINE void laneInertiaTimesMotion(const btMultiBodyBatchLaneData& d, const btLaneVector3& motionTop, const btLaneVector3& motionBottom,
+													 btLaneVector3& forceTop, btLaneVector3& forceBottom)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		for (int l = 0; l < BT_LANES; l++)
+		{
+			forceBottom.m_c[i][l] = d.m_inertiaBottomLeft.m_c[i][0][l] * motionTop.m_c[0][l] + d.m_inertiaBottomLeft.m_c[i][1][l] * motionTop.m_c[1][l] + d.m_inertiaBottomLeft.m_c[i][2][l] * motionTop.m_c[2][l] +
+									d.m_inertiaTopLeft.m_c[0][i][l] * motionBottom.m_c[0][l] + d.m_inertiaTopLeft.m_c[1][i][l] * motionBottom.m_c[1][l] + d.m_inertiaTopLeft.m_c[2][i][l] * motionBottom.m_c[2][l];
+			forceTop.m_c[i][l] = d.m_inertiaTopLeft.m_c[i][0][l] * motionTop.m_c[0][l] + d.m_inertiaTopLeft.m_c[i][1][l] * motionTop.m_c[1][l] + d.m_inertiaTopLeft.m_c[i][2][l] * motionTop.m_c[2][l] +
+								 d.m_inertiaTopRight.m_c[i][0][l] * motionBottom.m_c[0][l] + d.m_inertiaTopRight.m_c[i][1][l] * motionBottom.m_c[1][l] + d.m_inertiaTopRight.m_c[i][2][l] * motionBottom.m_c[2][l];
+		}
+	}
+}
+
+//bias force (external forces, damping, gyroscopic terms) and rigid body spatial inertia,
+//see the first upward loop of btMultiBody::computeAccelerationsArticulatedBodyAlgorithmMultiDof
+static void laneInitBodyForces(btMultiBodyBatchLaneData& d, const btMultiBodyBatchLaneData& base, bool useGyroTerm)
+{
+	btLaneVector3 tmp;
+	laneMatVec(d.m_rotFromWorld, d.m_appliedForce, tmp);
+	for (int c = 0; c < 3; c++)
+		for (int l = 0; l < BT_LANES; l++)
+			d.m_zeroAccTop.m_c[c][l] = -tmp.m_c[c][l];
+	laneMatVec(d.m_rotFromWorld, d.m_appliedTorque, tmp);
+	for (int c = 0; c < 3; c++)
+		for (int l = 0; l < BT_LANES; l++)
+			d.m_zeroAccBottom.m_c[c][l] = -tmp.m_c[c][l];
+
+	for (int l = 0; l < BT_LANES; l++)
+	{
+		const btScalar wx = d.m_velTop.m_c[0][l], wy = d.m_velTop.m_c[1][l], wz = d.m_velTop.m_c[2][l];
+		const btScalar vx = d.m_velBottom.m_c[0][l], vy = d.m_velBottom.m_c[1][l], vz = d.m_velBottom.m_c[2][l];
+		const btScalar w2 = wx * wx + wy * wy + wz * wz;
+		const btScalar v2 = vx * vx + vy * vy + vz * vz;
+		const btScalar wNorm = w2 > SIMD_EPSILON ? btSqrt(w2) : btScalar(0);
+		const btScalar vNorm = v2 > SIMD_EPSILON ? btSqrt(v2) : btScalar(0);
+		const btScalar angDamp = base.m_angularDamping[l] + base.m_angularDamping[l] * wNorm;
+		const btScalar linDamp = base.m_linearDamping[l] + base.m_linearDamping[l] * vNorm;
+		const btScalar mass = d.m_mass[l];
+		const btScalar Iwx = d.m_inertiaLocal.m_c[0][l] * wx;
+		const btScalar Iwy = d.m_inertiaLocal.m_c[1][l] * wy;
+		const btScalar Iwz = d.m_inertiaLocal.m_c[2][l] * wz;
+
+		//damping terms
+		d.m_zeroAccBottom.m_c[0][l] += Iwx * angDamp;
+		d.m_zeroAccBottom.m_c[1][l] += Iwy * angDamp;
+		d.m_zeroAccBottom.m_c[2][l] += Iwz * angDamp;
+		d.m_zeroAccTop.m_c[0][l] += mass * vx * linDamp;
+		d.m_zeroAccTop.m_c[1][l] += mass * vy * linDamp;
+		d.m_zeroAccTop.m_c[2][l] += mass * vz * linDamp;
+
+		//p += vhat x Ihat vhat
+		if (useGyroTerm)
+		{
+			d.m_zeroAccBottom.m_c[0][l] += wy * Iwz - wz * Iwy;
+			d.m_zeroAccBottom.m_c[1][l] += wz * Iwx - wx * Iwz;
+			d.m_zeroAccBottom.m_c[2][l] += wx * Iwy - wy * Iwx;
+		}
+		d.m_zeroAccTop.m_c[0][l] += mass * (wy * vz - wz * vy);
+		d.m_zeroAccTop.m_c[1][l] += mass * (wz * vx - wx * vz);
+		d.m_zeroAccTop.m_c[2][l] += mass * (wx * vy - wy * vx);
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			for (int l = 0; l < BT_LANES; l++)
+			{
+				d.m_inertiaTopLeft.m_c[i][j][l] = 0;
+				d.m_inertiaTopRight.m_c[i][j][l] = i == j ? d.m_mass[l] : btScalar(0);
+				d.m_inertiaBottomLeft.m_c[i][j][l] = i == j ? d.m_inertiaLocal.m_c[i][l] : btScalar(0);
+			}
+		}
+	}
+}
+
+//parent += child X^T * inertia * child X, see btSpatialTransformationMatrix::transformInverse
+static void laneTransformInverseInertiaAdd(const btMultiBodyBatchLaneData& child,
+										   const btLaneMatrix3x3& topLeft, const btLaneMatrix3x3& topRight, const btLaneMatrix3x3& bottomLeft,
+										   btMultiBodyBatchLaneData& parent)
+{
+	btLaneMatrix3x3 rCross;
+	for (int l = 0; l < BT_LANES; l++)
+	{
+		const btScalar rx = child.m_rVector.m_c[0][l], ry = child.m_rVector.m_c[1][l], rz = child.m_rVector.m_c[2][l];
+		rCross.m_c[0][0][l] = 0;
+		rCross.m_c[0][1][l] = -rz;
+		rCross.m_c[0][2][l] = ry;
+		rCross.m_c[1][0][l] = rz;
+		rCross.m_c[1][1][l] = 0;
+		rCross.m_c[1][2][l] = -rx;
+		rCross.m_c[2][0][l] = -ry;
+		rCross.m_c[2][1][l] = rx;
+		rCross.m_c[2][2][l] = 0;
+	}
+
+	const btLaneMatrix3x3& rot = child.m_rotFromParent;
+	btLaneMatrix3x3 t0, t1, t2;
+
+	//t0 = topLeft - topRight * rCross
+	laneMatMul(topRight, rCross, t1);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			for (int l = 0; l < BT_LANES; l++)
+				t0.m_c[i][j][l] = topLeft.m_c[i][j][l] - t1.m_c[i][j][l];
+
+	//parent.topLeft += R^T * t0 * R
+	laneMatMul(t0, rot, t1);
+	laneMatTransposeMul(rot, t1, t2);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			for (int l = 0; l < BT_LANES; l++)
+				parent.m_inertiaTopLeft.m_c[i][j][l] += t2.m_c[i][j][l];
+
+	//parent.topRight += R^T * topRight * R
+	laneMatMul(topRight, rot, t1);
+	laneMatTransposeMul(rot, t1, t2);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			for (int l = 0; l < BT_LANES; l++)
+				parent.m_inertiaTopRight.m_c[i][j][l] += t2.m_c[i][j][l];
+
+	//parent.bottomLeft += R^T * (rCross * t0 + bottomLeft - topLeft^T * rCross) * R
+	laneMatMul(rCross, t0, t1);
+	laneMatTransposeMul(topLeft, rCross, t2);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			for (int l = 0; l < BT_LANES; l++)
+				t1.m_c[i][j][l] += bottomLeft.m_c[i][j][l] - t2.m_c[i][j][l];
+	laneMatMul(t1, rot, t0);
+	laneMatTransposeMul(rot, t0, t2);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			for (int l = 0; l < BT_LANES; l++)
+				parent.m_inertiaBottomLeft.m_c[i][j][l] += t2.m_c[i][j][l];
+}
+
+btMultiBodyBatchedDynamics::btMultiBodyBatchedDynamics()
+	: m_numBatchedBodies(0),
+	  m_numFallbackBodies(0)
+{
+}
+
+btMultiBodyBatchedDynamics::~btMultiBodyBatchedDynamics()
+{
+}
+
+bool btMultiBodyBatchedDynamics::canBatch(const btMultiBody* body)
+{
+	if (body->isUsingGlobalVelocities())
+		return false;
+
+	for (int i = 0; i < body->getNumLinks(); i++)
+	{
+		const btMultibodyLink& link = body->getLink(i);
+		if (link.m_jointFeedback)
+			return false;
+
+		switch (link.m_jointType)
+		{
+			case btMultibodyLink::eRevolute:
+			case btMultibodyLink::ePrismatic:
+			case btMultibodyLink::eFixed:
+				break;
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+void btMultiBodyBatchedDynamics::buildSignature(const btMultiBody* body, btAlignedObjectArray<int>& signature) const
+{
+	signature.resize(0);
+	signature.push_back(body->getNumLinks());
+	signature.push_back(body->hasFixedBase() ? 1 : 0);
+	signature.push_back(body->getUseGyroTerm() ? 1 : 0);
+	for (int i = 0; i < body->getNumLinks(); i++)
+	{
+		signature.push_back(body->getLink(i).m_parent);
+		signature.push_back(body->getLink(i).m_jointType);
+	}
+}
+
+void btMultiBodyBatchedDynamics::computeAccelerations(btMultiBody** bodies, int numBodies, btScalar dt,
+													  bool isConstraintPass,
+													  bool jointFeedbackInWorldSpace,
+													  bool jointFeedbackInJointFrame)
+{
+	BT_PROFILE("btMultiBodyBatchedDynamics::computeAccelerations");
+
+	m_numBatchedBodies = 0;
+	m_numFallbackBodies = 0;
+
+	for (int g = 0; g < m_groups.size(); g++)
+	{
+		m_groups[g].m_bodies.resize(0);
+	}
+
+	for (int b = 0; b < numBodies; b++)
+	{
+		btMultiBody* body = bodies[b];
+		if (!canBatch(body))
+		{
+			body->computeAccelerationsArticulatedBodyAlgorithmMultiDof(dt, m_scratch_r, m_scratch_v, m_scratch_m, isConstraintPass,
+																	   jointFeedbackInWorldSpace, jointFeedbackInJointFrame);
+			m_numFallbackBodies++;
+			continue;
+		}
+
+		buildSignature(body, m_scratchSignature);
+		int groupIndex = -1;
+		for (int g = 0; g < m_groups.size() && groupIndex < 0; g++)
+		{
+			const btAlignedObjectArray<int>& signature = m_groups[g].m_signature;
+			if (signature.size() != m_scratchSignature.size())
+				continue;
+			bool match = true;
+			for (int i = 0; i < signature.size() && match; i++)
+			{
+				match = signature[i] == m_scratchSignature[i];
+			}
+			if (match)
+				groupIndex = g;
+		}
+		if (groupIndex < 0)
+		{
+			groupIndex = m_groups.size();
+			m_groups.expand();
+			m_groups[groupIndex].m_signature = m_scratchSignature;
+			m_groups[groupIndex].m_bodies.resize(0);
+		}
+		m_groups[groupIndex].m_bodies.push_back(body);
+	}
+
+	for (int g = 0; g < m_groups.size(); g++)
+	{
+		btAlignedObjectArray<btMultiBody*>& groupBodies = m_groups[g].m_bodies;
+		for (int start = 0; start < groupBodies.size(); start += BT_LANES)
+		{
+			const int numLanes = btMin(int(BT_LANES), groupBodies.size() - start);
+			computeLanes(&groupBodies[start], numLanes, dt, isConstraintPass);
+			m_numBatchedBodies += numLanes;
+		}
+	}
+}
+
+void btMultiBodyBatchedDynamics::computeLanes(btMultiBody** bodies, int numLanes, btScalar dt, bool isConstraintPass)
+{
+	btMultiBody* first = bodies[0];
+	const int numLinks = first->getNumLinks();
+	const int numDofs = first->getNumDofs();
+	const bool fixedBase = first->hasFixedBase();
+	const bool useGyroTerm = first->getUseGyroTerm();
+
+	m_laneData.resizeNoInitialize(numLinks + 1);
+	btMultiBodyBatchLaneData* data = &m_laneData[0];
+
+	// gather; unused lanes replicate the first body so every lane holds valid numbers
+	for (int l = 0; l < BT_LANES; l++)
+	{
+		const btMultiBody* body = l < numLanes ? bodies[l] : first;
+
+		btMultiBodyBatchLaneData& base = data[0];
+		const btMatrix3x3 baseRot(body->m_baseQuat);
+		laneSetMatrix(base.m_rotFromParent, l, baseRot);
+		laneSetMatrix(base.m_rotFromWorld, l, baseRot);
+		laneSetVector(base.m_velTop, l, baseRot * body->getBaseOmega());
+		laneSetVector(base.m_velBottom, l, baseRot * body->getBaseVel());
+		laneSetVector(base.m_appliedForce, l, isConstraintPass ? body->m_baseConstraintForce : body->m_baseForce);
+		laneSetVector(base.m_appliedTorque, l, isConstraintPass ? body->m_baseConstraintTorque : body->m_baseTorque);
+		laneSetVector(base.m_inertiaLocal, l, body->m_baseInertia);
+		base.m_mass[l] = body->m_baseMass;
+		base.m_linearDamping[l] = body->m_linearDamping;
+		base.m_angularDamping[l] = body->m_angularDamping;
+
+		for (int i = 0; i < numLinks; i++)
+		{
+			const btMultibodyLink& link = body->m_links[i];
+			btMultiBodyBatchLaneData& d = data[i + 1];
+			laneSetMatrix(d.m_rotFromParent, l, btMatrix3x3(link.m_cachedRotParentToThis));
+			laneSetVector(d.m_rVector, l, link.m_cachedRVector);
+			laneSetVector(d.m_appliedForce, l, isConstraintPass ? link.m_appliedConstraintForce : link.m_appliedForce);
+			laneSetVector(d.m_appliedTorque, l, isConstraintPass ? link.m_appliedConstraintTorque : link.m_appliedTorque);
+			laneSetVector(d.m_inertiaLocal, l, link.m_inertiaLocal);
+			d.m_mass[l] = link.m_mass;
+			if (link.m_dofCount == 1)
+			{
+				laneSetVector(d.m_axisTop, l, link.m_axes[0].m_topVec);
+				laneSetVector(d.m_axisBottom, l, link.m_axes[0].m_bottomVec);
+				d.m_jointVel[l] = body->m_realBuf[6 + link.m_dofOffset];
+				d.m_jointTorque[l] = link.m_jointTorque[0];
+			}
+		}
+	}
+
+	// First 'upward' loop: velocities, coriolis terms, bias forces and rigid body inertias.
+	if (fixedBase)
+	{
+		laneSetZero(data[0].m_zeroAccTop);
+		laneSetZero(data[0].m_zeroAccBottom);
+	}
+	else
+	{
+		laneInitBodyForces(data[0], data[0], useGyroTerm);
+	}
+	if (fixedBase)
+	{
+		//the inertia of a fixed base is never used, but keep it well defined
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+				for (int l = 0; l < BT_LANES; l++)
+				{
+					data[0].m_inertiaTopLeft.m_c[i][j][l] = 0;
+					data[0].m_inertiaTopRight.m_c[i][j][l] = 0;
+					data[0].m_inertiaBottomLeft.m_c[i][j][l] = 0;
+				}
+	}
+
+	for (int i = 0; i < numLinks; i++)
+	{
+		const btMultibodyLink& link = first->m_links[i];
+		btMultiBodyBatchLaneData& d = data[i + 1];
+		const btMultiBodyBatchLaneData& p = data[link.m_parent + 1];
+		btLaneVector3 tmp;
+
+		laneMatMul(d.m_rotFromParent, p.m_rotFromWorld, d.m_rotFromWorld);
+
+		//vhat_i = i_xhat_p(i) * vhat_p(i)
+		laneMatVec(d.m_rotFromParent, p.m_velTop, d.m_velTop);
+		laneMatVec(d.m_rotFromParent, p.m_velBottom, d.m_velBottom);
+		laneCross(d.m_rVector, d.m_velTop, tmp);
+		for (int c = 0; c < 3; c++)
+			for (int l = 0; l < BT_LANES; l++)
+				d.m_velBottom.m_c[c][l] -= tmp.m_c[c][l];
+
+		if (link.m_dofCount == 1)
+		{
+			//vhat_i += qidot * shat_i, chat_i = vhat_i x (qidot * shat_i)
+			btLaneVector3 jointVelTop, jointVelBottom;
+			for (int c = 0; c < 3; c++)
+			{
+				for (int l = 0; l < BT_LANES; l++)
+				{
+					jointVelTop.m_c[c][l] = d.m_axisTop.m_c[c][l] * d.m_jointVel[l];
+					jointVelBottom.m_c[c][l] = d.m_axisBottom.m_c[c][l] * d.m_jointVel[l];
+					d.m_velTop.m_c[c][l] += jointVelTop.m_c[c][l];
+					d.m_velBottom.m_c[c][l] += jointVelBottom.m_c[c][l];
+				}
+			}
+			laneCross(d.m_velTop, jointVelTop, d.m_coriolisTop);
+			laneCross(d.m_velBottom, jointVelTop, d.m_coriolisBottom);
+			laneCross(d.m_velTop, jointVelBottom, tmp);
+			for (int c = 0; c < 3; c++)
+				for (int l = 0; l < BT_LANES; l++)
+					d.m_coriolisBottom.m_c[c][l] += tmp.m_c[c][l];
+		}
+		else
+		{
+			laneSetZero(d.m_coriolisTop);
+			laneSetZero(d.m_coriolisBottom);
+		}
+
+		laneInitBodyForces(d, data[0], useGyroTerm);
+	}
+
+	// 'Downward' loop: articulated body inertias and bias forces.
+	for (int i = numLinks - 1; i >= 0; --i)
+	{
+		const btMultibodyLink& link = first->m_links[i];
+		btMultiBodyBatchLaneData& d = data[i + 1];
+		btMultiBodyBatchLaneData& p = data[link.m_parent + 1];
+
+		btLaneMatrix3x3 topLeft = d.m_inertiaTopLeft;
+		btLaneMatrix3x3 topRight = d.m_inertiaTopRight;
+		btLaneMatrix3x3 bottomLeft = d.m_inertiaBottomLeft;
+
+		// f = zhat_i + Ihat_i * chat_i (+ h_i * D_i^{-1} * Y_i)
+		btLaneVector3 forceTop, forceBottom;
+		laneInertiaTimesMotion(d, d.m_coriolisTop, d.m_coriolisBottom, forceTop, forceBottom);
+		for (int c = 0; c < 3; c++)
+		{
+			for (int l = 0; l < BT_LANES; l++)
+			{
+				forceTop.m_c[c][l] += d.m_zeroAccTop.m_c[c][l];
+				forceBottom.m_c[c][l] += d.m_zeroAccBottom.m_c[c][l];
+			}
+		}
+
+		if (link.m_dofCount == 1)
+		{
+			laneInertiaTimesMotion(d, d.m_axisTop, d.m_axisBottom, d.m_hTop, d.m_hBottom);
+
+			for (int l = 0; l < BT_LANES; l++)
+			{
+				const btScalar D = laneSpatialDot(d.m_axisTop, d.m_axisBottom, d.m_hTop, d.m_hBottom, l);
+				d.m_invD[l] = D >= SIMD_EPSILON ? btScalar(1.) / D : btScalar(0.);
+				d.m_Y[l] = d.m_jointTorque[l] - laneSpatialDot(d.m_axisTop, d.m_axisBottom, d.m_zeroAccTop, d.m_zeroAccBottom, l) - laneSpatialDot(d.m_coriolisTop, d.m_coriolisBottom, d.m_hTop, d.m_hBottom, l);
+			}
+
+			//Ihat_i - h_i * D_i^{-1} * h_i^T
+			for (int r = 0; r < 3; r++)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					for (int l = 0; l < BT_LANES; l++)
+					{
+						const btScalar s = d.m_invD[l];
+						topLeft.m_c[r][c][l] -= d.m_hTop.m_c[r][l] * d.m_hBottom.m_c[c][l] * s;
+						topRight.m_c[r][c][l] -= d.m_hTop.m_c[r][l] * d.m_hTop.m_c[c][l] * s;
+						bottomLeft.m_c[r][c][l] -= d.m_hBottom.m_c[r][l] * d.m_hBottom.m_c[c][l] * s;
+					}
+				}
+			}
+
+			for (int c = 0; c < 3; c++)
+			{
+				for (int l = 0; l < BT_LANES; l++)
+				{
+					const btScalar invDY = d.m_invD[l] * d.m_Y[l];
+					forceTop.m_c[c][l] += d.m_hTop.m_c[c][l] * invDY;
+					forceBottom.m_c[c][l] += d.m_hBottom.m_c[c][l] * invDY;
+				}
+			}
+		}
+
+		laneTransformInverseInertiaAdd(d, topLeft, topRight, bottomLeft, p);
+
+		//zhat_p(i) += p(i)_xhat_i^T * f
+		btLaneVector3 tmp;
+		laneCross(d.m_rVector, forceTop, tmp);
+		for (int c = 0; c < 3; c++)
+			for (int l = 0; l < BT_LANES; l++)
+				forceBottom.m_c[c][l] += tmp.m_c[c][l];
+		laneMatTransposeVec(d.m_rotFromParent, forceTop, tmp);
+		for (int c = 0; c < 3; c++)
+			for (int l = 0; l < BT_LANES; l++)
+				p.m_zeroAccTop.m_c[c][l] += tmp.m_c[c][l];
+		laneMatTransposeVec(d.m_rotFromParent, forceBottom, tmp);
+		for (int c = 0; c < 3; c++)
+			for (int l = 0; l < BT_LANES; l++)
+				p.m_zeroAccBottom.m_c[c][l] += tmp.m_c[c][l];
+	}
+
+	// Base acceleration: the 6x6 solve is done per instance with the body's own solveImatrix.
+	for (int l = 0; l < numLanes; l++)
+	{
+		btMultiBody* body = bodies[l];
+		if (fixedBase)
+		{
+			laneSetVector(data[0].m_accTop, l, btVector3(0, 0, 0));
+			laneSetVector(data[0].m_accBottom, l, btVector3(0, 0, 0));
+			continue;
+		}
+		if (numLinks > 0)
+		{
+			body->m_cachedInertiaValid = true;
+			body->m_cachedInertiaTopLeft = laneGetMatrix(data[0].m_inertiaTopLeft, l);
+			body->m_cachedInertiaTopRight = laneGetMatrix(data[0].m_inertiaTopRight, l);
+			body->m_cachedInertiaLowerLeft = laneGetMatrix(data[0].m_inertiaBottomLeft, l);
+			body->m_cachedInertiaLowerRight = body->m_cachedInertiaTopLeft.transpose();
+		}
+		btSpatialMotionVector result;
+		body->solveImatrix(btSpatialForceVector(laneGetVector(data[0].m_zeroAccBottom, l), laneGetVector(data[0].m_zeroAccTop, l)), result);
+		laneSetVector(data[0].m_accTop, l, -result.m_topVec);
+		laneSetVector(data[0].m_accBottom, l, -result.m_bottomVec);
+	}
+	for (int l = numLanes; l < BT_LANES; l++)
+	{
+		laneSetVector(data[0].m_accTop, l, laneGetVector(data[0].m_accTop, 0));
+		laneSetVector(data[0].m_accBottom, l, laneGetVector(data[0].m_accBottom, 0));
+	}
+
+	// Second 'upward' loop: joint and link accelerations.
+	for (int i = 0; i < numLinks; i++)
+	{
+		const btMultibodyLink& link = first->m_links[i];
+		btMultiBodyBatchLaneData& d = data[i + 1];
+		const btMultiBodyBatchLaneData& p = data[link.m_parent + 1];
+		btLaneVector3 tmp;
+
+		laneMatVec(d.m_rotFromParent, p.m_accTop, d.m_accTop);
+		laneMatVec(d.m_rotFromParent, p.m_accBottom, d.m_accBottom);
+		laneCross(d.m_rVector, d.m_accTop, tmp);
+		for (int c = 0; c < 3; c++)
+			for (int l = 0; l < BT_LANES; l++)
+				d.m_accBottom.m_c[c][l] -= tmp.m_c[c][l];
+
+		if (link.m_dofCount == 1)
+		{
+			//qdd = D^{-1} * (Y - h^{T}*apar)
+			for (int l = 0; l < BT_LANES; l++)
+			{
+				d.m_jointAccel[l] = d.m_invD[l] * (d.m_Y[l] - laneSpatialDot(d.m_accTop, d.m_accBottom, d.m_hTop, d.m_hBottom, l));
+			}
+			//a = apar + cor + Sqdd
+			for (int c = 0; c < 3; c++)
+			{
+				for (int l = 0; l < BT_LANES; l++)
+				{
+					d.m_accTop.m_c[c][l] += d.m_coriolisTop.m_c[c][l] + d.m_axisTop.m_c[c][l] * d.m_jointAccel[l];
+					d.m_accBottom.m_c[c][l] += d.m_coriolisBottom.m_c[c][l] + d.m_axisBottom.m_c[c][l] * d.m_jointAccel[l];
+				}
+			}
+		}
+		else
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				for (int l = 0; l < BT_LANES; l++)
+				{
+					d.m_accTop.m_c[c][l] += d.m_coriolisTop.m_c[c][l];
+					d.m_accBottom.m_c[c][l] += d.m_coriolisBottom.m_c[c][l];
+				}
+			}
+		}
+	}
+
+	// scatter results and caches back into the per-instance btMultiBody
+	m_scratchOutput.resize(6 + numDofs);
+	btScalar* output = &m_scratchOutput[0];
+	for (int l = 0; l < numLanes; l++)
+	{
+		btMultiBody* body = bodies[l];
+		body->m_internalNeedsJointFeedback = false;
+
+		btSpatialForceVector* h = numDofs > 0 ? (btSpatialForceVector*)&body->m_vectorBuf[0] : 0;
+		btScalar* invD = numDofs > 0 ? &body->m_realBuf[6 + numDofs] : 0;
+
+		body->m_matrixBuf[0] = laneGetMatrix(data[0].m_rotFromParent, l);
+		for (int i = 0; i < numLinks; i++)
+		{
+			const btMultibodyLink& link = body->m_links[i];
+			const btMultiBodyBatchLaneData& d = data[i + 1];
+			body->m_matrixBuf[i + 1] = laneGetMatrix(d.m_rotFromParent, l);
+			if (link.m_dofCount == 1)
+			{
+				h[link.m_dofOffset].m_topVec = laneGetVector(d.m_hTop, l);
+				h[link.m_dofOffset].m_bottomVec = laneGetVector(d.m_hBottom, l);
+				invD[link.m_dofOffset * link.m_dofOffset] = d.m_invD[l];
+				output[6 + link.m_dofOffset] = d.m_jointAccel[l];
+			}
+		}
+
+		// transform base accelerations back to the world frame.
+		const btMatrix3x3 baseRot = laneGetMatrix(data[0].m_rotFromParent, l);
+		const btVector3 omegadot_out = baseRot.transpose() * laneGetVector(data[0].m_accTop, l);
+		const btVector3 vdot_out = baseRot.transpose() * (laneGetVector(data[0].m_accBottom, l) + laneGetVector(data[0].m_velTop, l).cross(laneGetVector(data[0].m_velBottom, l)));
+		output[0] = omegadot_out[0];
+		output[1] = omegadot_out[1];
+		output[2] = omegadot_out[2];
+		output[3] = vdot_out[0];
+		output[4] = vdot_out[1];
+		output[5] = vdot_out[2];
+
+		if (!isConstraintPass && dt > 0.)
+			body->applyDeltaVeeMultiDof(output, dt);
+	}
+}
@@ -0,0 +1,87 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_MULTIBODY_BATCHED_DYNAMICS_H
+#define BT_MULTIBODY_BATCHED_DYNAMICS_H
+
+#include "LinearMath/btScalar.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btMatrix3x3.h"
+
+class btMultiBody;
+
+///number of btMultiBody instances processed together, one per lane (4, 8 or 16)
+#ifndef BT_MULTIBODY_BATCH_WIDTH
+#define BT_MULTIBODY_BATCH_WIDTH 8
+#endif
+
+struct btMultiBodyBatchLaneData;
+
+///btMultiBodyBatchedDynamics runs the forward dynamics (articulated body algorithm) step of many btMultiBody
+///instances that share the same topology. Bodies with the same link tree and joint types are grouped and processed
+///BT_MULTIBODY_BATCH_WIDTH at a time, with every per-link quantity stored lane-wise so the inner loops vectorize.
+///Each btMultiBody remains the per-instance view: the results (velocities and the caches used by
+///calcAccelerationDeltasMultiDof) are written back exactly as computeAccelerationsArticulatedBodyAlgorithmMultiDof does.
+///Bodies that cannot be batched (multi-dof joints, global velocities, joint feedback) use the regular per-body path.
+class btMultiBodyBatchedDynamics
+{
+	struct btBatchGroup
+	{
+		btAlignedObjectArray<int> m_signature;
+		btAlignedObjectArray<btMultiBody*> m_bodies;
+	};
+
+	btAlignedObjectArray<btBatchGroup> m_groups;
+	btAlignedObjectArray<int> m_scratchSignature;
+	btAlignedObjectArray<btMultiBodyBatchLaneData> m_laneData;
+	btAlignedObjectArray<btScalar> m_scratchOutput;
+
+	btAlignedObjectArray<btScalar> m_scratch_r;
+	btAlignedObjectArray<btVector3> m_scratch_v;
+	btAlignedObjectArray<btMatrix3x3> m_scratch_m;
+
+	int m_numBatchedBodies;
+	int m_numFallbackBodies;
+
+	void buildSignature(const btMultiBody* body, btAlignedObjectArray<int>& signature) const;
+	void computeLanes(btMultiBody** bodies, int numLanes, btScalar dt, bool isConstraintPass);
+
+public:
+	btMultiBodyBatchedDynamics();
+	~btMultiBodyBatchedDynamics();
+
+	///returns true if the body can be processed in lanes
+	static bool canBatch(const btMultiBody* body);
+
+	///equivalent to calling computeAccelerationsArticulatedBodyAlgorithmMultiDof(dt, ..., isConstraintPass, jointFeedbackInWorldSpace, jointFeedbackInJointFrame)
+	///for every body, but processes bodies sharing a topology in lanes
+	void computeAccelerations(btMultiBody** bodies, int numBodies, btScalar dt,
+							  bool isConstraintPass = false,
+							  bool jointFeedbackInWorldSpace = false,
+							  bool jointFeedbackInJointFrame = false);
+
+	///number of bodies that went through the lane path in the last computeAccelerations call
+	int getNumBatchedBodies() const
+	{
+		return m_numBatchedBodies;
+	}
+	///number of bodies that used the per-body path in the last computeAccelerations call
+	int getNumFallbackBodies() const
+	{
+		return m_numFallbackBodies;
+	}
+};
+
+#endif  //BT_MULTIBODY_BATCHED_DYNAMICS_H
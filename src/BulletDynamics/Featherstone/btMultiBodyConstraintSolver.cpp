@@ -22,61 +22,56 @@ subject to the following restrictions:
 #include "BulletDynamics/ConstraintSolver/btContactSolverInfo.h"
 
 #include "LinearMath/btQuickprof.h"
-
-btScalar btMultiBodyConstraintSolver::solveSingleIteration(int iteration, btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
+#include "LinearMath/btThreads.h"
+
+btMultiBodyConstraintSolver::btMultiBodyConstraintSolver()
+	: m_tmpMultiBodyConstraints(0),
+	  m_tmpNumMultiBodyConstraints(0),
+	  m_useConstraintColoring(false),
+	  m_constraintsColored(false),
+	  m_minColorSize(64),
+	  m_coloringGrainSize(16)
 {
-	btScalar leastSquaredResidual = btSequentialImpulseConstraintSolver::solveSingleIteration(iteration, bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
-
-	//solve featherstone non-contact constraints
-
-	//printf("m_multiBodyNonContactConstraints = %d\n",m_multiBodyNonContactConstraints.size());
-
-	for (int j = 0; j < m_multiBodyNonContactConstraints.size(); j++)
-	{
-		int index = iteration & 1 ? j : m_multiBodyNonContactConstraints.size() - 1 - j;
-
-		btMultiBodySolverConstraint& constraint = m_multiBodyNonContactConstraints[index];
-
-		btScalar residual = resolveSingleConstraintRowGeneric(constraint);
-		leastSquaredResidual = btMax(leastSquaredResidual, residual * residual);
-
-		if (constraint.m_multiBodyA)
-			constraint.m_multiBodyA->setPosUpdated(false);
-		if (constraint.m_multiBodyB)
-			constraint.m_multiBodyB->setPosUpdated(false);
-	}
+}
 
-	//solve featherstone normal contact
-	for (int j0 = 0; j0 < m_multiBodyNormalContactConstraints.size(); j0++)
+btScalar btMultiBodyConstraintSolver::solveConstraintItem(btMultiBodyConstraintItemType type, int index, int iteration, const btContactSolverInfo& infoGlobal)
+{
+	switch (type)
 	{
-		int index = j0;  //iteration&1? j0 : m_multiBodyNormalContactConstraints.size()-1-j0;
+		case BT_MULTIBODY_ITEM_NON_CONTACT:
+		{
+			btMultiBodySolverConstraint& constraint = m_multiBodyNonContactConstraints[index];
 
-		btMultiBodySolverConstraint& constraint = m_multiBodyNormalContactConstraints[index];
-		btScalar residual = 0.f;
+			btScalar residual = resolveSingleConstraintRowGeneric(constraint);
 
-		if (iteration < infoGlobal.m_numIterations)
-		{
-			residual = resolveSingleConstraintRowGeneric(constraint);
+			if (constraint.m_multiBodyA)
+				constraint.m_multiBodyA->setPosUpdated(false);
+			if (constraint.m_multiBodyB)
+				constraint.m_multiBodyB->setPosUpdated(false);
+			return residual * residual;
 		}
+		case BT_MULTIBODY_ITEM_NORMAL_CONTACT:
+		{
+			btMultiBodySolverConstraint& constraint = m_multiBodyNormalContactConstraints[index];
+			btScalar residual = 0.f;
 
-		leastSquaredResidual = btMax(leastSquaredResidual, residual * residual);
-
-		if (constraint.m_multiBodyA)
-			constraint.m_multiBodyA->setPosUpdated(false);
-		if (constraint.m_multiBodyB)
-			constraint.m_multiBodyB->setPosUpdated(false);
-	}
+			if (iteration < infoGlobal.m_numIterations)
+			{
+				residual = resolveSingleConstraintRowGeneric(constraint);
+			}
 
-	//solve featherstone frictional contact
-	if (infoGlobal.m_solverMode & SOLVER_USE_2_FRICTION_DIRECTIONS && ((infoGlobal.m_solverMode & SOLVER_DISABLE_IMPLICIT_CONE_FRICTION) == 0))
-	{
-		for (int j1 = 0; j1 < this->m_multiBodyTorsionalFrictionContactConstraints.size(); j1++)
+			if (constraint.m_multiBodyA)
+				constraint.m_multiBodyA->setPosUpdated(false);
+			if (constraint.m_multiBodyB)
+				constraint.m_multiBodyB->setPosUpdated(false);
+			return residual * residual;
+		}
+		case BT_MULTIBODY_ITEM_TORSIONAL_FRICTION:
+		case BT_MULTIBODY_ITEM_FRICTION:
 		{
 			if (iteration < infoGlobal.m_numIterations)
 			{
-				int index = j1;  //iteration&1? j1 : m_multiBodyTorsionalFrictionContactConstraints.size()-1-j1;
-
-				btMultiBodySolverConstraint& frictionConstraint = m_multiBodyTorsionalFrictionContactConstraints[index];
+				btMultiBodySolverConstraint& frictionConstraint = type == BT_MULTIBODY_ITEM_FRICTION ? m_multiBodyFrictionContactConstraints[index] : m_multiBodyTorsionalFrictionContactConstraints[index];
 				btScalar totalImpulse = m_multiBodyNormalContactConstraints[frictionConstraint.m_frictionIndex].m_appliedImpulse;
 				//adjust friction limits here
 				if (totalImpulse > btScalar(0))
@@ -84,27 +79,23 @@ btScalar btMultiBodyConstraintSolver::solveSingleIteration(int iteration, btColl
 					frictionConstraint.m_lowerLimit = -(frictionConstraint.m_friction * totalImpulse);
 					frictionConstraint.m_upperLimit = frictionConstraint.m_friction * totalImpulse;
 					btScalar residual = resolveSingleConstraintRowGeneric(frictionConstraint);
-					leastSquaredResidual = btMax(leastSquaredResidual, residual * residual);
 
 					if (frictionConstraint.m_multiBodyA)
 						frictionConstraint.m_multiBodyA->setPosUpdated(false);
 					if (frictionConstraint.m_multiBodyB)
 						frictionConstraint.m_multiBodyB->setPosUpdated(false);
+					return residual * residual;
 				}
 			}
+			return 0.f;
 		}
-
-		for (int j1 = 0; j1 < this->m_multiBodyFrictionContactConstraints.size(); j1++)
+		case BT_MULTIBODY_ITEM_CONE_FRICTION:
 		{
 			if (iteration < infoGlobal.m_numIterations)
 			{
-				int index = j1;  //iteration&1? j1 : m_multiBodyFrictionContactConstraints.size()-1-j1;
 				btMultiBodySolverConstraint& frictionConstraint = m_multiBodyFrictionContactConstraints[index];
-
 				btScalar totalImpulse = m_multiBodyNormalContactConstraints[frictionConstraint.m_frictionIndex].m_appliedImpulse;
-				j1++;
-				int index2 = j1;  //iteration&1? j1 : m_multiBodyFrictionContactConstraints.size()-1-j1;
-				btMultiBodySolverConstraint& frictionConstraintB = m_multiBodyFrictionContactConstraints[index2];
+				btMultiBodySolverConstraint& frictionConstraintB = m_multiBodyFrictionContactConstraints[index + 1];
 				btAssert(frictionConstraint.m_frictionIndex == frictionConstraintB.m_frictionIndex);
 
 				if (frictionConstraint.m_frictionIndex == frictionConstraintB.m_frictionIndex)
@@ -114,7 +105,6 @@ btScalar btMultiBodyConstraintSolver::solveSingleIteration(int iteration, btColl
 					frictionConstraintB.m_lowerLimit = -(frictionConstraintB.m_friction * totalImpulse);
 					frictionConstraintB.m_upperLimit = frictionConstraintB.m_friction * totalImpulse;
 					btScalar residual = resolveConeFrictionConstraintRows(frictionConstraint, frictionConstraintB);
-					leastSquaredResidual = btMax(leastSquaredResidual, residual * residual);
 
 					if (frictionConstraintB.m_multiBodyA)
 						frictionConstraintB.m_multiBodyA->setPosUpdated(false);
@@ -125,37 +115,256 @@ btScalar btMultiBodyConstraintSolver::solveSingleIteration(int iteration, btColl
 						frictionConstraint.m_multiBodyA->setPosUpdated(false);
 					if (frictionConstraint.m_multiBodyB)
 						frictionConstraint.m_multiBodyB->setPosUpdated(false);
+					return residual * residual;
 				}
 			}
+			return 0.f;
+		}
+		default:
+			btAssert(0);
+	}
+	return 0.f;
+}
+
+struct btMultiBodyColorSolverLoop : public btIParallelForBody
+{
+	btMultiBodyConstraintSolver* m_solver;
+	btMultiBodyConstraintSolver::btMultiBodyConstraintItemType m_type;
+	const int* m_items;
+	btScalar* m_residuals;
+	int m_iteration;
+	const btContactSolverInfo* m_infoGlobal;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			m_residuals[i] = m_solver->solveConstraintItem(m_type, m_items[i], m_iteration, *m_infoGlobal);
+		}
+	}
+};
+
+btScalar btMultiBodyConstraintSolver::solveColoredItems(btMultiBodyConstraintItemType type, int iteration, const btContactSolverInfo& infoGlobal)
+{
+	const btMultiBodyConstraintColoring& coloring = m_colorings[type];
+	btScalar leastSquaredResidual = 0.f;
+	if (coloring.m_colorOffsets.size() == 0)
+	{
+		return leastSquaredResidual;
+	}
+
+	const int numColors = coloring.m_colorOffsets.size() - 1;
+	const int serialBegin = coloring.m_colorOffsets[numColors];
+	const int numItems = coloring.m_items.size();
+	//non-contact constraints alternate their order between iterations, like the serial loop
+	const bool reverse = type == BT_MULTIBODY_ITEM_NON_CONTACT && (iteration & 1) == 0;
+
+	btMultiBodyColorSolverLoop loop;
+	loop.m_solver = this;
+	loop.m_type = type;
+	loop.m_items = numItems ? &coloring.m_items[0] : 0;
+	loop.m_residuals = m_itemResiduals.size() ? &m_itemResiduals[0] : 0;
+	loop.m_iteration = iteration;
+	loop.m_infoGlobal = &infoGlobal;
+
+	for (int c = 0; c < numColors; c++)
+	{
+		int color = reverse ? numColors - 1 - c : c;
+		int begin = coloring.m_colorOffsets[color];
+		int end = coloring.m_colorOffsets[color + 1];
+#if BT_THREADSAFE
+		if (btGetTaskScheduler())
+		{
+			btParallelFor(begin, end, m_coloringGrainSize, loop);
+		}
+		else
+		{
+			loop.forLoop(begin, end);
+		}
+#else
+		loop.forLoop(begin, end);
+#endif
+		for (int i = begin; i < end; i++)
+		{
+			leastSquaredResidual = btMax(leastSquaredResidual, m_itemResiduals[i]);
+		}
+	}
+
+	for (int j = serialBegin; j < numItems; j++)
+	{
+		int i = reverse ? numItems - 1 - (j - serialBegin) : j;
+		btScalar residual = solveConstraintItem(type, coloring.m_items[i], iteration, infoGlobal);
+		leastSquaredResidual = btMax(leastSquaredResidual, residual);
+	}
+	return leastSquaredResidual;
+}
+
+btScalar btMultiBodyConstraintSolver::solveSingleIteration(int iteration, btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
+{
+	btScalar leastSquaredResidual = btSequentialImpulseConstraintSolver::solveSingleIteration(iteration, bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
+
+	const bool coneFriction = (infoGlobal.m_solverMode & SOLVER_USE_2_FRICTION_DIRECTIONS) && ((infoGlobal.m_solverMode & SOLVER_DISABLE_IMPLICIT_CONE_FRICTION) == 0);
+
+	if (m_constraintsColored)
+	{
+		leastSquaredResidual = btMax(leastSquaredResidual, solveColoredItems(BT_MULTIBODY_ITEM_NON_CONTACT, iteration, infoGlobal));
+		leastSquaredResidual = btMax(leastSquaredResidual, solveColoredItems(BT_MULTIBODY_ITEM_NORMAL_CONTACT, iteration, infoGlobal));
+		if (coneFriction)
+		{
+			leastSquaredResidual = btMax(leastSquaredResidual, solveColoredItems(BT_MULTIBODY_ITEM_TORSIONAL_FRICTION, iteration, infoGlobal));
+			leastSquaredResidual = btMax(leastSquaredResidual, solveColoredItems(BT_MULTIBODY_ITEM_CONE_FRICTION, iteration, infoGlobal));
+		}
+		else
+		{
+			leastSquaredResidual = btMax(leastSquaredResidual, solveColoredItems(BT_MULTIBODY_ITEM_FRICTION, iteration, infoGlobal));
+		}
+		return leastSquaredResidual;
+	}
+
+	//solve featherstone non-contact constraints
+
+	//printf("m_multiBodyNonContactConstraints = %d\n",m_multiBodyNonContactConstraints.size());
+
+	for (int j = 0; j < m_multiBodyNonContactConstraints.size(); j++)
+	{
+		int index = iteration & 1 ? j : m_multiBodyNonContactConstraints.size() - 1 - j;
+		leastSquaredResidual = btMax(leastSquaredResidual, solveConstraintItem(BT_MULTIBODY_ITEM_NON_CONTACT, index, iteration, infoGlobal));
+	}
+
+	//solve featherstone normal contact
+	for (int j0 = 0; j0 < m_multiBodyNormalContactConstraints.size(); j0++)
+	{
+		int index = j0;  //iteration&1? j0 : m_multiBodyNormalContactConstraints.size()-1-j0;
+		leastSquaredResidual = btMax(leastSquaredResidual, solveConstraintItem(BT_MULTIBODY_ITEM_NORMAL_CONTACT, index, iteration, infoGlobal));
+	}
+
+	//solve featherstone frictional contact
+	if (coneFriction)
+	{
+		for (int j1 = 0; j1 < this->m_multiBodyTorsionalFrictionContactConstraints.size(); j1++)
+		{
+			leastSquaredResidual = btMax(leastSquaredResidual, solveConstraintItem(BT_MULTIBODY_ITEM_TORSIONAL_FRICTION, j1, iteration, infoGlobal));
+		}
+
+		//the two friction directions of a contact are consecutive rows, solved together against the implicit friction cone
+		for (int j1 = 0; j1 + 1 < this->m_multiBodyFrictionContactConstraints.size(); j1 += 2)
+		{
+			leastSquaredResidual = btMax(leastSquaredResidual, solveConstraintItem(BT_MULTIBODY_ITEM_CONE_FRICTION, j1, iteration, infoGlobal));
 		}
 	}
 	else
 	{
 		for (int j1 = 0; j1 < this->m_multiBodyFrictionContactConstraints.size(); j1++)
 		{
-			if (iteration < infoGlobal.m_numIterations)
-			{
-				int index = j1;  //iteration&1? j1 : m_multiBodyFrictionContactConstraints.size()-1-j1;
+			leastSquaredResidual = btMax(leastSquaredResidual, solveConstraintItem(BT_MULTIBODY_ITEM_FRICTION, j1, iteration, infoGlobal));
+		}
+	}
+	return leastSquaredResidual;
+}
 
-				btMultiBodySolverConstraint& frictionConstraint = m_multiBodyFrictionContactConstraints[index];
-				btScalar totalImpulse = m_multiBodyNormalContactConstraints[frictionConstraint.m_frictionIndex].m_appliedImpulse;
-				//adjust friction limits here
-				if (totalImpulse > btScalar(0))
-				{
-					frictionConstraint.m_lowerLimit = -(frictionConstraint.m_friction * totalImpulse);
-					frictionConstraint.m_upperLimit = frictionConstraint.m_friction * totalImpulse;
-					btScalar residual = resolveSingleConstraintRowGeneric(frictionConstraint);
-					leastSquaredResidual = btMax(leastSquaredResidual, residual * residual);
+int btMultiBodyConstraintSolver::getConstraintNode(const btMultiBody* multiBody, int deltaVelIndex, int solverBodyId) const
+{
+	//a multibody is a single node: applying an impulse updates the velocities of all of its dofs
+	if (multiBody)
+		return m_tmpSolverBodyPool.size() + deltaVelIndex;
+	//the shared fixed body ignores impulses, so it doesn't connect constraints
+	if (solverBodyId >= 0 && m_tmpSolverBodyPool[solverBodyId].m_originalBody)
+		return solverBodyId;
+	return -1;
+}
 
-					if (frictionConstraint.m_multiBodyA)
-						frictionConstraint.m_multiBodyA->setPosUpdated(false);
-					if (frictionConstraint.m_multiBodyB)
-						frictionConstraint.m_multiBodyB->setPosUpdated(false);
-				}
+void btMultiBodyConstraintSolver::colorConstraints(btMultiBodyConstraintColoring& coloring, const btMultiBodyConstraintArray& constraints, int itemStride)
+{
+	coloring.m_items.resize(0);
+	coloring.m_colorOffsets.resize(0);
+	coloring.m_colorOffsets.push_back(0);
+
+	m_scratchItems.resize(0);
+	for (int i = 0; i + itemStride - 1 < constraints.size(); i += itemStride)
+	{
+		m_scratchItems.push_back(i);
+	}
+
+	const int numNodes = m_tmpSolverBodyPool.size() + m_data.m_deltaVelocities.size();
+	m_scratchNodeColor.resize(numNodes);
+	for (int i = 0; i < numNodes; i++)
+	{
+		m_scratchNodeColor[i] = -1;
+	}
+
+	//greedy coloring, one color per pass over the remaining items, in the original order
+	btAlignedObjectArray<int>& remaining = m_scratchRemainingItems;
+	int color = 0;
+	while (m_scratchItems.size() >= m_minColorSize)
+	{
+		const int colorBegin = coloring.m_items.size();
+		remaining.resize(0);
+		for (int i = 0; i < m_scratchItems.size(); i++)
+		{
+			const btMultiBodySolverConstraint& c = constraints[m_scratchItems[i]];
+			int nodeA = getConstraintNode(c.m_multiBodyA, c.m_deltaVelAindex, c.m_solverBodyIdA);
+			int nodeB = getConstraintNode(c.m_multiBodyB, c.m_deltaVelBindex, c.m_solverBodyIdB);
+			if ((nodeA >= 0 && m_scratchNodeColor[nodeA] == color) || (nodeB >= 0 && m_scratchNodeColor[nodeB] == color))
+			{
+				remaining.push_back(m_scratchItems[i]);
+				continue;
 			}
+			if (nodeA >= 0)
+				m_scratchNodeColor[nodeA] = color;
+			if (nodeB >= 0)
+				m_scratchNodeColor[nodeB] = color;
+			coloring.m_items.push_back(m_scratchItems[i]);
 		}
+		if (coloring.m_items.size() - colorBegin < m_minColorSize)
+		{
+			//too small to be worth dispatching, leave these to the serial tail
+			coloring.m_items.resize(colorBegin);
+			break;
+		}
+		coloring.m_colorOffsets.push_back(coloring.m_items.size());
+		m_scratchItems.copyFromArray(remaining);
+		color++;
+	}
+
+	for (int i = 0; i < m_scratchItems.size(); i++)
+	{
+		coloring.m_items.push_back(m_scratchItems[i]);
+	}
+	if (m_itemResiduals.size() < coloring.m_items.size())
+	{
+		m_itemResiduals.resize(coloring.m_items.size());
 	}
-	return leastSquaredResidual;
+}
+
+void btMultiBodyConstraintSolver::setupConstraintColoring(const btContactSolverInfo& infoGlobal)
+{
+	BT_PROFILE("btMultiBodyConstraintSolver::setupConstraintColoring");
+	m_constraintsColored = false;
+	for (int i = 0; i < BT_MULTIBODY_ITEM_TYPE_COUNT; i++)
+	{
+		m_colorings[i].m_items.resize(0);
+		m_colorings[i].m_colorOffsets.resize(0);
+	}
+
+	const int numRows = m_multiBodyNonContactConstraints.size() + m_multiBodyNormalContactConstraints.size() +
+						m_multiBodyFrictionContactConstraints.size() + m_multiBodyTorsionalFrictionContactConstraints.size();
+	if (!m_useConstraintColoring || numRows < 2 * m_minColorSize)
+	{
+		return;
+	}
+
+	colorConstraints(m_colorings[BT_MULTIBODY_ITEM_NON_CONTACT], m_multiBodyNonContactConstraints, 1);
+	colorConstraints(m_colorings[BT_MULTIBODY_ITEM_NORMAL_CONTACT], m_multiBodyNormalContactConstraints, 1);
+	if ((infoGlobal.m_solverMode & SOLVER_USE_2_FRICTION_DIRECTIONS) && ((infoGlobal.m_solverMode & SOLVER_DISABLE_IMPLICIT_CONE_FRICTION) == 0))
+	{
+		colorConstraints(m_colorings[BT_MULTIBODY_ITEM_TORSIONAL_FRICTION], m_multiBodyTorsionalFrictionContactConstraints, 1);
+		colorConstraints(m_colorings[BT_MULTIBODY_ITEM_CONE_FRICTION], m_multiBodyFrictionContactConstraints, 2);
+	}
+	else
+	{
+		colorConstraints(m_colorings[BT_MULTIBODY_ITEM_FRICTION], m_multiBodyFrictionContactConstraints, 1);
+	}
+	m_constraintsColored = true;
 }
 
 btScalar btMultiBodyConstraintSolver::solveGroupCacheFriendlySetup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
@@ -180,6 +389,8 @@ btScalar btMultiBodyConstraintSolver::solveGroupCacheFriendlySetup(btCollisionOb
 
 	btScalar val = btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
 
+	setupConstraintColoring(infoGlobal);
+
 	return val;
 }
 
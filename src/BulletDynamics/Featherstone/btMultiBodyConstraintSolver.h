@@ -22,12 +22,15 @@ subject to the following restrictions:
 #define DIRECTLY_UPDATE_VELOCITY_DURING_SOLVER_ITERATIONS
 
 class btMultiBody;
+struct btMultiBodyColorSolverLoop;
 
 #include "btMultiBodyConstraint.h"
 
 ATTRIBUTE_ALIGNED16(class)
 btMultiBodyConstraintSolver : public btSequentialImpulseConstraintSolver
 {
+	friend struct btMultiBodyColorSolverLoop;
+
 protected:
 	btMultiBodyConstraintArray m_multiBodyNonContactConstraints;
 
@@ -41,6 +44,41 @@ protected:
 	btMultiBodyConstraint** m_tmpMultiBodyConstraints;
 	int m_tmpNumMultiBodyConstraints;
 
+	///kind of work item in a btMultiBodyConstraintColoring, each kind matches one of the loops in solveSingleIteration
+	enum btMultiBodyConstraintItemType
+	{
+		BT_MULTIBODY_ITEM_NON_CONTACT = 0,
+		BT_MULTIBODY_ITEM_NORMAL_CONTACT,
+		BT_MULTIBODY_ITEM_TORSIONAL_FRICTION,
+		BT_MULTIBODY_ITEM_FRICTION,
+		BT_MULTIBODY_ITEM_CONE_FRICTION,  //two consecutive friction rows solved together
+		BT_MULTIBODY_ITEM_TYPE_COUNT
+	};
+
+	///graph coloring of one constraint array: items of the same color never share a multibody or a dynamic rigid body,
+	///so a color can be solved in parallel. Items that did not end up in a large enough color are solved serially.
+	struct btMultiBodyConstraintColoring
+	{
+		btAlignedObjectArray<int> m_items;         //constraint indices, grouped by color, followed by the serial items
+		btAlignedObjectArray<int> m_colorOffsets;  //color c is m_items[m_colorOffsets[c] .. m_colorOffsets[c+1]), the last offset starts the serial items
+	};
+
+	btMultiBodyConstraintColoring m_colorings[BT_MULTIBODY_ITEM_TYPE_COUNT];
+	btAlignedObjectArray<btScalar> m_itemResiduals;
+	btAlignedObjectArray<int> m_scratchItems;
+	btAlignedObjectArray<int> m_scratchRemainingItems;
+	btAlignedObjectArray<int> m_scratchNodeColor;
+	bool m_useConstraintColoring;
+	bool m_constraintsColored;
+	int m_minColorSize;
+	int m_coloringGrainSize;
+
+	int getConstraintNode(const btMultiBody* multiBody, int deltaVelIndex, int solverBodyId) const;
+	void colorConstraints(btMultiBodyConstraintColoring & coloring, const btMultiBodyConstraintArray& constraints, int itemStride);
+	void setupConstraintColoring(const btContactSolverInfo& infoGlobal);
+	btScalar solveColoredItems(btMultiBodyConstraintItemType type, int iteration, const btContactSolverInfo& infoGlobal);
+	btScalar solveConstraintItem(btMultiBodyConstraintItemType type, int index, int iteration, const btContactSolverInfo& infoGlobal);
+
 	btScalar resolveSingleConstraintRowGeneric(const btMultiBodySolverConstraint& c);
 
 	//solve 2 friction directions and clamp against the implicit friction cone
@@ -85,6 +123,38 @@ protected:
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
 
+	btMultiBodyConstraintSolver();
+
+	///when enabled, the multibody constraint rows are colored so that rows touching disjoint bodies are solved in parallel
+	///with btParallelFor. A large island (for example many robots on one static terrain) can then use several threads.
+	///The solve order within an iteration changes, so results are not bitwise identical to the serial solver.
+	void setUseConstraintColoring(bool useColoring)
+	{
+		m_useConstraintColoring = useColoring;
+	}
+	bool getUseConstraintColoring() const
+	{
+		return m_useConstraintColoring;
+	}
+	///colors with fewer rows than this are not worth dispatching, their rows are solved serially instead
+	void setMinColorSize(int minColorSize)
+	{
+		m_minColorSize = btMax(1, minColorSize);
+	}
+	int getMinColorSize() const
+	{
+		return m_minColorSize;
+	}
+	///number of rows handed to a thread at once
+	void setColoringGrainSize(int grainSize)
+	{
+		m_coloringGrainSize = btMax(1, grainSize);
+	}
+	int getColoringGrainSize() const
+	{
+		return m_coloringGrainSize;
+	}
+
 	///this method should not be called, it was just used during porting/integration of Featherstone btMultiBody, providing backwards compatibility but no support for btMultiBodyConstraint (only contact constraints)
 	virtual btScalar solveGroup(btCollisionObject * *bodies, int numBodies, btPersistentManifold** manifold, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info, btIDebugDraw* debugDrawer, btDispatcher* dispatcher);
 	virtual btScalar solveGroupCacheFriendlyFinish(btCollisionObject * *bodies, int numBodies, const btContactSolverInfo& infoGlobal);
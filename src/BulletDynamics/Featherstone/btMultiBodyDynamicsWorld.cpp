@@ -22,9 +22,11 @@ subject to the following restrictions:
 #include "btMultiBodyConstraint.h"
 #include "LinearMath/btIDebugDraw.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btAllocatorContext.h"
 
 void btMultiBodyDynamicsWorld::addMultiBody(btMultiBody* body, int group, int mask)
 {
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 	m_multiBodies.push_back(body);
 }
 
@@ -363,7 +365,8 @@ struct MultiBodyInplaceSolverIslandCallback : public btSimulationIslandManager::
 
 btMultiBodyDynamicsWorld::btMultiBodyDynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btMultiBodyConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration)
 	: btDiscreteDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration),
-	  m_multiBodyConstraintSolver(constraintSolver)
+	  m_multiBodyConstraintSolver(constraintSolver),
+	  m_useBatchedForwardDynamics(false)
 {
 	//split impulse is not yet supported for Featherstone hierarchies
 	//	getSolverInfo().m_splitImpulse = false;
@@ -468,6 +471,7 @@ void btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 
 	{
 		BT_PROFILE("btMultiBody stepVelocities");
+		m_scratchBatchedBodies.resize(0);
 		for (int i = 0; i < this->m_multiBodies.size(); i++)
 		{
 			btMultiBody* bod = m_multiBodies[i];
@@ -495,6 +499,11 @@ void btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 				{
 					if (!bod->isUsingRK4Integration())
 					{
+						if (m_useBatchedForwardDynamics)
+						{
+							m_scratchBatchedBodies.push_back(bod);
+							continue;
+						}
 						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(solverInfo.m_timeStep,
 						m_scratch_r, m_scratch_v, m_scratch_m,isConstraintPass,
 						getSolverInfo().m_jointFeedbackInWorldSpace,
@@ -683,6 +692,18 @@ void btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 #endif         //BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
 			}  //if (!isSleeping)
 		}
+
+		if (m_scratchBatchedBodies.size())
+		{
+			bool isConstraintPass = false;
+			m_batchedDynamics.computeAccelerations(&m_scratchBatchedBodies[0], m_scratchBatchedBodies.size(), solverInfo.m_timeStep, isConstraintPass,
+												   getSolverInfo().m_jointFeedbackInWorldSpace,
+												   getSolverInfo().m_jointFeedbackInJointFrame);
+#ifndef BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
+			for (int i = 0; i < m_scratchBatchedBodies.size(); i++)
+				m_scratchBatchedBodies[i]->clearForcesAndTorques();
+#endif  //BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
+		}
 	}
 
 	/// solve all the constraints for this island
@@ -694,6 +715,7 @@ void btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 
 	{
 		BT_PROFILE("btMultiBody stepVelocities");
+		m_scratchBatchedBodies.resize(0);
 		for (int i = 0; i < this->m_multiBodies.size(); i++)
 		{
 			btMultiBody* bod = m_multiBodies[i];
@@ -720,6 +742,11 @@ void btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 				{
 					if (!bod->isUsingRK4Integration())
 					{
+						if (m_useBatchedForwardDynamics)
+						{
+							m_scratchBatchedBodies.push_back(bod);
+							continue;
+						}
 						bool isConstraintPass = true;
 						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(solverInfo.m_timeStep, m_scratch_r, m_scratch_v, m_scratch_m, isConstraintPass,
 						getSolverInfo().m_jointFeedbackInWorldSpace,
@@ -728,6 +755,14 @@ void btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 				}
 			}
 		}
+
+		if (m_scratchBatchedBodies.size())
+		{
+			bool isConstraintPass = true;
+			m_batchedDynamics.computeAccelerations(&m_scratchBatchedBodies[0], m_scratchBatchedBodies.size(), solverInfo.m_timeStep, isConstraintPass,
+												   getSolverInfo().m_jointFeedbackInWorldSpace,
+												   getSolverInfo().m_jointFeedbackInJointFrame);
+		}
 	}
 
 	for (int i = 0; i < this->m_multiBodies.size(); i++)
@@ -793,6 +828,7 @@ void btMultiBodyDynamicsWorld::integrateTransforms(btScalar timeStep)
 
 void btMultiBodyDynamicsWorld::addMultiBodyConstraint(btMultiBodyConstraint* constraint)
 {
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 	m_multiBodyConstraints.push_back(constraint);
 }
 
@@ -17,6 +17,7 @@ subject to the following restrictions:
 #define BT_MULTIBODY_DYNAMICS_WORLD_H
 
 #include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h"
+#include "btMultiBodyBatchedDynamics.h"
 
 #define BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
 
@@ -45,6 +46,11 @@ protected:
 	btAlignedObjectArray<btVector3> m_scratch_v;
 	btAlignedObjectArray<btMatrix3x3> m_scratch_m;
 
+	//optional lane-batched forward dynamics for bodies that share a topology
+	btMultiBodyBatchedDynamics m_batchedDynamics;
+	btAlignedObjectArray<btMultiBody*> m_scratchBatchedBodies;
+	bool m_useBatchedForwardDynamics;
+
 	virtual void calculateSimulationIslands();
 	virtual void updateActivationState(btScalar timeStep);
 	virtual void solveConstraints(btContactSolverInfo& solverInfo);
@@ -106,6 +112,20 @@ public:
 	virtual void clearMultiBodyForces();
 	virtual void applyGravity();
 
+	///run the articulated body algorithm of bodies sharing a topology in lanes, see btMultiBodyBatchedDynamics
+	void setUseBatchedForwardDynamics(bool useBatched)
+	{
+		m_useBatchedForwardDynamics = useBatched;
+	}
+	bool getUseBatchedForwardDynamics() const
+	{
+		return m_useBatchedForwardDynamics;
+	}
+	btMultiBodyBatchedDynamics& getBatchedDynamics()
+	{
+		return m_batchedDynamics;
+	}
+
 	virtual void serialize(btSerializer* serializer);
 	virtual void setMultiBodyConstraintSolver(btMultiBodyConstraintSolver* solver);
 	virtual void setConstraintSolver(btConstraintSolver* solver);
@@ -19,6 +19,7 @@ subject to the following restrictions:
 #include "BulletDynamics/Featherstone/btMultiBodyLinkCollider.h"
 #include "BulletDynamics/Featherstone/btMultiBodyConstraint.h"
 #include "BulletDynamics/MLCPSolvers/btMLCPSolverInterface.h"
+#include "BulletDynamics/MLCPSolvers/btSolveProjectedGaussSeidel.h"
 
 #define DIRECTLY_UPDATE_VELOCITY_DURING_SOLVER_ITERATIONS
 
@@ -641,10 +642,31 @@ void btMultiBodyMLCPConstraintSolver::createMLCPFastMultiBody(const btContactSol
 
 		if (infoGlobal.m_solverMode & SOLVER_USE_WARMSTARTING)
 		{
+			// btMultiBodyConstraintSolver does not warm start contacts, so their applied impulse is zero here.
+			// The impulses of the previous step are still written back to the contact points, the active set uses those.
 			for (int i = 0; i < multiBodyNumConstraints; ++i)
 			{
 				const btMultiBodySolverConstraint& constraint = *m_multiBodyAllConstraintPtrArray[i];
 				m_multiBodyX[i] = constraint.m_appliedImpulse;
+				if (!m_useActiveSetWarmStart)
+					continue;
+
+				const btManifoldPoint* pt = (const btManifoldPoint*)constraint.m_originalContactPoint;
+				switch (m_multiBodyContactImpulseIndex[i])
+				{
+					case 0:
+						m_multiBodyX[i] = pt->m_appliedImpulse * infoGlobal.m_warmstartingFactor;
+						break;
+					case 1:
+						m_multiBodyX[i] = pt->m_appliedImpulseLateral1 * infoGlobal.m_warmstartingFactor;
+						break;
+					case 2:
+						if (infoGlobal.m_solverMode & SOLVER_USE_2_FRICTION_DIRECTIONS)
+							m_multiBodyX[i] = pt->m_appliedImpulseLateral2 * infoGlobal.m_warmstartingFactor;
+						break;
+					default:
+						break;
+				}
 			}
 		}
 		else
@@ -663,17 +685,13 @@ bool btMultiBodyMLCPConstraintSolver::solveMLCP(const btContactSolverInfo& infoG
 		// If using split impulse, we solve 2 separate (M)LCPs
 		if (infoGlobal.m_splitImpulse)
 		{
-			const btMatrixXu Acopy = m_A;
-			const btAlignedObjectArray<int> limitDependenciesCopy = m_limitDependencies;
-			// TODO(JS): Do we really need these copies when solveMLCP takes them as const?
-
-			result = m_solver->solveMLCP(m_A, m_b, m_x, m_lo, m_hi, m_limitDependencies, infoGlobal.m_numIterations);
+			result = solveMLCPByIslands(m_A, m_b, m_x, m_lo, m_hi, m_limitDependencies, infoGlobal);
 			if (result)
-				result = m_solver->solveMLCP(Acopy, m_bSplit, m_xSplit, m_lo, m_hi, limitDependenciesCopy, infoGlobal.m_numIterations);
+				result = solveMLCPByIslands(m_A, m_bSplit, m_xSplit, m_lo, m_hi, m_limitDependencies, infoGlobal);
 		}
 		else
 		{
-			result = m_solver->solveMLCP(m_A, m_b, m_x, m_lo, m_hi, m_limitDependencies, infoGlobal.m_numIterations);
+			result = solveMLCPByIslands(m_A, m_b, m_x, m_lo, m_hi, m_limitDependencies, infoGlobal);
 		}
 	}
 
@@ -682,12 +700,336 @@ bool btMultiBodyMLCPConstraintSolver::solveMLCP(const btContactSolverInfo& infoG
 
 	if (m_multiBodyA.rows() != 0)
 	{
-		result = m_solver->solveMLCP(m_multiBodyA, m_multiBodyB, m_multiBodyX, m_multiBodyLo, m_multiBodyHi, m_multiBodyLimitDependencies, infoGlobal.m_numIterations);
+		result = solveMLCPByIslands(m_multiBodyA, m_multiBodyB, m_multiBodyX, m_multiBodyLo, m_multiBodyHi, m_multiBodyLimitDependencies, infoGlobal);
 	}
 
 	return result;
 }
 
+static int findIslandRoot(btAlignedObjectArray<int>& parent, int i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+static void unionIslands(btAlignedObjectArray<int>& parent, int i, int j)
+{
+	i = findIslandRoot(parent, i);
+	j = findIslandRoot(parent, j);
+	// keep the smallest row as the root, so islands are ordered by their first row
+	if (i < j)
+		parent[j] = i;
+	else if (j < i)
+		parent[i] = j;
+}
+
+bool btMultiBodyMLCPConstraintSolver::solveMLCPByIslands(const btMatrixXu& A, const btVectorXu& b, btVectorXu& x, const btVectorXu& lo, const btVectorXu& hi, const btAlignedObjectArray<int>& limitDependencies, const btContactSolverInfo& infoGlobal)
+{
+	const int n = A.rows();
+	if (!m_splitIslands || n <= 1)
+	{
+		return solveIslandMLCP(A, b, x, lo, hi, limitDependencies, infoGlobal);
+	}
+
+	// Two rows belong to the same island if they are coupled through A, or if one bounds the other
+	btAlignedObjectArray<int>& parent = m_scratchIslandParent;
+	{
+		BT_PROFILE("find MLCP islands");
+		parent.resizeNoInitialize(n);
+		for (int i = 0; i < n; ++i)
+			parent[i] = i;
+
+		const btScalar* Aptr = A.getBufferPointer();
+		for (int i = 0; i < n; ++i)
+		{
+			const btScalar* Arow = Aptr + (size_t)i * n;
+			for (int j = i + 1; j < n; ++j)
+			{
+				if (Arow[j] != btScalar(0))
+					unionIslands(parent, i, j);
+			}
+			if (limitDependencies[i] >= 0)
+				unionIslands(parent, i, limitDependencies[i]);
+		}
+	}
+
+	// Bucket the rows by island, keeping their relative order
+	btAlignedObjectArray<int>& offsets = m_scratchIslandOffsets;
+	btAlignedObjectArray<int>& rows = m_scratchIslandRows;
+	btAlignedObjectArray<int>& localIndex = m_scratchIslandLocalIndex;
+	offsets.resize(0);
+	offsets.resize(n + 1, 0);
+	for (int i = 0; i < n; ++i)
+	{
+		offsets[findIslandRoot(parent, i) + 1]++;
+	}
+	if (offsets[1] == n)
+	{
+		// a single island, no need to copy
+		return solveIslandMLCP(A, b, x, lo, hi, limitDependencies, infoGlobal);
+	}
+	for (int i = 0; i < n; ++i)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+	rows.resizeNoInitialize(n);
+	localIndex.resizeNoInitialize(n);
+	{
+		btAlignedObjectArray<int>& fill = m_scratchIslandFill;
+		fill.resize(0);
+		fill.resize(n, 0);
+		for (int i = 0; i < n; ++i)
+		{
+			const int root = parent[i];
+			localIndex[i] = fill[root]++;
+			rows[offsets[root] + localIndex[i]] = i;
+		}
+	}
+
+	for (int root = 0; root < n; ++root)
+	{
+		const int begin = offsets[root];
+		const int size = offsets[root + 1] - begin;
+		if (size == 0)
+			continue;
+
+		btMatrixXu& islandA = m_scratchIslandA;
+		btVectorXu& islandB = m_scratchIslandB;
+		btVectorXu& islandX = m_scratchIslandX;
+		btVectorXu& islandLo = m_scratchIslandLo;
+		btVectorXu& islandHi = m_scratchIslandHi;
+		btAlignedObjectArray<int>& islandDependencies = m_scratchIslandLimitDependencies;
+
+		islandA.resize(size, size);
+		islandB.resize(size);
+		islandX.resize(size);
+		islandLo.resize(size);
+		islandHi.resize(size);
+		islandDependencies.resizeNoInitialize(size);
+
+		btScalar* islandAptr = islandA.getBufferPointerWritable();
+		for (int li = 0; li < size; ++li)
+		{
+			const int i = rows[begin + li];
+			for (int lj = 0; lj < size; ++lj)
+			{
+				islandAptr[(size_t)li * size + lj] = A(i, rows[begin + lj]);
+			}
+			islandB[li] = b[i];
+			islandX[li] = x[i];
+			islandLo[li] = lo[i];
+			islandHi[li] = hi[i];
+			islandDependencies[li] = limitDependencies[i] >= 0 ? localIndex[limitDependencies[i]] : -1;
+		}
+
+		// an island that cannot be solved makes the whole solve fall back to btMultiBodyConstraintSolver
+		if (!solveIslandMLCP(islandA, islandB, islandX, islandLo, islandHi, islandDependencies, infoGlobal))
+			return false;
+
+		for (int li = 0; li < size; ++li)
+		{
+			x[rows[begin + li]] = islandX[li];
+		}
+	}
+	return true;
+}
+
+bool btMultiBodyMLCPConstraintSolver::solveIslandMLCP(const btMatrixXu& A, const btVectorXu& b, btVectorXu& x, const btVectorXu& lo, const btVectorXu& hi, const btAlignedObjectArray<int>& limitDependencies, const btContactSolverInfo& infoGlobal)
+{
+	if (m_useActiveSetWarmStart && (infoGlobal.m_solverMode & SOLVER_USE_WARMSTARTING))
+	{
+		BT_PROFILE("solveActiveSetWarmStart");
+		if (solveActiveSetWarmStart(A, b, x, lo, hi, limitDependencies))
+		{
+			m_numActiveSetHits++;
+			return true;
+		}
+	}
+
+	if (m_solver->solveMLCP(A, b, x, lo, hi, limitDependencies, infoGlobal.m_numIterations))
+		return true;
+	if (!m_useGaussSeidelFallback)
+		return false;
+
+	// the MLCP solvers leave x untouched when they fail, so the fallback starts from the warm start as well
+	m_numGaussSeidelFallbacks++;
+	btSolveProjectedGaussSeidel pgs;
+	return pgs.solveMLCP(A, b, x, lo, hi, limitDependencies, infoGlobal.m_numIterations);
+}
+
+// Solves (M + regularization * I) y = rhs in place with a Cholesky factorization of the symmetric n x n matrix M,
+// returns false if it is not numerically positive definite
+static bool choleskySolve(btScalar* M, btScalar* rhs, int n, btScalar regularization)
+{
+	for (int j = 0; j < n; ++j)
+	{
+		btScalar* Mj = M + (size_t)j * n;
+		Mj[j] += regularization;
+		btScalar d = Mj[j];
+		for (int k = 0; k < j; ++k)
+			d -= Mj[k] * Mj[k];
+		if (!(d > SIMD_EPSILON * btFabs(Mj[j])) || d <= btScalar(0))
+			return false;
+		const btScalar Ljj = btSqrt(d);
+		Mj[j] = Ljj;
+		const btScalar invLjj = btScalar(1) / Ljj;
+		for (int i = j + 1; i < n; ++i)
+		{
+			btScalar* Mi = M + (size_t)i * n;
+			btScalar v = Mi[j];
+			for (int k = 0; k < j; ++k)
+				v -= Mi[k] * Mj[k];
+			Mi[j] = v * invLjj;
+		}
+	}
+	// forward substitution L z = rhs
+	for (int i = 0; i < n; ++i)
+	{
+		const btScalar* Mi = M + (size_t)i * n;
+		btScalar v = rhs[i];
+		for (int k = 0; k < i; ++k)
+			v -= Mi[k] * rhs[k];
+		rhs[i] = v / Mi[i];
+	}
+	// backward substitution L^T y = z
+	for (int i = n - 1; i >= 0; --i)
+	{
+		btScalar v = rhs[i];
+		for (int k = i + 1; k < n; ++k)
+			v -= M[(size_t)k * n + i] * rhs[k];
+		rhs[i] = v / M[(size_t)i * n + i];
+	}
+	return true;
+}
+
+// Bounds of row i, scaled by the impulse of the row it depends on in the same way as btSolveProjectedGaussSeidel
+static void computeRowBounds(const btVectorXu& x, const btVectorXu& lo, const btVectorXu& hi, const btAlignedObjectArray<int>& limitDependencies, int i, btScalar& rowLo, btScalar& rowHi)
+{
+	btScalar s = btScalar(1);
+	if (limitDependencies[i] >= 0)
+	{
+		s = x[limitDependencies[i]];
+		if (s < 0)
+			s = btScalar(1);
+	}
+	rowLo = lo[i] * s;
+	rowHi = hi[i] * s;
+}
+
+bool btMultiBodyMLCPConstraintSolver::solveActiveSetWarmStart(const btMatrixXu& A, const btVectorXu& b, btVectorXu& x, const btVectorXu& lo, const btVectorXu& hi, const btAlignedObjectArray<int>& limitDependencies)
+{
+	enum
+	{
+		ROW_FREE = 0,
+		ROW_AT_LOWER,
+		ROW_AT_UPPER
+	};
+
+	const int n = A.rows();
+	if (n == 0)
+		return true;
+
+	btScalar bScale = btScalar(0);
+	for (int i = 0; i < n; ++i)
+		bScale = btMax(bScale, btFabs(b[i]));
+	const btScalar tolerance = m_activeSetTolerance * (btScalar(1) + bScale);
+
+	// 1. Classify the rows with the warm started impulses
+	btAlignedObjectArray<int>& state = m_scratchActiveSetState;
+	btAlignedObjectArray<int>& freeRows = m_scratchFreeRows;
+	state.resizeNoInitialize(n);
+	freeRows.resize(0);
+	btVectorXu& xNew = m_scratchActiveSetX;
+	xNew.resize(n);
+	for (int i = 0; i < n; ++i)
+	{
+		btScalar rowLo, rowHi;
+		computeRowBounds(x, lo, hi, limitDependencies, i, rowLo, rowHi);
+		if (x[i] <= rowLo + tolerance)
+		{
+			state[i] = ROW_AT_LOWER;
+			xNew[i] = rowLo;
+		}
+		else if (x[i] >= rowHi - tolerance)
+		{
+			state[i] = ROW_AT_UPPER;
+			xNew[i] = rowHi;
+		}
+		else
+		{
+			state[i] = ROW_FREE;
+			xNew[i] = btScalar(0);
+			freeRows.push_back(i);
+		}
+	}
+
+	// 2. Solve A_ff x_f = b_f - A_fc x_c for the free rows
+	const int nf = freeRows.size();
+	if (nf)
+	{
+		m_scratchFactor.resizeNoInitialize(nf * nf);
+		m_scratchRhs.resizeNoInitialize(nf);
+		btScalar* M = &m_scratchFactor[0];
+		btScalar* rhs = &m_scratchRhs[0];
+		btScalar maxDiag = btScalar(0);
+		for (int fi = 0; fi < nf; ++fi)
+		{
+			const int i = freeRows[fi];
+			btScalar v = b[i];
+			for (int j = 0; j < n; ++j)
+			{
+				if (state[j] != ROW_FREE)
+					v -= A(i, j) * xNew[j];
+			}
+			rhs[fi] = v;
+			for (int fj = 0; fj < nf; ++fj)
+				M[(size_t)fi * nf + fj] = A(i, freeRows[fj]);
+			maxDiag = btMax(maxDiag, A(i, i));
+		}
+		// contacts usually outnumber the degrees of freedom, so A_ff is often singular: regularize it slightly and
+		// let the verification below decide if the result is accurate enough
+		if (!choleskySolve(M, rhs, nf, m_activeSetTolerance * maxDiag))
+			return false;
+		for (int fi = 0; fi < nf; ++fi)
+			xNew[freeRows[fi]] = rhs[fi];
+	}
+
+	// 3. Verify bounds and complementarity, with bounds that depend on the new impulses
+	for (int i = 0; i < n; ++i)
+	{
+		btScalar residual = -b[i];
+		for (int j = 0; j < n; ++j)
+			residual += A(i, j) * xNew[j];
+
+		btScalar rowLo, rowHi;
+		computeRowBounds(xNew, lo, hi, limitDependencies, i, rowLo, rowHi);
+
+		switch (state[i])
+		{
+			case ROW_FREE:
+				if (xNew[i] < rowLo - tolerance || xNew[i] > rowHi + tolerance)
+					return false;
+				break;
+			case ROW_AT_LOWER:
+				if (residual < -tolerance || btFabs(xNew[i] - rowLo) > tolerance)
+					return false;
+				break;
+			default:
+				if (residual > tolerance || btFabs(xNew[i] - rowHi) > tolerance)
+					return false;
+				break;
+		}
+	}
+
+	for (int i = 0; i < n; ++i)
+		x[i] = xNew[i];
+	return true;
+}
+
 btScalar btMultiBodyMLCPConstraintSolver::solveGroupCacheFriendlySetup(
 	btCollisionObject** bodies,
 	int numBodies,
@@ -775,10 +1117,12 @@ btScalar btMultiBodyMLCPConstraintSolver::solveGroupCacheFriendlySetup(
 		dindex = 0;
 
 		m_multiBodyLimitDependencies.resize(numMultiBodyConstraints);
+		m_multiBodyContactImpulseIndex.resize(numMultiBodyConstraints);
 
 		for (int i = 0; i < m_multiBodyNonContactConstraints.size(); ++i)
 		{
 			m_multiBodyAllConstraintPtrArray.push_back(&m_multiBodyNonContactConstraints[i]);
+			m_multiBodyContactImpulseIndex[dindex] = -1;
 			m_multiBodyLimitDependencies[dindex++] = -1;
 		}
 
@@ -792,6 +1136,7 @@ btScalar btMultiBodyMLCPConstraintSolver::solveGroupCacheFriendlySetup(
 				const int numtiBodyNumFrictionPerContact = m_multiBodyNormalContactConstraints.size() == m_multiBodyFrictionContactConstraints.size() ? 1 : 2;
 
 				m_multiBodyAllConstraintPtrArray.push_back(&m_multiBodyNormalContactConstraints[i]);
+				m_multiBodyContactImpulseIndex[dindex] = 0;
 				m_multiBodyLimitDependencies[dindex++] = -1;
 
 				btMultiBodySolverConstraint& frictionContactConstraint1 = m_multiBodyFrictionContactConstraints[i * numtiBodyNumFrictionPerContact];
@@ -799,6 +1144,7 @@ btScalar btMultiBodyMLCPConstraintSolver::solveGroupCacheFriendlySetup(
 
 				const int findex = (frictionContactConstraint1.m_frictionIndex * (1 + numtiBodyNumFrictionPerContact)) + firstContactConstraintOffset;
 
+				m_multiBodyContactImpulseIndex[dindex] = 1;
 				m_multiBodyLimitDependencies[dindex++] = findex;
 
 				if (numtiBodyNumFrictionPerContact == 2)
@@ -806,6 +1152,7 @@ btScalar btMultiBodyMLCPConstraintSolver::solveGroupCacheFriendlySetup(
 					btMultiBodySolverConstraint& frictionContactConstraint2 = m_multiBodyFrictionContactConstraints[i * numtiBodyNumFrictionPerContact + 1];
 					m_multiBodyAllConstraintPtrArray.push_back(&frictionContactConstraint2);
 
+					m_multiBodyContactImpulseIndex[dindex] = 2;
 					m_multiBodyLimitDependencies[dindex++] = findex;
 				}
 			}
@@ -815,11 +1162,15 @@ btScalar btMultiBodyMLCPConstraintSolver::solveGroupCacheFriendlySetup(
 			for (int i = 0; i < m_multiBodyNormalContactConstraints.size(); ++i)
 			{
 				m_multiBodyAllConstraintPtrArray.push_back(&m_multiBodyNormalContactConstraints[i]);
+				m_multiBodyContactImpulseIndex[dindex] = 0;
 				m_multiBodyLimitDependencies[dindex++] = -1;
 			}
 			for (int i = 0; i < m_multiBodyFrictionContactConstraints.size(); ++i)
 			{
+				const btMultiBodySolverConstraint& frictionContactConstraint = m_multiBodyFrictionContactConstraints[i];
+				const int firstFriction = m_multiBodyNormalContactConstraints[frictionContactConstraint.m_frictionIndex].m_frictionIndex;
 				m_multiBodyAllConstraintPtrArray.push_back(&m_multiBodyFrictionContactConstraints[i]);
+				m_multiBodyContactImpulseIndex[dindex] = 1 + i - firstFriction;
 				m_multiBodyLimitDependencies[dindex++] = m_multiBodyFrictionContactConstraints[i].m_frictionIndex + firstContactConstraintOffset;
 			}
 		}
@@ -935,7 +1286,14 @@ btScalar btMultiBodyMLCPConstraintSolver::solveGroupCacheFriendlyIterations(btCo
 }
 
 btMultiBodyMLCPConstraintSolver::btMultiBodyMLCPConstraintSolver(btMLCPSolverInterface* solver)
-	: m_solver(solver), m_fallback(0)
+	: m_solver(solver),
+	  m_fallback(0),
+	  m_splitIslands(false),
+	  m_useActiveSetWarmStart(false),
+	  m_activeSetTolerance(btScalar(1e-5)),
+	  m_numActiveSetHits(0),
+	  m_useGaussSeidelFallback(true),
+	  m_numGaussSeidelFallbacks(0)
 {
 	// Do nothing
 }
@@ -960,6 +1318,66 @@ void btMultiBodyMLCPConstraintSolver::setNumFallbacks(int num)
 	m_fallback = num;
 }
 
+void btMultiBodyMLCPConstraintSolver::setSplitIslands(bool splitIslands)
+{
+	m_splitIslands = splitIslands;
+}
+
+bool btMultiBodyMLCPConstraintSolver::getSplitIslands() const
+{
+	return m_splitIslands;
+}
+
+void btMultiBodyMLCPConstraintSolver::setUseActiveSetWarmStart(bool useActiveSetWarmStart)
+{
+	m_useActiveSetWarmStart = useActiveSetWarmStart;
+}
+
+bool btMultiBodyMLCPConstraintSolver::getUseActiveSetWarmStart() const
+{
+	return m_useActiveSetWarmStart;
+}
+
+void btMultiBodyMLCPConstraintSolver::setActiveSetTolerance(btScalar tolerance)
+{
+	m_activeSetTolerance = tolerance;
+}
+
+btScalar btMultiBodyMLCPConstraintSolver::getActiveSetTolerance() const
+{
+	return m_activeSetTolerance;
+}
+
+int btMultiBodyMLCPConstraintSolver::getNumActiveSetHits() const
+{
+	return m_numActiveSetHits;
+}
+
+void btMultiBodyMLCPConstraintSolver::setNumActiveSetHits(int num)
+{
+	m_numActiveSetHits = num;
+}
+
+void btMultiBodyMLCPConstraintSolver::setUseGaussSeidelFallback(bool useGaussSeidelFallback)
+{
+	m_useGaussSeidelFallback = useGaussSeidelFallback;
+}
+
+bool btMultiBodyMLCPConstraintSolver::getUseGaussSeidelFallback() const
+{
+	return m_useGaussSeidelFallback;
+}
+
+int btMultiBodyMLCPConstraintSolver::getNumGaussSeidelFallbacks() const
+{
+	return m_numGaussSeidelFallbacks;
+}
+
+void btMultiBodyMLCPConstraintSolver::setNumGaussSeidelFallbacks(int num)
+{
+	m_numGaussSeidelFallbacks = num;
+}
+
 btConstraintSolverType btMultiBodyMLCPConstraintSolver::getSolverType() const
 {
 	return BT_MLCP_SOLVER;
@@ -94,6 +94,10 @@ protected:
 	/// Otherwise, -1.
 	btAlignedObjectArray<int> m_multiBodyLimitDependencies;
 
+	/// Impulse of the contact point that warm starts each multibody constraint: 0 for the normal impulse, 1 and 2 for
+	/// the lateral friction impulses, -1 for non-contact constraints.
+	btAlignedObjectArray<int> m_multiBodyContactImpulseIndex;
+
 	/// Array of all the rigid body constraints
 	btAlignedObjectArray<btSolverConstraint*> m_allConstraintPtrArray;
 
@@ -106,6 +110,24 @@ protected:
 	/// Count of fallbacks of using btSequentialImpulseConstraintSolver, which happens when the MLCP solver fails.
 	int m_fallback;
 
+	/// Whether the MLCPs are split into independent islands that are solved separately.
+	bool m_splitIslands;
+
+	/// Whether the active set implied by the warm started impulses is tried before the MLCP solver.
+	bool m_useActiveSetWarmStart;
+
+	/// Relative tolerance used to accept the solution of the warm started active set.
+	btScalar m_activeSetTolerance;
+
+	/// Count of islands solved by the warm started active set without calling the MLCP solver.
+	int m_numActiveSetHits;
+
+	/// Whether an island that the MLCP solver fails on is solved with btSolveProjectedGaussSeidel.
+	bool m_useGaussSeidelFallback;
+
+	/// Count of islands solved by btSolveProjectedGaussSeidel after the MLCP solver failed.
+	int m_numGaussSeidelFallbacks;
+
 	/// \name MLCP Scratch Variables
 	/// The following scratch variables are not stateful -- contents are cleared prior to each use.
 	/// They are only cached here to avoid extra memory allocations and deallocations and to ensure
@@ -122,6 +144,28 @@ protected:
 	/// Cache variable for offsets.
 	btAlignedObjectArray<int> m_scratchOfs;
 
+	/// Cache variables for splitting an MLCP into islands.
+	btAlignedObjectArray<int> m_scratchIslandParent;
+	btAlignedObjectArray<int> m_scratchIslandOffsets;
+	btAlignedObjectArray<int> m_scratchIslandRows;
+	btAlignedObjectArray<int> m_scratchIslandLocalIndex;
+	btAlignedObjectArray<int> m_scratchIslandFill;
+
+	/// Cache variables for the MLCP of a single island.
+	btMatrixXu m_scratchIslandA;
+	btVectorXu m_scratchIslandB;
+	btVectorXu m_scratchIslandX;
+	btVectorXu m_scratchIslandLo;
+	btVectorXu m_scratchIslandHi;
+	btAlignedObjectArray<int> m_scratchIslandLimitDependencies;
+
+	/// Cache variables for the warm started active set solve.
+	btAlignedObjectArray<int> m_scratchActiveSetState;
+	btAlignedObjectArray<int> m_scratchFreeRows;
+	btVectorXu m_scratchActiveSetX;
+	btAlignedObjectArray<btScalar> m_scratchFactor;
+	btAlignedObjectArray<btScalar> m_scratchRhs;
+
 	/// \}
 
 	/// Constructs MLCP terms, which are \c m_A, \c m_b, \c m_lo, and \c m_hi.
@@ -136,6 +180,17 @@ protected:
 	/// Solves MLCP and returns the success
 	virtual bool solveMLCP(const btContactSolverInfo& infoGlobal);
 
+	/// Splits the MLCP into islands of coupled rows and solves each of them with solveIslandMLCP.
+	bool solveMLCPByIslands(const btMatrixXu& A, const btVectorXu& b, btVectorXu& x, const btVectorXu& lo, const btVectorXu& hi, const btAlignedObjectArray<int>& limitDependencies, const btContactSolverInfo& infoGlobal);
+
+	/// Solves the MLCP of one island: the warm started active set is tried first, then the MLCP solver, then
+	/// btSolveProjectedGaussSeidel if the MLCP solver fails and the fallback is enabled. \c x holds the warm start on input.
+	bool solveIslandMLCP(const btMatrixXu& A, const btVectorXu& b, btVectorXu& x, const btVectorXu& lo, const btVectorXu& hi, const btAlignedObjectArray<int>& limitDependencies, const btContactSolverInfo& infoGlobal);
+
+	/// Keeps the rows of \c x that are at a bound in the warm start clamped, solves A x = b for the others and
+	/// returns true if the result satisfies the complementarity conditions. \c x is only modified on success.
+	bool solveActiveSetWarmStart(const btMatrixXu& A, const btVectorXu& b, btVectorXu& x, const btVectorXu& lo, const btVectorXu& hi, const btAlignedObjectArray<int>& limitDependencies);
+
 	// Documentation inherited
 	btScalar solveGroupCacheFriendlySetup(
 		btCollisionObject** bodies,
@@ -180,6 +235,33 @@ public:
 	/// Sets the number of fallbacks. This function may be used to reset the number to zero.
 	void setNumFallbacks(int num);
 
+	/// Enables or disables solving independent islands of the MLCP separately. Disabled by default.
+	void setSplitIslands(bool splitIslands);
+	bool getSplitIslands() const;
+
+	/// Enables or disables trying the active set of the warm started impulses before the MLCP solver. Disabled by
+	/// default; it only has an effect when SOLVER_USE_WARMSTARTING is set.
+	void setUseActiveSetWarmStart(bool useActiveSetWarmStart);
+	bool getUseActiveSetWarmStart() const;
+
+	/// Sets the relative tolerance used to accept the warm started active set solution.
+	void setActiveSetTolerance(btScalar tolerance);
+	btScalar getActiveSetTolerance() const;
+
+	/// Returns the number of islands solved by the warm started active set. setNumActiveSetHits may be used to reset it.
+	int getNumActiveSetHits() const;
+	void setNumActiveSetHits(int num);
+
+	/// Enables or disables solving an island with btSolveProjectedGaussSeidel when the MLCP solver fails on it.
+	/// Enabled by default. When disabled, or when the fallback fails too, the whole step falls back to
+	/// btMultiBodyConstraintSolver.
+	void setUseGaussSeidelFallback(bool useGaussSeidelFallback);
+	bool getUseGaussSeidelFallback() const;
+
+	/// Returns the number of islands solved by btSolveProjectedGaussSeidel. setNumGaussSeidelFallbacks may be used to reset it.
+	int getNumGaussSeidelFallbacks() const;
+	void setNumGaussSeidelFallbacks(int num);
+
 	/// Returns the constraint solver type.
 	virtual btConstraintSolverType getSolverType() const;
 };
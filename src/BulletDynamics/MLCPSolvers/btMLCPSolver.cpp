@@ -17,8 +17,12 @@ subject to the following restrictions:
 #include "btMLCPSolver.h"
 #include "LinearMath/btMatrixX.h"
 #include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
 #include "btSolveProjectedGaussSeidel.h"
 
+///number of rows of A assembled per task in createMLCP
+#define BT_MLCP_ASSEMBLY_GRAIN_SIZE 32
+
 btMLCPSolver::btMLCPSolver(btMLCPSolverInterface* solver)
 	: m_solver(solver),
 	  m_fallback(0)
@@ -455,6 +459,67 @@ void btMLCPSolver::createMLCPFast(const btContactSolverInfo& infoGlobal)
 	}
 }
 
+static inline btScalar btMLCPDot6(const btScalar* a, const btScalar* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] + a[4] * b[4] + a[5] * b[5];
+}
+
+///computes the lower triangle of A = J * M^-1 * J^T, one row of A per iteration.
+///Row i only touches the rows that share a body with it, found through the per-body row lists,
+///and only writes to row i of A, so rows can be assembled concurrently.
+struct btMLCPAssembleRowsLoop : public btIParallelForBody
+{
+	const btMLCPJacobianRow* m_jacobianRows;
+	const int* m_bodyRowOffsets;
+	const int* m_bodyRows;
+	btScalar* m_A;
+	int m_numRows;
+
+	btMLCPAssembleRowsLoop(const btMLCPJacobianRow* jacobianRows, const int* bodyRowOffsets, const int* bodyRows, btScalar* A, int numRows)
+		: m_jacobianRows(jacobianRows), m_bodyRowOffsets(bodyRowOffsets), m_bodyRows(bodyRows), m_A(A), m_numRows(numRows)
+	{
+	}
+
+	void addBodyBlock(int i, int body, const btScalar* jacInvM) const
+	{
+		btScalar* Arow = m_A + (size_t)i * m_numRows;
+		for (int r = m_bodyRowOffsets[body]; r < m_bodyRowOffsets[body + 1]; r++)
+		{
+			int j = m_bodyRows[r];
+			if (j > i)
+				break;  //rows are sorted, the upper triangle is mirrored afterwards
+			const btMLCPJacobianRow& other = m_jacobianRows[j];
+			const btScalar* jac = (other.m_bodyA == body) ? other.m_jacA : other.m_jacB;
+			Arow[j] += btMLCPDot6(jacInvM, jac);
+		}
+	}
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			const btMLCPJacobianRow& row = m_jacobianRows[i];
+			if (row.m_bodyA >= 0)
+				addBodyBlock(i, row.m_bodyA, row.m_jacInvMA);
+			if (row.m_bodyB >= 0 && row.m_bodyB != row.m_bodyA)
+				addBodyBlock(i, row.m_bodyB, row.m_jacInvMB);
+		}
+	}
+};
+
+static void btMLCPSetBodyBlock(btScalar* jac, btScalar* jacInvM, const btVector3& linear, const btVector3& angular, const btVector3& invMass, const btMatrix3x3& invInertia)
+{
+	btVector3 linearInvM = linear * invMass;
+	btVector3 angularInvM = angular * invInertia;
+	for (int r = 0; r < 3; r++)
+	{
+		jac[r] = linear[r];
+		jac[r + 3] = angular[r];
+		jacInvM[r] = linearInvM[r];
+		jacInvM[r + 3] = angularInvM[r];
+	}
+}
+
 void btMLCPSolver::createMLCP(const btContactSolverInfo& infoGlobal)
 {
 	int numBodies = this->m_tmpSolverBodyPool.size();
@@ -477,71 +542,85 @@ void btMLCPSolver::createMLCP(const btContactSolverInfo& infoGlobal)
 		}
 	}
 
-	btMatrixXu& Minv = m_scratchMInv;
-	Minv.resize(6 * numBodies, 6 * numBodies);
-	Minv.setZero();
-	for (int i = 0; i < numBodies; i++)
-	{
-		const btSolverBody& rb = m_tmpSolverBodyPool[i];
-		const btVector3& invMass = rb.m_invMass;
-		setElem(Minv, i * 6 + 0, i * 6 + 0, invMass[0]);
-		setElem(Minv, i * 6 + 1, i * 6 + 1, invMass[1]);
-		setElem(Minv, i * 6 + 2, i * 6 + 2, invMass[2]);
-		btRigidBody* orgBody = m_tmpSolverBodyPool[i].m_originalBody;
-
-		for (int r = 0; r < 3; r++)
-			for (int c = 0; c < 3; c++)
-				setElem(Minv, i * 6 + 3 + r, i * 6 + 3 + c, orgBody ? orgBody->getInvInertiaTensorWorld()[r][c] : 0);
-	}
-
-	btMatrixXu& J = m_scratchJ;
-	J.resize(numConstraintRows, 6 * numBodies);
-	J.setZero();
-
 	m_lo.resize(numConstraintRows);
 	m_hi.resize(numConstraintRows);
 
-	for (int i = 0; i < numConstraintRows; i++)
+	// J is stored as one pair of 6-wide body blocks per row, M^-1 is block diagonal so J * M^-1 has the same layout
+	btAlignedObjectArray<btMLCPJacobianRow>& jacobianRows = m_scratchJacobianRows;
+	btAlignedObjectArray<int>& bodyRowOffsets = m_scratchBodyRowOffsets;
+	btAlignedObjectArray<int>& bodyRows = m_scratchBodyRows;
 	{
-		m_lo[i] = m_allConstraintPtrArray[i]->m_lowerLimit;
-		m_hi[i] = m_allConstraintPtrArray[i]->m_upperLimit;
+		BT_PROFILE("J and J*Minv");
+		jacobianRows.resizeNoInitialize(numConstraintRows);
+		bodyRowOffsets.resize(0);
+		bodyRowOffsets.resize(numBodies + 1, 0);
 
-		int bodyIndex0 = m_allConstraintPtrArray[i]->m_solverBodyIdA;
-		int bodyIndex1 = m_allConstraintPtrArray[i]->m_solverBodyIdB;
-		if (m_tmpSolverBodyPool[bodyIndex0].m_originalBody)
+		for (int i = 0; i < numConstraintRows; i++)
 		{
-			setElem(J, i, 6 * bodyIndex0 + 0, m_allConstraintPtrArray[i]->m_contactNormal1[0]);
-			setElem(J, i, 6 * bodyIndex0 + 1, m_allConstraintPtrArray[i]->m_contactNormal1[1]);
-			setElem(J, i, 6 * bodyIndex0 + 2, m_allConstraintPtrArray[i]->m_contactNormal1[2]);
-			setElem(J, i, 6 * bodyIndex0 + 3, m_allConstraintPtrArray[i]->m_relpos1CrossNormal[0]);
-			setElem(J, i, 6 * bodyIndex0 + 4, m_allConstraintPtrArray[i]->m_relpos1CrossNormal[1]);
-			setElem(J, i, 6 * bodyIndex0 + 5, m_allConstraintPtrArray[i]->m_relpos1CrossNormal[2]);
+			const btSolverConstraint& c = *m_allConstraintPtrArray[i];
+			m_lo[i] = c.m_lowerLimit;
+			m_hi[i] = c.m_upperLimit;
+
+			btMLCPJacobianRow& row = jacobianRows[i];
+			row.m_bodyA = -1;
+			row.m_bodyB = -1;
+
+			const btSolverBody& bodyA = m_tmpSolverBodyPool[c.m_solverBodyIdA];
+			if (bodyA.m_originalBody)
+			{
+				row.m_bodyA = c.m_solverBodyIdA;
+				btMLCPSetBodyBlock(row.m_jacA, row.m_jacInvMA, c.m_contactNormal1, c.m_relpos1CrossNormal, bodyA.m_invMass, bodyA.m_originalBody->getInvInertiaTensorWorld());
+				bodyRowOffsets[row.m_bodyA + 1]++;
+			}
+			const btSolverBody& bodyB = m_tmpSolverBodyPool[c.m_solverBodyIdB];
+			if (bodyB.m_originalBody)
+			{
+				row.m_bodyB = c.m_solverBodyIdB;
+				btMLCPSetBodyBlock(row.m_jacB, row.m_jacInvMB, c.m_contactNormal2, c.m_relpos2CrossNormal, bodyB.m_invMass, bodyB.m_originalBody->getInvInertiaTensorWorld());
+				if (row.m_bodyB != row.m_bodyA)
+					bodyRowOffsets[row.m_bodyB + 1]++;
+			}
 		}
-		if (m_tmpSolverBodyPool[bodyIndex1].m_originalBody)
+
+		// per-body lists of the rows acting on it, in increasing row order
+		for (int b = 0; b < numBodies; b++)
 		{
-			setElem(J, i, 6 * bodyIndex1 + 0, m_allConstraintPtrArray[i]->m_contactNormal2[0]);
-			setElem(J, i, 6 * bodyIndex1 + 1, m_allConstraintPtrArray[i]->m_contactNormal2[1]);
-			setElem(J, i, 6 * bodyIndex1 + 2, m_allConstraintPtrArray[i]->m_contactNormal2[2]);
-			setElem(J, i, 6 * bodyIndex1 + 3, m_allConstraintPtrArray[i]->m_relpos2CrossNormal[0]);
-			setElem(J, i, 6 * bodyIndex1 + 4, m_allConstraintPtrArray[i]->m_relpos2CrossNormal[1]);
-			setElem(J, i, 6 * bodyIndex1 + 5, m_allConstraintPtrArray[i]->m_relpos2CrossNormal[2]);
+			bodyRowOffsets[b + 1] += bodyRowOffsets[b];
+		}
+		bodyRows.resizeNoInitialize(bodyRowOffsets[numBodies]);
+		btAlignedObjectArray<int> fill;
+		fill.resize(numBodies, 0);
+		for (int i = 0; i < numConstraintRows; i++)
+		{
+			const btMLCPJacobianRow& row = jacobianRows[i];
+			if (row.m_bodyA >= 0)
+				bodyRows[bodyRowOffsets[row.m_bodyA] + fill[row.m_bodyA]++] = i;
+			if (row.m_bodyB >= 0 && row.m_bodyB != row.m_bodyA)
+				bodyRows[bodyRowOffsets[row.m_bodyB] + fill[row.m_bodyB]++] = i;
 		}
 	}
 
-	btMatrixXu& J_transpose = m_scratchJTranspose;
-	J_transpose = J.transpose();
-
-	btMatrixXu& tmp = m_scratchTmp;
-
 	{
+		BT_PROFILE("J*Minv*J^T");
+		m_A.resize(numConstraintRows, numConstraintRows);
+		m_A.setZero();
+		if (numConstraintRows)
 		{
-			BT_PROFILE("J*Minv");
-			tmp = J * Minv;
-		}
-		{
-			BT_PROFILE("J*tmp");
-			m_A = tmp * J_transpose;
+			btMLCPAssembleRowsLoop assembleLoop(&jacobianRows[0], &bodyRowOffsets[0], bodyRows.size() ? &bodyRows[0] : 0, m_A.getBufferPointerWritable(), numConstraintRows);
+#if BT_THREADSAFE
+			if (btGetTaskScheduler())
+			{
+				btParallelFor(0, numConstraintRows, BT_MLCP_ASSEMBLY_GRAIN_SIZE, assembleLoop);
+			}
+			else
+			{
+				assembleLoop.forLoop(0, numConstraintRows);
+			}
+#else
+			assembleLoop.forLoop(0, numConstraintRows);
+#endif
 		}
+		m_A.copyLowerToUpperTriangle();
 	}
 
 	if (1)
@@ -21,6 +21,18 @@ subject to the following restrictions:
 #include "LinearMath/btMatrixX.h"
 #include "BulletDynamics/MLCPSolvers/btMLCPSolverInterface.h"
 
+///one row of the constraint Jacobian J, stored as a 6-wide (linear, angular) block for each of the two bodies,
+///together with the matching blocks of J * M^-1. A body index of -1 means the block is zero.
+struct btMLCPJacobianRow
+{
+	int m_bodyA;
+	int m_bodyB;
+	btScalar m_jacA[6];
+	btScalar m_jacB[6];
+	btScalar m_jacInvMA[6];
+	btScalar m_jacInvMB[6];
+};
+
 class btMLCPSolver : public btSequentialImpulseConstraintSolver
 {
 protected:
@@ -47,10 +59,9 @@ protected:
 	btMatrixXu m_scratchJ3;
 	btMatrixXu m_scratchJInvM3;
 	btAlignedObjectArray<int> m_scratchOfs;
-	btMatrixXu m_scratchMInv;
-	btMatrixXu m_scratchJ;
-	btMatrixXu m_scratchJTranspose;
-	btMatrixXu m_scratchTmp;
+	btAlignedObjectArray<btMLCPJacobianRow> m_scratchJacobianRows;
+	btAlignedObjectArray<int> m_scratchBodyRowOffsets;
+	btAlignedObjectArray<int> m_scratchBodyRows;
 
 	virtual btScalar solveGroupCacheFriendlySetup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer);
 	virtual btScalar solveGroupCacheFriendlyIterations(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer);
@@ -21,6 +21,8 @@
 #include "LinearMath/btMinMax.h"
 #include "LinearMath/btIDebugDraw.h"
 #include "BulletDynamics/ConstraintSolver/btContactConstraint.h"
+#include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include "LinearMath/btThreads.h"
 
 #define ROLLING_INFLUENCE_FIX
 
@@ -161,8 +163,6 @@ btScalar btRaycastVehicle::rayCast(btWheelInfo& wheel)
 {
 	updateWheelTransformsWS(wheel, false);
 
-	btScalar depth = -1;
-
 	btScalar raylen = wheel.getSuspensionRestLength() + wheel.m_wheelsRadius;
 
 	btVector3 rayvector = wheel.m_raycastInfo.m_wheelDirectionWS * (raylen);
@@ -170,14 +170,23 @@ btScalar btRaycastVehicle::rayCast(btWheelInfo& wheel)
 	wheel.m_raycastInfo.m_contactPointWS = source + rayvector;
 	const btVector3& target = wheel.m_raycastInfo.m_contactPointWS;
 
-	btScalar param = btScalar(0.);
-
 	btVehicleRaycaster::btVehicleRaycasterResult rayResults;
 
 	btAssert(m_vehicleRaycaster);
 
 	void* object = m_vehicleRaycaster->castRay(source, target, rayResults);
 
+	return processRayResult(wheel, object, rayResults, getFixedBody());
+}
+
+btScalar btRaycastVehicle::processRayResult(btWheelInfo& wheel, void* object, const btVehicleRaycaster::btVehicleRaycasterResult& rayResults, btRigidBody& groundObject)
+{
+	btScalar depth = -1;
+
+	btScalar raylen = wheel.getSuspensionRestLength() + wheel.m_wheelsRadius;
+
+	btScalar param = btScalar(0.);
+
 	wheel.m_raycastInfo.m_groundObject = 0;
 
 	if (object)
@@ -187,7 +196,7 @@ btScalar btRaycastVehicle::rayCast(btWheelInfo& wheel)
 		wheel.m_raycastInfo.m_contactNormalWS = rayResults.m_hitNormalInWorld;
 		wheel.m_raycastInfo.m_isInContact = true;
 
-		wheel.m_raycastInfo.m_groundObject = &getFixedBody();  ///@todo for driving on dynamic/movable objects!;
+		wheel.m_raycastInfo.m_groundObject = &groundObject;  ///@todo for driving on dynamic/movable objects!;
 		//wheel.m_raycastInfo.m_groundObject = object;
 
 		btScalar hitDistance = param * raylen;
@@ -253,13 +262,11 @@ const btTransform& btRaycastVehicle::getChassisWorldTransform() const
 	return getRigidBody()->getCenterOfMassTransform();
 }
 
-void btRaycastVehicle::updateVehicle(btScalar step)
+void btRaycastVehicle::updateWheelTransformsAndSpeed()
 {
+	for (int i = 0; i < getNumWheels(); i++)
 	{
-		for (int i = 0; i < getNumWheels(); i++)
-		{
-			updateWheelTransform(i, false);
-		}
+		updateWheelTransform(i, false);
 	}
 
 	m_currentVehicleSpeedKmHour = btScalar(3.6) * getRigidBody()->getLinearVelocity().length();
@@ -275,6 +282,11 @@ void btRaycastVehicle::updateVehicle(btScalar step)
 	{
 		m_currentVehicleSpeedKmHour *= btScalar(-1.);
 	}
+}
+
+void btRaycastVehicle::updateVehicle(btScalar step)
+{
+	updateWheelTransformsAndSpeed();
 
 	//
 	// simulate suspension
@@ -288,6 +300,36 @@ void btRaycastVehicle::updateVehicle(btScalar step)
 		rayCast(m_wheelInfo[i]);
 	}
 
+	updateWheelForces(step);
+}
+
+void btRaycastVehicle::updateWheelRays(btVector3* rayFrom, btVector3* rayTo)
+{
+	updateWheelTransformsAndSpeed();
+
+	for (int i = 0; i < m_wheelInfo.size(); i++)
+	{
+		btWheelInfo& wheel = m_wheelInfo[i];
+		updateWheelTransformsWS(wheel, false);
+		btScalar raylen = wheel.getSuspensionRestLength() + wheel.m_wheelsRadius;
+		rayFrom[i] = wheel.m_raycastInfo.m_hardPointWS;
+		wheel.m_raycastInfo.m_contactPointWS = rayFrom[i] + wheel.m_raycastInfo.m_wheelDirectionWS * (raylen);
+		rayTo[i] = wheel.m_raycastInfo.m_contactPointWS;
+	}
+}
+
+void btRaycastVehicle::updateWheelContacts(const btVehicleRaycaster::btVehicleRaycasterResult* rayResults, void* const* objects, btRigidBody& groundObject)
+{
+	for (int i = 0; i < m_wheelInfo.size(); i++)
+	{
+		processRayResult(m_wheelInfo[i], objects[i], rayResults[i], groundObject);
+	}
+}
+
+void btRaycastVehicle::updateWheelForces(btScalar step)
+{
+	int i;
+
 	updateSuspension(step);
 
 	for (i = 0; i < m_wheelInfo.size(); i++)
@@ -706,3 +748,122 @@ void* btDefaultVehicleRaycaster::castRay(const btVector3& from, const btVector3&
 	}
 	return 0;
 }
+
+struct btVehicleRaycastLoop : public btIParallelForBody
+{
+	btDefaultVehicleRaycaster* m_raycaster;
+	const btVector3* m_from;
+	const btVector3* m_to;
+	btVehicleRaycaster::btVehicleRaycasterResult* m_results;
+	void** m_objects;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			m_objects[i] = m_raycaster->castRay(m_from[i], m_to[i], m_results[i]);
+		}
+	}
+};
+
+#define BT_VEHICLE_RAYCAST_GRAIN_SIZE 64
+
+void btDefaultVehicleRaycaster::castRays(int numRays, const btVector3* from, const btVector3* to, btVehicleRaycasterResult* results, void** objects)
+{
+	btVehicleRaycastLoop loop;
+	loop.m_raycaster = this;
+	loop.m_from = from;
+	loop.m_to = to;
+	loop.m_results = results;
+	loop.m_objects = objects;
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		btParallelFor(0, numRays, BT_VEHICLE_RAYCAST_GRAIN_SIZE, loop);
+	}
+	else
+	{
+		loop.forLoop(0, numRays);
+	}
+#else
+	loop.forLoop(0, numRays);
+#endif
+}
+
+struct btVehicleSweepCallback : public btCollisionWorld::ClosestConvexResultCallback
+{
+	const void* m_exclude;
+
+	btVehicleSweepCallback(const btVector3& from, const btVector3& to, const void* exclude)
+		: btCollisionWorld::ClosestConvexResultCallback(from, to),
+		  m_exclude(exclude)
+	{
+	}
+
+	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+	{
+		if (proxy0->m_clientObject == m_exclude)
+			return false;
+		return btCollisionWorld::ClosestConvexResultCallback::needsCollision(proxy0);
+	}
+};
+
+struct btVehicleSweepLoop : public btIParallelForBody
+{
+	btDynamicsWorld* m_dynamicsWorld;
+	const btVector3* m_from;
+	const btVector3* m_to;
+	const btScalar* m_radii;
+	void* const* m_excludeObjects;
+	btVehicleRaycaster::btVehicleRaycasterResult* m_results;
+	void** m_objects;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			m_objects[i] = 0;
+			btSphereShape sphere(m_radii[i]);
+			btTransform from(btMatrix3x3::getIdentity(), m_from[i]);
+			btTransform to(btMatrix3x3::getIdentity(), m_to[i]);
+			btVehicleSweepCallback sweepCallback(m_from[i], m_to[i], m_excludeObjects ? m_excludeObjects[i] : 0);
+			m_dynamicsWorld->convexSweepTest(&sphere, from, to, sweepCallback);
+			if (sweepCallback.hasHit())
+			{
+				const btRigidBody* body = btRigidBody::upcast(sweepCallback.m_hitCollisionObject);
+				if (body && body->hasContactResponse())
+				{
+					m_results[i].m_hitPointInWorld = sweepCallback.m_hitPointWorld;
+					m_results[i].m_hitNormalInWorld = sweepCallback.m_hitNormalWorld;
+					m_results[i].m_hitNormalInWorld.normalize();
+					m_results[i].m_distFraction = sweepCallback.m_closestHitFraction;
+					m_objects[i] = (void*)body;
+				}
+			}
+		}
+	}
+};
+
+void btDefaultVehicleRaycaster::castSpheres(int numSpheres, const btVector3* from, const btVector3* to, const btScalar* radii, void* const* excludeObjects, btVehicleRaycasterResult* results, void** objects)
+{
+	btVehicleSweepLoop loop;
+	loop.m_dynamicsWorld = m_dynamicsWorld;
+	loop.m_from = from;
+	loop.m_to = to;
+	loop.m_radii = radii;
+	loop.m_excludeObjects = excludeObjects;
+	loop.m_results = results;
+	loop.m_objects = objects;
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		btParallelFor(0, numSpheres, BT_VEHICLE_RAYCAST_GRAIN_SIZE, loop);
+	}
+	else
+	{
+		loop.forLoop(0, numSpheres);
+	}
+#else
+	loop.forLoop(0, numSpheres);
+#endif
+}
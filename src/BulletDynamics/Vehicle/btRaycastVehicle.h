@@ -68,6 +68,9 @@ private:
 
 	void defaultInit(const btVehicleTuning& tuning);
 
+	void updateWheelTransformsAndSpeed();
+	btScalar processRayResult(btWheelInfo& wheel, void* object, const btVehicleRaycaster::btVehicleRaycasterResult& rayResults, btRigidBody& groundObject);
+
 public:
 	//constructor to create a car from an existing rigidbody
 	btRaycastVehicle(const btVehicleTuning& tuning, btRigidBody* chassis, btVehicleRaycaster* raycaster);
@@ -90,6 +93,16 @@ public:
 
 	virtual void updateVehicle(btScalar step);
 
+	///the three steps of updateVehicle, so btRaycastVehicleFleet can batch the suspension rays of many vehicles
+	///updateWheelRays updates the wheel transforms and vehicle speed and writes the suspension ray of each wheel
+	void updateWheelRays(btVector3* rayFrom, btVector3* rayTo);
+
+	///updates each wheel from the result of its suspension ray, as rayCast does once the raycaster returns
+	void updateWheelContacts(const btVehicleRaycaster::btVehicleRaycasterResult* rayResults, void* const* objects, btRigidBody& groundObject);
+
+	///applies the suspension and friction impulses and advances the wheel rotation
+	void updateWheelForces(btScalar step);
+
 	void resetSuspension();
 
 	btScalar getSteeringValue(int wheel) const;
@@ -213,6 +226,12 @@ public:
 	}
 
 	virtual void* castRay(const btVector3& from, const btVector3& to, btVehicleRaycasterResult& result);
+
+	///casts the rays with btParallelFor, the world's rayTest must be safe to call from several threads (BT_THREADSAFE)
+	virtual void castRays(int numRays, const btVector3* from, const btVector3* to, btVehicleRaycasterResult* results, void** objects);
+
+	///sweeps btSphereShape with convexSweepTest, in parallel like castRays
+	virtual void castSpheres(int numSpheres, const btVector3* from, const btVector3* to, const btScalar* radii, void* const* excludeObjects, btVehicleRaycasterResult* results, void** objects);
 };
 
 #endif  //BT_RAYCASTVEHICLE_H
@@ -0,0 +1,209 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btRaycastVehicleFleet.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+
+struct btVehicleFleetRaysLoop : public btIParallelForBody
+{
+	btRaycastVehicle* const* m_vehicles;
+	const int* m_wheelOffsets;
+	btVector3* m_rayFrom;
+	btVector3* m_rayTo;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			if (m_vehicles[i]->getNumWheels())
+			{
+				m_vehicles[i]->updateWheelRays(m_rayFrom + m_wheelOffsets[i], m_rayTo + m_wheelOffsets[i]);
+			}
+		}
+	}
+};
+
+struct btVehicleFleetForcesLoop : public btIParallelForBody
+{
+	btRaycastVehicle* const* m_vehicles;
+	const int* m_wheelOffsets;
+	const btVehicleRaycaster::btVehicleRaycasterResult* m_rayResults;
+	void* const* m_hitObjects;
+	btRigidBody* m_groundObject;
+	btScalar m_step;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			btRaycastVehicle* vehicle = m_vehicles[i];
+			if (vehicle->getNumWheels())
+			{
+				vehicle->updateWheelContacts(m_rayResults + m_wheelOffsets[i], m_hitObjects + m_wheelOffsets[i], *m_groundObject);
+			}
+			vehicle->updateWheelForces(m_step);
+		}
+	}
+};
+
+btRaycastVehicleFleet::btRaycastVehicleFleet(btVehicleRaycaster* raycaster)
+	: m_raycaster(raycaster),
+	  m_useWheelSweeps(false),
+	  m_grainSize(16)
+{
+}
+
+btRaycastVehicleFleet::~btRaycastVehicleFleet()
+{
+}
+
+void btRaycastVehicleFleet::addVehicle(btRaycastVehicle* vehicle)
+{
+	if (m_vehicles.findLinearSearch(vehicle) == m_vehicles.size())
+	{
+		m_vehicles.push_back(vehicle);
+	}
+}
+
+void btRaycastVehicleFleet::removeVehicle(btRaycastVehicle* vehicle)
+{
+	m_vehicles.remove(vehicle);
+}
+
+void btRaycastVehicleFleet::castWheelSweeps()
+{
+	const int numWheels = m_rayFrom.size();
+	m_wheelRadii.resize(numWheels);
+	m_chassisObjects.resize(numWheels);
+	// the sphere center travels the rest length, the ray the rest length plus the radius
+	for (int v = 0; v < m_vehicles.size(); v++)
+	{
+		btRaycastVehicle* vehicle = m_vehicles[v];
+		btCollisionObject* chassis = vehicle->getRigidBody();
+		for (int w = 0; w < vehicle->getNumWheels(); w++)
+		{
+			const btWheelInfo& wheel = vehicle->getWheelInfo(w);
+			const int i = m_wheelOffsets[v] + w;
+			const btScalar raylen = wheel.getSuspensionRestLength() + wheel.m_wheelsRadius;
+			m_rayTo[i] = m_rayFrom[i] + (m_rayTo[i] - m_rayFrom[i]) * (wheel.getSuspensionRestLength() / raylen);
+			m_wheelRadii[i] = wheel.m_wheelsRadius;
+			m_chassisObjects[i] = chassis;
+		}
+	}
+	m_raycaster->castSpheres(numWheels, &m_rayFrom[0], &m_rayTo[0], &m_wheelRadii[0], &m_chassisObjects[0], &m_rayResults[0], &m_hitObjects[0]);
+	// convert to the fraction of the suspension ray, which processRayResult expects
+	for (int v = 0; v < m_vehicles.size(); v++)
+	{
+		btRaycastVehicle* vehicle = m_vehicles[v];
+		for (int w = 0; w < vehicle->getNumWheels(); w++)
+		{
+			const btWheelInfo& wheel = vehicle->getWheelInfo(w);
+			const int i = m_wheelOffsets[v] + w;
+			if (m_hitObjects[i])
+			{
+				const btScalar raylen = wheel.getSuspensionRestLength() + wheel.m_wheelsRadius;
+				m_rayResults[i].m_distFraction = (m_rayResults[i].m_distFraction * wheel.getSuspensionRestLength() + wheel.m_wheelsRadius) / raylen;
+			}
+		}
+	}
+}
+
+void btRaycastVehicleFleet::updateFleet(btScalar step)
+{
+	BT_PROFILE("btRaycastVehicleFleet::updateFleet");
+	const int numVehicles = m_vehicles.size();
+	if (!numVehicles)
+		return;
+
+	m_wheelOffsets.resize(numVehicles);
+	int numWheels = 0;
+	for (int v = 0; v < numVehicles; v++)
+	{
+		m_wheelOffsets[v] = numWheels;
+		numWheels += m_vehicles[v]->getNumWheels();
+	}
+	m_rayFrom.resize(numWheels);
+	m_rayTo.resize(numWheels);
+	m_rayResults.resize(numWheels);
+	m_hitObjects.resize(numWheels);
+
+	btVehicleFleetRaysLoop raysLoop;
+	raysLoop.m_vehicles = &m_vehicles[0];
+	raysLoop.m_wheelOffsets = &m_wheelOffsets[0];
+	raysLoop.m_rayFrom = numWheels ? &m_rayFrom[0] : 0;
+	raysLoop.m_rayTo = numWheels ? &m_rayTo[0] : 0;
+	{
+		BT_PROFILE("updateWheelRays");
+#if BT_THREADSAFE
+		if (btGetTaskScheduler())
+		{
+			btParallelFor(0, numVehicles, m_grainSize, raysLoop);
+		}
+		else
+		{
+			raysLoop.forLoop(0, numVehicles);
+		}
+#else
+		raysLoop.forLoop(0, numVehicles);
+#endif
+	}
+
+	if (numWheels)
+	{
+		BT_PROFILE("castWheelRays");
+		btAssert(m_raycaster);
+		if (m_useWheelSweeps)
+		{
+			castWheelSweeps();
+		}
+		else
+		{
+			m_raycaster->castRays(numWheels, &m_rayFrom[0], &m_rayTo[0], &m_rayResults[0], &m_hitObjects[0]);
+		}
+	}
+
+	btVehicleFleetForcesLoop forcesLoop;
+	forcesLoop.m_vehicles = &m_vehicles[0];
+	forcesLoop.m_wheelOffsets = &m_wheelOffsets[0];
+	forcesLoop.m_rayResults = numWheels ? &m_rayResults[0] : 0;
+	forcesLoop.m_hitObjects = numWheels ? &m_hitObjects[0] : 0;
+	// getFixedBody resets the mass of the shared body on every call, so fetch it once outside the loop
+	forcesLoop.m_groundObject = &getFixedBody();
+	forcesLoop.m_step = step;
+	{
+		BT_PROFILE("updateWheelForces");
+#if BT_THREADSAFE
+		if (btGetTaskScheduler())
+		{
+			btParallelFor(0, numVehicles, m_grainSize, forcesLoop);
+		}
+		else
+		{
+			forcesLoop.forLoop(0, numVehicles);
+		}
+#else
+		forcesLoop.forLoop(0, numVehicles);
+#endif
+	}
+}
+
+void btRaycastVehicleFleet::debugDraw(btIDebugDraw* debugDrawer)
+{
+	for (int v = 0; v < m_vehicles.size(); v++)
+	{
+		m_vehicles[v]->debugDraw(debugDrawer);
+	}
+}
@@ -0,0 +1,96 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_RAYCAST_VEHICLE_FLEET_H
+#define BT_RAYCAST_VEHICLE_FLEET_H
+
+#include "btRaycastVehicle.h"
+
+///btRaycastVehicleFleet updates many btRaycastVehicle as a single action. The suspension rays of all wheels
+///go to the fleet raycaster in one btVehicleRaycaster::castRays call, and the wheel contacts, suspension and
+///friction of the vehicles are computed with btParallelFor. Results match updating each vehicle on its own.
+///Add the fleet to the world with addAction instead of the vehicles. Vehicles must not share a chassis, and
+///overrides of btRaycastVehicle::updateVehicle are not called.
+class btRaycastVehicleFleet : public btActionInterface
+{
+	btVehicleRaycaster* m_raycaster;
+	btAlignedObjectArray<btRaycastVehicle*> m_vehicles;
+	btAlignedObjectArray<int> m_wheelOffsets;
+	btAlignedObjectArray<btVector3> m_rayFrom;
+	btAlignedObjectArray<btVector3> m_rayTo;
+	btAlignedObjectArray<btScalar> m_wheelRadii;
+	btAlignedObjectArray<void*> m_chassisObjects;
+	btAlignedObjectArray<btVehicleRaycaster::btVehicleRaycasterResult> m_rayResults;
+	btAlignedObjectArray<void*> m_hitObjects;
+	bool m_useWheelSweeps;
+	int m_grainSize;
+
+	void castWheelSweeps();
+
+public:
+	btRaycastVehicleFleet(btVehicleRaycaster* raycaster);
+
+	virtual ~btRaycastVehicleFleet();
+
+	void addVehicle(btRaycastVehicle* vehicle);
+
+	void removeVehicle(btRaycastVehicle* vehicle);
+
+	int getNumVehicles() const
+	{
+		return m_vehicles.size();
+	}
+
+	btRaycastVehicle* getVehicle(int index)
+	{
+		return m_vehicles[index];
+	}
+
+	///sweep a sphere of the wheel radius along the suspension instead of casting a ray, see btVehicleRaycaster::castSpheres
+	void setUseWheelSweeps(bool useWheelSweeps)
+	{
+		m_useWheelSweeps = useWheelSweeps;
+	}
+
+	bool getUseWheelSweeps() const
+	{
+		return m_useWheelSweeps;
+	}
+
+	///number of vehicles per btParallelFor task
+	void setGrainSize(int grainSize)
+	{
+		m_grainSize = btMax(1, grainSize);
+	}
+
+	int getGrainSize() const
+	{
+		return m_grainSize;
+	}
+
+	///btActionInterface interface
+	virtual void updateAction(btCollisionWorld* collisionWorld, btScalar step)
+	{
+		(void)collisionWorld;
+		updateFleet(step);
+	}
+
+	///btActionInterface interface
+	virtual void debugDraw(btIDebugDraw* debugDrawer);
+
+	void updateFleet(btScalar step);
+};
+
+#endif  //BT_RAYCAST_VEHICLE_FLEET_H
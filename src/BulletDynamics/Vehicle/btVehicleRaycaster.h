@@ -28,6 +28,36 @@ struct btVehicleRaycaster
 	};
 
 	virtual void* castRay(const btVector3& from, const btVector3& to, btVehicleRaycasterResult& result) = 0;
+
+	///casts numRays rays at once, objects[i] receives what castRay returns for ray i
+	///the default implementation calls castRay for each ray, override it to batch the queries
+	virtual void castRays(int numRays, const btVector3* from, const btVector3* to, btVehicleRaycasterResult* results, void** objects)
+	{
+		for (int i = 0; i < numRays; i++)
+		{
+			objects[i] = castRay(from[i], to[i], results[i]);
+		}
+	}
+
+	///sweeps spheres with the given radii from their centers at from to to, ignoring excludeObjects[i] (may be 0) for sphere i
+	///m_distFraction is the fraction of the center path that the sphere travels before the hit
+	///the default implementation casts rays extended by the radius, which is what castRays sees for a thin wheel
+	virtual void castSpheres(int numSpheres, const btVector3* from, const btVector3* to, const btScalar* radii, void* const* excludeObjects, btVehicleRaycasterResult* results, void** objects)
+	{
+		(void)excludeObjects;
+		for (int i = 0; i < numSpheres; i++)
+		{
+			const btVector3 path = to[i] - from[i];
+			const btScalar length = path.length();
+			const btVector3 dir = length > SIMD_EPSILON ? path / length : btVector3(0, 0, 0);
+			objects[i] = castRay(from[i], to[i] + dir * radii[i], results[i]);
+			if (objects[i])
+			{
+				const btScalar distance = results[i].m_distFraction * (length + radii[i]) - radii[i];
+				results[i].m_distFraction = length > SIMD_EPSILON ? btMax(btScalar(0), distance / length) : btScalar(0);
+			}
+		}
+	}
 };
 
 #endif  //BT_VEHICLE_RAYCASTER_H
@@ -135,6 +135,59 @@ int MultiBodyTree::calculateMassMatrix(const vecx &q, matxx *mass_matrix)
 	return calculateMassMatrix(q, true, true, true, mass_matrix);
 }
 
+int MultiBodyTree::calculateInverseDynamicsDerivatives(const vecx &q, const vecx &u,
+													   const vecx &dot_u, matxx *d_joint_forces_d_q,
+													   matxx *d_joint_forces_d_u)
+{
+	if (false == m_is_finalized)
+	{
+		bt_id_error_message("system has not been initialized\n");
+		return -1;
+	}
+	if (-1 == m_impl->calculateInverseDynamicsDerivatives(q, u, dot_u, d_joint_forces_d_q,
+														  d_joint_forces_d_u))
+	{
+		bt_id_error_message("error in inverse dynamics derivative calculation\n");
+		return -1;
+	}
+	return 0;
+}
+
+int MultiBodyTree::calculateForwardDynamics(const vecx &q, const vecx &u, const vecx &joint_forces,
+											vecx *dot_u)
+{
+	if (false == m_is_finalized)
+	{
+		bt_id_error_message("system has not been initialized\n");
+		return -1;
+	}
+	if (-1 == m_impl->calculateForwardDynamics(q, u, joint_forces, dot_u))
+	{
+		bt_id_error_message("error in forward dynamics calculation\n");
+		return -1;
+	}
+	return 0;
+}
+
+int MultiBodyTree::calculateForwardDynamicsDerivatives(const vecx &q, const vecx &u,
+													   const vecx &joint_forces, vecx *dot_u,
+													   matxx *d_dot_u_d_q, matxx *d_dot_u_d_u,
+													   matxx *d_dot_u_d_joint_forces)
+{
+	if (false == m_is_finalized)
+	{
+		bt_id_error_message("system has not been initialized\n");
+		return -1;
+	}
+	if (-1 == m_impl->calculateForwardDynamicsDerivatives(q, u, joint_forces, dot_u, d_dot_u_d_q,
+														  d_dot_u_d_u, d_dot_u_d_joint_forces))
+	{
+		bt_id_error_message("error in forward dynamics derivative calculation\n");
+		return -1;
+	}
+	return 0;
+}
+
 int MultiBodyTree::calculateKinematics(const vecx &q, const vecx &u, const vecx &dot_u)
 {
 	vec3 world_gravity(m_impl->m_world_gravity);
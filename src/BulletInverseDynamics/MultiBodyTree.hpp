@@ -158,6 +158,53 @@ public:
 	/// @return -1 on error, 0 on success
 	int calculateMassMatrix(const vecx& q, matxx* mass_matrix);
 
+	/// Calculate the partial derivatives of the joint forces returned by
+	/// calculateInverseDynamics w.r.t. the generalized coordinates and velocities.
+	/// The derivatives are computed recursively alongside the inverse dynamics
+	/// algorithm, not by finite differences.
+	/// (The derivative w.r.t. dot_u is the mass matrix, see calculateMassMatrix).
+	/// This also updates kinematic terms, like calculateInverseDynamics.
+	/// Supported joint types are FIXED, REVOLUTE, PRISMATIC and FLOATING. Systems with
+	/// SPHERICAL joints are rejected with an error.
+	/// The cost is one tangent pass over the moved subtree per coordinate, roughly half the
+	/// time of central finite differences of calculateInverseDynamics for chains of a few
+	/// tens of DoFs, not the order of magnitude of a fused spatial algebra formulation.
+	/// @param q generalized coordinates
+	/// @param u generalized velocities
+	/// @param dot_u time derivative of u
+	/// @param d_joint_forces_d_q output, d(joint_forces)/dq (should be dim(u)xdim(q))
+	/// @param d_joint_forces_d_u output, d(joint_forces)/du (should be dim(u)xdim(u))
+	/// @return 0 on success, -1 on error
+	int calculateInverseDynamicsDerivatives(const vecx& q, const vecx& u, const vecx& dot_u,
+											matxx* d_joint_forces_d_q, matxx* d_joint_forces_d_u);
+	/// Calculate generalized accelerations for given joint forces (forward dynamics),
+	/// by solving M(q)*dot_u = joint_forces - h(q,u).
+	/// The result is consistent with calculateInverseDynamics, ie, it includes
+	/// gravity and user forces.
+	/// @param q generalized coordinates
+	/// @param u generalized velocities
+	/// @param joint_forces generalized forces
+	/// @param dot_u output, time derivative of u
+	/// @return 0 on success, -1 on error
+	int calculateForwardDynamics(const vecx& q, const vecx& u, const vecx& joint_forces, vecx* dot_u);
+	/// Calculate forward dynamics and its partial derivatives.
+	/// These follow from differentiating the equations of motion, eg,
+	/// d(dot_u)/dq = -M^-1*d(joint_forces)/dq, with the inverse dynamics
+	/// derivatives from calculateInverseDynamicsDerivatives.
+	/// Supports the same joint types as calculateInverseDynamicsDerivatives.
+	/// @param q generalized coordinates
+	/// @param u generalized velocities
+	/// @param joint_forces generalized forces
+	/// @param dot_u output, time derivative of u
+	/// @param d_dot_u_d_q output, d(dot_u)/dq (should be dim(u)xdim(q))
+	/// @param d_dot_u_d_u output, d(dot_u)/du (should be dim(u)xdim(u))
+	/// @param d_dot_u_d_joint_forces output, d(dot_u)/d(joint_forces),
+	///		ie, the inverse mass matrix (should be dim(u)xdim(u))
+	/// @return 0 on success, -1 on error
+	int calculateForwardDynamicsDerivatives(const vecx& q, const vecx& u, const vecx& joint_forces,
+											vecx* dot_u, matxx* d_dot_u_d_q, matxx* d_dot_u_d_u,
+											matxx* d_dot_u_d_joint_forces);
+
 	/// Calculates kinematics also calculated in calculateInverseDynamics,
 	/// but not dynamics.
 	/// This function ensures that correct accelerations are computed that do not
@@ -171,6 +171,17 @@ int MultiBodyTree::MultiBodyImpl::generateIndexSets()
 		return -1;
 	}
 
+	m_dof_body_index.resize(m_num_dofs);
+	for (idArrayIdx i = 0; i < m_body_list.size(); i++)
+	{
+		const RigidBody &body = m_body_list[i];
+		for (int dof = 0; dof < bodyNumDoFs(body.m_joint_type); dof++)
+		{
+			m_dof_body_index[body.m_q_index + dof] = i;
+		}
+	}
+	m_tangent_list.resize(m_body_list.size());
+
 	m_child_indices.resize(m_body_list.size());
 
 	for (idArrayIdx child = 1; child < m_parent_index.size(); child++)
@@ -383,6 +394,503 @@ int MultiBodyTree::MultiBodyImpl::calculateInverseDynamics(const vecx &q, const
 	return 0;
 }
 
+int MultiBodyTree::MultiBodyImpl::calculateInverseDynamicsDerivatives(const vecx &q, const vecx &u,
+																	   const vecx &dot_u,
+																	   matxx *d_joint_forces_d_q,
+																	   matxx *d_joint_forces_d_u)
+{
+	// The derivatives are calculated by differentiating the recursions in calculateKinematics
+	// and calculateInverseDynamics w.r.t. one generalized coordinate at a time
+	// (forward mode differentiation, see calculateTangents).
+	// Every coordinate only changes the kinematics of the subtree it moves and the forces
+	// of that subtree and its ancestors, so for chains and trees of moderate depth this
+	// costs a fraction of the 2*dim(q) inverse dynamics evaluations needed for
+	// central finite differences, and is exact up to round-off.
+	if (d_joint_forces_d_q->rows() != m_num_dofs || d_joint_forces_d_q->cols() != m_num_dofs ||
+		d_joint_forces_d_u->rows() != m_num_dofs || d_joint_forces_d_u->cols() != m_num_dofs)
+	{
+		bt_id_error_message(
+			"Dimension error. System has %d DOFs,\n"
+			"but dim(d_joint_forces_d_q)= %d x %d, dim(d_joint_forces_d_u)= %d x %d\n",
+			m_num_dofs, static_cast<int>(d_joint_forces_d_q->rows()),
+			static_cast<int>(d_joint_forces_d_q->cols()),
+			static_cast<int>(d_joint_forces_d_u->rows()),
+			static_cast<int>(d_joint_forces_d_u->cols()));
+		return -1;
+	}
+	if (m_body_spherical_list.size() > 0)
+	{
+		bt_id_error_message("derivatives are not implemented for spherical joints\n");
+		return -1;
+	}
+
+	// 1. kinematics and joint forces at the current state
+	vecx joint_forces(m_num_dofs);
+	if (-1 == calculateInverseDynamics(q, u, dot_u, &joint_forces))
+	{
+		bt_id_error_message("error in calculateInverseDynamics\n");
+		return -1;
+	}
+
+	// 2. one column per generalized position and velocity
+	for (int wrt_u = 0; wrt_u < 2; wrt_u++)
+	{
+		matxx *jacobian = wrt_u ? d_joint_forces_d_u : d_joint_forces_d_q;
+		for (int dof = 0; dof < m_num_dofs; dof++)
+		{
+			calculateTangents(dof, wrt_u != 0, q, u, dot_u);
+
+			// 3. joint force derivatives: components of the force & moment derivatives
+			// in the free directions (as in calculateInverseDynamics)
+			for (int i = 0; i < m_num_dofs; i++)
+			{
+				setMatxxElem(i, dof, 0.0, jacobian);
+			}
+			for (idArrayIdx i = 0; i < m_body_revolute_list.size(); i++)
+			{
+				const RigidBody &body = m_body_list[m_body_revolute_list[i]];
+				const RigidBodyTangent &tangent = m_tangent_list[m_body_revolute_list[i]];
+				if (tangent.m_forces_active)
+				{
+					setMatxxElem(body.m_q_index, dof, body.m_Jac_JR.dot(tangent.m_moment_at_joint), jacobian);
+				}
+			}
+			for (idArrayIdx i = 0; i < m_body_prismatic_list.size(); i++)
+			{
+				const RigidBody &body = m_body_list[m_body_prismatic_list[i]];
+				const RigidBodyTangent &tangent = m_tangent_list[m_body_prismatic_list[i]];
+				if (tangent.m_forces_active)
+				{
+					setMatxxElem(body.m_q_index, dof, body.m_Jac_JT.dot(tangent.m_force_at_joint), jacobian);
+				}
+			}
+			for (idArrayIdx i = 0; i < m_body_floating_list.size(); i++)
+			{
+				const RigidBody &body = m_body_list[m_body_floating_list[i]];
+				const RigidBodyTangent &tangent = m_tangent_list[m_body_floating_list[i]];
+				if (tangent.m_forces_active)
+				{
+					for (int k = 0; k < 3; k++)
+					{
+						setMatxxElem(body.m_q_index + k, dof, tangent.m_moment_at_joint(k), jacobian);
+						setMatxxElem(body.m_q_index + 3 + k, dof, tangent.m_force_at_joint(k), jacobian);
+					}
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+void MultiBodyTree::MultiBodyImpl::calculateTangents(const int dof, const bool wrt_u, const vecx &q,
+													 const vecx &u, const vecx &dot_u)
+{
+	vec3 zero;
+	setZero(zero);
+	mat33 zero_mat;
+	setZero(zero_mat);
+
+	for (idArrayIdx i = 0; i < m_tangent_list.size(); i++)
+	{
+		m_tangent_list[i].m_kinematics_active = false;
+		m_tangent_list[i].m_forces_active = false;
+	}
+
+	// 1. derivatives of the relative kinematics of the body moved by q(dof)/u(dof)
+	const int joint_body_index = m_dof_body_index[dof];
+	const RigidBody &joint_body = m_body_list[joint_body_index];
+	RigidBodyTangent &joint_tangent = m_tangent_list[joint_body_index];
+	joint_tangent.m_body_T_parent = zero_mat;
+	joint_tangent.m_parent_pos_parent_body = zero;
+	joint_tangent.m_body_ang_vel_rel = zero;
+	joint_tangent.m_parent_vel_rel = zero;
+	joint_tangent.m_body_ang_acc_rel = zero;
+	joint_tangent.m_parent_acc_rel = zero;
+	const int joint_dof = dof - joint_body.m_q_index;
+	switch (joint_body.m_joint_type)
+	{
+		case REVOLUTE:
+			if (wrt_u)
+			{
+				joint_tangent.m_body_ang_vel_rel = joint_body.m_Jac_JR;
+			}
+			else
+			{
+				// body_T_parent = R(axis, -q)*body_T_parent_ref, so
+				// d(body_T_parent)/dq = -tilde(axis)*body_T_parent = tilde(axis)^T*body_T_parent
+				joint_tangent.m_body_T_parent =
+					tildeOperator(joint_body.m_Jac_JR).transpose() * joint_body.m_body_T_parent;
+			}
+			break;
+		case PRISMATIC:
+			if (wrt_u)
+			{
+				joint_tangent.m_parent_vel_rel = joint_body.m_parent_Jac_JT;
+			}
+			else
+			{
+				joint_tangent.m_parent_pos_parent_body = joint_body.m_parent_Jac_JT;
+			}
+			break;
+		case FLOATING:
+		{
+			const mat33 &T = joint_body.m_body_T_parent;
+			if (wrt_u)
+			{
+				if (joint_dof < 3)
+				{
+					joint_tangent.m_body_ang_vel_rel(joint_dof) = 1.0;
+				}
+				else
+				{
+					// row of T = column of T^T
+					for (int k = 0; k < 3; k++)
+					{
+						joint_tangent.m_parent_vel_rel(k) = T(joint_dof - 3, k);
+					}
+				}
+			}
+			else if (joint_dof < 3)
+			{
+				// body_T_parent = Z*Y*X, the elementary transforms are transposed rotations,
+				// so their derivatives are -tilde(axis)*transform = tilde(axis)^T*transform
+				const int idx = joint_body.m_q_index;
+				const mat33 X = transformX(q(idx));
+				const mat33 Y = transformY(q(idx + 1));
+				const mat33 Z = transformZ(q(idx + 2));
+				vec3 axis;
+				setZero(axis);
+				axis(joint_dof) = 1.0;
+				const mat33 tilde_axis_T = tildeOperator(axis).transpose();
+				mat33 &dT = joint_tangent.m_body_T_parent;
+				switch (joint_dof)
+				{
+					case 0:
+						dT = Z * Y * (tilde_axis_T * X);
+						break;
+					case 1:
+						dT = Z * (tilde_axis_T * Y) * X;
+						break;
+					default:
+						dT = tilde_axis_T * T;
+						break;
+				}
+				vec3 parent_pos, parent_vel, parent_acc;
+				for (int k = 0; k < 3; k++)
+				{
+					parent_pos(k) = q(idx + 3 + k);
+					parent_vel(k) = u(idx + 3 + k);
+					parent_acc(k) = dot_u(idx + 3 + k);
+				}
+				joint_tangent.m_parent_pos_parent_body = dT * parent_pos;
+				joint_tangent.m_parent_vel_rel = dT.transpose() * parent_vel;
+				joint_tangent.m_parent_acc_rel = dT.transpose() * parent_acc;
+			}
+			else
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					joint_tangent.m_parent_pos_parent_body(k) = T(k, joint_dof - 3);
+				}
+			}
+			break;
+		}
+		default:
+			// fixed joints have no dofs, spherical joints are rejected by the caller
+			break;
+	}
+	joint_tangent.m_kinematics_active = true;
+
+	// 2. absolute kinematics, only for the subtree moved by the joint.
+	// (parents always have smaller indices than their children)
+	for (idArrayIdx i = joint_body_index; i < m_body_list.size(); i++)
+	{
+		RigidBody &body = m_body_list[i];
+		RigidBodyTangent &tangent = m_tangent_list[i];
+		if (static_cast<int>(i) != joint_body_index)
+		{
+			if (!m_tangent_list[m_parent_index[i]].m_kinematics_active)
+			{
+				continue;
+			}
+			tangent.m_kinematics_active = true;
+			tangent.m_body_T_parent = zero_mat;
+			tangent.m_parent_pos_parent_body = zero;
+			tangent.m_body_ang_vel_rel = zero;
+			tangent.m_parent_vel_rel = zero;
+			tangent.m_body_ang_acc_rel = zero;
+			tangent.m_parent_acc_rel = zero;
+		}
+
+		if (0 == i)
+		{
+			// root body, see calculateKinematics
+			tangent.m_body_ang_vel = tangent.m_body_ang_vel_rel;
+			tangent.m_body_vel = tangent.m_parent_vel_rel;
+			tangent.m_body_ang_acc = tangent.m_body_ang_acc_rel;
+			tangent.m_body_acc = tangent.m_body_T_parent * (body.m_parent_acc_rel - m_world_gravity) +
+								 body.m_body_T_parent * tangent.m_parent_acc_rel;
+			continue;
+		}
+
+		const RigidBody &parent = m_body_list[m_parent_index[i]];
+		const RigidBodyTangent &parent_tangent = m_tangent_list[m_parent_index[i]];
+		const bool parent_active = parent_tangent.m_kinematics_active;
+		const vec3 &d_parent_ang_vel = parent_active ? parent_tangent.m_body_ang_vel : zero;
+		const vec3 &d_parent_vel = parent_active ? parent_tangent.m_body_vel : zero;
+		const vec3 &d_parent_ang_acc = parent_active ? parent_tangent.m_body_ang_acc : zero;
+		const vec3 &d_parent_acc = parent_active ? parent_tangent.m_body_acc : zero;
+		const vec3 &r = body.m_parent_pos_parent_body;
+		const vec3 &d_r = tangent.m_parent_pos_parent_body;
+		const mat33 &T = body.m_body_T_parent;
+		const mat33 &d_T = tangent.m_body_T_parent;
+
+		tangent.m_body_ang_vel = d_T * parent.m_body_ang_vel + T * d_parent_ang_vel +
+								 tangent.m_body_ang_vel_rel;
+
+		const vec3 vel_in_parent =
+			parent.m_body_vel + parent.m_body_ang_vel.cross(r) + body.m_parent_vel_rel;
+		tangent.m_body_vel =
+			d_T * vel_in_parent +
+			T * (d_parent_vel + d_parent_ang_vel.cross(r) + parent.m_body_ang_vel.cross(d_r) +
+				 tangent.m_parent_vel_rel);
+
+		const vec3 parent_ang_vel_in_body = T * parent.m_body_ang_vel;
+		tangent.m_body_ang_acc =
+			d_T * parent.m_body_ang_acc + T * d_parent_ang_acc -
+			tangent.m_body_ang_vel_rel.cross(parent_ang_vel_in_body) -
+			body.m_body_ang_vel_rel.cross(d_T * parent.m_body_ang_vel + T * d_parent_ang_vel) +
+			tangent.m_body_ang_acc_rel;
+
+		const vec3 &w = parent.m_body_ang_vel;
+		const vec3 acc_in_parent = parent.m_body_acc + parent.m_body_ang_acc.cross(r) +
+								   w.cross(w.cross(r)) + 2.0 * w.cross(body.m_parent_vel_rel) +
+								   body.m_parent_acc_rel;
+		tangent.m_body_acc =
+			d_T * acc_in_parent +
+			T * (d_parent_acc + d_parent_ang_acc.cross(r) + parent.m_body_ang_acc.cross(d_r) +
+				 d_parent_ang_vel.cross(w.cross(r)) +
+				 w.cross(d_parent_ang_vel.cross(r) + w.cross(d_r)) +
+				 2.0 * (d_parent_ang_vel.cross(body.m_parent_vel_rel) + w.cross(tangent.m_parent_vel_rel)) +
+				 tangent.m_parent_acc_rel);
+	}
+
+	// 3. joint forces & moments, for the moved subtree and its ancestors
+	for (int body_idx = m_body_list.size() - 1; body_idx >= 0; body_idx--)
+	{
+		const RigidBody &body = m_body_list[body_idx];
+		RigidBodyTangent &tangent = m_tangent_list[body_idx];
+
+		vec3 d_sum_f_children;
+		vec3 d_sum_m_children;
+		setZero(d_sum_f_children);
+		setZero(d_sum_m_children);
+		bool forces_active = tangent.m_kinematics_active;
+		for (idArrayIdx child_list_idx = 0; child_list_idx < m_child_indices[body_idx].size();
+			 child_list_idx++)
+		{
+			const int child_idx = m_child_indices[body_idx][child_list_idx];
+			const RigidBody &child = m_body_list[child_idx];
+			const RigidBodyTangent &child_tangent = m_tangent_list[child_idx];
+			if (!child_tangent.m_forces_active)
+			{
+				continue;
+			}
+			forces_active = true;
+			const mat33 this_T_child = child.m_body_T_parent.transpose();
+			const vec3 child_joint_force_in_this_frame = this_T_child * child.m_force_at_joint;
+			vec3 d_child_joint_force = this_T_child * child_tangent.m_force_at_joint;
+			vec3 d_child_joint_moment = this_T_child * child_tangent.m_moment_at_joint;
+			if (child_tangent.m_kinematics_active)
+			{
+				const mat33 d_this_T_child = child_tangent.m_body_T_parent.transpose();
+				d_child_joint_force += d_this_T_child * child.m_force_at_joint;
+				d_child_joint_moment += d_this_T_child * child.m_moment_at_joint +
+										child_tangent.m_parent_pos_parent_body.cross(child_joint_force_in_this_frame);
+			}
+			d_sum_f_children -= d_child_joint_force;
+			d_sum_m_children -= d_child_joint_moment +
+								child.m_parent_pos_parent_body.cross(d_child_joint_force);
+		}
+		tangent.m_forces_active = forces_active;
+		if (!forces_active)
+		{
+			continue;
+		}
+
+		tangent.m_force_at_joint = zero - d_sum_f_children;
+		tangent.m_moment_at_joint = zero - d_sum_m_children;
+		if (tangent.m_kinematics_active)
+		{
+			// derivatives of m_eom_lhs_rotational and m_eom_lhs_translational
+			// (user forces are constant in the body-fixed frame)
+			const vec3 &w = body.m_body_ang_vel;
+			const vec3 &d_w = tangent.m_body_ang_vel;
+			tangent.m_moment_at_joint +=
+				body.m_body_I_body * tangent.m_body_ang_acc +
+				body.m_body_mass_com.cross(tangent.m_body_acc) +
+				d_w.cross(body.m_body_I_body * w) + w.cross(body.m_body_I_body * d_w);
+			tangent.m_force_at_joint +=
+				tangent.m_body_ang_acc.cross(body.m_body_mass_com) + body.m_mass * tangent.m_body_acc +
+				d_w.cross(w.cross(body.m_body_mass_com)) + w.cross(d_w.cross(body.m_body_mass_com));
+		}
+	}
+}
+
+// in-place cholesky decomposition of a symmetric positive definite matrix,
+// the lower triangle of m is replaced by the factor L, m = L*L^T
+static int choleskyDecomposition(matxx *m)
+{
+	const int n = m->rows();
+	for (int j = 0; j < n; j++)
+	{
+		idScalar diagonal = (*m)(j, j);
+		for (int k = 0; k < j; k++)
+		{
+			diagonal -= (*m)(j, k) * (*m)(j, k);
+		}
+		if (diagonal <= 0)
+		{
+			bt_id_error_message("mass matrix is not positive definite\n");
+			return -1;
+		}
+		setMatxxElem(j, j, BT_ID_SQRT(diagonal), m);
+		for (int i = j + 1; i < n; i++)
+		{
+			idScalar value = (*m)(i, j);
+			for (int k = 0; k < j; k++)
+			{
+				value -= (*m)(i, k) * (*m)(j, k);
+			}
+			setMatxxElem(i, j, value / (*m)(j, j), m);
+		}
+	}
+	return 0;
+}
+
+// solve L*L^T*x = b in place, with L from choleskyDecomposition
+static void choleskySolve(const matxx &factor, vecx *x)
+{
+	const int n = factor.rows();
+	for (int i = 0; i < n; i++)
+	{
+		idScalar value = (*x)(i);
+		for (int k = 0; k < i; k++)
+		{
+			value -= factor(i, k) * (*x)(k);
+		}
+		(*x)(i) = value / factor(i, i);
+	}
+	for (int i = n - 1; i >= 0; i--)
+	{
+		idScalar value = (*x)(i);
+		for (int k = i + 1; k < n; k++)
+		{
+			value -= factor(k, i) * (*x)(k);
+		}
+		(*x)(i) = value / factor(i, i);
+	}
+}
+
+int MultiBodyTree::MultiBodyImpl::calculateForwardDynamics(const vecx &q, const vecx &u,
+														   const vecx &joint_forces,
+														   matxx *mass_matrix, vecx *dot_u)
+{
+	if (q.size() != m_num_dofs || u.size() != m_num_dofs || joint_forces.size() != m_num_dofs ||
+		dot_u->size() != m_num_dofs)
+	{
+		bt_id_error_message(
+			"wrong vector dimension. system has %d DOFs,\n"
+			"but dim(q)= %d, dim(u)= %d, dim(joint_forces)= %d, dim(dot_u)= %d\n",
+			m_num_dofs, static_cast<int>(q.size()), static_cast<int>(u.size()),
+			static_cast<int>(joint_forces.size()), static_cast<int>(dot_u->size()));
+		return -1;
+	}
+	// M(q)*dot_u + h(q,u) = joint_forces, with h = inverse dynamics for dot_u = 0
+	if (-1 == calculateMassMatrix(q, true, true, true, mass_matrix) ||
+		-1 == choleskyDecomposition(mass_matrix))
+	{
+		return -1;
+	}
+	vecx zero(m_num_dofs);
+	setZero(zero);
+	vecx bias_forces(m_num_dofs);
+	if (-1 == calculateInverseDynamics(q, u, zero, &bias_forces))
+	{
+		return -1;
+	}
+	for (int i = 0; i < m_num_dofs; i++)
+	{
+		(*dot_u)(i) = joint_forces(i) - bias_forces(i);
+	}
+	choleskySolve(*mass_matrix, dot_u);
+	return 0;
+}
+
+int MultiBodyTree::MultiBodyImpl::calculateForwardDynamics(const vecx &q, const vecx &u,
+														   const vecx &joint_forces, vecx *dot_u)
+{
+	matxx mass_matrix(m_num_dofs, m_num_dofs);
+	return calculateForwardDynamics(q, u, joint_forces, &mass_matrix, dot_u);
+}
+
+int MultiBodyTree::MultiBodyImpl::calculateForwardDynamicsDerivatives(
+	const vecx &q, const vecx &u, const vecx &joint_forces, vecx *dot_u, matxx *d_dot_u_d_q,
+	matxx *d_dot_u_d_u, matxx *d_dot_u_d_joint_forces)
+{
+	// Differentiating M(q)*dot_u + h(q,u) = joint_forces gives
+	// d(dot_u)/dq = -M^-1*d(tau)/dq, d(dot_u)/du = -M^-1*d(tau)/du and
+	// d(dot_u)/d(joint_forces) = M^-1, where tau(q,u,dot_u) are the inverse dynamics
+	// joint forces evaluated at the forward dynamics solution.
+	if (d_dot_u_d_joint_forces->rows() != m_num_dofs || d_dot_u_d_joint_forces->cols() != m_num_dofs)
+	{
+		bt_id_error_message("Dimension error. System has %d DOFs, but dim(d_dot_u_d_joint_forces)= %d x %d\n",
+							m_num_dofs, static_cast<int>(d_dot_u_d_joint_forces->rows()),
+							static_cast<int>(d_dot_u_d_joint_forces->cols()));
+		return -1;
+	}
+	matxx mass_matrix_factor(m_num_dofs, m_num_dofs);
+	if (-1 == calculateForwardDynamics(q, u, joint_forces, &mass_matrix_factor, dot_u) ||
+		-1 == calculateInverseDynamicsDerivatives(q, u, *dot_u, d_dot_u_d_q, d_dot_u_d_u))
+	{
+		return -1;
+	}
+	vecx column(m_num_dofs);
+	for (int j = 0; j < m_num_dofs; j++)
+	{
+		for (int i = 0; i < m_num_dofs; i++)
+		{
+			column(i) = -(*d_dot_u_d_q)(i, j);
+		}
+		choleskySolve(mass_matrix_factor, &column);
+		for (int i = 0; i < m_num_dofs; i++)
+		{
+			setMatxxElem(i, j, column(i), d_dot_u_d_q);
+		}
+
+		for (int i = 0; i < m_num_dofs; i++)
+		{
+			column(i) = -(*d_dot_u_d_u)(i, j);
+		}
+		choleskySolve(mass_matrix_factor, &column);
+		for (int i = 0; i < m_num_dofs; i++)
+		{
+			setMatxxElem(i, j, column(i), d_dot_u_d_u);
+		}
+
+		for (int i = 0; i < m_num_dofs; i++)
+		{
+			column(i) = i == j ? 1.0 : 0.0;
+		}
+		choleskySolve(mass_matrix_factor, &column);
+		for (int i = 0; i < m_num_dofs; i++)
+		{
+			setMatxxElem(i, j, column(i), d_dot_u_d_joint_forces);
+		}
+	}
+	return 0;
+}
+
 int MultiBodyTree::MultiBodyImpl::calculateKinematics(const vecx &q, const vecx &u, const vecx &dot_u,
 													  const KinUpdateType type)
 {
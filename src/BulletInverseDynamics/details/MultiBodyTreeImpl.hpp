@@ -6,6 +6,7 @@
 #define MULTI_BODY_REFERENCE_IMPL_HPP_
 
 #include "../IDConfig.hpp"
+#include "../IDMath.hpp"
 #include "../MultiBodyTree.hpp"
 
 namespace btInverseDynamics
@@ -126,6 +127,53 @@ struct RigidBody
 #endif
 };
 
+/// Directional derivatives of the state dependent RigidBody quantities, ie, their
+/// partial derivatives w.r.t. a single generalized position or velocity.
+/// These are propagated through the same recursions as the quantities themselves
+/// to calculate derivatives of the inverse dynamics.
+struct RigidBodyTangent
+{
+	ID_DECLARE_ALIGNED_ALLOCATOR();
+	/// true if the kinematics of this body depend on the current coordinate,
+	/// ie, if the body is in the subtree moved by it
+	bool m_kinematics_active;
+	/// true if the joint force and moment depend on the current coordinate
+	bool m_forces_active;
+	// relative kinematics, see RigidBody
+	mat33 m_body_T_parent;
+	vec3 m_parent_pos_parent_body;
+	vec3 m_body_ang_vel_rel;
+	vec3 m_parent_vel_rel;
+	vec3 m_body_ang_acc_rel;
+	vec3 m_parent_acc_rel;
+	// absolute kinematics, see RigidBody
+	vec3 m_body_vel;
+	vec3 m_body_acc;
+	vec3 m_body_ang_vel;
+	vec3 m_body_ang_acc;
+	// joint force and moment, see RigidBody
+	vec3 m_force_at_joint;
+	vec3 m_moment_at_joint;
+
+	RigidBodyTangent()
+		: m_kinematics_active(false),
+		  m_forces_active(false)
+	{
+		setZero(m_body_T_parent);
+		setZero(m_parent_pos_parent_body);
+		setZero(m_body_ang_vel_rel);
+		setZero(m_parent_vel_rel);
+		setZero(m_body_ang_acc_rel);
+		setZero(m_parent_acc_rel);
+		setZero(m_body_vel);
+		setZero(m_body_acc);
+		setZero(m_body_ang_vel);
+		setZero(m_body_ang_acc);
+		setZero(m_force_at_joint);
+		setZero(m_moment_at_joint);
+	}
+};
+
 /// The MBS implements a tree structured multibody system
 class MultiBodyTree::MultiBodyImpl
 {
@@ -153,6 +201,15 @@ public:
 	int calculateMassMatrix(const vecx& q, const bool update_kinematics,
 							const bool initialize_matrix, const bool set_lower_triangular_matrix,
 							matxx* mass_matrix);
+	/// \copydoc MultiBodyTree::calculateInverseDynamicsDerivatives
+	int calculateInverseDynamicsDerivatives(const vecx& q, const vecx& u, const vecx& dot_u,
+											matxx* d_joint_forces_d_q, matxx* d_joint_forces_d_u);
+	/// \copydoc MultiBodyTree::calculateForwardDynamics
+	int calculateForwardDynamics(const vecx& q, const vecx& u, const vecx& joint_forces, vecx* dot_u);
+	/// \copydoc MultiBodyTree::calculateForwardDynamicsDerivatives
+	int calculateForwardDynamicsDerivatives(const vecx& q, const vecx& u, const vecx& joint_forces,
+											vecx* dot_u, matxx* d_dot_u_d_q, matxx* d_dot_u_d_u,
+											matxx* d_dot_u_d_joint_forces);
 	/// calculate kinematics (vector quantities)
 	/// Depending on type, update positions only, positions & velocities, or positions, velocities
 	/// and accelerations.
@@ -251,6 +308,14 @@ private:
 	const char* jointTypeToString(const JointType& type) const;
 	// get number of degrees of freedom from joint type
 	int bodyNumDoFs(const JointType& type) const;
+	// propagate the partial derivatives w.r.t. q(dof) or u(dof) through kinematics and
+	// dynamics. Requires the state of a preceding calculateInverseDynamics call.
+	void calculateTangents(const int dof, const bool wrt_u, const vecx& q, const vecx& u,
+						   const vecx& dot_u);
+	// mass matrix and generalized accelerations for given joint forces.
+	// mass_matrix is replaced by its cholesky factor.
+	int calculateForwardDynamics(const vecx& q, const vecx& u, const vecx& joint_forces,
+								 matxx* mass_matrix, vecx* dot_u);
 	// number of bodies in the system
 	int m_num_bodies;
 	// number of degrees of freedom
@@ -276,6 +341,10 @@ private:
 	idArray<int>::type m_body_floating_list;
 	// Indices of spherical joints
 	idArray<int>::type m_body_spherical_list;
+	// m_dof_body_index[i] is the index of the body that q(i) belongs to
+	idArray<int>::type m_dof_body_index;
+	// scratch data for derivative calculations, one entry per body
+	idArray<RigidBodyTangent>::type m_tangent_list;
 	// a user-provided integer
 	idArray<int>::type m_user_int;
 	// a user-provided pointer
@@ -20,6 +20,89 @@ subject to the following restrictions:
 #include "btDefaultSoftBodySolver.h"
 #include "BulletCollision/CollisionShapes/btCapsuleShape.h"
 #include "BulletSoftBody/btSoftBody.h"
+#include "BulletDynamics/Featherstone/btMultiBodyLinkCollider.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+
+// runs the loop on the calling thread when there is no task scheduler to hand it to
+static void softBodySolverParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody &body)
+{
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		btParallelFor(iBegin, iEnd, grainSize, body);
+		return;
+	}
+#endif
+	body.forLoop(iBegin, iEnd);
+}
+
+// the contact buffer of the calling thread, there is only the one of the main thread without BT_THREADSAFE
+static int contactBufferIndex()
+{
+#if BT_THREADSAFE
+	return int(btGetCurrentThreadIndex());
+#else
+	return 0;
+#endif
+}
+
+// runs predictMotion or integrateMotion, both only touch the soft body itself
+struct btSoftBodyMotionLoop : public btIParallelForBody
+{
+	btSoftBody *const *m_bodies;
+	float m_timeStep;
+	bool m_integrate;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			if (m_integrate)
+				m_bodies[i]->integrateMotion();
+			else
+				m_bodies[i]->predictMotion(m_timeStep);
+		}
+	}
+};
+
+// solves groups of coupled soft bodies, each group serially and in order
+struct btSoftBodyGroupSolveLoop : public btIParallelForBody
+{
+	btSoftBody *const *m_bodies;
+	const int *m_groupOffsets;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int g = iBegin; g < iEnd; ++g)
+		{
+			for (int i = m_groupOffsets[g]; i < m_groupOffsets[g + 1]; ++i)
+			{
+				m_bodies[i]->solveConstraints();
+			}
+		}
+	}
+};
+
+static int findRoot(btAlignedObjectArray<int> &parent, int i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+static void unite(btAlignedObjectArray<int> &parent, int a, int b)
+{
+	a = findRoot(parent, a);
+	b = findRoot(parent, b);
+	if (a != b)
+	{
+		parent[btMax(a, b)] = btMin(a, b);
+	}
+}
 
 btDefaultSoftBodySolver::btDefaultSoftBodySolver()
 {
@@ -27,6 +110,11 @@ btDefaultSoftBodySolver::btDefaultSoftBodySolver()
 	// For now this is global for the cloths linked with this solver - we should probably make this body specific
 	// for performance in future once we understand more clearly when constants need to be updated
 	m_updateSolverConstants = true;
+	m_useMultithreading = false;
+	m_useLinkColoring = false;
+	m_useContactBuffers = false;
+	m_minLinkColorSize = 256;
+	m_contactBuffers.resize(BT_MAX_THREAD_COUNT);
 }
 
 btDefaultSoftBodySolver::~btDefaultSoftBodySolver()
@@ -43,8 +131,33 @@ void btDefaultSoftBodySolver::optimize(btAlignedObjectArray<btSoftBody *> &softB
 	m_softBodySet.copyFromArray(softBodies);
 }
 
+void btDefaultSoftBodySolver::gatherActiveBodies()
+{
+	m_activeBodies.resize(0);
+	for (int i = 0; i < m_softBodySet.size(); ++i)
+	{
+		if (m_softBodySet[i]->isActive())
+		{
+			m_activeBodies.push_back(m_softBodySet[i]);
+		}
+	}
+}
+
 void btDefaultSoftBodySolver::updateSoftBodies()
 {
+	if (m_useMultithreading)
+	{
+		gatherActiveBodies();
+		if (m_activeBodies.size() > 1)
+		{
+			btSoftBodyMotionLoop loop;
+			loop.m_bodies = &m_activeBodies[0];
+			loop.m_timeStep = 0;
+			loop.m_integrate = true;
+			softBodySolverParallelFor(0, m_activeBodies.size(), 1, loop);
+			return;
+		}
+	}
 	for (int i = 0; i < m_softBodySet.size(); i++)
 	{
 		btSoftBody *psb = (btSoftBody *)m_softBodySet[i];
@@ -60,8 +173,183 @@ bool btDefaultSoftBodySolver::checkInitialized()
 	return true;
 }
 
+void btDefaultSoftBodySolver::updateLinkColoring(btSoftBody *psb)
+{
+	if (m_useLinkColoring && psb->m_links.size() >= 2 * m_minLinkColorSize)
+	{
+		if (!psb->hasLinkColoring())
+		{
+			psb->colorLinks(m_minLinkColorSize);
+		}
+	}
+	else if (psb->m_linkColorOffsets.size())
+	{
+		psb->clearLinkColoring();
+	}
+}
+
+int btDefaultSoftBodySolver::findNodeOwner(const void *node) const
+{
+	const char *address = static_cast<const char *>(node);
+	int lo = 0;
+	int hi = m_nodeRanges.size();
+	while (lo < hi)
+	{
+		const int mid = (lo + hi) / 2;
+		if (m_nodeRanges[mid].m_begin <= address)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo > 0 && address < m_nodeRanges[lo - 1].m_end)
+	{
+		return m_nodeRanges[lo - 1].m_body;
+	}
+	return -1;
+}
+
+// Soft bodies exchange impulses with anchored dynamic bodies, with the rigid bodies and
+// multibodies they touch and with the faces of other soft bodies. Bodies connected that way
+// end up in the same group, m_groupBodies holds the active bodies grouped in their original order.
+void btDefaultSoftBodySolver::groupCoupledBodies()
+{
+	const int nb = m_softBodySet.size();
+	m_bodyParent.resize(nb);
+	m_nodeRanges.resize(0);
+	for (int i = 0; i < nb; ++i)
+	{
+		m_bodyParent[i] = i;
+		btSoftBody *psb = m_softBodySet[i];
+		if (psb->m_nodes.size())
+		{
+			NodeRange range;
+			range.m_begin = reinterpret_cast<const char *>(&psb->m_nodes[0]);
+			range.m_end = reinterpret_cast<const char *>(&psb->m_nodes[0] + psb->m_nodes.size());
+			range.m_body = i;
+			m_nodeRanges.push_back(range);
+		}
+	}
+	m_nodeRanges.quickSort(NodeRangeSortPredicate());
+
+	m_sharedObjectBody.clear();
+	for (int i = 0; i < nb; ++i)
+	{
+		btSoftBody *psb = m_softBodySet[i];
+		if (!psb->isActive())
+		{
+			continue;
+		}
+		for (int j = 0; j < psb->m_anchors.size(); ++j)
+		{
+			const btRigidBody *body = psb->m_anchors[j].m_body;
+			// static and kinematic bodies ignore the impulses
+			if (body->isStaticOrKinematicObject())
+				continue;
+			const int *owner = m_sharedObjectBody.find(btHashPtr(body));
+			if (owner)
+				unite(m_bodyParent, i, *owner);
+			else
+				m_sharedObjectBody.insert(btHashPtr(body), i);
+		}
+		for (int j = 0; j < psb->m_rcontacts.size(); ++j)
+		{
+			const btCollisionObject *colObj = psb->m_rcontacts[j].m_cti.m_colObj;
+			if (!colObj->hasContactResponse())
+				continue;
+			const void *shared = 0;
+			if (colObj->getInternalType() == btCollisionObject::CO_RIGID_BODY)
+			{
+				const btRigidBody *body = btRigidBody::upcast(colObj);
+				if (body && !body->isStaticOrKinematicObject())
+					shared = body;
+			}
+			else if (colObj->getInternalType() == btCollisionObject::CO_FEATHERSTONE_LINK)
+			{
+				const btMultiBodyLinkCollider *link = btMultiBodyLinkCollider::upcast(colObj);
+				// an impulse on any link changes the velocities of the whole multibody
+				if (link)
+					shared = link->m_multiBody;
+			}
+			if (!shared)
+				continue;
+			const int *owner = m_sharedObjectBody.find(btHashPtr(shared));
+			if (owner)
+				unite(m_bodyParent, i, *owner);
+			else
+				m_sharedObjectBody.insert(btHashPtr(shared), i);
+		}
+		for (int j = 0; j < psb->m_scontacts.size(); ++j)
+		{
+			const int owner = findNodeOwner(psb->m_scontacts[j].m_face->m_n[0]);
+			if (owner >= 0 && owner != i)
+				unite(m_bodyParent, i, owner);
+		}
+	}
+
+	// counting sort of the active bodies by group, keeping their order within a group
+	m_bodyGroup.resize(nb);
+	m_groupOffsets.resize(0);
+	for (int i = 0; i < nb; ++i)
+	{
+		m_bodyGroup[i] = -1;
+	}
+	for (int i = 0; i < nb; ++i)
+	{
+		if (!m_softBodySet[i]->isActive())
+			continue;
+		int &group = m_bodyGroup[findRoot(m_bodyParent, i)];
+		if (group < 0)
+		{
+			group = m_groupOffsets.size();
+			m_groupOffsets.push_back(0);
+		}
+		m_groupOffsets[group]++;
+	}
+	const int ng = m_groupOffsets.size();
+	int offset = 0;
+	for (int g = 0; g < ng; ++g)
+	{
+		const int count = m_groupOffsets[g];
+		m_groupOffsets[g] = offset;
+		offset += count;
+	}
+	m_groupOffsets.push_back(offset);
+	m_groupBodies.resize(offset);
+	for (int i = 0; i < nb; ++i)
+	{
+		if (!m_softBodySet[i]->isActive())
+			continue;
+		// m_groupOffsets[g] advances while filling and is restored below
+		const int g = m_bodyGroup[findRoot(m_bodyParent, i)];
+		m_groupBodies[m_groupOffsets[g]++] = m_softBodySet[i];
+	}
+	for (int g = ng; g > 0; --g)
+	{
+		m_groupOffsets[g] = m_groupOffsets[g - 1];
+	}
+	m_groupOffsets[0] = 0;
+}
+
 void btDefaultSoftBodySolver::solveConstraints(float solverdt)
 {
+	for (int i = 0; i < m_softBodySet.size(); ++i)
+	{
+		updateLinkColoring(m_softBodySet[i]);
+	}
+	if (m_useMultithreading && m_softBodySet.size() > 1)
+	{
+		BT_PROFILE("solveSoftBodyGroups");
+		groupCoupledBodies();
+		const int ng = m_groupOffsets.size() - 1;
+		if (ng > 1)
+		{
+			btSoftBodyGroupSolveLoop loop;
+			loop.m_bodies = &m_groupBodies[0];
+			loop.m_groupOffsets = &m_groupOffsets[0];
+			softBodySolverParallelFor(0, ng, 1, loop);
+			return;
+		}
+	}
 	// Solve constraints for non-solver softbodies
 	for (int i = 0; i < m_softBodySet.size(); ++i)
 	{
@@ -123,17 +411,50 @@ void btDefaultSoftBodySolver::copySoftBodyToVertexBuffer(const btSoftBody *const
 
 void btDefaultSoftBodySolver::processCollision(btSoftBody *softBody, btSoftBody *otherSoftBody)
 {
-	softBody->defaultCollisionHandler(otherSoftBody);
+	if (m_useContactBuffers)
+	{
+		softBody->defaultCollisionHandler(otherSoftBody, &m_contactBuffers[contactBufferIndex()]);
+	}
+	else
+	{
+		softBody->defaultCollisionHandler(otherSoftBody);
+	}
 }
 
 // For the default solver just leave the soft body to do its collision processing
 void btDefaultSoftBodySolver::processCollision(btSoftBody *softBody, const btCollisionObjectWrapper *collisionObjectWrap)
 {
-	softBody->defaultCollisionHandler(collisionObjectWrap);
+	if (m_useContactBuffers)
+	{
+		softBody->defaultCollisionHandler(collisionObjectWrap, &m_contactBuffers[contactBufferIndex()]);
+	}
+	else
+	{
+		softBody->defaultCollisionHandler(collisionObjectWrap);
+	}
 }  // btDefaultSoftBodySolver::processCollision
 
+void btDefaultSoftBodySolver::finishCollisions()
+{
+	// also merge what was buffered before the contact buffers were switched off
+	btSoftBody::mergeContactBuffers(&m_contactBuffers[0], m_contactBuffers.size());
+}
+
 void btDefaultSoftBodySolver::predictMotion(float timeStep)
 {
+	if (m_useMultithreading)
+	{
+		gatherActiveBodies();
+		if (m_activeBodies.size() > 1)
+		{
+			btSoftBodyMotionLoop loop;
+			loop.m_bodies = &m_activeBodies[0];
+			loop.m_timeStep = timeStep;
+			loop.m_integrate = false;
+			softBodySolverParallelFor(0, m_activeBodies.size(), 1, loop);
+			return;
+		}
+	}
 	for (int i = 0; i < m_softBodySet.size(); ++i)
 	{
 		btSoftBody *psb = m_softBodySet[i];
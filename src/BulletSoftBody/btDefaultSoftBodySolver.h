@@ -18,6 +18,8 @@ subject to the following restrictions:
 
 #include "BulletSoftBody/btSoftBodySolvers.h"
 #include "btSoftBodySolverVertexBuffer.h"
+#include "BulletSoftBody/btSoftBody.h"
+#include "LinearMath/btHashMap.h"
 struct btCollisionObjectWrapper;
 
 class btDefaultSoftBodySolver : public btSoftBodySolver
@@ -28,6 +30,43 @@ protected:
 
 	btAlignedObjectArray<btSoftBody *> m_softBodySet;
 
+	bool m_useMultithreading;
+	bool m_useLinkColoring;
+	bool m_useContactBuffers;
+	int m_minLinkColorSize;
+
+	/** Address range of the node array of one soft body, to find the owner of a node */
+	struct NodeRange
+	{
+		const char *m_begin;
+		const char *m_end;
+		int m_body;
+	};
+	struct NodeRangeSortPredicate
+	{
+		bool operator()(const NodeRange &a, const NodeRange &b) const
+		{
+			return a.m_begin < b.m_begin;
+		}
+	};
+
+	/** Scratch for grouping the soft bodies that have to be solved by the same thread */
+	btAlignedObjectArray<btSoftBody *> m_activeBodies;
+	btAlignedObjectArray<btSoftBody *> m_groupBodies;
+	btAlignedObjectArray<int> m_groupOffsets;
+	btAlignedObjectArray<int> m_bodyParent;
+	btAlignedObjectArray<int> m_bodyGroup;
+	btAlignedObjectArray<NodeRange> m_nodeRanges;
+	btHashMap<btHashPtr, int> m_sharedObjectBody;
+
+	/** One contact buffer per thread, used by processCollision when contact buffers are enabled */
+	btAlignedObjectArray<btSoftBody::ContactBuffer> m_contactBuffers;
+
+	void gatherActiveBodies();
+	void updateLinkColoring(btSoftBody *psb);
+	int findNodeOwner(const void *node) const;
+	void groupCoupledBodies();
+
 public:
 	btDefaultSoftBodySolver();
 
@@ -55,6 +94,51 @@ public:
 	virtual void processCollision(btSoftBody *, const btCollisionObjectWrapper *);
 
 	virtual void processCollision(btSoftBody *, btSoftBody *);
+
+	virtual void finishCollisions();
+
+	///When enabled, predictMotion, solveConstraints and updateSoftBodies distribute the soft bodies over threads with btParallelFor.
+	///Soft bodies that share an anchored or touched dynamic body, a multibody or a soft contact are solved by the same thread,
+	///in their original order, so the result is the same as the serial solver.
+	void setUseMultithreading(bool useMultithreading)
+	{
+		m_useMultithreading = useMultithreading;
+	}
+	bool getUseMultithreading() const
+	{
+		return m_useMultithreading;
+	}
+	///When enabled, processCollision collects the contacts in per-thread buffers, so btCollisionDispatcherMt can process
+	///the soft body pairs in parallel, and finishCollisions merges them sorted by object, node and face.
+	///The merged order differs from the order of a serial dispatch, but not between runs or thread counts.
+	void setUseContactBuffers(bool useContactBuffers)
+	{
+		m_useContactBuffers = useContactBuffers;
+	}
+	bool getUseContactBuffers() const
+	{
+		return m_useContactBuffers;
+	}
+	///When enabled, the links of each soft body are colored so that links of the same color share no node,
+	///and each color is solved in parallel. This changes the order of the link updates compared to the serial solver,
+	///but not between runs or thread counts.
+	void setUseLinkColoring(bool useLinkColoring)
+	{
+		m_useLinkColoring = useLinkColoring;
+	}
+	bool getUseLinkColoring() const
+	{
+		return m_useLinkColoring;
+	}
+	///Colors with fewer links than this are not worth dispatching, their links are solved serially instead
+	void setMinLinkColorSize(int minLinkColorSize)
+	{
+		m_minLinkColorSize = btMax(1, minLinkColorSize);
+	}
+	int getMinLinkColorSize() const
+	{
+		return m_minLinkColorSize;
+	}
 };
 
 #endif  // #ifndef BT_ACCELERATED_SOFT_BODY_CPU_SOLVER_H
@@ -20,6 +20,25 @@ subject to the following restrictions:
 #include "LinearMath/btSerializer.h"
 #include "BulletDynamics/Featherstone/btMultiBodyLinkCollider.h"
 #include "BulletDynamics/Featherstone/btMultiBodyConstraint.h"
+#include "LinearMath/btThreads.h"
+
+/// links per task when the links of one color are solved in parallel, a link is only a few flops
+#define BT_SOFTBODY_LINK_GRAIN_SIZE 128
+/// leaves or internal nodes per task when the trees are refit
+#define BT_SOFTBODY_REFIT_GRAIN_SIZE 256
+
+// runs the loop on the calling thread when there is no task scheduler to hand it to
+static void softBodyParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		btParallelFor(iBegin, iEnd, grainSize, body);
+		return;
+	}
+#endif
+	body.forLoop(iBegin, iEnd);
+}
 
 //
 btSoftBody::btSoftBody(btSoftBodyWorldInfo* worldInfo, int node_count, const btVector3* x, const btScalar* m)
@@ -110,6 +129,9 @@ void btSoftBody::initDefaults()
 
 	m_windVelocity = btVector3(0, 0, 0);
 	m_restLengthScale = btScalar(1.0);
+	m_usePackedSolverData = false;
+	m_useTreeRefit = false;
+	m_treeRebuildRatio = 4;
 }
 
 //
@@ -260,6 +282,7 @@ void btSoftBody::appendNode(const btVector3& x, btScalar m)
 	n.m_im = m > 0 ? 1 / m : 0;
 	n.m_material = m_materials[0];
 	n.m_leaf = m_ndbvt.insert(btDbvtVolume::FromCR(n.m_x, margin), &n);
+	clearTreeRefit();
 }
 
 //
@@ -811,6 +834,7 @@ void btSoftBody::transform(const btTransform& trs)
 
 		m_ndbvt.update(n.m_leaf, vol);
 	}
+	clearTreeRefit();
 	updateNormals();
 	updateBounds();
 	updateConstants();
@@ -850,6 +874,7 @@ void btSoftBody::scale(const btVector3& scl)
 		vol = btDbvtVolume::FromCR(n.m_x, margin);
 		m_ndbvt.update(n.m_leaf, vol);
 	}
+	clearTreeRefit();
 	updateNormals();
 	updateBounds();
 	updateConstants();
@@ -1179,6 +1204,7 @@ void btSoftBody::randomizeConstraints()
 		btSwap(m_faces[i], m_faces[NEXTRAND % ni]);
 	}
 #undef NEXTRAND
+	clearLinkColoring();
 }
 
 //
@@ -1399,6 +1425,9 @@ void btSoftBody::refine(ImplicitFn* ifn, btScalar accurary, bool cut)
 	int newnodes = 0;
 	int i, j, k, ni;
 
+	clearLinkColoring();
+	clearTreeRefit();
+
 	/* Filter out		*/
 	for (i = 0; i < m_links.size(); ++i)
 	{
@@ -1665,6 +1694,8 @@ bool btSoftBody::cutLink(int node0, int node1, btScalar position)
 {
 	bool done = false;
 	int i, ni;
+	clearLinkColoring();
+	clearTreeRefit();
 	//	const btVector3	d=m_nodes[node0].m_x-m_nodes[node1].m_x;
 	const btVector3 x = Lerp(m_nodes[node0].m_x, m_nodes[node1].m_x, position);
 	const btVector3 v = Lerp(m_nodes[node0].m_v, m_nodes[node1].m_v, position);
@@ -1715,6 +1746,264 @@ bool btSoftBody::cutLink(int node0, int node1, btScalar position)
 	return (done);
 }
 
+//
+void btSoftBody::colorLinks(int minColorSize)
+{
+	clearLinkColoring();
+	const int nlinks = m_links.size();
+	if (nlinks == 0)
+	{
+		return;
+	}
+	minColorSize = btMax(1, minColorSize);
+	m_linkColorOffsets.push_back(0);
+
+	btAlignedObjectArray<int> nodeColor;
+	nodeColor.resize(m_nodes.size(), -1);
+	btAlignedObjectArray<int> pending;
+	btAlignedObjectArray<int> remaining;
+	pending.resize(nlinks);
+	for (int i = 0; i < nlinks; ++i)
+	{
+		pending[i] = i;
+	}
+
+	/* Greedy, one color per pass over the remaining links, in link order	*/
+	const Node* nbase = &m_nodes[0];
+	int color = 0;
+	while (pending.size() >= minColorSize)
+	{
+		const int colorBegin = m_linkColorItems.size();
+		remaining.resize(0);
+		for (int i = 0; i < pending.size(); ++i)
+		{
+			const Link& l = m_links[pending[i]];
+			const int n0 = int(l.m_n[0] - nbase);
+			const int n1 = int(l.m_n[1] - nbase);
+			if (nodeColor[n0] == color || nodeColor[n1] == color)
+			{
+				remaining.push_back(pending[i]);
+				continue;
+			}
+			nodeColor[n0] = color;
+			nodeColor[n1] = color;
+			m_linkColorItems.push_back(pending[i]);
+		}
+		if (m_linkColorItems.size() - colorBegin < minColorSize)
+		{
+			/* Not worth dispatching, leave these to the serial tail	*/
+			m_linkColorItems.resize(colorBegin);
+			break;
+		}
+		m_linkColorOffsets.push_back(m_linkColorItems.size());
+		pending.copyFromArray(remaining);
+		++color;
+	}
+	for (int i = 0; i < pending.size(); ++i)
+	{
+		m_linkColorItems.push_back(pending[i]);
+	}
+}
+
+//
+void btSoftBody::clearLinkColoring()
+{
+	m_linkColorItems.resize(0);
+	m_linkColorOffsets.resize(0);
+}
+
+//
+bool btSoftBody::hasLinkColoring() const
+{
+	/* Links appended since the coloring was built invalidate it			*/
+	return (m_linkColorOffsets.size() > 0 && m_linkColorItems.size() == m_links.size());
+}
+
+//
+void btSoftBody::clearTreeRefit()
+{
+	m_ndbvtRefit.m_root = 0;
+	m_fdbvtRefit.m_root = 0;
+}
+
+// fattened leaf volumes, as btDbvt::update(leaf,volume,velocity,margin) makes them
+struct btSoftBodyLeafVolumeLoop : public btIParallelForBody
+{
+	btSoftBody* m_psb;
+	bool m_faces;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		const btSoftBody::SolverState& sst = m_psb->m_sst;
+		const btVector3 margin(sst.updmrg, sst.updmrg, sst.updmrg);
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			ATTRIBUTE_ALIGNED16(btDbvtVolume)
+			vol;
+			if (m_faces)
+			{
+				btSoftBody::Face& f = m_psb->m_faces[i];
+				const btVector3 v = (f.m_n[0]->m_v +
+									 f.m_n[1]->m_v +
+									 f.m_n[2]->m_v) /
+									3;
+				vol = VolumeOf(f, sst.radmrg);
+				vol.Expand(margin);
+				vol.SignedExpand(v * sst.velmrg);
+				f.m_leaf->volume = vol;
+			}
+			else
+			{
+				btSoftBody::Node& n = m_psb->m_nodes[i];
+				vol = btDbvtVolume::FromCR(n.m_x, sst.radmrg);
+				vol.Expand(margin);
+				vol.SignedExpand(n.m_v * sst.velmrg);
+				n.m_leaf->volume = vol;
+			}
+		}
+	}
+};
+
+// merges the children of the internal nodes of one level, one chunk of nodes per index
+struct btSoftBodyTreeRefitLoop : public btIParallelForBody
+{
+	btDbvtNode* const* m_nodes;
+	btScalar* m_costs;
+	int m_count;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int c = iBegin; c < iEnd; ++c)
+		{
+			const int end = btMin(m_count, (c + 1) * BT_SOFTBODY_REFIT_GRAIN_SIZE);
+			btScalar cost = 0;
+			for (int i = c * BT_SOFTBODY_REFIT_GRAIN_SIZE; i < end; ++i)
+			{
+				btDbvtNode* node = m_nodes[i];
+				Merge(node->childs[0]->volume, node->childs[1]->volume, node->volume);
+				const btVector3 e = node->volume.Lengths();
+				cost += e.x() * e.y() + e.y() * e.z() + e.z() * e.x();
+			}
+			m_costs[c] = cost;
+		}
+	}
+};
+
+//
+static int gatherTreeLevels(btDbvtNode* node, btAlignedObjectArray<btDbvtNode*>& nodes, btAlignedObjectArray<int>& heights)
+{
+	if (node->isleaf())
+	{
+		return (0);
+	}
+	const int height = 1 + btMax(gatherTreeLevels(node->childs[0], nodes, heights),
+								 gatherTreeLevels(node->childs[1], nodes, heights));
+	nodes.push_back(node);
+	heights.push_back(height);
+	return (height);
+}
+
+// sorts the internal nodes by height, children come before their parent
+static void buildTreeRefit(btDbvt& tree, btSoftBody::TreeRefit& refit)
+{
+	btAlignedObjectArray<btDbvtNode*> nodes;
+	btAlignedObjectArray<int> heights;
+	nodes.reserve(tree.m_leaves);
+	heights.reserve(tree.m_leaves);
+	const int nlevels = gatherTreeLevels(tree.m_root, nodes, heights);
+	refit.m_levels.resize(0);
+	refit.m_levels.resize(nlevels + 1, 0);
+	for (int i = 0; i < heights.size(); ++i)
+	{
+		++refit.m_levels[heights[i] - 1];
+	}
+	for (int l = 0, offset = 0; l <= nlevels; ++l)
+	{
+		const int count = refit.m_levels[l];
+		refit.m_levels[l] = offset;
+		offset += count;
+	}
+	btAlignedObjectArray<int> next;
+	next.copyFromArray(refit.m_levels);
+	refit.m_nodes.resize(nodes.size());
+	refit.m_cost = 0;
+	for (int i = 0; i < nodes.size(); ++i)
+	{
+		refit.m_nodes[next[heights[i] - 1]++] = nodes[i];
+		const btVector3 e = nodes[i]->volume.Lengths();
+		refit.m_cost += e.x() * e.y() + e.y() * e.z() + e.z() * e.x();
+	}
+	refit.m_root = tree.m_root;
+	refit.m_leaves = tree.m_leaves;
+}
+
+// refits the internal volumes to the leaves, rebuilds the tree when the refit order is stale or the cost grew too much
+static void refitTree(btDbvt& tree, btSoftBody::TreeRefit& refit, btScalar rebuildRatio)
+{
+	if (!tree.m_root)
+	{
+		return;
+	}
+	bool rebuild = (refit.m_root != tree.m_root) || (refit.m_leaves != tree.m_leaves);
+	if (!rebuild)
+	{
+		btSoftBodyTreeRefitLoop loop;
+		btScalar cost = 0;
+		for (int l = 0; l + 1 < refit.m_levels.size(); ++l)
+		{
+			const int begin = refit.m_levels[l];
+			const int count = refit.m_levels[l + 1] - begin;
+			const int nchunks = (count + BT_SOFTBODY_REFIT_GRAIN_SIZE - 1) / BT_SOFTBODY_REFIT_GRAIN_SIZE;
+			refit.m_costs.resize(nchunks);
+			loop.m_nodes = &refit.m_nodes[begin];
+			loop.m_costs = &refit.m_costs[0];
+			loop.m_count = count;
+			if (nchunks > 1)
+			{
+				softBodyParallelFor(0, nchunks, 1, loop);
+			}
+			else
+			{
+				loop.forLoop(0, nchunks);
+			}
+			/* Chunk costs are summed in order, so the rebuilds do not depend on threads	*/
+			for (int c = 0; c < nchunks; ++c)
+			{
+				cost += refit.m_costs[c];
+			}
+		}
+		rebuild = cost > refit.m_cost * rebuildRatio;
+	}
+	if (rebuild)
+	{
+		tree.optimizeTopDown();
+		buildTreeRefit(tree, refit);
+	}
+}
+
+//
+void btSoftBody::refitTrees()
+{
+	BT_PROFILE("refitTrees");
+	btSoftBodyLeafVolumeLoop loop;
+	loop.m_psb = this;
+	loop.m_faces = false;
+	if (m_nodes.size() > BT_SOFTBODY_REFIT_GRAIN_SIZE)
+		softBodyParallelFor(0, m_nodes.size(), BT_SOFTBODY_REFIT_GRAIN_SIZE, loop);
+	else
+		loop.forLoop(0, m_nodes.size());
+	refitTree(m_ndbvt, m_ndbvtRefit, m_treeRebuildRatio);
+	if (!m_fdbvt.empty())
+	{
+		loop.m_faces = true;
+		if (m_faces.size() > BT_SOFTBODY_REFIT_GRAIN_SIZE)
+			softBodyParallelFor(0, m_faces.size(), BT_SOFTBODY_REFIT_GRAIN_SIZE, loop);
+		else
+			loop.forLoop(0, m_faces.size());
+		refitTree(m_fdbvt, m_fdbvtRefit, m_treeRebuildRatio);
+	}
+}
+
 //
 bool btSoftBody::rayTest(const btVector3& rayFrom,
 						 const btVector3& rayTo,
@@ -1812,34 +2101,42 @@ void btSoftBody::predictMotion(btScalar dt)
 	updateClusters();
 	/* Bounds				*/
 	updateBounds();
-	/* Nodes				*/
-	ATTRIBUTE_ALIGNED16(btDbvtVolume)
-	vol;
-	for (i = 0, ni = m_nodes.size(); i < ni; ++i)
+	if (m_useTreeRefit)
 	{
-		Node& n = m_nodes[i];
-		vol = btDbvtVolume::FromCR(n.m_x, m_sst.radmrg);
-		m_ndbvt.update(n.m_leaf,
-					   vol,
-					   n.m_v * m_sst.velmrg,
-					   m_sst.updmrg);
+		/* Nodes and faces		*/
+		refitTrees();
 	}
-	/* Faces				*/
-	if (!m_fdbvt.empty())
+	else
 	{
-		for (int i = 0; i < m_faces.size(); ++i)
+		/* Nodes				*/
+		ATTRIBUTE_ALIGNED16(btDbvtVolume)
+		vol;
+		for (i = 0, ni = m_nodes.size(); i < ni; ++i)
 		{
-			Face& f = m_faces[i];
-			const btVector3 v = (f.m_n[0]->m_v +
-								 f.m_n[1]->m_v +
-								 f.m_n[2]->m_v) /
-								3;
-			vol = VolumeOf(f, m_sst.radmrg);
-			m_fdbvt.update(f.m_leaf,
+			Node& n = m_nodes[i];
+			vol = btDbvtVolume::FromCR(n.m_x, m_sst.radmrg);
+			m_ndbvt.update(n.m_leaf,
 						   vol,
-						   v * m_sst.velmrg,
+						   n.m_v * m_sst.velmrg,
 						   m_sst.updmrg);
 		}
+		/* Faces				*/
+		if (!m_fdbvt.empty())
+		{
+			for (int i = 0; i < m_faces.size(); ++i)
+			{
+				Face& f = m_faces[i];
+				const btVector3 v = (f.m_n[0]->m_v +
+									 f.m_n[1]->m_v +
+									 f.m_n[2]->m_v) /
+									3;
+				vol = VolumeOf(f, m_sst.radmrg);
+				m_fdbvt.update(f.m_leaf,
+							   vol,
+							   v * m_sst.velmrg,
+							   m_sst.updmrg);
+			}
+		}
 	}
 	/* Pose					*/
 	updatePose();
@@ -1861,8 +2158,11 @@ void btSoftBody::predictMotion(btScalar dt)
 	m_rcontacts.resize(0);
 	m_scontacts.resize(0);
 	/* Optimize dbvt's		*/
-	m_ndbvt.optimizeIncremental(1);
-	m_fdbvt.optimizeIncremental(1);
+	if (!m_useTreeRefit)
+	{
+		m_ndbvt.optimizeIncremental(1);
+		m_fdbvt.optimizeIncremental(1);
+	}
 	m_cdbvt.optimizeIncremental(1);
 }
 
@@ -1881,6 +2181,10 @@ void btSoftBody::solveConstraints()
 		l.m_c3 = l.m_n[1]->m_q - l.m_n[0]->m_q;
 		l.m_c2 = 1 / (l.m_c3.length2() * l.m_c0);
 	}
+	if (m_usePackedSolverData)
+	{
+		packSolverData();
+	}
 	/* Prepare anchors		*/
 	for (i = 0, ni = m_anchors.size(); i < ni; ++i)
 	{
@@ -1957,6 +2261,8 @@ void btSoftBody::solveConstraints()
 	/* Apply clusters		*/
 	dampClusters();
 	applyClusters(true);
+	/* Packed links are only refreshed here, keep staticSolve on m_links	*/
+	m_packedLinks.resize(0);
 }
 
 //
@@ -2240,6 +2546,7 @@ int btSoftBody::rayTest(const btVector3& rayFrom, const btVector3& rayTo,
 void btSoftBody::initializeFaceTree()
 {
 	m_fdbvt.clear();
+	clearTreeRefit();
 	for (int i = 0; i < m_faces.size(); ++i)
 	{
 		Face& f = m_faces[i];
@@ -2475,6 +2782,33 @@ void btSoftBody::updateLinkConstants()
 	}
 }
 
+//
+void btSoftBody::packSolverData()
+{
+	BT_PROFILE("packSolverData");
+	const int nn = m_nodes.size();
+	m_packedNodes.resize(nn);
+	for (int i = 0; i < nn; ++i)
+	{
+		m_packedNodes[i].m_im = m_nodes[i].m_im;
+	}
+
+	/* Colored links are packed color by color, so a color is a contiguous range	*/
+	const int nl = m_links.size();
+	const bool colored = hasLinkColoring();
+	const Node* nbase = nn ? &m_nodes[0] : 0;
+	m_packedLinks.resize(nl);
+	for (int i = 0; i < nl; ++i)
+	{
+		const Link& l = m_links[colored ? m_linkColorItems[i] : i];
+		PackedLink& pl = m_packedLinks[i];
+		pl.m_n[0] = int(l.m_n[0] - nbase);
+		pl.m_n[1] = int(l.m_n[1] - nbase);
+		pl.m_c0 = l.m_c0;
+		pl.m_c1 = l.m_c1;
+	}
+}
+
 void btSoftBody::updateConstants()
 {
 	resetLinkRestLengths();
@@ -3144,39 +3478,268 @@ void btSoftBody::PSolve_SContacts(btSoftBody* psb, btScalar, btScalar ti)
 }
 
 //
-void btSoftBody::PSolve_Links(btSoftBody* psb, btScalar kst, btScalar ti)
+static inline void PSolve_Link(btSoftBody::Link& l, btScalar kst)
 {
-	BT_PROFILE("PSolve_Links");
-	for (int i = 0, ni = psb->m_links.size(); i < ni; ++i)
+	if (l.m_c0 > 0)
 	{
-		Link& l = psb->m_links[i];
+		btSoftBody::Node& a = *l.m_n[0];
+		btSoftBody::Node& b = *l.m_n[1];
+		const btVector3 del = b.m_x - a.m_x;
+		const btScalar len = del.length2();
+		if (l.m_c1 + len > SIMD_EPSILON)
+		{
+			const btScalar k = ((l.m_c1 - len) / (l.m_c0 * (l.m_c1 + len))) * kst;
+			a.m_x -= del * (k * a.m_im);
+			b.m_x += del * (k * b.m_im);
+		}
+	}
+}
+
+//
+static inline void VSolve_Link(btSoftBody::Link& l, btScalar kst)
+{
+	btSoftBody::Node** n = l.m_n;
+	const btScalar j = -btDot(l.m_c3, n[0]->m_v - n[1]->m_v) * l.m_c2 * kst;
+	n[0]->m_v += l.m_c3 * (j * n[0]->m_im);
+	n[1]->m_v -= l.m_c3 * (j * n[1]->m_im);
+}
+
+// solves the links of one color, they share no node
+struct btSoftBodyLinkColorLoop : public btIParallelForBody
+{
+	btSoftBody* m_psb;
+	btScalar m_kst;
+	bool m_velocities;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		const int* items = &m_psb->m_linkColorItems[0];
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			btSoftBody::Link& l = m_psb->m_links[items[i]];
+			if (m_velocities)
+				VSolve_Link(l, m_kst);
+			else
+				PSolve_Link(l, m_kst);
+		}
+	}
+};
+
+//
+static void solveColoredLinks(btSoftBody* psb, btScalar kst, bool velocities)
+{
+	btSoftBodyLinkColorLoop loop;
+	loop.m_psb = psb;
+	loop.m_kst = kst;
+	loop.m_velocities = velocities;
+	const int ncolors = psb->m_linkColorOffsets.size() - 1;
+	for (int c = 0; c < ncolors; ++c)
+	{
+		softBodyParallelFor(psb->m_linkColorOffsets[c], psb->m_linkColorOffsets[c + 1], BT_SOFTBODY_LINK_GRAIN_SIZE, loop);
+	}
+	/* Serial tail				*/
+	loop.forLoop(psb->m_linkColorOffsets[ncolors], psb->m_linkColorItems.size());
+}
+
+// Gauss-Seidel over packed links, same arithmetic and order as PSolve_Link
+static void PSolve_PackedLinks(btSoftBody::PackedNode* nodes, const btSoftBody::PackedLink* links, int begin, int end, btScalar kst)
+{
+	for (int i = begin; i < end; ++i)
+	{
+		const btSoftBody::PackedLink& l = links[i];
 		if (l.m_c0 > 0)
 		{
-			Node& a = *l.m_n[0];
-			Node& b = *l.m_n[1];
-			const btVector3 del = b.m_x - a.m_x;
-			const btScalar len = del.length2();
+			btSoftBody::PackedNode& a = nodes[l.m_n[0]];
+			btSoftBody::PackedNode& b = nodes[l.m_n[1]];
+			const btScalar dx = b.m_x[0] - a.m_x[0];
+			const btScalar dy = b.m_x[1] - a.m_x[1];
+			const btScalar dz = b.m_x[2] - a.m_x[2];
+			const btScalar len = dx * dx + dy * dy + dz * dz;
 			if (l.m_c1 + len > SIMD_EPSILON)
 			{
 				const btScalar k = ((l.m_c1 - len) / (l.m_c0 * (l.m_c1 + len))) * kst;
-				a.m_x -= del * (k * a.m_im);
-				b.m_x += del * (k * b.m_im);
+				const btScalar ka = k * a.m_im;
+				const btScalar kb = k * b.m_im;
+				a.m_x[0] -= dx * ka;
+				a.m_x[1] -= dy * ka;
+				a.m_x[2] -= dz * ka;
+				b.m_x[0] += dx * kb;
+				b.m_x[1] += dy * kb;
+				b.m_x[2] += dz * kb;
 			}
 		}
 	}
 }
 
+// links that share no node (one color), four at a time
+static void PSolve_PackedLinksIndependent(btSoftBody::PackedNode* nodes, const btSoftBody::PackedLink* links, int begin, int end, btScalar kst)
+{
+	int i = begin;
+#if defined(BT_USE_SSE)
+	const __m128 vkst = _mm_set1_ps(kst);
+	const __m128 veps = _mm_set1_ps(SIMD_EPSILON);
+	const __m128 vzero = _mm_setzero_ps();
+	for (; i + 4 <= end; i += 4)
+	{
+		const btSoftBody::PackedLink* l = &links[i];
+		btScalar* a[4] = {nodes[l[0].m_n[0]].m_x, nodes[l[1].m_n[0]].m_x, nodes[l[2].m_n[0]].m_x, nodes[l[3].m_n[0]].m_x};
+		btScalar* b[4] = {nodes[l[0].m_n[1]].m_x, nodes[l[1].m_n[1]].m_x, nodes[l[2].m_n[1]].m_x, nodes[l[3].m_n[1]].m_x};
+		// a packed node is x, y, z, 1/mass, so a transpose gives one component per register
+		__m128 ax = _mm_load_ps(a[0]), ay = _mm_load_ps(a[1]), az = _mm_load_ps(a[2]), ima = _mm_load_ps(a[3]);
+		__m128 bx = _mm_load_ps(b[0]), by = _mm_load_ps(b[1]), bz = _mm_load_ps(b[2]), imb = _mm_load_ps(b[3]);
+		_MM_TRANSPOSE4_PS(ax, ay, az, ima);
+		_MM_TRANSPOSE4_PS(bx, by, bz, imb);
+		// the same for the links, the node index rows are not used
+		__m128 n0 = _mm_load_ps(reinterpret_cast<const float*>(&l[0]));
+		__m128 n1 = _mm_load_ps(reinterpret_cast<const float*>(&l[1]));
+		__m128 c0 = _mm_load_ps(reinterpret_cast<const float*>(&l[2]));
+		__m128 c1 = _mm_load_ps(reinterpret_cast<const float*>(&l[3]));
+		_MM_TRANSPOSE4_PS(n0, n1, c0, c1);
+		const __m128 dx = _mm_sub_ps(bx, ax);
+		const __m128 dy = _mm_sub_ps(by, ay);
+		const __m128 dz = _mm_sub_ps(bz, az);
+		const __m128 len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		const __m128 sum = _mm_add_ps(c1, len);
+		// lanes that the scalar loop skips get k = 0, which leaves their nodes unchanged
+		const __m128 mask = _mm_and_ps(_mm_cmpgt_ps(c0, vzero), _mm_cmpgt_ps(sum, veps));
+		const __m128 k = _mm_and_ps(_mm_mul_ps(_mm_div_ps(_mm_sub_ps(c1, len), _mm_mul_ps(c0, sum)), vkst), mask);
+		const __m128 ka = _mm_mul_ps(k, ima);
+		const __m128 kb = _mm_mul_ps(k, imb);
+		ax = _mm_sub_ps(ax, _mm_mul_ps(dx, ka));
+		ay = _mm_sub_ps(ay, _mm_mul_ps(dy, ka));
+		az = _mm_sub_ps(az, _mm_mul_ps(dz, ka));
+		bx = _mm_add_ps(bx, _mm_mul_ps(dx, kb));
+		by = _mm_add_ps(by, _mm_mul_ps(dy, kb));
+		bz = _mm_add_ps(bz, _mm_mul_ps(dz, kb));
+		_MM_TRANSPOSE4_PS(ax, ay, az, ima);
+		_MM_TRANSPOSE4_PS(bx, by, bz, imb);
+		_mm_store_ps(a[0], ax);
+		_mm_store_ps(a[1], ay);
+		_mm_store_ps(a[2], az);
+		_mm_store_ps(a[3], ima);
+		_mm_store_ps(b[0], bx);
+		_mm_store_ps(b[1], by);
+		_mm_store_ps(b[2], bz);
+		_mm_store_ps(b[3], imb);
+	}
+#else
+	// fixed-width lanes without dependencies between them, for the auto-vectorizer
+	for (; i + 4 <= end; i += 4)
+	{
+		const btSoftBody::PackedLink* l = &links[i];
+		btSoftBody::PackedNode* a[4] = {&nodes[l[0].m_n[0]], &nodes[l[1].m_n[0]], &nodes[l[2].m_n[0]], &nodes[l[3].m_n[0]]};
+		btSoftBody::PackedNode* b[4] = {&nodes[l[0].m_n[1]], &nodes[l[1].m_n[1]], &nodes[l[2].m_n[1]], &nodes[l[3].m_n[1]]};
+		btScalar dx[4], dy[4], dz[4], ka[4], kb[4];
+		for (int j = 0; j < 4; ++j)
+		{
+			dx[j] = b[j]->m_x[0] - a[j]->m_x[0];
+			dy[j] = b[j]->m_x[1] - a[j]->m_x[1];
+			dz[j] = b[j]->m_x[2] - a[j]->m_x[2];
+		}
+		for (int j = 0; j < 4; ++j)
+		{
+			const btScalar c0 = l[j].m_c0;
+			const btScalar c1 = l[j].m_c1;
+			const btScalar len = dx[j] * dx[j] + dy[j] * dy[j] + dz[j] * dz[j];
+			const btScalar k = (c0 > 0 && c1 + len > SIMD_EPSILON) ? ((c1 - len) / (c0 * (c1 + len))) * kst : btScalar(0);
+			ka[j] = k * a[j]->m_im;
+			kb[j] = k * b[j]->m_im;
+		}
+		for (int j = 0; j < 4; ++j)
+		{
+			a[j]->m_x[0] -= dx[j] * ka[j];
+			a[j]->m_x[1] -= dy[j] * ka[j];
+			a[j]->m_x[2] -= dz[j] * ka[j];
+			b[j]->m_x[0] += dx[j] * kb[j];
+			b[j]->m_x[1] += dy[j] * kb[j];
+			b[j]->m_x[2] += dz[j] * kb[j];
+		}
+	}
+#endif
+	PSolve_PackedLinks(nodes, links, i, end, kst);
+}
+
+// solves the packed links of one color
+struct btSoftBodyPackedLinkColorLoop : public btIParallelForBody
+{
+	btSoftBody::PackedNode* m_nodes;
+	const btSoftBody::PackedLink* m_links;
+	btScalar m_kst;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		PSolve_PackedLinksIndependent(m_nodes, m_links, iBegin, iEnd, m_kst);
+	}
+};
+
+//
+static void PSolve_Packed(btSoftBody* psb, btScalar kst)
+{
+	const int nn = psb->m_nodes.size();
+	btSoftBody::PackedNode* nodes = &psb->m_packedNodes[0];
+	const btSoftBody::PackedLink* links = &psb->m_packedLinks[0];
+	for (int i = 0; i < nn; ++i)
+	{
+		const btVector3& x = psb->m_nodes[i].m_x;
+		nodes[i].m_x[0] = x.x();
+		nodes[i].m_x[1] = x.y();
+		nodes[i].m_x[2] = x.z();
+	}
+	if (psb->hasLinkColoring())
+	{
+		btSoftBodyPackedLinkColorLoop loop;
+		loop.m_nodes = nodes;
+		loop.m_links = links;
+		loop.m_kst = kst;
+		const int ncolors = psb->m_linkColorOffsets.size() - 1;
+		for (int c = 0; c < ncolors; ++c)
+		{
+			softBodyParallelFor(psb->m_linkColorOffsets[c], psb->m_linkColorOffsets[c + 1], BT_SOFTBODY_LINK_GRAIN_SIZE, loop);
+		}
+		PSolve_PackedLinks(nodes, links, psb->m_linkColorOffsets[ncolors], psb->m_packedLinks.size(), kst);
+	}
+	else
+	{
+		PSolve_PackedLinks(nodes, links, 0, psb->m_packedLinks.size(), kst);
+	}
+	for (int i = 0; i < nn; ++i)
+	{
+		psb->m_nodes[i].m_x.setValue(nodes[i].m_x[0], nodes[i].m_x[1], nodes[i].m_x[2]);
+	}
+}
+
+//
+void btSoftBody::PSolve_Links(btSoftBody* psb, btScalar kst, btScalar ti)
+{
+	BT_PROFILE("PSolve_Links");
+	if (psb->m_usePackedSolverData && psb->m_links.size() && psb->m_packedLinks.size() == psb->m_links.size())
+	{
+		PSolve_Packed(psb, kst);
+		return;
+	}
+	if (psb->hasLinkColoring())
+	{
+		solveColoredLinks(psb, kst, false);
+		return;
+	}
+	for (int i = 0, ni = psb->m_links.size(); i < ni; ++i)
+	{
+		PSolve_Link(psb->m_links[i], kst);
+	}
+}
+
 //
 void btSoftBody::VSolve_Links(btSoftBody* psb, btScalar kst)
 {
 	BT_PROFILE("VSolve_Links");
+	if (psb->hasLinkColoring())
+	{
+		solveColoredLinks(psb, kst, true);
+		return;
+	}
 	for (int i = 0, ni = psb->m_links.size(); i < ni; ++i)
 	{
-		Link& l = psb->m_links[i];
-		Node** n = l.m_n;
-		const btScalar j = -btDot(l.m_c3, n[0]->m_v - n[1]->m_v) * l.m_c2 * kst;
-		n[0]->m_v += l.m_c3 * (j * n[0]->m_im);
-		n[1]->m_v -= l.m_c3 * (j * n[1]->m_im);
+		VSolve_Link(psb->m_links[i], kst);
 	}
 }
 
@@ -3215,7 +3778,7 @@ btSoftBody::vsolver_t btSoftBody::getSolver(eVSolver::_ solver)
 }
 
 //
-void btSoftBody::defaultCollisionHandler(const btCollisionObjectWrapper* pcoWrap)
+void btSoftBody::defaultCollisionHandler(const btCollisionObjectWrapper* pcoWrap, ContactBuffer* buffer)
 {
 	switch (m_cfg.collisions & fCollision::RVSmask)
 	{
@@ -3240,6 +3803,7 @@ void btSoftBody::defaultCollisionHandler(const btCollisionObjectWrapper* pcoWrap
 			docollide.psb = this;
 			docollide.m_colObj1Wrap = pcoWrap;
 			docollide.m_rigidBody = prb1;
+			docollide.m_buffer = buffer;
 
 			docollide.dynmargin = basemargin + timemargin;
 			docollide.stamargin = basemargin;
@@ -3249,6 +3813,7 @@ void btSoftBody::defaultCollisionHandler(const btCollisionObjectWrapper* pcoWrap
 		case fCollision::CL_RS:
 		{
 			btSoftColliders::CollideCL_RS collider;
+			collider.m_buffer = buffer;
 			collider.ProcessColObj(this, pcoWrap);
 		}
 		break;
@@ -3256,7 +3821,7 @@ void btSoftBody::defaultCollisionHandler(const btCollisionObjectWrapper* pcoWrap
 }
 
 //
-void btSoftBody::defaultCollisionHandler(btSoftBody* psb)
+void btSoftBody::defaultCollisionHandler(btSoftBody* psb, ContactBuffer* buffer)
 {
 	const int cf = m_cfg.collisions & psb->m_cfg.collisions;
 	switch (cf & fCollision::SVSmask)
@@ -3267,6 +3832,7 @@ void btSoftBody::defaultCollisionHandler(btSoftBody* psb)
 			if (this != psb || psb->m_cfg.collisions & fCollision::CL_SELF)
 			{
 				btSoftColliders::CollideCL_SS docollide;
+				docollide.m_buffer = buffer;
 				docollide.ProcessSoftSoft(this, psb);
 			}
 		}
@@ -3280,6 +3846,7 @@ void btSoftBody::defaultCollisionHandler(btSoftBody* psb)
 				/* common					*/
 				docollide.mrg = getCollisionShape()->getMargin() +
 								psb->getCollisionShape()->getMargin();
+				docollide.m_buffer = buffer;
 				/* psb0 nodes vs psb1 faces	*/
 				docollide.psb[0] = this;
 				docollide.psb[1] = psb;
@@ -3301,6 +3868,90 @@ void btSoftBody::defaultCollisionHandler(btSoftBody* psb)
 	}
 }
 
+//
+struct btSoftBodyMergeItem
+{
+	const btSoftBody::ContactBuffer::Key* m_key;
+	int m_buffer;
+	int m_index;
+};
+
+struct btSoftBodyMergeItemSortPredicate
+{
+	bool operator()(const btSoftBodyMergeItem& a, const btSoftBodyMergeItem& b) const
+	{
+		const btSoftBody::ContactBuffer::Key& ka = *a.m_key;
+		const btSoftBody::ContactBuffer::Key& kb = *b.m_key;
+		if (ka.m_body != kb.m_body) return ka.m_body < kb.m_body;
+		if (ka.m_object != kb.m_object) return ka.m_object < kb.m_object;
+		if (ka.m_a != kb.m_a) return ka.m_a < kb.m_a;
+		if (ka.m_b != kb.m_b) return ka.m_b < kb.m_b;
+		// equal keys come from the same pair, hence from the same buffer, keep their order
+		if (a.m_buffer != b.m_buffer) return a.m_buffer < b.m_buffer;
+		return a.m_index < b.m_index;
+	}
+};
+
+template <typename T>
+static void btSoftBodyGatherMergeItems(const btAlignedObjectArray<T>& entries, int buffer, btAlignedObjectArray<btSoftBodyMergeItem>& items)
+{
+	for (int i = 0; i < entries.size(); ++i)
+	{
+		btSoftBodyMergeItem& item = items.expandNonInitializing();
+		item.m_key = &entries[i].m_key;
+		item.m_buffer = buffer;
+		item.m_index = i;
+	}
+}
+
+void btSoftBody::mergeContactBuffers(ContactBuffer* buffers, int count)
+{
+	BT_PROFILE("mergeContactBuffers");
+	btAlignedObjectArray<btSoftBodyMergeItem> items;
+	/* Rigid contacts		*/
+	for (int i = 0; i < count; ++i)
+	{
+		btSoftBodyGatherMergeItems(buffers[i].m_rcontacts, i, items);
+	}
+	items.quickSort(btSoftBodyMergeItemSortPredicate());
+	for (int i = 0; i < items.size(); ++i)
+	{
+		const RContact& c = buffers[items[i].m_buffer].m_rcontacts[items[i].m_index].m_contact;
+		items[i].m_key->m_body->m_rcontacts.push_back(c);
+		btRigidBody* prb = (btRigidBody*)btRigidBody::upcast(c.m_cti.m_colObj);
+		if (prb)
+			prb->activate();
+	}
+	/* Soft contacts		*/
+	items.resize(0);
+	for (int i = 0; i < count; ++i)
+	{
+		btSoftBodyGatherMergeItems(buffers[i].m_scontacts, i, items);
+	}
+	items.quickSort(btSoftBodyMergeItemSortPredicate());
+	for (int i = 0; i < items.size(); ++i)
+	{
+		items[i].m_key->m_body->m_scontacts.push_back(buffers[items[i].m_buffer].m_scontacts[items[i].m_index].m_contact);
+	}
+	/* Cluster contacts		*/
+	items.resize(0);
+	for (int i = 0; i < count; ++i)
+	{
+		btSoftBodyGatherMergeItems(buffers[i].m_joints, i, items);
+	}
+	items.quickSort(btSoftBodyMergeItemSortPredicate());
+	for (int i = 0; i < items.size(); ++i)
+	{
+		items[i].m_key->m_body->m_joints.push_back(buffers[items[i].m_buffer].m_joints[items[i].m_index].m_joint);
+	}
+	for (int i = 0; i < count; ++i)
+	{
+		buffers[i].m_rcontacts.resize(0);
+		buffers[i].m_scontacts.resize(0);
+		buffers[i].m_joints.resize(0);
+	}
+}
+
 void btSoftBody::setWindVelocity(const btVector3& velocity)
 {
 	m_windVelocity = velocity;
@@ -637,6 +637,88 @@ public:
 		btScalar radmrg;  // radial margin
 		btScalar updmrg;  // Update margin
 	};
+	/* Packed node, a compact copy of what the link solver reads			*/
+	ATTRIBUTE_ALIGNED16(struct)
+	PackedNode
+	{
+		btScalar m_x[3];  // Position
+		btScalar m_im;    // 1/mass
+	};
+	/* Packed link															*/
+	ATTRIBUTE_ALIGNED16(struct)
+	PackedLink
+	{
+		int m_n[2];       // Node indices
+		btScalar m_c0;    // (ima+imb)*kLST
+		btScalar m_c1;    // rl^2
+	};
+	/* TreeRefit, internal nodes of a btDbvt grouped by height, so that	*/
+	/* the volumes can be refit bottom-up one level at a time				*/
+	struct TreeRefit
+	{
+		btAlignedObjectArray<btDbvtNode*> m_nodes;  // Internal nodes, lowest level first
+		btAlignedObjectArray<int> m_levels;         // Level l is m_nodes[m_levels[l] .. m_levels[l+1])
+		btAlignedObjectArray<btScalar> m_costs;     // Cost of each chunk of a level, summed in a fixed order
+		const btDbvtNode* m_root;                   // Root the order was built for
+		int m_leaves;                               // Leaf count the order was built for
+		btScalar m_cost;                            // Surface area of the internal nodes after the last rebuild
+		TreeRefit() : m_root(0), m_leaves(0), m_cost(0) {}
+	};
+	/* ContactBuffer, contacts found by one thread while the collision		*/
+	/* pairs are processed in parallel, see mergeContactBuffers				*/
+	struct ContactBuffer
+	{
+		struct Key
+		{
+			btSoftBody* m_body;  // Body the contact belongs to
+			int m_object;        // World array index of the other object
+			int m_a;             // Node or cluster index in m_body
+			int m_b;             // Face or cluster index in the other object
+			Key() : m_body(0), m_object(-1), m_a(0), m_b(0) {}
+		};
+		struct RContactEntry
+		{
+			Key m_key;
+			RContact m_contact;
+			RContactEntry()
+			{
+				m_contact.m_cti.m_colObj = 0;
+				m_contact.m_cti.m_normal.setZero();
+				m_contact.m_cti.m_offset = 0;
+				m_contact.m_node = 0;
+				m_contact.m_c0.setValue(0, 0, 0, 0, 0, 0, 0, 0, 0);
+				m_contact.m_c1.setZero();
+				m_contact.m_c2 = 0;
+				m_contact.m_c3 = 0;
+				m_contact.m_c4 = 0;
+			}
+		};
+		struct SContactEntry
+		{
+			Key m_key;
+			SContact m_contact;
+			SContactEntry()
+			{
+				m_contact.m_node = 0;
+				m_contact.m_face = 0;
+				m_contact.m_weights.setZero();
+				m_contact.m_normal.setZero();
+				m_contact.m_margin = 0;
+				m_contact.m_friction = 0;
+				m_contact.m_cfm[0] = 0;
+				m_contact.m_cfm[1] = 0;
+			}
+		};
+		struct JointEntry
+		{
+			Key m_key;
+			CJoint* m_joint;
+			JointEntry() : m_joint(0) {}
+		};
+		btAlignedObjectArray<RContactEntry> m_rcontacts;
+		btAlignedObjectArray<SContactEntry> m_scontacts;
+		btAlignedObjectArray<JointEntry> m_joints;
+	};
 	/// RayFromToCaster takes a ray from, ray to (instead of direction!)
 	struct RayFromToCaster : btDbvt::ICollide
 	{
@@ -669,6 +751,8 @@ public:
 	typedef btAlignedObjectArray<Node> tNodeArray;
 	typedef btAlignedObjectArray<btDbvtNode*> tLeafArray;
 	typedef btAlignedObjectArray<Link> tLinkArray;
+	typedef btAlignedObjectArray<PackedNode> tPackedNodeArray;
+	typedef btAlignedObjectArray<PackedLink> tPackedLinkArray;
 	typedef btAlignedObjectArray<Face> tFaceArray;
 	typedef btAlignedObjectArray<Tetra> tTetraArray;
 	typedef btAlignedObjectArray<Anchor> tAnchorArray;
@@ -713,6 +797,16 @@ public:
 
 	btScalar m_restLengthScale;
 
+	btAlignedObjectArray<int> m_linkColorItems;    // Link indices grouped by color, followed by the links solved serially
+	btAlignedObjectArray<int> m_linkColorOffsets;  // Color c is m_linkColorItems[m_linkColorOffsets[c] .. m_linkColorOffsets[c+1]), the last offset starts the serial links
+	bool m_usePackedSolverData;                     // Solve links on m_packedNodes/m_packedLinks
+	tPackedNodeArray m_packedNodes;                 // Positions (valid inside PSolve_Links only) and 1/mass
+	tPackedLinkArray m_packedLinks;                 // Links in solver order, valid inside solveConstraints only
+	bool m_useTreeRefit;                            // Refit m_ndbvt/m_fdbvt each step instead of updating them leaf by leaf
+	btScalar m_treeRebuildRatio;                    // Rebuild a refit tree when its cost exceeds this ratio of the cost after the last rebuild
+	TreeRefit m_ndbvtRefit;                         // Refit order of m_ndbvt
+	TreeRefit m_fdbvtRefit;                         // Refit order of m_fdbvt
+
 	//
 	// Api
 	//
@@ -893,6 +987,34 @@ public:
 	/* CutLink																*/
 	bool cutLink(int node0, int node1, btScalar position);
 	bool cutLink(const Node* node0, const Node* node1, btScalar position);
+	/* Color links so that links of the same color share no node, links		*/
+	/* that do not fit in a color of at least minColorSize are solved serially	*/
+	void colorLinks(int minColorSize);
+	void clearLinkColoring();
+	bool hasLinkColoring() const;
+	/* Solve links on a packed copy of the positions, inverse masses and	*/
+	/* link constants, m_nodes and m_links stay up to date					*/
+	void setUsePackedSolverData(bool usePackedSolverData)
+	{
+		m_usePackedSolverData = usePackedSolverData;
+	}
+	bool getUsePackedSolverData() const
+	{
+		return m_usePackedSolverData;
+	}
+	/* Refit the node and face trees bottom-up each step, in parallel, and	*/
+	/* rebuild them top-down once their cost grew by more than rebuildRatio	*/
+	void setUseTreeRefit(bool useTreeRefit, btScalar rebuildRatio = 4)
+	{
+		m_useTreeRefit = useTreeRefit;
+		m_treeRebuildRatio = btMax(btScalar(1), rebuildRatio);
+		clearTreeRefit();
+	}
+	bool getUseTreeRefit() const
+	{
+		return m_useTreeRefit;
+	}
+	void clearTreeRefit();
 
 	///Ray casting using rayFrom and rayTo in worldspace, (not direction!)
 	bool rayTest(const btVector3& rayFrom,
@@ -913,8 +1035,13 @@ public:
 	/* integrateMotion														*/
 	void integrateMotion();
 	/* defaultCollisionHandlers												*/
-	void defaultCollisionHandler(const btCollisionObjectWrapper* pcoWrap);
-	void defaultCollisionHandler(btSoftBody* psb);
+	///With a buffer, the contacts are collected in it instead of being appended to the bodies,
+	///so that several pairs can be processed at the same time, one buffer per thread
+	void defaultCollisionHandler(const btCollisionObjectWrapper* pcoWrap, ContactBuffer* buffer = 0);
+	void defaultCollisionHandler(btSoftBody* psb, ContactBuffer* buffer = 0);
+	///Append the buffered contacts to their bodies and clear the buffers. The contacts of each body
+	///are sorted by object, node and face, so the result does not depend on how pairs were spread over the buffers
+	static void mergeContactBuffers(ContactBuffer* buffers, int count);
 
 	//
 	// Functionality to deal with new accelerated solvers.
@@ -997,6 +1124,8 @@ public:
 	void updatePose();
 	void updateConstants();
 	void updateLinkConstants();
+	void packSolverData();
+	void refitTrees();
 	void updateArea(bool averageArea = true);
 	void initializeClusters();
 	void updateClusters();
@@ -16,10 +16,12 @@ subject to the following restrictions:
 
 #include "btSoftBodyInternals.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "btSoftBodyHelpers.h"
 #include "LinearMath/btConvexHull.h"
 #include "LinearMath/btConvexHullComputer.h"
+#include "LinearMath/btThreads.h"
 
 //
 static void drawVertex(btIDebugDraw* idraw,
@@ -1110,7 +1112,7 @@ static int nextLine(const char* buffer)
 {
 	int numBytesRead = 0;
 
-	while (*buffer != '\n')
+	while (*buffer && *buffer != '\n')
 	{
 		buffer++;
 		numBytesRead++;
@@ -1124,6 +1126,267 @@ static int nextLine(const char* buffer)
 	return numBytesRead;
 }
 
+// sscanf measures the remaining string on every call, which makes parsing large
+// TetGen files quadratic, so fields are read with strtol/strtod instead
+static const char* parseInt(const char* buffer, int& value)
+{
+	char* end;
+	value = (int)strtol(buffer, &end, 10);
+	return end;
+}
+
+static const char* parseFloat(const char* buffer, float& value)
+{
+	char* end;
+	value = (float)strtod(buffer, &end);
+	return end;
+}
+
+//
+// Tet mesh preprocessing
+//
+
+#define BT_SOFTBODY_TETMESH_GRAIN_SIZE 4096
+
+static const int tetraEdges[6][2] = {{0, 1}, {1, 2}, {2, 0}, {0, 3}, {1, 3}, {2, 3}};
+static const int triangleEdges[3][2] = {{0, 1}, {1, 2}, {2, 0}};
+// Outward facing sides of a tetra with positive volume
+static const int tetraFaces[4][3] = {{0, 2, 1}, {0, 1, 3}, {1, 2, 3}, {0, 3, 2}};
+
+// The import helpers are not opt-in, so they must also run without BT_THREADSAFE or a task scheduler
+static void tetMeshParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		btParallelFor(iBegin, iEnd, grainSize, body);
+		return;
+	}
+#endif
+	(void)grainSize;
+	body.forLoop(iBegin, iEnd);
+}
+
+// Edge or face of an element, keyed by its sorted node indices, m_order is the
+// position of the occurrence in the input and keeps the results in input order
+struct btTetMeshKey
+{
+	int m_n[3];
+	int m_order;
+};
+
+struct btTetMeshKeyPredicate
+{
+	SIMD_FORCE_INLINE bool operator()(const btTetMeshKey& a, const btTetMeshKey& b) const
+	{
+		if (a.m_n[0] != b.m_n[0]) return a.m_n[0] < b.m_n[0];
+		if (a.m_n[1] != b.m_n[1]) return a.m_n[1] < b.m_n[1];
+		if (a.m_n[2] != b.m_n[2]) return a.m_n[2] < b.m_n[2];
+		return a.m_order < b.m_order;
+	}
+};
+
+struct btTetMeshOrderPredicate
+{
+	SIMD_FORCE_INLINE bool operator()(const btTetMeshKey& a, const btTetMeshKey& b) const
+	{
+		return a.m_order < b.m_order;
+	}
+};
+
+template <typename L>
+struct btTetMeshSortLoop : public btIParallelForBody
+{
+	btAlignedObjectArray<btTetMeshKey>* m_keys;
+	L m_predicate;
+
+	btTetMeshSortLoop(btAlignedObjectArray<btTetMeshKey>* keys, const L& predicate) : m_keys(keys), m_predicate(predicate) {}
+	void forLoop(int iBegin, int iEnd) const
+	{
+		const int n = m_keys->size();
+		for (int c = iBegin; c < iEnd; ++c)
+		{
+			const int lo = c * BT_SOFTBODY_TETMESH_GRAIN_SIZE;
+			const int hi = btMin(n, lo + BT_SOFTBODY_TETMESH_GRAIN_SIZE) - 1;
+			if (hi > lo) m_keys->quickSortInternal(m_predicate, lo, hi);
+		}
+	}
+};
+
+template <typename L>
+struct btTetMeshMergeLoop : public btIParallelForBody
+{
+	const btTetMeshKey* m_src;
+	btTetMeshKey* m_dst;
+	int m_size;
+	int m_width;
+	L m_predicate;
+
+	btTetMeshMergeLoop(const btTetMeshKey* src, btTetMeshKey* dst, int size, int width, const L& predicate) : m_src(src), m_dst(dst), m_size(size), m_width(width), m_predicate(predicate) {}
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int p = iBegin; p < iEnd; ++p)
+		{
+			const int lo = p * 2 * m_width;
+			const int mid = btMin(m_size, lo + m_width);
+			const int hi = btMin(m_size, lo + 2 * m_width);
+			int i = lo, j = mid, k = lo;
+			while (i < mid && j < hi) m_dst[k++] = m_predicate(m_src[j], m_src[i]) ? m_src[j++] : m_src[i++];
+			while (i < mid) m_dst[k++] = m_src[i++];
+			while (j < hi) m_dst[k++] = m_src[j++];
+		}
+	}
+};
+
+// Sorts chunks in parallel and merges them pairwise, keys are unique so the
+// result does not depend on the number of threads
+template <typename L>
+static void sortTetMeshKeys(btAlignedObjectArray<btTetMeshKey>& keys, const L& predicate)
+{
+	const int n = keys.size();
+	if (n <= BT_SOFTBODY_TETMESH_GRAIN_SIZE)
+	{
+		keys.quickSort(predicate);
+		return;
+	}
+	btTetMeshSortLoop<L> sortLoop(&keys, predicate);
+	tetMeshParallelFor(0, (n + BT_SOFTBODY_TETMESH_GRAIN_SIZE - 1) / BT_SOFTBODY_TETMESH_GRAIN_SIZE, 1, sortLoop);
+	btAlignedObjectArray<btTetMeshKey> buffer;
+	buffer.resize(n);
+	btTetMeshKey* src = &keys[0];
+	btTetMeshKey* dst = &buffer[0];
+	for (int width = BT_SOFTBODY_TETMESH_GRAIN_SIZE; width < n; width *= 2)
+	{
+		btTetMeshMergeLoop<L> mergeLoop(src, dst, n, width, predicate);
+		tetMeshParallelFor(0, (n + 2 * width - 1) / (2 * width), 1, mergeLoop);
+		btSwap(src, dst);
+	}
+	if (src != &keys[0]) keys = buffer;
+}
+
+struct btTetMeshEdgeLoop : public btIParallelForBody
+{
+	const int* m_elements;
+	int m_stride;
+	const int (*m_edges)[2];
+	int m_nedges;
+	btTetMeshKey* m_keys;
+
+	btTetMeshEdgeLoop(const int* elements, int stride, const int (*edges)[2], int nedges, btTetMeshKey* keys) : m_elements(elements), m_stride(stride), m_edges(edges), m_nedges(nedges), m_keys(keys) {}
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			const int* ni = m_elements + i * m_stride;
+			for (int e = 0; e < m_nedges; ++e)
+			{
+				btTetMeshKey& key = m_keys[i * m_nedges + e];
+				const int a = ni[m_edges[e][0]], b = ni[m_edges[e][1]];
+				key.m_n[0] = btMin(a, b);
+				key.m_n[1] = btMax(a, b);
+				key.m_n[2] = 0;
+				key.m_order = i * m_nedges + e;
+			}
+		}
+	}
+};
+
+// Appends one link per distinct edge of the elements, in order of first
+// occurrence and with its orientation, same as appendLink with bcheckexist
+static void appendTetMeshLinks(btSoftBody* psb, const int* elements, int nelements, int stride, const int (*edges)[2], int nedges)
+{
+	btAlignedObjectArray<btTetMeshKey> keys;
+	keys.resize(nelements * nedges);
+	if (keys.size() == 0) return;
+	btTetMeshEdgeLoop loop(elements, stride, edges, nedges, &keys[0]);
+	tetMeshParallelFor(0, nelements, BT_SOFTBODY_TETMESH_GRAIN_SIZE / nedges, loop);
+	sortTetMeshKeys(keys, btTetMeshKeyPredicate());
+	int nunique = 0;
+	for (int i = 0; i < keys.size(); ++i)
+	{
+		if (nunique == 0 || keys[i].m_n[0] != keys[nunique - 1].m_n[0] || keys[i].m_n[1] != keys[nunique - 1].m_n[1])
+		{
+			keys[nunique++] = keys[i];
+		}
+	}
+	keys.resize(nunique);
+	sortTetMeshKeys(keys, btTetMeshOrderPredicate());
+	psb->m_links.reserve(psb->m_links.size() + nunique);
+	for (int i = 0; i < nunique; ++i)
+	{
+		const int* ni = elements + (keys[i].m_order / nedges) * stride;
+		const int e = keys[i].m_order % nedges;
+		psb->appendLink(ni[edges[e][0]], ni[edges[e][1]]);
+	}
+}
+
+struct btTetMeshFaceLoop : public btIParallelForBody
+{
+	const btScalar* m_vertices;
+	const int* m_tetras;
+	btTetMeshKey* m_keys;
+	int* m_faces;
+
+	btTetMeshFaceLoop(const btScalar* vertices, const int* tetras, btTetMeshKey* keys, int* faces) : m_vertices(vertices), m_tetras(tetras), m_keys(keys), m_faces(faces) {}
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			const int* ni = m_tetras + i * 4;
+			btVector3 x[4];
+			for (int j = 0; j < 4; ++j)
+			{
+				x[j] = btVector3(m_vertices[ni[j] * 3], m_vertices[ni[j] * 3 + 1], m_vertices[ni[j] * 3 + 2]);
+			}
+			const bool flip = btDot(x[1] - x[0], btCross(x[2] - x[0], x[3] - x[0])) < 0;
+			for (int f = 0; f < 4; ++f)
+			{
+				int* face = m_faces + (i * 4 + f) * 3;
+				face[0] = ni[tetraFaces[f][0]];
+				face[1] = ni[tetraFaces[f][flip ? 2 : 1]];
+				face[2] = ni[tetraFaces[f][flip ? 1 : 2]];
+				btTetMeshKey& key = m_keys[i * 4 + f];
+				key.m_n[0] = btMin(face[0], btMin(face[1], face[2]));
+				key.m_n[2] = btMax(face[0], btMax(face[1], face[2]));
+				key.m_n[1] = face[0] + face[1] + face[2] - key.m_n[0] - key.m_n[2];
+				key.m_order = i * 4 + f;
+			}
+		}
+	}
+};
+
+// Extracts the outward facing sides that belong to a single tetra
+static void extractTetMeshSurface(const btScalar* vertices, const int* tetras, int ntetras, btAlignedObjectArray<int>& surface)
+{
+	btAlignedObjectArray<btTetMeshKey> keys;
+	btAlignedObjectArray<int> faces;
+	keys.resize(ntetras * 4);
+	faces.resize(ntetras * 12);
+	surface.resize(0);
+	if (ntetras == 0) return;
+	btTetMeshFaceLoop loop(vertices, tetras, &keys[0], &faces[0]);
+	tetMeshParallelFor(0, ntetras, BT_SOFTBODY_TETMESH_GRAIN_SIZE / 4, loop);
+	sortTetMeshKeys(keys, btTetMeshKeyPredicate());
+	int nsurface = 0;
+	for (int i = 0, j; i < keys.size(); i = j)
+	{
+		for (j = i + 1; j < keys.size() && keys[j].m_n[0] == keys[i].m_n[0] && keys[j].m_n[1] == keys[i].m_n[1] && keys[j].m_n[2] == keys[i].m_n[2]; ++j)
+		{
+		}
+		if (j == i + 1) keys[nsurface++] = keys[i];
+	}
+	keys.resize(nsurface);
+	sortTetMeshKeys(keys, btTetMeshOrderPredicate());
+	surface.resize(nsurface * 3);
+	for (int i = 0; i < nsurface; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			surface[i * 3 + j] = faces[keys[i].m_order * 3 + j];
+		}
+	}
+}
+
 /* Create from TetGen .ele, .face, .node data							*/
 btSoftBody* btSoftBodyHelpers::CreateFromTetGenData(btSoftBodyWorldInfo& worldInfo,
 													const char* ele,
@@ -1139,7 +1402,6 @@ btSoftBody* btSoftBodyHelpers::CreateFromTetGenData(btSoftBodyWorldInfo& worldIn
 	int nattrb = 0;
 	int hasbounds = 0;
 	int result = sscanf(node, "%d %d %d %d", &nnode, &ndims, &nattrb, &hasbounds);
-	result = sscanf(node, "%d %d %d %d", &nnode, &ndims, &nattrb, &hasbounds);
 	node += nextLine(node);
 
 	pos.resize(nnode);
@@ -1148,7 +1410,10 @@ btSoftBody* btSoftBodyHelpers::CreateFromTetGenData(btSoftBodyWorldInfo& worldIn
 		int index = 0;
 		//int			bound=0;
 		float x, y, z;
-		sscanf(node, "%d %f %f %f", &index, &x, &y, &z);
+		const char* field = parseInt(node, index);
+		field = parseFloat(field, x);
+		field = parseFloat(field, y);
+		field = parseFloat(field, z);
 
 		//	sn>>index;
 		//	sn>>x;sn>>y;sn>>z;
@@ -1198,27 +1463,29 @@ if(face&&face[0])
 		ele += nextLine(ele);
 
 		//se>>ntetra;se>>ncorner;se>>neattrb;
+		btAlignedObjectArray<int> tetras;
+		tetras.resize(ntetra * 4);
+		psb->m_tetras.reserve(ntetra);
 		for (int i = 0; i < ntetra; ++i)
 		{
 			int index = 0;
-			int ni[4];
+			int* ni = &tetras[i * 4];
 
 			//se>>index;
 			//se>>ni[0];se>>ni[1];se>>ni[2];se>>ni[3];
-			sscanf(ele, "%d %d %d %d %d", &index, &ni[0], &ni[1], &ni[2], &ni[3]);
+			const char* field = parseInt(ele, index);
+			for (int j = 0; j < 4; ++j)
+			{
+				field = parseInt(field, ni[j]);
+			}
 			ele += nextLine(ele);
 			//for(int j=0;j<neattrb;++j)
 			//	se>>a;
 			psb->appendTetra(ni[0], ni[1], ni[2], ni[3]);
-			if (btetralinks)
-			{
-				psb->appendLink(ni[0], ni[1], 0, true);
-				psb->appendLink(ni[1], ni[2], 0, true);
-				psb->appendLink(ni[2], ni[0], 0, true);
-				psb->appendLink(ni[0], ni[3], 0, true);
-				psb->appendLink(ni[1], ni[3], 0, true);
-				psb->appendLink(ni[2], ni[3], 0, true);
-			}
+		}
+		if (btetralinks)
+		{
+			appendTetMeshLinks(psb, tetras.size() ? &tetras[0] : 0, ntetra, 4, tetraEdges, 6);
 		}
 	}
 	printf("Nodes:  %u\r\n", psb->m_nodes.size());
@@ -1227,3 +1494,236 @@ if(face&&face[0])
 	printf("Tetras: %u\r\n", psb->m_tetras.size());
 	return (psb);
 }
+
+//
+btSoftBody* btSoftBodyHelpers::CreateFromTetMesh(btSoftBodyWorldInfo& worldInfo,
+												 const btScalar* vertices,
+												 int nvertices,
+												 const int* tetras,
+												 int ntetras,
+												 bool bfacelinks,
+												 bool btetralinks,
+												 bool bfacesfromtetras)
+{
+	btAlignedObjectArray<btVector3> pos;
+	pos.resize(nvertices);
+	for (int i = 0; i < nvertices; ++i)
+	{
+		pos[i] = btVector3(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+	}
+	btSoftBody* psb = new btSoftBody(&worldInfo, nvertices, nvertices ? &pos[0] : 0, 0);
+	psb->m_tetras.reserve(ntetras);
+	for (int i = 0; i < ntetras; ++i)
+	{
+		const int* ni = tetras + i * 4;
+		psb->appendTetra(ni[0], ni[1], ni[2], ni[3]);
+	}
+	btAlignedObjectArray<int> surface;
+	if (bfacesfromtetras || (bfacelinks && !btetralinks))
+	{
+		extractTetMeshSurface(vertices, tetras, ntetras, surface);
+	}
+	if (btetralinks)
+	{
+		appendTetMeshLinks(psb, tetras, ntetras, 4, tetraEdges, 6);
+	}
+	else if (bfacelinks && surface.size())
+	{
+		appendTetMeshLinks(psb, &surface[0], surface.size() / 3, 3, triangleEdges, 3);
+	}
+	if (bfacesfromtetras)
+	{
+		psb->m_faces.reserve(surface.size() / 3);
+		for (int i = 0; i < surface.size(); i += 3)
+		{
+			psb->appendFace(surface[i], surface[i + 1], surface[i + 2]);
+		}
+	}
+	return (psb);
+}
+
+// Spreads the low 10 bits of v so there are two zero bits between each
+static inline unsigned int expandMortonBits(unsigned int v)
+{
+	v = (v * 0x00010001u) & 0xFF0000FFu;
+	v = (v * 0x00000101u) & 0x0F00F00Fu;
+	v = (v * 0x00000011u) & 0xC30C30C3u;
+	v = (v * 0x00000005u) & 0x49249249u;
+	return v;
+}
+
+//
+void btSoftBodyHelpers::SortTetMeshNodes(btScalar* vertices,
+										 int nvertices,
+										 int* tetras,
+										 int ntetras,
+										 int* remap)
+{
+	if (nvertices <= 0) return;
+	btVector3 mins(vertices[0], vertices[1], vertices[2]);
+	btVector3 maxs = mins;
+	for (int i = 1; i < nvertices; ++i)
+	{
+		const btVector3 x(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+		mins.setMin(x);
+		maxs.setMax(x);
+	}
+	const btVector3 extents = maxs - mins;
+	const btScalar scale = btScalar(1023) / btMax(SIMD_EPSILON, extents[extents.maxAxis()]);
+	btAlignedObjectArray<btTetMeshKey> keys;
+	keys.resize(nvertices);
+	for (int i = 0; i < nvertices; ++i)
+	{
+		const btVector3 q = (btVector3(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]) - mins) * scale;
+		btTetMeshKey& key = keys[i];
+		key.m_n[0] = (int)((expandMortonBits((unsigned int)q.x()) << 2) | (expandMortonBits((unsigned int)q.y()) << 1) | expandMortonBits((unsigned int)q.z()));
+		key.m_n[1] = key.m_n[2] = 0;
+		key.m_order = i;
+	}
+	sortTetMeshKeys(keys, btTetMeshKeyPredicate());
+	btAlignedObjectArray<btScalar> sorted;
+	btAlignedObjectArray<int> order;
+	sorted.resize(nvertices * 3);
+	order.resize(nvertices);
+	for (int i = 0; i < nvertices; ++i)
+	{
+		const int j = keys[i].m_order;
+		order[j] = i;
+		sorted[i * 3] = vertices[j * 3];
+		sorted[i * 3 + 1] = vertices[j * 3 + 1];
+		sorted[i * 3 + 2] = vertices[j * 3 + 2];
+	}
+	memcpy(vertices, &sorted[0], sizeof(btScalar) * nvertices * 3);
+	for (int i = 0; i < ntetras * 4; ++i)
+	{
+		tetras[i] = order[tetras[i]];
+	}
+	if (remap)
+	{
+		memcpy(remap, &order[0], sizeof(int) * nvertices);
+	}
+}
+
+// Binary tet mesh layout, in native byte order so a mismatch fails the version check:
+// header, then per node float x,y,z,mass, then int pairs for links,
+// int triplets for faces and int quadruplets for tetras
+struct btBinaryTetMeshHeader
+{
+	char m_magic[4];
+	int m_version;
+	int m_nodes;
+	int m_links;
+	int m_faces;
+	int m_tetras;
+};
+
+#define BT_BINARY_TETMESH_VERSION 1
+
+//
+void btSoftBodyHelpers::ExportAsBinaryTetMesh(const btSoftBody* psb,
+											  btAlignedObjectArray<char>& data)
+{
+	btBinaryTetMeshHeader header;
+	memcpy(header.m_magic, "BTTM", 4);
+	header.m_version = BT_BINARY_TETMESH_VERSION;
+	header.m_nodes = psb->m_nodes.size();
+	header.m_links = psb->m_links.size();
+	header.m_faces = psb->m_faces.size();
+	header.m_tetras = psb->m_tetras.size();
+	data.resize(sizeof(header) + sizeof(float) * 4 * header.m_nodes +
+				sizeof(int) * (2 * header.m_links + 3 * header.m_faces + 4 * header.m_tetras));
+	char* dst = &data[0];
+	memcpy(dst, &header, sizeof(header));
+	dst += sizeof(header);
+	const btSoftBody::Node* nbase = header.m_nodes ? &psb->m_nodes[0] : 0;
+	for (int i = 0; i < header.m_nodes; ++i)
+	{
+		const btSoftBody::Node& n = psb->m_nodes[i];
+		const float values[4] = {float(n.m_x.x()), float(n.m_x.y()), float(n.m_x.z()), float(n.m_im > 0 ? 1 / n.m_im : 0)};
+		memcpy(dst, values, sizeof(values));
+		dst += sizeof(values);
+	}
+	for (int i = 0; i < header.m_links; ++i)
+	{
+		const int ni[2] = {int(psb->m_links[i].m_n[0] - nbase), int(psb->m_links[i].m_n[1] - nbase)};
+		memcpy(dst, ni, sizeof(ni));
+		dst += sizeof(ni);
+	}
+	for (int i = 0; i < header.m_faces; ++i)
+	{
+		const btSoftBody::Face& f = psb->m_faces[i];
+		const int ni[3] = {int(f.m_n[0] - nbase), int(f.m_n[1] - nbase), int(f.m_n[2] - nbase)};
+		memcpy(dst, ni, sizeof(ni));
+		dst += sizeof(ni);
+	}
+	for (int i = 0; i < header.m_tetras; ++i)
+	{
+		const btSoftBody::Tetra& t = psb->m_tetras[i];
+		const int ni[4] = {int(t.m_n[0] - nbase), int(t.m_n[1] - nbase), int(t.m_n[2] - nbase), int(t.m_n[3] - nbase)};
+		memcpy(dst, ni, sizeof(ni));
+		dst += sizeof(ni);
+	}
+}
+
+// Reads count groups of stride indices and checks them against the node count
+static const char* readTetMeshIndices(const char* src, int count, int stride, int nnodes, btAlignedObjectArray<int>& indices)
+{
+	indices.resize(count * stride);
+	if (count == 0) return src;
+	memcpy(&indices[0], src, sizeof(int) * count * stride);
+	for (int i = 0; i < indices.size(); ++i)
+	{
+		if (indices[i] < 0 || indices[i] >= nnodes) return 0;
+	}
+	return src + sizeof(int) * count * stride;
+}
+
+//
+btSoftBody* btSoftBodyHelpers::CreateFromBinaryTetMesh(btSoftBodyWorldInfo& worldInfo,
+													   const char* data,
+													   int size)
+{
+	btBinaryTetMeshHeader header;
+	if (!data || size < (int)sizeof(header)) return 0;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.m_magic, "BTTM", 4) != 0 || header.m_version != BT_BINARY_TETMESH_VERSION) return 0;
+	if (header.m_nodes < 0 || header.m_links < 0 || header.m_faces < 0 || header.m_tetras < 0) return 0;
+	const double expected = sizeof(header) + sizeof(float) * 4.0 * header.m_nodes +
+							sizeof(int) * (2.0 * header.m_links + 3.0 * header.m_faces + 4.0 * header.m_tetras);
+	if (expected > size) return 0;
+	const char* src = data + sizeof(header);
+	btAlignedObjectArray<btVector3> pos;
+	btAlignedObjectArray<btScalar> masses;
+	pos.resize(header.m_nodes);
+	masses.resize(header.m_nodes);
+	for (int i = 0; i < header.m_nodes; ++i)
+	{
+		float values[4];
+		memcpy(values, src, sizeof(values));
+		src += sizeof(values);
+		pos[i] = btVector3(values[0], values[1], values[2]);
+		masses[i] = values[3];
+	}
+	btAlignedObjectArray<int> links, faces, tetras;
+	src = readTetMeshIndices(src, header.m_links, 2, header.m_nodes, links);
+	if (src) src = readTetMeshIndices(src, header.m_faces, 3, header.m_nodes, faces);
+	if (src) src = readTetMeshIndices(src, header.m_tetras, 4, header.m_nodes, tetras);
+	if (!src) return 0;
+	btSoftBody* psb = new btSoftBody(&worldInfo, header.m_nodes, header.m_nodes ? &pos[0] : 0, header.m_nodes ? &masses[0] : 0);
+	psb->m_links.reserve(header.m_links);
+	psb->m_faces.reserve(header.m_faces);
+	psb->m_tetras.reserve(header.m_tetras);
+	for (int i = 0; i < links.size(); i += 2)
+	{
+		psb->appendLink(links[i], links[i + 1]);
+	}
+	for (int i = 0; i < faces.size(); i += 3)
+	{
+		psb->appendFace(faces[i], faces[i + 1], faces[i + 2]);
+	}
+	for (int i = 0; i < tetras.size(); i += 4)
+	{
+		psb->appendTetra(tetras[i], tetras[i + 1], tetras[i + 2], tetras[i + 3]);
+	}
+	return (psb);
+}
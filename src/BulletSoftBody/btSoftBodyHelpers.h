@@ -140,6 +140,33 @@ struct btSoftBodyHelpers
 											bool bfacelinks,
 											bool btetralinks,
 											bool bfacesfromtetras);
+	/* Create from an indexed tetrahedral mesh, vertices are xyz triplets	*/
+	/* Links and surface faces are extracted by sorting instead of per		*/
+	/* link lookups, so this scales to meshes with millions of tetras		*/
+	static btSoftBody* CreateFromTetMesh(btSoftBodyWorldInfo& worldInfo,
+										 const btScalar* vertices,
+										 int nvertices,
+										 const int* tetras,
+										 int ntetras,
+										 bool bfacelinks,
+										 bool btetralinks,
+										 bool bfacesfromtetras);
+	/* Sort the vertices of a tetrahedral mesh along a Morton curve and		*/
+	/* remap the tetras, so nodes close in space are close in memory		*/
+	/* If remap is given, it receives the new index of each old vertex		*/
+	static void SortTetMeshNodes(btScalar* vertices,
+								 int nvertices,
+								 int* tetras,
+								 int ntetras,
+								 int* remap = 0);
+	/* Export nodes, links, faces and tetras to a binary tet mesh			*/
+	static void ExportAsBinaryTetMesh(const btSoftBody* psb,
+									  btAlignedObjectArray<char>& data);
+	/* Create from a binary tet mesh, links and faces are taken as stored	*/
+	/* Returns 0 if the data is not a valid binary tet mesh					*/
+	static btSoftBody* CreateFromBinaryTetMesh(btSoftBodyWorldInfo& worldInfo,
+											   const char* data,
+											   int size);
 
 	/// Sort the list of links to move link calculations that are dependent upon earlier
 	/// ones as far as possible away from the calculation of those values
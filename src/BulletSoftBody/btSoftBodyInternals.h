@@ -683,6 +683,7 @@ struct btSoftColliders
 		btScalar m_margin;
 		btScalar friction;
 		btScalar threshold;
+		btSoftBody::ContactBuffer* m_buffer;
 		ClusterBase()
 		{
 			erp = (btScalar)1;
@@ -690,6 +691,7 @@ struct btSoftColliders
 			m_margin = 0;
 			friction = 0;
 			threshold = (btScalar)0;
+			m_buffer = 0;
 		}
 		bool SolveContact(const btGjkEpaSolver2::sResults& res,
 						  btSoftBody::Body ba, const btSoftBody::Body bb,
@@ -766,7 +768,19 @@ struct btSoftColliders
 				{
 					btSoftBody::CJoint* pj = new (btAlignedAlloc(sizeof(btSoftBody::CJoint), 16)) btSoftBody::CJoint();
 					*pj = joint;
-					psb->m_joints.push_back(pj);
+					if (m_buffer)
+					{
+						btSoftBody::ContactBuffer::JointEntry& entry = m_buffer->m_joints.expandNonInitializing();
+						entry.m_key.m_body = psb;
+						entry.m_key.m_object = m_colObjWrap->getCollisionObject()->getWorldArrayIndex();
+						entry.m_key.m_a = cluster->m_clusterIndex;
+						entry.m_key.m_b = -1;
+						entry.m_joint = pj;
+					}
+					else
+					{
+						psb->m_joints.push_back(pj);
+					}
 					if (m_colObjWrap->getCollisionObject()->isStaticOrKinematicObject())
 					{
 						pj->m_erp *= psb->m_cfg.kSKHR_CL;
@@ -830,7 +844,19 @@ struct btSoftColliders
 					{
 						btSoftBody::CJoint* pj = new (btAlignedAlloc(sizeof(btSoftBody::CJoint), 16)) btSoftBody::CJoint();
 						*pj = joint;
-						bodies[0]->m_joints.push_back(pj);
+						if (m_buffer)
+						{
+							btSoftBody::ContactBuffer::JointEntry& entry = m_buffer->m_joints.expandNonInitializing();
+							entry.m_key.m_body = bodies[0];
+							entry.m_key.m_object = bodies[1]->getWorldArrayIndex();
+							entry.m_key.m_a = cla->m_clusterIndex;
+							entry.m_key.m_b = clb->m_clusterIndex;
+							entry.m_joint = pj;
+						}
+						else
+						{
+							bodies[0]->m_joints.push_back(pj);
+						}
 						pj->m_erp *= btMax(bodies[0]->m_cfg.kSSHR_CL, bodies[1]->m_cfg.kSSHR_CL);
 						pj->m_split *= (bodies[0]->m_cfg.kSS_SPLT_CL + bodies[1]->m_cfg.kSS_SPLT_CL) / 2;
 					}
@@ -893,9 +919,22 @@ struct btSoftColliders
 					c.m_c2 = ima * psb->m_sst.sdt;
 					c.m_c3 = fv.length2() < (dn * fc * dn * fc) ? 0 : 1 - fc;
 					c.m_c4 = m_colObj1Wrap->getCollisionObject()->isStaticOrKinematicObject() ? psb->m_cfg.kKHR : psb->m_cfg.kCHR;
-					psb->m_rcontacts.push_back(c);
-					if (m_rigidBody)
-						m_rigidBody->activate();
+					if (m_buffer)
+					{
+						btSoftBody::ContactBuffer::RContactEntry& entry = m_buffer->m_rcontacts.expandNonInitializing();
+						entry.m_key.m_body = psb;
+						entry.m_key.m_object = c.m_cti.m_colObj->getWorldArrayIndex();
+						entry.m_key.m_a = int(&n - &psb->m_nodes[0]);
+						entry.m_key.m_b = 0;
+						entry.m_contact = c;
+						//rigid bodies are activated when the buffers are merged
+					}
+					else
+					{
+						psb->m_rcontacts.push_back(c);
+						if (m_rigidBody)
+							m_rigidBody->activate();
+					}
 				}
 			}
 		}
@@ -904,6 +943,7 @@ struct btSoftColliders
 		btRigidBody* m_rigidBody;
 		btScalar dynmargin;
 		btScalar stamargin;
+		btSoftBody::ContactBuffer* m_buffer;
 	};
 	//
 	// CollideVF_SS
@@ -947,12 +987,25 @@ struct btSoftColliders
 					c.m_friction = btMax(psb[0]->m_cfg.kDF, psb[1]->m_cfg.kDF);
 					c.m_cfm[0] = ma / ms * psb[0]->m_cfg.kSHR;
 					c.m_cfm[1] = mb / ms * psb[1]->m_cfg.kSHR;
-					psb[0]->m_scontacts.push_back(c);
+					if (m_buffer)
+					{
+						btSoftBody::ContactBuffer::SContactEntry& entry = m_buffer->m_scontacts.expandNonInitializing();
+						entry.m_key.m_body = psb[0];
+						entry.m_key.m_object = psb[1]->getWorldArrayIndex();
+						entry.m_key.m_a = int(node - &psb[0]->m_nodes[0]);
+						entry.m_key.m_b = int(face - &psb[1]->m_faces[0]);
+						entry.m_contact = c;
+					}
+					else
+					{
+						psb[0]->m_scontacts.push_back(c);
+					}
 				}
 			}
 		}
 		btSoftBody* psb[2];
 		btScalar mrg;
+		btSoftBody::ContactBuffer* m_buffer;
 	};
 };
 
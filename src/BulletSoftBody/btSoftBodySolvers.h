@@ -85,6 +85,11 @@ public:
 	/** Process a collision between two soft bodies */
 	virtual void processCollision(btSoftBody *, btSoftBody *) = 0;
 
+	/** Called by the soft body worlds once all collision pairs of a step have been processed */
+	virtual void finishCollisions()
+	{
+	}
+
 	/** Set the number of velocity constraint solver iterations this solver uses. */
 	virtual void setNumberOfPositionIterations(int iterations)
 	{
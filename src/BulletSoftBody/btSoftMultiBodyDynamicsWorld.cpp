@@ -22,6 +22,7 @@ subject to the following restrictions:
 #include "BulletSoftBody/btSoftBodySolvers.h"
 #include "BulletSoftBody/btDefaultSoftBodySolver.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btAllocatorContext.h"
 
 btSoftMultiBodyDynamicsWorld::btSoftMultiBodyDynamicsWorld(
 	btDispatcher* dispatcher,
@@ -104,6 +105,14 @@ void btSoftMultiBodyDynamicsWorld::internalSingleStepSimulation(btScalar timeSte
 	// ///////////////////////////////
 }
 
+void btSoftMultiBodyDynamicsWorld::performDiscreteCollisionDetection()
+{
+	btMultiBodyDynamicsWorld::performDiscreteCollisionDetection();
+
+	// let the solver merge the soft body contacts found on other threads
+	m_softBodySolver->finishCollisions();
+}
+
 void btSoftMultiBodyDynamicsWorld::solveSoftBodiesConstraints(btScalar timeStep)
 {
 	BT_PROFILE("solveSoftConstraints");
@@ -119,6 +128,7 @@ void btSoftMultiBodyDynamicsWorld::solveSoftBodiesConstraints(btScalar timeStep)
 
 void btSoftMultiBodyDynamicsWorld::addSoftBody(btSoftBody* body, int collisionFilterGroup, int collisionFilterMask)
 {
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 	m_softBodies.push_back(body);
 
 	// Set the soft body solver that will deal with this body
@@ -22,6 +22,7 @@ subject to the following restrictions:
 #include "btSoftBodySolvers.h"
 #include "btDefaultSoftBodySolver.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btAllocatorContext.h"
 
 btSoftRigidDynamicsWorld::btSoftRigidDynamicsWorld(
 	btDispatcher* dispatcher,
@@ -104,6 +105,14 @@ void btSoftRigidDynamicsWorld::internalSingleStepSimulation(btScalar timeStep)
 	// ///////////////////////////////
 }
 
+void btSoftRigidDynamicsWorld::performDiscreteCollisionDetection()
+{
+	btDiscreteDynamicsWorld::performDiscreteCollisionDetection();
+
+	// let the solver merge the soft body contacts found on other threads
+	m_softBodySolver->finishCollisions();
+}
+
 void btSoftRigidDynamicsWorld::solveSoftBodiesConstraints(btScalar timeStep)
 {
 	BT_PROFILE("solveSoftConstraints");
@@ -119,6 +128,7 @@ void btSoftRigidDynamicsWorld::solveSoftBodiesConstraints(btScalar timeStep)
 
 void btSoftRigidDynamicsWorld::addSoftBody(btSoftBody* body, int collisionFilterGroup, int collisionFilterMask)
 {
+	btAllocatorContextScope allocatorScope(m_allocatorContext);
 	m_softBodies.push_back(body);
 
 	// Set the soft body solver that will deal with this body
@@ -51,6 +51,8 @@ public:
 
 	virtual void debugDrawWorld();
 
+	virtual void performDiscreteCollisionDetection();
+
 	void addSoftBody(btSoftBody* body, int collisionFilterGroup = btBroadphaseProxy::DefaultFilter, int collisionFilterMask = btBroadphaseProxy::AllFilter);
 
 	void removeSoftBody(btSoftBody* body);
@@ -24,9 +24,9 @@ subject to the following restrictions:
 #define USE_PERSISTENT_CONTACTS 1
 
 btSoftSoftCollisionAlgorithm::btSoftSoftCollisionAlgorithm(btPersistentManifold* /*mf*/, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* /*obj0*/, const btCollisionObjectWrapper* /*obj1*/)
-	: btCollisionAlgorithm(ci)
-//m_ownManifold(false),
-//m_manifoldPtr(mf)
+	: btCollisionAlgorithm(ci),
+	  m_ownManifold(false),
+	  m_manifoldPtr(0)
 {
 }
 
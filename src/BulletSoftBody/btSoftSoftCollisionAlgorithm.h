@@ -35,7 +35,7 @@ class btSoftSoftCollisionAlgorithm : public btCollisionAlgorithm
 
 public:
 	btSoftSoftCollisionAlgorithm(const btCollisionAlgorithmConstructionInfo& ci)
-		: btCollisionAlgorithm(ci) {}
+		: btCollisionAlgorithm(ci), m_ownManifold(false), m_manifoldPtr(0) {}
 
 	virtual void processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
 
@@ -19,6 +19,8 @@ subject to the following restrictions:
 
 #include "BulletCollision/CollisionDispatch/btCollisionObject.h"
 #include "BulletCollision/NarrowPhaseCollision/btGjkEpa2.h"
+#include "LinearMath/btThreads.h"
+#include <string.h>  //for memset and memcpy
 
 // Modified Paul Hsieh hash
 template <const int DWORDLEN>
@@ -49,6 +51,10 @@ struct btSparseSdf
 	//
 	// Inner types
 	//
+	enum
+	{
+		LOCKCOUNT = 64  // Stripes of the cell hash, so that Evaluate can be called from several threads
+	};
 	struct IntFrac
 	{
 		int b;
@@ -75,6 +81,8 @@ struct btSparseSdf
 	int m_clampCells;
 	int nprobes;
 	int nqueries;
+	btSpinMutex m_cellLocks[LOCKCOUNT];  // Lock of cells[i] is m_cellLocks[i%LOCKCOUNT]
+	btSpinMutex m_cellCountLock;         // Guards ncells
 
 	//
 	// Methods
@@ -170,6 +178,8 @@ struct btSparseSdf
 		return (refcount);
 	}
 	//
+	// Thread safe, Reset, GarbageCollect and RemoveReferences are not
+	// (nqueries and nprobes may miss counts when called from several threads)
 	btScalar Evaluate(const btVector3& x,
 					  const btCollisionShape* shape,
 					  btVector3& normal,
@@ -181,7 +191,10 @@ struct btSparseSdf
 		const IntFrac iy = Decompose(scx.y());
 		const IntFrac iz = Decompose(scx.z());
 		const unsigned h = Hash(ix.b, iy.b, iz.b, shape);
-		Cell*& root = cells[static_cast<int>(h % cells.size())];
+		const int bucket = static_cast<int>(h % cells.size());
+		btSpinMutex* lock = &m_cellLocks[bucket % LOCKCOUNT];
+		btMutexLock(lock);
+		Cell*& root = cells[bucket];
 		Cell* c = root;
 		++nqueries;
 		while (c)
@@ -203,14 +216,38 @@ struct btSparseSdf
 		if (!c)
 		{
 			++nprobes;
-			++ncells;
+			btMutexLock(&m_cellCountLock);
+			const bool clamp = ++ncells > m_clampCells;
+			if (clamp)
+			{
+				--ncells;
+			}
+			btMutexUnlock(&m_cellCountLock);
 			//int sz = sizeof(Cell);
-			if (ncells > m_clampCells)
+			if (clamp)
 			{
 				static int numResets = 0;
 				numResets++;
 				//				printf("numResets=%d\n",numResets);
-				Reset();
+				// other threads may be reading cells, reset with all the stripes locked
+				btMutexUnlock(lock);
+				for (int i = 0; i < LOCKCOUNT; ++i)
+				{
+					btMutexLock(&m_cellLocks[i]);
+				}
+				if (ncells >= m_clampCells)
+				{
+					Reset();
+				}
+				// the new cell is counted here rather than clamped again, so a limit of 0 cells still makes progress
+				++ncells;
+				for (int i = 0; i < LOCKCOUNT; ++i)
+				{
+					if (&m_cellLocks[i] != lock)
+					{
+						btMutexUnlock(&m_cellLocks[i]);
+					}
+				}
 			}
 
 			c = new Cell();
@@ -234,6 +271,7 @@ struct btSparseSdf
 							  c->d[o[0] + 1][o[1] + 0][o[2] + 1],
 							  c->d[o[0] + 1][o[1] + 1][o[2] + 1],
 							  c->d[o[0] + 0][o[1] + 1][o[2] + 1]};
+		btMutexUnlock(lock);
 		/* Normal	*/
 #if 1
 		const btScalar gx[] = {d[1] - d[0], d[2] - d[3],
@@ -327,14 +365,19 @@ struct btSparseSdf
 		};
 
 		btS myset;
+		//the padding before p is hashed too, clear it so that a cell always gets the same hash
+		memset(&myset, 0, sizeof(myset));
 
 		myset.x = x;
 		myset.y = y;
 		myset.z = z;
 		myset.p = (void*)shape;
-		const void* ptr = &myset;
 
-		unsigned int result = HsiehHash<sizeof(btS) / 4>(ptr);
+		//HsiehHash reads shorts, copy the key so that the reads do not alias myset
+		unsigned short data[sizeof(btS) / 2];
+		memcpy(data, &myset, sizeof(myset));
+
+		unsigned int result = HsiehHash<sizeof(btS) / 4>(data);
 
 		return result;
 	}
@@ -14,6 +14,8 @@ subject to the following restrictions:
 */
 
 #include "btAlignedAllocator.h"
+#include "btThreads.h"
+#include "btAllocatorContext.h"
 
 #ifdef BT_DEBUG_MEMORY_ALLOCATIONS
 int gNumAlignedAllocs = 0;
@@ -34,6 +36,80 @@ static void btFreeDefault(void *ptr)
 static btAllocFunc *sAllocFunc = btAllocDefault;
 static btFreeFunc *sFreeFunc = btFreeDefault;
 
+static size_t sNumAllocations = 0;
+static size_t sNumAllocatedBytes = 0;
+
+//the counters are updated with atomic adds, so allocations on different threads do not serialize on a lock
+static inline void btCountAllocation(size_t size)
+{
+	btAtomicAdd(&sNumAllocations, 1);
+	btAtomicAdd(&sNumAllocatedBytes, size);
+}
+
+void btAlignedAllocGetCounters(size_t *numAllocations, size_t *numBytes)
+{
+	*numAllocations = sNumAllocations;
+	*numBytes = sNumAllocatedBytes;
+}
+
+btAllocatorContext::btAllocatorContext()
+	: m_numAllocations(0),
+	  m_numLiveBlocks(0),
+	  m_liveBytes(0),
+	  m_peakBytes(0)
+{
+}
+
+btAllocatorContext::~btAllocatorContext()
+{
+	btAssert(m_numLiveBlocks == 0);  // blocks of this context are still in use
+}
+
+void *btAllocatorContext::allocate(size_t size)
+{
+	return sAllocFunc(size);
+}
+
+void btAllocatorContext::deallocate(void *ptr)
+{
+	sFreeFunc(ptr);
+}
+
+void *btAllocatorContext::allocateTracked(size_t size)
+{
+	void *ptr = allocate(size);
+	if (ptr)
+	{
+		btMutexLock(&m_mutex);
+		++m_numAllocations;
+		++m_numLiveBlocks;
+		m_liveBytes += size;
+		if (m_liveBytes > m_peakBytes)
+		{
+			m_peakBytes = m_liveBytes;
+		}
+		btMutexUnlock(&m_mutex);
+	}
+	return ptr;
+}
+
+void btAllocatorContext::deallocateTracked(void *ptr, size_t size)
+{
+	btMutexLock(&m_mutex);
+	btAssert(m_numLiveBlocks > 0 && m_liveBytes >= size);
+	--m_numLiveBlocks;
+	m_liveBytes -= size;
+	btMutexUnlock(&m_mutex);
+	deallocate(ptr);
+}
+
+void btAllocatorContext::resetPeakBytes()
+{
+	btMutexLock(&m_mutex);
+	m_peakBytes = m_liveBytes;
+	btMutexUnlock(&m_mutex);
+}
+
 #if defined(BT_HAS_ALIGNED_ALLOCATOR)
 #include <malloc.h>
 static void *btAlignedAllocDefault(size_t size, int alignment)
@@ -59,15 +135,30 @@ static inline void btAlignedFreeDefault(void *ptr)
 }
 #else
 
+//the real pointer is stored in front of the aligned pointer. A block from an allocator context sets the lowest bit
+//of the real pointer and also stores the context and its size, so blocks without a context keep the one pointer header
 static inline void *btAlignedAllocDefault(size_t size, int alignment)
 {
 	void *ret;
 	char *real;
-	real = (char *)sAllocFunc(size + sizeof(void *) + (alignment - 1));
+	btAllocatorContext *context = btGetCurrentAllocatorContext();
+	size_t header = context ? 3 * sizeof(void *) : sizeof(void *);
+	size_t realSize = size + header + (alignment - 1);
+	real = context ? (char *)context->allocateTracked(realSize) : (char *)sAllocFunc(realSize);
 	if (real)
 	{
-		ret = btAlignPointer(real + sizeof(void *), alignment);
-		*((void **)(ret)-1) = (void *)(real);
+		btAssert(((size_t)real & 1) == 0);
+		ret = btAlignPointer(real + header, alignment);
+		if (context)
+		{
+			*((void **)(ret)-1) = (void *)(real + 1);
+			*((void **)(ret)-2) = (void *)(context);
+			*((size_t *)(ret)-3) = realSize;
+		}
+		else
+		{
+			*((void **)(ret)-1) = (void *)(real);
+		}
 	}
 	else
 	{
@@ -83,7 +174,15 @@ static inline void btAlignedFreeDefault(void *ptr)
 	if (ptr)
 	{
 		real = *((void **)(ptr)-1);
-		sFreeFunc(real);
+		if ((size_t)real & 1)
+		{
+			btAllocatorContext *context = (btAllocatorContext *)*((void **)(ptr)-2);
+			context->deallocateTracked((char *)real - 1, *((size_t *)(ptr)-3));
+		}
+		else
+		{
+			sFreeFunc(real);
+		}
 	}
 }
 #endif
@@ -162,6 +261,7 @@ void *btAlignedAllocInternal(size_t size, int alignment, int line, char *filenam
 
 	gTotalBytesAlignedAllocs += size;
 	gNumAlignedAllocs++;
+	btCountAllocation(size);
 
 	int sz4prt = 4 * sizeof(void *);
 
@@ -244,6 +344,7 @@ void btAlignedFreeInternal(void *ptr, int line, char *filename)
 void *btAlignedAllocInternal(size_t size, int alignment)
 {
 	void *ptr;
+	btCountAllocation(size);
 	ptr = sAlignedAllocFunc(size, alignment);
 	//	printf("btAlignedAllocInternal %d, %x\n",size,ptr);
 	return ptr;
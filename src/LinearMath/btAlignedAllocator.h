@@ -59,6 +59,11 @@ void btAlignedAllocSetCustom(btAllocFunc* allocFunc, btFreeFunc* freeFunc);
 ///If the developer has already an custom aligned allocator, then btAlignedAllocSetCustomAligned can be used. The default aligned allocator pre-allocates extra memory using the non-aligned allocator, and instruments it.
 void btAlignedAllocSetCustomAligned(btAlignedAllocFunc* allocFunc, btAlignedFreeFunc* freeFunc);
 
+///Number of btAlignedAlloc calls and bytes requested since startup, over all threads.
+///Take the difference between two calls to measure the heap traffic of a simulation step, see btDiscreteDynamicsWorld::getLastStepHeapBytes
+///The counters are not read atomically together, while other threads allocate they may be slightly apart
+void btAlignedAllocGetCounters(size_t* numAllocations, size_t* numBytes);
+
 ///The btAlignedAllocator is a portable class for aligned memory allocations.
 ///Default implementations for unaligned and aligned allocations can be overridden by a custom allocator using btAlignedAllocSetCustom and btAlignedAllocSetCustomAligned.
 template <typename T, unsigned Alignment>
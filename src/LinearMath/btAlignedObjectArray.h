@@ -38,6 +38,13 @@ subject to the following restrictions:
 #include <new>  //for placement new
 #endif          //BT_USE_PLACEMENT_NEW
 
+///With C++11, arrays can be moved, and elements are moved instead of copied when the array grows.
+///The interface stays the same for C++03 compilers.
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define BT_USE_MOVE_SEMANTICS 1
+#include <utility>  //for std::move
+#endif              //BT_USE_MOVE_SEMANTICS
+
 // The register keyword is deprecated in C++11 so don't use it.
 #if __cplusplus > 199711L
 #define BT_REGISTER
@@ -71,6 +78,19 @@ private:
 	SIMD_FORCE_INLINE btAlignedObjectArray<T>& operator=(const btAlignedObjectArray<T>& other);
 #endif  //BT_ALLOW_ARRAY_COPY_OPERATOR
 
+#ifdef BT_USE_MOVE_SEMANTICS
+public:
+	SIMD_FORCE_INLINE btAlignedObjectArray<T>& operator=(btAlignedObjectArray<T>&& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			moveFromArray(other);
+		}
+		return *this;
+	}
+#endif  //BT_USE_MOVE_SEMANTICS
+
 protected:
 	SIMD_FORCE_INLINE int allocSize(int size)
 	{
@@ -87,6 +107,18 @@ protected:
 #endif  //BT_USE_PLACEMENT_NEW
 	}
 
+	///like copy, but the elements may be moved from, used when the array grows
+	SIMD_FORCE_INLINE void relocate(int start, int end, T* dest)
+	{
+#if defined(BT_USE_MOVE_SEMANTICS) && defined(BT_USE_PLACEMENT_NEW)
+		int i;
+		for (i = start; i < end; ++i)
+			new (&dest[i]) T(std::move(m_data[i]));
+#else
+		copy(start, end, dest);
+#endif
+	}
+
 	SIMD_FORCE_INLINE void init()
 	{
 		//PCK: added this line
@@ -124,6 +156,32 @@ protected:
 		}
 	}
 
+#ifdef BT_USE_MOVE_SEMANTICS
+	///takes the memory of the other array if it owns it and this array has no room,
+	///otherwise the elements are moved one by one. this array must be empty
+	void moveFromArray(btAlignedObjectArray& otherArray)
+	{
+		btAssert(m_size == 0);
+		if (otherArray.m_ownsMemory && (!m_data || otherArray.m_size > m_capacity))
+		{
+			deallocate();
+			m_ownsMemory = true;
+			m_data = otherArray.m_data;
+			m_size = otherArray.m_size;
+			m_capacity = otherArray.m_capacity;
+			otherArray.init();
+		}
+		else
+		{
+			int otherSize = otherArray.size();
+			reserve(otherSize);
+			otherArray.relocate(0, otherSize, m_data);
+			m_size = otherSize;
+			otherArray.resize(0);
+		}
+	}
+#endif  //BT_USE_MOVE_SEMANTICS
+
 public:
 	btAlignedObjectArray()
 	{
@@ -139,11 +197,16 @@ public:
 	btAlignedObjectArray(const btAlignedObjectArray& otherArray)
 	{
 		init();
+		copyFromArray(otherArray);
+	}
 
-		int otherSize = otherArray.size();
-		resize(otherSize);
-		otherArray.copy(0, otherSize, m_data);
+#ifdef BT_USE_MOVE_SEMANTICS
+	btAlignedObjectArray(btAlignedObjectArray&& otherArray)
+	{
+		init();
+		moveFromArray(otherArray);
 	}
+#endif  //BT_USE_MOVE_SEMANTICS
 
 	/// return the number of elements in the array
 	SIMD_FORCE_INLINE int size() const
@@ -278,6 +341,25 @@ public:
 		m_size++;
 	}
 
+#ifdef BT_USE_MOVE_SEMANTICS
+	SIMD_FORCE_INLINE void push_back(T&& _Val)
+	{
+		const BT_REGISTER int sz = size();
+		if (sz == capacity())
+		{
+			reserve(allocSize(size()));
+		}
+
+#ifdef BT_USE_PLACEMENT_NEW
+		new (&m_data[m_size]) T(std::move(_Val));
+#else
+		m_data[size()] = std::move(_Val);
+#endif  //BT_USE_PLACEMENT_NEW
+
+		m_size++;
+	}
+#endif  //BT_USE_MOVE_SEMANTICS
+
 	/// return the pre-allocated (reserved) elements, this is at least as large as the total number of elements,see size() and reserve()
 	SIMD_FORCE_INLINE int capacity() const
 	{
@@ -290,7 +372,7 @@ public:
 		{  // not enough room, reallocate
 			T* s = (T*)allocate(_Count);
 
-			copy(0, size(), s);
+			relocate(0, size(), s);
 
 			destroy(0, size());
 
@@ -393,6 +475,10 @@ public:
 		memcpy(temp, &m_data[index0], sizeof(T));
 		memcpy(&m_data[index0], &m_data[index1], sizeof(T));
 		memcpy(&m_data[index1], temp, sizeof(T));
+#elif defined(BT_USE_MOVE_SEMANTICS)
+		T temp = std::move(m_data[index0]);
+		m_data[index0] = std::move(m_data[index1]);
+		m_data[index1] = std::move(temp);
 #else
 		T temp = m_data[index0];
 		m_data[index0] = m_data[index1];
@@ -500,11 +586,140 @@ public:
 		m_capacity = capacity;
 	}
 
+	///the elements are copy constructed, the previous ones are destroyed first
 	void copyFromArray(const btAlignedObjectArray& otherArray)
 	{
+		if (this == &otherArray)
+		{
+			return;
+		}
 		int otherSize = otherArray.size();
-		resize(otherSize);
+		resize(0);
+		reserve(otherSize);
 		otherArray.copy(0, otherSize, m_data);
+		m_size = otherSize;
+	}
+};
+
+///btSmallAlignedObjectArray keeps up to N elements inside the object, so a local array that stays small,
+///like a traversal stack, does not touch the heap. It moves to heap memory when it grows beyond N,
+///and clear() returns to the inline storage. Use it for locals and short lived objects, it is N elements larger.
+template <typename T, int N>
+class btSmallAlignedObjectArray : public btAlignedObjectArray<T>
+{
+	// ATTRIBUTE_ALIGNED16 is empty on some platforms, the other members keep the storage aligned for pointers and doubles
+	union btInlineStorage
+	{
+		char m_bytes[N * sizeof(T)];
+		double m_alignDouble;
+		void* m_alignPointer;
+	};
+	ATTRIBUTE_ALIGNED16(btInlineStorage m_storage);
+
+	SIMD_FORCE_INLINE void useStorage()
+	{
+		this->initializeFromBuffer(m_storage.m_bytes, 0, N);
+	}
+
+	//after its heap memory was taken by a move
+	SIMD_FORCE_INLINE void reuseStorage()
+	{
+		if (this->capacity() == 0)
+		{
+			useStorage();
+		}
+	}
+
+public:
+	btSmallAlignedObjectArray()
+	{
+		useStorage();
+	}
+
+	btSmallAlignedObjectArray(const btAlignedObjectArray<T>& otherArray)
+	{
+		useStorage();
+		this->copyFromArray(otherArray);
+	}
+
+	btSmallAlignedObjectArray(const btSmallAlignedObjectArray& otherArray)
+		: btAlignedObjectArray<T>()
+	{
+		useStorage();
+		this->copyFromArray(otherArray);
+	}
+
+	~btSmallAlignedObjectArray()
+	{
+		btAlignedObjectArray<T>::clear();
+	}
+
+	btSmallAlignedObjectArray& operator=(const btAlignedObjectArray<T>& otherArray)
+	{
+		if (this != &otherArray)
+		{
+			this->copyFromArray(otherArray);
+		}
+		return *this;
+	}
+
+	btSmallAlignedObjectArray& operator=(const btSmallAlignedObjectArray& otherArray)
+	{
+		if (this != &otherArray)
+		{
+			this->copyFromArray(otherArray);
+		}
+		return *this;
+	}
+
+#ifdef BT_USE_MOVE_SEMANTICS
+	btSmallAlignedObjectArray(btAlignedObjectArray<T>&& otherArray)
+	{
+		useStorage();
+		this->moveFromArray(otherArray);
+	}
+
+	btSmallAlignedObjectArray(btSmallAlignedObjectArray&& otherArray)
+		: btAlignedObjectArray<T>()
+	{
+		useStorage();
+		this->moveFromArray(otherArray);
+		otherArray.reuseStorage();
+	}
+
+	btSmallAlignedObjectArray& operator=(btAlignedObjectArray<T>&& otherArray)
+	{
+		if (this != &otherArray)
+		{
+			clear();
+			this->moveFromArray(otherArray);
+		}
+		return *this;
+	}
+
+	btSmallAlignedObjectArray& operator=(btSmallAlignedObjectArray&& otherArray)
+	{
+		if (this != &otherArray)
+		{
+			clear();
+			this->moveFromArray(otherArray);
+			otherArray.reuseStorage();
+		}
+		return *this;
+	}
+#endif  //BT_USE_MOVE_SEMANTICS
+
+	///destroys the elements and frees heap memory, the array uses its inline storage again
+	SIMD_FORCE_INLINE void clear()
+	{
+		btAlignedObjectArray<T>::clear();
+		useStorage();
+	}
+
+	SIMD_FORCE_INLINE bool usesInlineStorage() const
+	{
+		// heap memory is only used for more than N elements
+		return this->capacity() <= N;
 	}
 };
 
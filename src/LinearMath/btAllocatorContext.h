@@ -0,0 +1,104 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_ALLOCATOR_CONTEXT_H
+#define BT_ALLOCATOR_CONTEXT_H
+
+#include "btScalar.h"
+#include "btThreads.h"
+
+///btAllocatorContext is a memory source for btAlignedAlloc that is scoped to a thread instead of the whole process.
+///While a context is current on a thread, the default aligned allocator takes its raw memory from the context, and
+///every block remembers its context so btAlignedFree returns it there, whichever thread or context is current then.
+///Override allocate and deallocate to use a NUMA-local or arena allocator per world. The context keeps track of the
+///live blocks and bytes, so a world's memory can be attributed, and it must outlive all of its blocks.
+///Contexts are ignored with a custom btAlignedAllocSetCustomAligned allocator and with BT_DEBUG_MEMORY_ALLOCATIONS.
+///They are also ignored when BT_HAS_ALIGNED_ALLOCATOR is defined (off by default, see btScalar.h) and on __CELLOS_LV2__,
+///btAlignedAlloc then calls _aligned_malloc or memalign directly and its blocks have no header that could record a context.
+class btAllocatorContext
+{
+	btSpinMutex m_mutex;  // only used if BT_THREADSAFE
+	size_t m_numAllocations;
+	size_t m_numLiveBlocks;
+	size_t m_liveBytes;
+	size_t m_peakBytes;
+
+	btAllocatorContext(const btAllocatorContext&);
+	btAllocatorContext& operator=(const btAllocatorContext&);
+
+public:
+	btAllocatorContext();
+
+	virtual ~btAllocatorContext();
+
+	///raw memory, alignment is handled by the caller. the default uses the btAlignedAllocSetCustom allocator, or malloc
+	virtual void* allocate(size_t size);
+
+	///the default uses the btAlignedAllocSetCustom free function, or free
+	virtual void deallocate(void* ptr);
+
+	///allocate and deallocate with bookkeeping, called by btAlignedAlloc and btAlignedFree
+	void* allocateTracked(size_t size);
+	void deallocateTracked(void* ptr, size_t size);
+
+	size_t getNumAllocations() const
+	{
+		return m_numAllocations;
+	}
+
+	size_t getNumLiveBlocks() const
+	{
+		return m_numLiveBlocks;
+	}
+
+	size_t getLiveBytes() const
+	{
+		return m_liveBytes;
+	}
+
+	size_t getPeakBytes() const
+	{
+		return m_peakBytes;
+	}
+
+	void resetPeakBytes();
+};
+
+///the context of the calling thread, 0 means the global allocator
+btAllocatorContext* btGetCurrentAllocatorContext();
+void btSetCurrentAllocatorContext(btAllocatorContext* context);
+
+///makes a context current on this thread until the end of the scope, a null context keeps the current one
+class btAllocatorContextScope
+{
+	btAllocatorContext* m_previous;
+
+public:
+	explicit btAllocatorContextScope(btAllocatorContext* context)
+		: m_previous(btGetCurrentAllocatorContext())
+	{
+		if (context)
+		{
+			btSetCurrentAllocatorContext(context);
+		}
+	}
+
+	~btAllocatorContextScope()
+	{
+		btSetCurrentAllocatorContext(m_previous);
+	}
+};
+
+#endif  //BT_ALLOCATOR_CONTEXT_H
@@ -0,0 +1,137 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btFrameArena.h"
+#include "btAlignedAllocator.h"
+#include "btMinMax.h"
+
+btFrameArena::btFrameArena(size_t blockSize)
+	: m_blockSize(blockSize),
+	  m_highWaterMark(0)
+{
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); ++i)
+	{
+		btSubArena& arena = m_subArenas[i];
+		arena.m_blocks = 0;
+		arena.m_top = 0;
+		arena.m_end = 0;
+		arena.m_usedBytes = 0;
+		arena.m_capacity = 0;
+	}
+}
+
+btFrameArena::~btFrameArena()
+{
+	releaseMemory();
+}
+
+void btFrameArena::addBlock(btSubArena& arena, size_t minSize)
+{
+	// the block header is padded to 16 bytes so the data that follows is 16 byte aligned
+	const size_t headerSize = (sizeof(btArenaBlock) + 15) & ~size_t(15);
+	size_t size = btMax(m_blockSize, minSize);
+	btArenaBlock* block = (btArenaBlock*)btAlignedAlloc(headerSize + size, 16);
+	block->m_next = arena.m_blocks;
+	block->m_size = size;
+	arena.m_blocks = block;
+	arena.m_top = (unsigned char*)block + headerSize;
+	arena.m_end = arena.m_top + size;
+	arena.m_capacity += size;
+}
+
+void btFrameArena::freeBlocks(btSubArena& arena)
+{
+	while (arena.m_blocks)
+	{
+		btArenaBlock* block = arena.m_blocks;
+		arena.m_blocks = block->m_next;
+		btAlignedFree(block);
+	}
+	arena.m_top = 0;
+	arena.m_end = 0;
+	arena.m_capacity = 0;
+}
+
+void* btFrameArena::allocate(size_t size, int alignment)
+{
+#if BT_THREADSAFE
+	btSubArena& arena = m_subArenas[btGetCurrentThreadIndex()];
+#else
+	btSubArena& arena = m_subArenas[0];
+#endif
+	unsigned char* ptr = arena.m_top ? btAlignPointer(arena.m_top, alignment) : 0;
+	if (ptr == 0 || ptr + size > arena.m_end)
+	{
+		addBlock(arena, size + alignment);
+		ptr = btAlignPointer(arena.m_top, alignment);
+	}
+	arena.m_usedBytes += (ptr + size) - arena.m_top;
+	arena.m_top = ptr + size;
+	return ptr;
+}
+
+void btFrameArena::reset()
+{
+	m_highWaterMark = btMax(m_highWaterMark, getUsedBytes());
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); ++i)
+	{
+		btSubArena& arena = m_subArenas[i];
+		if (arena.m_blocks == 0)
+		{
+			continue;
+		}
+		if (arena.m_blocks->m_next)
+		{
+			// the step needed more than one block, use a single block of the total size from now on
+			size_t capacity = arena.m_capacity;
+			freeBlocks(arena);
+			addBlock(arena, capacity);
+		}
+		else
+		{
+			arena.m_top = arena.m_end - arena.m_blocks->m_size;
+		}
+		arena.m_usedBytes = 0;
+	}
+}
+
+void btFrameArena::releaseMemory()
+{
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); ++i)
+	{
+		freeBlocks(m_subArenas[i]);
+		m_subArenas[i].m_usedBytes = 0;
+	}
+}
+
+size_t btFrameArena::getUsedBytes() const
+{
+	size_t usedBytes = 0;
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); ++i)
+	{
+		usedBytes += m_subArenas[i].m_usedBytes;
+	}
+	return usedBytes;
+}
+
+size_t btFrameArena::getCapacityBytes() const
+{
+	size_t capacity = 0;
+	for (int i = 0; i < int(BT_MAX_THREAD_COUNT); ++i)
+	{
+		capacity += m_subArenas[i].m_capacity;
+	}
+	return capacity;
+}
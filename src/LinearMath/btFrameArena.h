@@ -0,0 +1,90 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2018 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_FRAME_ARENA_H
+#define BT_FRAME_ARENA_H
+
+#include "btScalar.h"
+#include "btAlignedObjectArray.h"
+#include "btThreads.h"
+
+///btFrameArena is a linear allocator for temporary data that lives until the end of a simulation step.
+///Each thread allocates from its own sub-arena without locking. Memory is never freed individually,
+///reset releases everything at once and merges the blocks of a sub-arena into a single block,
+///so after a few steps the arena serves all temporary data without touching the heap.
+///reset must not be called while other threads allocate, btDiscreteDynamicsWorld calls it at the end of performDiscreteCollisionDetection.
+class btFrameArena
+{
+	struct btArenaBlock
+	{
+		btArenaBlock* m_next;
+		size_t m_size;
+	};
+
+	struct btSubArena
+	{
+		btArenaBlock* m_blocks;  // the block allocations come from is first
+		unsigned char* m_top;
+		unsigned char* m_end;
+		size_t m_usedBytes;
+		size_t m_capacity;
+		// keep the sub-arenas of different threads on different cache lines
+		char m_padding[64 - 3 * sizeof(void*) - 2 * sizeof(size_t)];
+	};
+
+	btSubArena m_subArenas[BT_MAX_THREAD_COUNT];
+	size_t m_blockSize;
+	size_t m_highWaterMark;
+
+	void addBlock(btSubArena& arena, size_t minSize);
+	void freeBlocks(btSubArena& arena);
+
+public:
+	btFrameArena(size_t blockSize = 64 * 1024);
+
+	~btFrameArena();
+
+	///returns memory of the calling thread's sub-arena that stays valid until the next reset
+	void* allocate(size_t size, int alignment = 16);
+
+	///let array use arena memory for its first capacity elements. The array must be empty,
+	///if it grows beyond capacity it moves to the heap as usual
+	template <typename T>
+	void initializeArray(btAlignedObjectArray<T>& array, int capacity)
+	{
+		btAssert(array.capacity() == 0);
+		array.initializeFromBuffer(allocate(sizeof(T) * capacity, 16), 0, capacity);
+	}
+
+	///invalidate all memory handed out since the last reset
+	void reset();
+
+	///free all blocks, the arena grows again on the next allocations
+	void releaseMemory();
+
+	///bytes handed out since the last reset, over all threads
+	size_t getUsedBytes() const;
+
+	///bytes of all blocks, over all threads
+	size_t getCapacityBytes() const;
+
+	///largest getUsedBytes seen by reset
+	size_t getHighWaterMark() const
+	{
+		return m_highWaterMark;
+	}
+};
+
+#endif  //BT_FRAME_ARENA_H
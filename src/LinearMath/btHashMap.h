@@ -213,161 +213,266 @@ public:
 	}
 };
 
+#if defined(BT_USE_SSE) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BT_HASH_MAP_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+///control bytes are scanned one group at a time
+#define BT_HASH_GROUP_SIZE 16
+#define BT_HASH_EMPTY 0x80
+
+///index of the lowest set bit, mask must not be zero
+SIMD_FORCE_INLINE int btHashLowestBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#elif defined(__GNUC__)
+	return __builtin_ctz(mask);
+#else
+	int index = 0;
+	while (!(mask & 1))
+	{
+		mask >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
 ///The btHashMap template class implements a generic and lightweight hashmap.
+///Keys and values are stored densely in insertion order, and indexed by an open addressing table with linear
+///probing. Each slot has a control byte with 7 bits of the hash, or BT_HASH_EMPTY, and 16 control bytes are
+///compared at once, so a lookup rarely touches a key that doesn't match. Removal shifts the following slots back
+///instead of leaving tombstones, and moves the last pair into the removed spot, like the chained version did.
 ///A basic sample of how to use btHashMap is located in Demos\BasicDemo\main.cpp
 template <class Key, class Value>
 class btHashMap
 {
 protected:
+	//the first group of control bytes is repeated after the last slot, so a group can start at any slot
+	btAlignedObjectArray<unsigned char> m_control;
+	//index of the pair in each slot, BT_HASH_NULL for an empty slot
 	btAlignedObjectArray<int> m_hashTable;
-	btAlignedObjectArray<int> m_next;
+	btAlignedObjectArray<unsigned int> m_hashValues;
 
 	btAlignedObjectArray<Value> m_valueArray;
 	btAlignedObjectArray<Key> m_keyArray;
 
-	void growTables(const Key& /*key*/)
+	static unsigned char hashTag(unsigned int hash)
 	{
-		int newCapacity = m_valueArray.capacity();
+		return (unsigned char)(hash >> 25);
+	}
 
-		if (m_hashTable.size() < newCapacity)
+	//bit i of match is set if the control byte of slot pos + i equals tag, bit i of empty if it is BT_HASH_EMPTY
+	SIMD_FORCE_INLINE void matchGroup(int pos, unsigned char tag, unsigned int& match, unsigned int& empty) const
+	{
+#ifdef BT_HASH_MAP_SSE2
+		__m128i group = _mm_loadu_si128((const __m128i*)&m_control[pos]);
+		match = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+		empty = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)BT_HASH_EMPTY)));
+#else
+		match = 0;
+		empty = 0;
+		for (int i = 0; i < BT_HASH_GROUP_SIZE; i++)
 		{
-			//grow hashtable and next table
-			int curHashtableSize = m_hashTable.size();
+			if (m_control[pos + i] == tag)
+			{
+				match |= 1u << i;
+			}
+			if (m_control[pos + i] == BT_HASH_EMPTY)
+			{
+				empty |= 1u << i;
+			}
+		}
+#endif
+	}
 
-			m_hashTable.resize(newCapacity);
-			m_next.resize(newCapacity);
+	void setControl(int slot, unsigned char control)
+	{
+		m_control[slot] = control;
+		if (slot < BT_HASH_GROUP_SIZE - 1)
+		{
+			m_control[m_hashTable.size() + slot] = control;
+		}
+	}
 
-			int i;
+	//returns the slot of the key, or BT_HASH_NULL and the empty slot that ends the probe
+	int probe(const Key& key, unsigned int hash, int& emptySlot) const
+	{
+		const int mask = m_hashTable.size() - 1;
+		int pos = hash & mask;
 
-			for (i = 0; i < newCapacity; ++i)
+		const unsigned char tag = hashTag(hash);
+		for (;;)
+		{
+			unsigned int match, empty;
+			matchGroup(pos, tag, match, empty);
+			if (empty)
 			{
-				m_hashTable[i] = BT_HASH_NULL;
+				//slots after the first empty one are not part of this probe
+				match &= (empty & (0u - empty)) - 1;
 			}
-			for (i = 0; i < newCapacity; ++i)
+			while (match)
 			{
-				m_next[i] = BT_HASH_NULL;
+				int slot = (pos + btHashLowestBit(match)) & mask;
+				if (key.equals(m_keyArray[m_hashTable[slot]]))
+				{
+					return slot;
+				}
+				match &= match - 1;
 			}
-
-			for (i = 0; i < curHashtableSize; i++)
+			if (empty)
 			{
-				//const Value& value = m_valueArray[i];
-				//const Key& key = m_keyArray[i];
-
-				int hashValue = m_keyArray[i].getHash() & (m_valueArray.capacity() - 1);  // New hash value with new mask
-				m_next[i] = m_hashTable[hashValue];
-				m_hashTable[hashValue] = i;
+				emptySlot = (pos + btHashLowestBit(empty)) & mask;
+				return BT_HASH_NULL;
 			}
+			pos = (pos + BT_HASH_GROUP_SIZE) & mask;
 		}
 	}
 
-public:
-	void insert(const Key& key, const Value& value)
+	void insertSlot(int index, unsigned int hash)
 	{
-		int hash = key.getHash() & (m_valueArray.capacity() - 1);
+		const int mask = m_hashTable.size() - 1;
+		int pos = hash & mask;
+		unsigned int match, empty;
+		for (;;)
+		{
+			matchGroup(pos, BT_HASH_EMPTY, match, empty);
+			if (empty)
+			{
+				break;
+			}
+			pos = (pos + BT_HASH_GROUP_SIZE) & mask;
+		}
+		int slot = (pos + btHashLowestBit(empty)) & mask;
+		m_hashTable[slot] = index;
+		setControl(slot, hashTag(hash));
+	}
 
-		//replace value if the key is already there
-		int index = findIndex(key);
-		if (index != BT_HASH_NULL)
+	//the table is a power of two and at most 3/4 full, so every probe ends at an empty slot
+	void growTables()
+	{
+		int newSize = m_hashTable.size() ? m_hashTable.size() * 2 : BT_HASH_GROUP_SIZE;
+		while (newSize * 3 < (m_valueArray.size() + 1) * 4)
 		{
-			m_valueArray[index] = value;
-			return;
+			newSize *= 2;
 		}
 
-		int count = m_valueArray.size();
-		int oldCapacity = m_valueArray.capacity();
-		m_valueArray.push_back(value);
-		m_keyArray.push_back(key);
+		m_hashTable.resize(0);
+		m_hashTable.resize(newSize, BT_HASH_NULL);
+		m_control.resize(0);
+		m_control.resize(newSize + BT_HASH_GROUP_SIZE - 1, (unsigned char)BT_HASH_EMPTY);
 
-		int newCapacity = m_valueArray.capacity();
-		if (oldCapacity < newCapacity)
+		for (int i = 0; i < m_hashValues.size(); i++)
 		{
-			growTables(key);
-			//hash with new capacity
-			hash = key.getHash() & (m_valueArray.capacity() - 1);
+			insertSlot(i, m_hashValues[i]);
 		}
-		m_next[count] = m_hashTable[hash];
-		m_hashTable[hash] = count;
 	}
 
-	void remove(const Key& key)
+	//backward shift deletion: move later slots of the probe sequence into the hole, unless that
+	//would put them in front of their home slot
+	void eraseSlot(int hole)
 	{
-		int hash = key.getHash() & (m_valueArray.capacity() - 1);
-
-		int pairIndex = findIndex(key);
-
-		if (pairIndex == BT_HASH_NULL)
+		const int mask = m_hashTable.size() - 1;
+		int slot = hole;
+		for (;;)
 		{
-			return;
+			slot = (slot + 1) & mask;
+			if (m_control[slot] == BT_HASH_EMPTY)
+			{
+				break;
+			}
+			const int home = m_hashValues[m_hashTable[slot]] & mask;
+			const bool stays = (hole <= slot) ? (hole < home && home <= slot) : (hole < home || home <= slot);
+			if (!stays)
+			{
+				m_hashTable[hole] = m_hashTable[slot];
+				setControl(hole, m_control[slot]);
+				hole = slot;
+			}
 		}
+		m_hashTable[hole] = BT_HASH_NULL;
+		setControl(hole, BT_HASH_EMPTY);
+	}
 
-		// Remove the pair from the hash table.
-		int index = m_hashTable[hash];
-		btAssert(index != BT_HASH_NULL);
-
-		int previous = BT_HASH_NULL;
-		while (index != pairIndex)
+	int findSlot(const Key& key) const
+	{
+		if (m_hashTable.size() == 0)
 		{
-			previous = index;
-			index = m_next[index];
+			return BT_HASH_NULL;
 		}
+		int emptySlot = BT_HASH_NULL;
+		return probe(key, key.getHash(), emptySlot);
+	}
 
-		if (previous != BT_HASH_NULL)
+public:
+	void insert(const Key& key, const Value& value)
+	{
+		int count = m_valueArray.size();
+		if ((count + 1) * 4 > m_hashTable.size() * 3)
 		{
-			btAssert(m_next[previous] == pairIndex);
-			m_next[previous] = m_next[pairIndex];
+			growTables();
 		}
-		else
+
+		const unsigned int hash = key.getHash();
+		int emptySlot = BT_HASH_NULL;
+		int slot = probe(key, hash, emptySlot);
+
+		//replace value if the key is already there
+		if (slot != BT_HASH_NULL)
 		{
-			m_hashTable[hash] = m_next[pairIndex];
+			m_valueArray[m_hashTable[slot]] = value;
+			return;
 		}
 
-		// We now move the last pair into spot of the
-		// pair being removed. We need to fix the hash
-		// table indices to support the move.
-
-		int lastPairIndex = m_valueArray.size() - 1;
+		m_valueArray.push_back(value);
+		m_keyArray.push_back(key);
+		m_hashValues.push_back(hash);
+		m_hashTable[emptySlot] = count;
+		setControl(emptySlot, hashTag(hash));
+	}
 
-		// If the removed pair is the last pair, we are done.
-		if (lastPairIndex == pairIndex)
+	void remove(const Key& key)
+	{
+		int slot = findSlot(key);
+		if (slot == BT_HASH_NULL)
 		{
-			m_valueArray.pop_back();
-			m_keyArray.pop_back();
 			return;
 		}
 
-		// Remove the last pair from the hash table.
-		int lastHash = m_keyArray[lastPairIndex].getHash() & (m_valueArray.capacity() - 1);
+		int pairIndex = m_hashTable[slot];
+		eraseSlot(slot);
 
-		index = m_hashTable[lastHash];
-		btAssert(index != BT_HASH_NULL);
+		// We now move the last pair into spot of the
+		// pair being removed. We need to fix the hash
+		// table index to support the move.
 
-		previous = BT_HASH_NULL;
-		while (index != lastPairIndex)
-		{
-			previous = index;
-			index = m_next[index];
-		}
+		int lastPairIndex = m_valueArray.size() - 1;
 
-		if (previous != BT_HASH_NULL)
-		{
-			btAssert(m_next[previous] == lastPairIndex);
-			m_next[previous] = m_next[lastPairIndex];
-		}
-		else
+		if (lastPairIndex != pairIndex)
 		{
-			m_hashTable[lastHash] = m_next[lastPairIndex];
-		}
-
-		// Copy the last pair into the remove pair's spot.
-		m_valueArray[pairIndex] = m_valueArray[lastPairIndex];
-		m_keyArray[pairIndex] = m_keyArray[lastPairIndex];
+			const int mask = m_hashTable.size() - 1;
+			int lastSlot = m_hashValues[lastPairIndex] & mask;
+			while (m_hashTable[lastSlot] != lastPairIndex)
+			{
+				lastSlot = (lastSlot + 1) & mask;
+			}
+			m_hashTable[lastSlot] = pairIndex;
 
-		// Insert the last pair into the hash table
-		m_next[pairIndex] = m_hashTable[lastHash];
-		m_hashTable[lastHash] = pairIndex;
+			m_valueArray[pairIndex] = m_valueArray[lastPairIndex];
+			m_keyArray[pairIndex] = m_keyArray[lastPairIndex];
+			m_hashValues[pairIndex] = m_hashValues[lastPairIndex];
+		}
 
 		m_valueArray.pop_back();
 		m_keyArray.pop_back();
+		m_hashValues.pop_back();
 	}
 
 	int size() const
@@ -443,25 +548,15 @@ public:
 
 	int findIndex(const Key& key) const
 	{
-		unsigned int hash = key.getHash() & (m_valueArray.capacity() - 1);
-
-		if (hash >= (unsigned int)m_hashTable.size())
-		{
-			return BT_HASH_NULL;
-		}
-
-		int index = m_hashTable[hash];
-		while ((index != BT_HASH_NULL) && key.equals(m_keyArray[index]) == false)
-		{
-			index = m_next[index];
-		}
-		return index;
+		int slot = findSlot(key);
+		return (slot == BT_HASH_NULL) ? BT_HASH_NULL : m_hashTable[slot];
 	}
 
 	void clear()
 	{
+		m_control.clear();
 		m_hashTable.clear();
-		m_next.clear();
+		m_hashValues.clear();
 		m_valueArray.clear();
 		m_keyArray.clear();
 	}
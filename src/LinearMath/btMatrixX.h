@@ -19,6 +19,7 @@ subject to the following restrictions:
 
 #include "LinearMath/btQuickprof.h"
 #include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btMinMax.h"
 #include <stdio.h>
 
 //#define BT_DEBUG_OSTREAM
@@ -27,6 +28,11 @@ subject to the following restrictions:
 #include <iomanip>  // std::setw
 #endif              //BT_DEBUG_OSTREAM
 
+///tile size, in elements, of the blocked matrix product kernels
+#ifndef BT_MATRIX_X_BLOCK_SIZE
+#define BT_MATRIX_X_BLOCK_SIZE 64
+#endif
+
 class btIntSortPredicate
 {
 public:
@@ -242,16 +248,16 @@ struct btMatrixX
 
 	void copyLowerToUpperTriangle()
 	{
-		int count = 0;
+		btAssert(rows() == cols());
+		T* data = getBufferPointerWritable();
 		for (int row = 0; row < rows(); row++)
 		{
+			const T* src = data + (size_t)row * m_cols;
 			for (int col = 0; col < row; col++)
 			{
-				setElem(col, row, (*this)(row, col));
-				count++;
+				data[(size_t)col * m_cols + row] = src[col];
 			}
 		}
-		//printf("copyLowerToUpperTriangle copied %d elements out of %dx%d=%d\n", count,rows(),cols(),cols()*rows());
 	}
 
 	const T& operator()(int row, int col) const
@@ -329,40 +335,115 @@ struct btMatrixX
 
 	btMatrixX operator*(const btMatrixX& other)
 	{
-		//btMatrixX*btMatrixX implementation, brute force
 		btAssert(cols() == other.rows());
 
-		btMatrixX res(rows(), other.cols());
-		res.setZero();
-		//		BT_PROFILE("btMatrixX mul");
-		for (int j = 0; j < res.cols(); ++j)
+		btMatrixX res;
+		res.setProduct(*this, other);
+		return res;
+	}
+
+	///this = a * b
+	void setProduct(const btMatrixX& a, const btMatrixX& b)
+	{
+		btAssert(this != &a && this != &b);
+		resize(a.rows(), b.cols());
+		setZero();
+		addProduct(a, b);
+	}
+
+	///this += a * b
+	///the loops are tiled over k and j and the innermost loop walks a row of b and of the result,
+	///so it runs over contiguous memory and can be vectorized. Zero elements of a are skipped,
+	///which keeps the product cheap for sparse Jacobians.
+	void addProduct(const btMatrixX& a, const btMatrixX& b)
+	{
+		btAssert(a.cols() == b.rows());
+		btAssert(rows() == a.rows() && cols() == b.cols());
+		btAssert(this != &a && this != &b);
+
+		const int n = a.rows();
+		const int m = a.cols();
+		const int p = b.cols();
+		if (n == 0 || m == 0 || p == 0)
+			return;
+
+		const T* A = a.getBufferPointer();
+		const T* B = b.getBufferPointer();
+		T* C = getBufferPointerWritable();
+
+		for (int kk = 0; kk < m; kk += BT_MATRIX_X_BLOCK_SIZE)
 		{
+			const int kEnd = btMin(kk + BT_MATRIX_X_BLOCK_SIZE, m);
+			for (int jj = 0; jj < p; jj += BT_MATRIX_X_BLOCK_SIZE)
 			{
-				for (int i = 0; i < res.rows(); ++i)
+				const int jEnd = btMin(jj + BT_MATRIX_X_BLOCK_SIZE, p);
+				for (int i = 0; i < n; i++)
 				{
-					T dotProd = 0;
-					//					T dotProd2=0;
-					//int waste=0,waste2=0;
+					const T* aRow = A + (size_t)i * m;
+					T* cRow = C + (size_t)i * p;
+					for (int k = kk; k < kEnd; k++)
+					{
+						const T aik = aRow[k];
+						if (aik == T(0))
+							continue;
+						const T* bRow = B + (size_t)k * p;
+						for (int j = jj; j < jEnd; j++)
+						{
+							cRow[j] += aik * bRow[j];
+						}
+					}
+				}
+			}
+		}
+		m_operations++;
+	}
+
+	///this += a * b^T, a rank-k update when b == a
+	///both operands are read along their rows. With lowerTriangleOnly set, only elements on or below
+	///the diagonal are computed, use copyLowerToUpperTriangle afterwards for a symmetric result.
+	void addProductTransposed(const btMatrixX& a, const btMatrixX& b, bool lowerTriangleOnly = false)
+	{
+		btAssert(a.cols() == b.cols());
+		btAssert(rows() == a.rows() && cols() == b.rows());
+		btAssert(this != &a && this != &b);
+
+		const int n = a.rows();
+		const int m = a.cols();
+		const int p = b.rows();
+		if (n == 0 || m == 0 || p == 0)
+			return;
 
+		const T* A = a.getBufferPointer();
+		const T* B = b.getBufferPointer();
+		T* C = getBufferPointerWritable();
+
+		for (int ii = 0; ii < n; ii += BT_MATRIX_X_BLOCK_SIZE)
+		{
+			const int iEnd = btMin(ii + BT_MATRIX_X_BLOCK_SIZE, n);
+			for (int jj = 0; jj < p; jj += BT_MATRIX_X_BLOCK_SIZE)
+			{
+				if (lowerTriangleOnly && jj >= iEnd)
+					break;
+				const int jEnd = btMin(jj + BT_MATRIX_X_BLOCK_SIZE, p);
+				for (int i = ii; i < iEnd; i++)
+				{
+					const T* aRow = A + (size_t)i * m;
+					T* cRow = C + (size_t)i * p;
+					const int jLast = lowerTriangleOnly ? btMin(jEnd, i + 1) : jEnd;
+					for (int j = jj; j < jLast; j++)
 					{
-						//						bool useOtherCol = true;
+						const T* bRow = B + (size_t)j * m;
+						T sum = T(0);
+						for (int k = 0; k < m; k++)
 						{
-							for (int v = 0; v < rows(); v++)
-							{
-								T w = (*this)(i, v);
-								if (other(v, j) != 0.f)
-								{
-									dotProd += w * other(v, j);
-								}
-							}
+							sum += aRow[k] * bRow[k];
 						}
+						cRow[j] += sum;
 					}
-					if (dotProd)
-						res.setElem(i, j, dotProd);
 				}
 			}
 		}
-		return res;
+		m_operations++;
 	}
 
 	// this assumes the 4th and 8th rows of B and C are zero.
@@ -17,39 +17,170 @@ subject to the following restrictions:
 
 #include "btScalar.h"
 #include "btAlignedAllocator.h"
+#include "btAlignedObjectArray.h"
+#include "btMinMax.h"
 #include "btThreads.h"
 
+#ifndef BT_POOL_ALLOCATOR_SLAB_SIZE
+///size in bytes of the slabs a growable btPoolAllocator adds when it runs out of elements
+#define BT_POOL_ALLOCATOR_SLAB_SIZE (64 * 1024)
+#endif
+
 ///The btPoolAllocator class allows to efficiently allocate a large pool of objects, instead of dynamically allocating them separately.
+///A growable pool adds slabs of BT_POOL_ALLOCATOR_SLAB_SIZE bytes when it is exhausted instead of returning 0,
+///and shrink releases the slabs that are entirely free. Allocation and freeing stay O(1) in both cases.
+///Pools are fixed size by default, callers such as btCollisionDispatcher rely on 0 to fall back to the heap.
 class btPoolAllocator
 {
+	struct btPoolSlab
+	{
+		unsigned char* m_memory;
+		int m_numElements;
+	};
+
 	int m_elemSize;
+	int m_poolElements;
 	int m_maxElements;
 	int m_freeCount;
 	void* m_firstFree;
 	unsigned char* m_pool;
 	btSpinMutex m_mutex;  // only used if BT_THREADSAFE
+	bool m_growable;
+	int m_highWaterMark;
+	btPoolSlab* m_slabs;  // slabs added after construction, sorted by address, guarded by m_mutex
+	int m_numSlabs;
+	int m_slabCapacity;
+
+	static void* linkElements(unsigned char* p, int elemSize, int count, void* next)
+	{
+		if (count <= 0)
+		{
+			return next;
+		}
+		for (int i = 0; i < count - 1; i++)
+		{
+			*(void**)(p + i * elemSize) = p + (i + 1) * elemSize;
+		}
+		*(void**)(p + (count - 1) * elemSize) = next;
+		return p;
+	}
+
+	//returns the index of the slab containing ptr, or -1
+	int findSlab(const void* ptr) const
+	{
+		const unsigned char* p = (const unsigned char*)ptr;
+		int lo = 0;
+		int hi = m_numSlabs - 1;
+		while (lo <= hi)
+		{
+			int mid = (lo + hi) >> 1;
+			const btPoolSlab& slab = m_slabs[mid];
+			if (p < slab.m_memory)
+			{
+				hi = mid - 1;
+			}
+			else if (p >= slab.m_memory + slab.m_numElements * m_elemSize)
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				return mid;
+			}
+		}
+		return -1;
+	}
+
+	//called and returns with m_mutex locked, the lock is released while the slab and a larger slab table are allocated.
+	//another thread may free or grow in the meantime, then the memory is dropped again and the caller checks the free list.
+	//returns false if the memory could not be allocated
+	bool grow()
+	{
+		const int tableCapacity = m_numSlabs < m_slabCapacity ? 0 : btMax(8, 2 * m_slabCapacity);
+		btMutexUnlock(&m_mutex);
+		btPoolSlab slab;
+		slab.m_numElements = btMax(1, BT_POOL_ALLOCATOR_SLAB_SIZE / m_elemSize);
+		slab.m_memory = (unsigned char*)btAlignedAlloc(static_cast<unsigned int>(m_elemSize * slab.m_numElements), 16);
+		btPoolSlab* table = tableCapacity ? (btPoolSlab*)btAlignedAlloc(sizeof(btPoolSlab) * tableCapacity, 16) : 0;
+		if (NULL == slab.m_memory || (tableCapacity && NULL == table))
+		{
+			releaseMemory(slab.m_memory, table);
+			btMutexLock(&m_mutex);
+			return false;
+		}
+		btMutexLock(&m_mutex);
+		if (NULL != m_firstFree || (m_numSlabs == m_slabCapacity && tableCapacity <= m_numSlabs))
+		{
+			btMutexUnlock(&m_mutex);
+			releaseMemory(slab.m_memory, table);
+			btMutexLock(&m_mutex);
+			return true;
+		}
+		if (m_numSlabs == m_slabCapacity)
+		{
+			for (int i = 0; i < m_numSlabs; i++)
+			{
+				table[i] = m_slabs[i];
+			}
+			btSwap(table, m_slabs);
+			m_slabCapacity = tableCapacity;
+		}
+		m_firstFree = linkElements(slab.m_memory, m_elemSize, slab.m_numElements, m_firstFree);
+		m_freeCount += slab.m_numElements;
+		m_maxElements += slab.m_numElements;
+
+		int index = m_numSlabs++;
+		while (index > 0 && m_slabs[index - 1].m_memory > slab.m_memory)
+		{
+			m_slabs[index] = m_slabs[index - 1];
+			--index;
+		}
+		m_slabs[index] = slab;
+		if (table)
+		{
+			// the previous slab table
+			btMutexUnlock(&m_mutex);
+			btAlignedFree(table);
+			btMutexLock(&m_mutex);
+		}
+		return true;
+	}
+
+	static void releaseMemory(void* slabMemory, void* table)
+	{
+		if (slabMemory)
+		{
+			btAlignedFree(slabMemory);
+		}
+		if (table)
+		{
+			btAlignedFree(table);
+		}
+	}
 
 public:
-	btPoolAllocator(int elemSize, int maxElements)
+	btPoolAllocator(int elemSize, int maxElements, bool growable = false)
 		: m_elemSize(elemSize),
-		  m_maxElements(maxElements)
+		  m_poolElements(maxElements),
+		  m_maxElements(maxElements),
+		  m_growable(growable),
+		  m_highWaterMark(0),
+		  m_slabs(0),
+		  m_numSlabs(0),
+		  m_slabCapacity(0)
 	{
 		m_pool = (unsigned char*)btAlignedAlloc(static_cast<unsigned int>(m_elemSize * m_maxElements), 16);
-
-		unsigned char* p = m_pool;
-		m_firstFree = p;
+		m_firstFree = linkElements(m_pool, m_elemSize, m_maxElements, 0);
 		m_freeCount = m_maxElements;
-		int count = m_maxElements;
-		while (--count)
-		{
-			*(void**)p = (p + m_elemSize);
-			p += m_elemSize;
-		}
-		*(void**)p = 0;
 	}
 
 	~btPoolAllocator()
 	{
+		for (int i = 0; i < m_numSlabs; i++)
+		{
+			btAlignedFree(m_slabs[i].m_memory);
+		}
+		releaseMemory(0, m_slabs);
 		btAlignedFree(m_pool);
 	}
 
@@ -63,11 +194,39 @@ public:
 		return m_maxElements - m_freeCount;
 	}
 
+	///number of elements in the initial pool and all slabs
 	int getMaxCount() const
 	{
 		return m_maxElements;
 	}
 
+	///largest number of elements in use at once since construction or resetHighWaterMark
+	int getHighWaterMark() const
+	{
+		return m_highWaterMark;
+	}
+
+	void resetHighWaterMark()
+	{
+		m_highWaterMark = getUsedCount();
+	}
+
+	///number of slabs added when the initial pool was exhausted
+	int getNumSlabs() const
+	{
+		return m_numSlabs;
+	}
+
+	void setGrowable(bool growable)
+	{
+		m_growable = growable;
+	}
+
+	bool isGrowable() const
+	{
+		return m_growable;
+	}
+
 	void* allocate(int size)
 	{
 		// release mode fix
@@ -75,11 +234,20 @@ public:
 		btMutexLock(&m_mutex);
 		btAssert(!size || size <= m_elemSize);
 		//btAssert(m_freeCount>0);  // should return null if all full
+		while (NULL == m_firstFree && m_growable)
+		{
+			if (!grow())
+			{
+				btMutexUnlock(&m_mutex);
+				return 0;
+			}
+		}
 		void* result = m_firstFree;
 		if (NULL != m_firstFree)
 		{
 			m_firstFree = *(void**)m_firstFree;
 			--m_freeCount;
+			m_highWaterMark = btMax(m_highWaterMark, m_maxElements - m_freeCount);
 		}
 		btMutexUnlock(&m_mutex);
 		return result;
@@ -89,10 +257,15 @@ public:
 	{
 		if (ptr)
 		{
-			if (((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_maxElements * m_elemSize))
+			// the initial pool never moves, the slab table can change in another thread
+			if (((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_poolElements * m_elemSize))
 			{
 				return true;
 			}
+			btMutexLock(&m_mutex);
+			bool valid = findSlab(ptr) >= 0;
+			btMutexUnlock(&m_mutex);
+			return valid;
 		}
 		return false;
 	}
@@ -101,7 +274,7 @@ public:
 	{
 		if (ptr)
 		{
-			btAssert((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_maxElements * m_elemSize);
+			btAssert(validPtr(ptr));
 
 			btMutexLock(&m_mutex);
 			*(void**)ptr = m_firstFree;
@@ -111,6 +284,61 @@ public:
 		}
 	}
 
+	///release the slabs whose elements are all free, returns the number of released slabs
+	///the cost is proportional to the number of free elements, the initial pool is never released
+	int shrink()
+	{
+		btMutexLock(&m_mutex);
+		if (m_numSlabs == 0)
+		{
+			btMutexUnlock(&m_mutex);
+			return 0;
+		}
+		btAlignedObjectArray<int> freeInSlab;
+		freeInSlab.resize(m_numSlabs, 0);
+		for (void* p = m_firstFree; p; p = *(void**)p)
+		{
+			int slab = findSlab(p);
+			if (slab >= 0)
+			{
+				freeInSlab[slab]++;
+			}
+		}
+		// unlink the elements of empty slabs from the free list
+		void** link = &m_firstFree;
+		while (*link)
+		{
+			int slab = findSlab(*link);
+			if (slab >= 0 && freeInSlab[slab] == m_slabs[slab].m_numElements)
+			{
+				*link = *(void**)*link;
+			}
+			else
+			{
+				link = (void**)*link;
+			}
+		}
+		int numReleased = 0;
+		for (int i = 0; i < m_numSlabs; i++)
+		{
+			const btPoolSlab& slab = m_slabs[i];
+			if (freeInSlab[i] == slab.m_numElements)
+			{
+				btAlignedFree(slab.m_memory);
+				m_freeCount -= slab.m_numElements;
+				m_maxElements -= slab.m_numElements;
+				numReleased++;
+			}
+			else
+			{
+				m_slabs[i - numReleased] = slab;
+			}
+		}
+		m_numSlabs -= numReleased;
+		btMutexUnlock(&m_mutex);
+		return numReleased;
+	}
+
 	int getElementSize() const
 	{
 		return m_elemSize;
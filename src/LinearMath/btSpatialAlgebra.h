@@ -219,7 +219,7 @@ struct btSymmetricSpatialDyad
 		return *this;
 	}
 	//
-	btSpatialForceVector operator*(const btSpatialMotionVector &vec)
+	btSpatialForceVector operator*(const btSpatialMotionVector &vec) const
 	{
 		return btSpatialForceVector(m_bottomLeftMat * vec.m_topVec + m_topLeftMat.transpose() * vec.m_bottomVec, m_topLeftMat * vec.m_topVec + m_topRightMat * vec.m_bottomVec);
 	}
@@ -286,20 +286,24 @@ struct btSpatialTransformationMatrix
 						  SpatialVectorType &outVec,
 						  eOutputOperation outOp = None)
 	{
+		//v * m_rotMat == m_rotMat^T * v, without building the transposed matrix
+		const btVector3 top = inVec.m_topVec * m_rotMat;
+		const btVector3 bottom = (inVec.m_bottomVec + m_trnVec.cross(inVec.m_topVec)) * m_rotMat;
+
 		if (outOp == None)
 		{
-			outVec.m_topVec = m_rotMat.transpose() * inVec.m_topVec;
-			outVec.m_bottomVec = m_rotMat.transpose() * (inVec.m_bottomVec + m_trnVec.cross(inVec.m_topVec));
+			outVec.m_topVec = top;
+			outVec.m_bottomVec = bottom;
 		}
 		else if (outOp == Add)
 		{
-			outVec.m_topVec += m_rotMat.transpose() * inVec.m_topVec;
-			outVec.m_bottomVec += m_rotMat.transpose() * (inVec.m_bottomVec + m_trnVec.cross(inVec.m_topVec));
+			outVec.m_topVec += top;
+			outVec.m_bottomVec += bottom;
 		}
 		else if (outOp == Subtract)
 		{
-			outVec.m_topVec -= m_rotMat.transpose() * inVec.m_topVec;
-			outVec.m_bottomVec -= m_rotMat.transpose() * (inVec.m_bottomVec + m_trnVec.cross(inVec.m_topVec));
+			outVec.m_topVec -= top;
+			outVec.m_bottomVec -= bottom;
 		}
 	}
 
@@ -310,18 +314,18 @@ struct btSpatialTransformationMatrix
 	{
 		if (outOp == None)
 		{
-			outVec.m_topVec = m_rotMat.transpose() * inVec.m_topVec;
-			outVec.m_bottomVec = m_rotMat.transpose() * inVec.m_bottomVec;
+			outVec.m_topVec = inVec.m_topVec * m_rotMat;
+			outVec.m_bottomVec = inVec.m_bottomVec * m_rotMat;
 		}
 		else if (outOp == Add)
 		{
-			outVec.m_topVec += m_rotMat.transpose() * inVec.m_topVec;
-			outVec.m_bottomVec += m_rotMat.transpose() * inVec.m_bottomVec;
+			outVec.m_topVec += inVec.m_topVec * m_rotMat;
+			outVec.m_bottomVec += inVec.m_bottomVec * m_rotMat;
 		}
 		else if (outOp == Subtract)
 		{
-			outVec.m_topVec -= m_rotMat.transpose() * inVec.m_topVec;
-			outVec.m_bottomVec -= m_rotMat.transpose() * inVec.m_bottomVec;
+			outVec.m_topVec -= inVec.m_topVec * m_rotMat;
+			outVec.m_bottomVec -= inVec.m_bottomVec * m_rotMat;
 		}
 	}
 
@@ -333,23 +337,31 @@ struct btSpatialTransformationMatrix
 								  m_trnVec[2], 0, -m_trnVec[0],
 								  -m_trnVec[1], m_trnVec[0], 0);
 
+		//shared subexpressions; R^T * M * R is evaluated as R.transposeTimes(M * R)
+		const btMatrix3x3 topLeft = inMat.m_topLeftMat - inMat.m_topRightMat * r_cross;
+		const btMatrix3x3 bottomLeft = r_cross * topLeft + inMat.m_bottomLeftMat - inMat.m_topLeftMat.transpose() * r_cross;
+
+		const btMatrix3x3 outTopLeft = m_rotMat.transposeTimes(topLeft * m_rotMat);
+		const btMatrix3x3 outTopRight = m_rotMat.transposeTimes(inMat.m_topRightMat * m_rotMat);
+		const btMatrix3x3 outBottomLeft = m_rotMat.transposeTimes(bottomLeft * m_rotMat);
+
 		if (outOp == None)
 		{
-			outMat.m_topLeftMat = m_rotMat.transpose() * (inMat.m_topLeftMat - inMat.m_topRightMat * r_cross) * m_rotMat;
-			outMat.m_topRightMat = m_rotMat.transpose() * inMat.m_topRightMat * m_rotMat;
-			outMat.m_bottomLeftMat = m_rotMat.transpose() * (r_cross * (inMat.m_topLeftMat - inMat.m_topRightMat * r_cross) + inMat.m_bottomLeftMat - inMat.m_topLeftMat.transpose() * r_cross) * m_rotMat;
+			outMat.m_topLeftMat = outTopLeft;
+			outMat.m_topRightMat = outTopRight;
+			outMat.m_bottomLeftMat = outBottomLeft;
 		}
 		else if (outOp == Add)
 		{
-			outMat.m_topLeftMat += m_rotMat.transpose() * (inMat.m_topLeftMat - inMat.m_topRightMat * r_cross) * m_rotMat;
-			outMat.m_topRightMat += m_rotMat.transpose() * inMat.m_topRightMat * m_rotMat;
-			outMat.m_bottomLeftMat += m_rotMat.transpose() * (r_cross * (inMat.m_topLeftMat - inMat.m_topRightMat * r_cross) + inMat.m_bottomLeftMat - inMat.m_topLeftMat.transpose() * r_cross) * m_rotMat;
+			outMat.m_topLeftMat += outTopLeft;
+			outMat.m_topRightMat += outTopRight;
+			outMat.m_bottomLeftMat += outBottomLeft;
 		}
 		else if (outOp == Subtract)
 		{
-			outMat.m_topLeftMat -= m_rotMat.transpose() * (inMat.m_topLeftMat - inMat.m_topRightMat * r_cross) * m_rotMat;
-			outMat.m_topRightMat -= m_rotMat.transpose() * inMat.m_topRightMat * m_rotMat;
-			outMat.m_bottomLeftMat -= m_rotMat.transpose() * (r_cross * (inMat.m_topLeftMat - inMat.m_topRightMat * r_cross) + inMat.m_bottomLeftMat - inMat.m_topLeftMat.transpose() * r_cross) * m_rotMat;
+			outMat.m_topLeftMat -= outTopLeft;
+			outMat.m_topRightMat -= outTopRight;
+			outMat.m_bottomLeftMat -= outBottomLeft;
 		}
 	}
 
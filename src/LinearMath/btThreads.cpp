@@ -14,6 +14,7 @@ subject to the following restrictions:
 
 #include "btThreads.h"
 #include "btQuickprof.h"
+#include "btAllocatorContext.h"
 #include <algorithm>  // for min and max
 
 #if BT_USE_OPENMP && BT_THREADSAFE
@@ -103,6 +104,12 @@ void btSpinMutex::unlock()
 	std::atomic_store_explicit(aDest, int(0), std::memory_order_release);
 }
 
+void btAtomicAdd(size_t* counter, size_t value)
+{
+	std::atomic<size_t>* aDest = reinterpret_cast<std::atomic<size_t>*>(counter);
+	std::atomic_fetch_add_explicit(aDest, value, std::memory_order_relaxed);
+}
+
 #elif USE_MSVC_INTRINSICS
 
 #define WIN32_LEAN_AND_MEAN
@@ -133,6 +140,15 @@ void btSpinMutex::unlock()
 	_InterlockedExchange(aDest, 0);
 }
 
+void btAtomicAdd(size_t* counter, size_t value)
+{
+#ifdef _WIN64
+	_InterlockedExchangeAdd64(reinterpret_cast<volatile __int64*>(counter), __int64(value));
+#else
+	_InterlockedExchangeAdd(reinterpret_cast<volatile long*>(counter), long(value));
+#endif
+}
+
 #elif USE_GCC_BUILTIN_ATOMICS
 
 #define THREAD_LOCAL_STATIC static __thread
@@ -160,6 +176,11 @@ void btSpinMutex::unlock()
 	__atomic_store_n(&mLock, int(0), __ATOMIC_RELEASE);
 }
 
+void btAtomicAdd(size_t* counter, size_t value)
+{
+	__atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
 #elif USE_GCC_BUILTIN_ATOMICS_OLD
 
 #define THREAD_LOCAL_STATIC static __thread
@@ -184,6 +205,11 @@ void btSpinMutex::unlock()
 	__sync_fetch_and_and(&mLock, int(0));
 }
 
+void btAtomicAdd(size_t* counter, size_t value)
+{
+	__sync_fetch_and_add(counter, value);
+}
+
 #else  //#elif USE_MSVC_INTRINSICS
 
 #error "no threading primitives defined -- unknown platform"
@@ -209,6 +235,11 @@ bool btSpinMutex::tryLock()
 	return true;
 }
 
+void btAtomicAdd(size_t* counter, size_t value)
+{
+	*counter += value;
+}
+
 #define THREAD_LOCAL_STATIC static
 
 #endif  // #else //#if BT_THREADSAFE
@@ -321,6 +352,18 @@ unsigned int btGetCurrentThreadIndex()
 	return sThreadIndex;
 }
 
+THREAD_LOCAL_STATIC btAllocatorContext* sCurrentAllocatorContext = 0;
+
+btAllocatorContext* btGetCurrentAllocatorContext()
+{
+	return sCurrentAllocatorContext;
+}
+
+void btSetCurrentAllocatorContext(btAllocatorContext* context)
+{
+	sCurrentAllocatorContext = context;
+}
+
 bool btIsMainThread()
 {
 	return btGetCurrentThreadIndex() == 0;
@@ -409,6 +452,33 @@ btITaskScheduler* btGetTaskScheduler()
 	return gBtTaskScheduler;
 }
 
+#if BT_THREADSAFE
+// worker threads allocate from the allocator context of the thread that started the loop
+struct btParallelForContextBody : public btIParallelForBody
+{
+	const btIParallelForBody* m_body;
+	btAllocatorContext* m_context;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		btAllocatorContextScope scope(m_context);
+		m_body->forLoop(iBegin, iEnd);
+	}
+};
+
+struct btParallelSumContextBody : public btIParallelSumBody
+{
+	const btIParallelSumBody* m_body;
+	btAllocatorContext* m_context;
+
+	btScalar sumLoop(int iBegin, int iEnd) const
+	{
+		btAllocatorContextScope scope(m_context);
+		return m_body->sumLoop(iBegin, iEnd);
+	}
+};
+#endif  // #if BT_THREADSAFE
+
 void btParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
 {
 #if BT_THREADSAFE
@@ -425,6 +495,14 @@ void btParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody
 #endif  // #if BT_DETECT_BAD_THREAD_INDEX
 
 	btAssert(gBtTaskScheduler != NULL);  // call btSetTaskScheduler() with a valid task scheduler first!
+	if (btAllocatorContext* context = btGetCurrentAllocatorContext())
+	{
+		btParallelForContextBody contextBody;
+		contextBody.m_body = &body;
+		contextBody.m_context = context;
+		gBtTaskScheduler->parallelFor(iBegin, iEnd, grainSize, contextBody);
+		return;
+	}
 	gBtTaskScheduler->parallelFor(iBegin, iEnd, grainSize, body);
 
 #else  // #if BT_THREADSAFE
@@ -452,6 +530,13 @@ btScalar btParallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSum
 #endif  // #if BT_DETECT_BAD_THREAD_INDEX
 
 	btAssert(gBtTaskScheduler != NULL);  // call btSetTaskScheduler() with a valid task scheduler first!
+	if (btAllocatorContext* context = btGetCurrentAllocatorContext())
+	{
+		btParallelSumContextBody contextBody;
+		contextBody.m_body = &body;
+		contextBody.m_context = context;
+		return gBtTaskScheduler->parallelSum(iBegin, iEnd, grainSize, contextBody);
+	}
 	return gBtTaskScheduler->parallelSum(iBegin, iEnd, grainSize, body);
 
 #else  // #if BT_THREADSAFE
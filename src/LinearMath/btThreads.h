@@ -35,6 +35,7 @@ bool btIsMainThread();
 bool btThreadsAreRunning();
 unsigned int btGetCurrentThreadIndex();
 void btResetThreadIndexCounter();  // notify that all worker threads have been destroyed
+void btAtomicAdd(size_t* counter, size_t value);  // relaxed atomic add if BT_THREADSAFE, for statistics
 
 ///
 /// btSpinMutex -- lightweight spin-mutex implemented with atomic ops, never puts
@@ -39,6 +39,9 @@
 #include "Test_3x3getRot.h"
 
 #include "Test_btDbvt.h"
+#include "Test_btMatrixX.h"
+#include "Test_btHashMap.h"
+#include "Test_btAlignedObjectArray.h"
 #include "Test_quat_aos_neon.h"
 
 #include "LinearMath/btScalar.h"
@@ -89,6 +92,9 @@ TestDesc gTestList[] =
 		ENTRY("3x3getRot", Test_3x3getRot),
 
 		ENTRY("btDbvt", Test_btDbvt),
+		ENTRY("btMatrixX", Test_btMatrixX),
+		ENTRY("btHashMap", Test_btHashMap),
+		ENTRY("btAlignedObjectArray", Test_btAlignedObjectArray),
 		ENTRY("quat_aos_neon", Test_quat_aos_neon),
 
 		{NULL, NULL}};
@@ -0,0 +1,297 @@
+//
+//  Test_btAlignedObjectArray.cpp
+//  BulletTest
+//
+
+#include "LinearMath/btScalar.h"
+#if defined(BT_USE_SSE_IN_API) || defined(BT_USE_NEON)
+
+#include "Test_btAlignedObjectArray.h"
+#include "vector.h"
+#include "Utils.h"
+#include "main.h"
+#include <stdio.h>
+#include <string>
+
+#include <LinearMath/btAlignedObjectArray.h>
+
+#define LOOPCOUNT 10
+#define NUM_ARRAYS 100000
+#define ARRAY_SIZE 4
+
+#define CHECK(_cond)                                                                         \
+	if (!(_cond))                                                                            \
+	{                                                                                        \
+		vlog("Error - btAlignedObjectArray check failed @ line %d: %s\n", __LINE__, #_cond); \
+		return 1;                                                                            \
+	}
+
+// an element with heap storage that counts its live instances, so lost or doubled elements show up
+static int gNumLiveElements = 0;
+
+struct Element
+{
+	std::string m_name;
+
+	Element(const char* name = "")
+		: m_name(name)
+	{
+		gNumLiveElements++;
+	}
+
+	Element(const Element& other)
+		: m_name(other.m_name)
+	{
+		gNumLiveElements++;
+	}
+
+#ifdef BT_USE_MOVE_SEMANTICS
+	Element(Element&& other)
+		: m_name(std::move(other.m_name))
+	{
+		gNumLiveElements++;
+	}
+
+	Element& operator=(Element&& other)
+	{
+		m_name = std::move(other.m_name);
+		return *this;
+	}
+#endif
+
+	Element& operator=(const Element& other)
+	{
+		m_name = other.m_name;
+		return *this;
+	}
+
+	~Element()
+	{
+		gNumLiveElements--;
+	}
+
+	bool operator<(const Element& other) const
+	{
+		return m_name < other.m_name;
+	}
+};
+
+static void fillArray(btAlignedObjectArray<Element>& array, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		char name[16];
+		sprintf(name, "%d", i);
+		array.push_back(Element(name));
+	}
+}
+
+static int testElements()
+{
+	{
+		// growing an array of arrays keeps the inner arrays intact
+		btAlignedObjectArray<btAlignedObjectArray<Element> > nested;
+		for (int i = 0; i < 100; i++)
+		{
+			btAlignedObjectArray<Element> inner;
+			inner.push_back(Element("x"));
+			inner.push_back(Element("yy"));
+			nested.push_back(inner);
+		}
+		CHECK(nested.size() == 100);
+		CHECK(nested[0][0].m_name == "x");
+		CHECK(nested[99][1].m_name == "yy");
+		CHECK(gNumLiveElements == 200);
+
+		btAlignedObjectArray<Element> sorted;
+		fillArray(sorted, 50);
+		sorted.quickSort(btAlignedObjectArray<Element>::less());
+		CHECK(sorted[0].m_name == "0");
+		CHECK(sorted[49].m_name == "9");
+		btAlignedObjectArray<Element> copy(sorted);
+		CHECK(copy.size() == 50);
+		CHECK(sorted.size() == 50);
+		CHECK(sorted[10].m_name == copy[10].m_name);
+		sorted.removeAtIndex(0);
+		CHECK(sorted.size() == 49);
+	}
+	CHECK(gNumLiveElements == 0);
+	return 0;
+}
+
+static int testSmallArray()
+{
+	{
+		btSmallAlignedObjectArray<Element, 4> small;
+		CHECK(small.usesInlineStorage());
+		for (int i = 0; i < 4; i++)
+		{
+			small.push_back(Element("s"));
+		}
+		CHECK(small.usesInlineStorage());
+		CHECK(small.size() == 4);
+
+		// the array moves to the heap past its inline capacity and back again on clear
+		small.push_back(Element("u"));
+		CHECK(!small.usesInlineStorage());
+		CHECK(small.size() == 5);
+		CHECK(small[0].m_name == "s");
+		CHECK(small[4].m_name == "u");
+		small.resize(0);
+		small.push_back(Element("v"));
+		small.clear();
+		CHECK(small.usesInlineStorage());
+		CHECK(small.size() == 0);
+		CHECK(small.capacity() == 4);
+
+		// copies get their own inline storage
+		small.push_back(Element("w"));
+		btSmallAlignedObjectArray<Element, 4> copy(small);
+		CHECK(copy.size() == 1);
+		CHECK(copy[0].m_name == "w");
+		CHECK(copy.usesInlineStorage());
+
+		btAlignedObjectArray<Element> large;
+		fillArray(large, 50);
+		copy = large;
+		CHECK(copy.size() == 50);
+		CHECK(copy[10].m_name == large[10].m_name);
+		small = copy;
+		CHECK(small.size() == 50);
+
+		btSmallAlignedObjectArray<int, 8> ints;
+		for (int i = 0; i < 8; i++)
+		{
+			ints.push_back(i);
+		}
+		ints.removeAtIndex(2);
+		CHECK(ints.size() == 7);
+		CHECK(ints[2] == 7);
+		CHECK(ints.usesInlineStorage());
+	}
+	CHECK(gNumLiveElements == 0);
+	return 0;
+}
+
+#ifdef BT_USE_MOVE_SEMANTICS
+static int testMove()
+{
+	{
+		// a heap array hands its memory over and is left empty
+		btAlignedObjectArray<Element> array;
+		fillArray(array, 50);
+		const Element* first = &array[0];
+		btAlignedObjectArray<Element> moved(std::move(array));
+		CHECK(moved.size() == 50);
+		CHECK(&moved[0] == first);
+		CHECK(array.size() == 0);
+		CHECK(array.capacity() == 0);
+		array = std::move(moved);
+		CHECK(array.size() == 50);
+		CHECK(&array[0] == first);
+		CHECK(moved.size() == 0);
+		CHECK(gNumLiveElements == 50);
+
+		// a small array on the heap gives its memory away and returns to its inline storage
+		btSmallAlignedObjectArray<Element, 4> small;
+		fillArray(small, 50);
+		btSmallAlignedObjectArray<Element, 4> movedSmall(std::move(small));
+		CHECK(movedSmall.size() == 50);
+		CHECK(!movedSmall.usesInlineStorage());
+		CHECK(small.size() == 0);
+		CHECK(small.usesInlineStorage());
+		CHECK(small.capacity() == 4);
+		small.push_back(Element("r"));
+		CHECK(small.size() == 1);
+
+		// inline elements are moved one by one
+		btSmallAlignedObjectArray<Element, 4> inlined;
+		inlined.push_back(Element("a"));
+		btSmallAlignedObjectArray<Element, 4> movedInline(std::move(inlined));
+		CHECK(movedInline.size() == 1);
+		CHECK(movedInline[0].m_name == "a");
+		CHECK(movedInline.usesInlineStorage());
+		CHECK(inlined.size() == 0);
+		btAlignedObjectArray<Element> fromInline(std::move(movedInline));
+		CHECK(fromInline.size() == 1);
+		CHECK(fromInline[0].m_name == "a");
+		CHECK(movedInline.size() == 0);
+
+		movedInline = std::move(array);
+		CHECK(movedInline.size() == 50);
+		CHECK(array.size() == 0);
+		inlined = std::move(movedInline);
+		CHECK(inlined.size() == 50);
+
+		// memory that the array does not own is not taken over
+		ATTRIBUTE_ALIGNED16(char buffer[64 * sizeof(Element)]);
+		btAlignedObjectArray<Element> external;
+		external.initializeFromBuffer(buffer, 0, 64);
+		external.push_back(Element("e"));
+		btAlignedObjectArray<Element> movedExternal(std::move(external));
+		CHECK(movedExternal.size() == 1);
+		CHECK(movedExternal[0].m_name == "e");
+		CHECK((char*)&movedExternal[0] < buffer || (char*)&movedExternal[0] >= buffer + sizeof(buffer));
+		CHECK(external.size() == 0);
+	}
+	CHECK(gNumLiveElements == 0);
+	return 0;
+}
+#endif  //BT_USE_MOVE_SEMANTICS
+
+// fill and drop many short arrays, like the per-pair scratch arrays of the narrowphase
+template <class Array>
+static uint64_t runShortArrays(int& checksum)
+{
+	uint64_t startTime = ReadTicks();
+	for (int i = 0; i < NUM_ARRAYS; i++)
+	{
+		Array array;
+		for (int j = 0; j < ARRAY_SIZE; j++)
+		{
+			array.push_back(i + j);
+		}
+		checksum += array[ARRAY_SIZE - 1];
+	}
+	return ReadTicks() - startTime;
+}
+
+int Test_btAlignedObjectArray(void)
+{
+	if (testElements() || testSmallArray())
+	{
+		return 1;
+	}
+#ifdef BT_USE_MOVE_SEMANTICS
+	if (testMove())
+	{
+		return 1;
+	}
+#endif
+
+	uint64_t heapTime = -1LL, inlineTime = -1LL;
+	for (int j = 0; j < LOOPCOUNT; j++)
+	{
+		int heapSum = 0, inlineSum = 0;
+		uint64_t currentTime = runShortArrays<btAlignedObjectArray<int> >(heapSum);
+		if (currentTime < heapTime)
+			heapTime = currentTime;
+		currentTime = runShortArrays<btSmallAlignedObjectArray<int, ARRAY_SIZE> >(inlineSum);
+		if (currentTime < inlineTime)
+			inlineTime = currentTime;
+
+		if (heapSum != inlineSum)
+		{
+			vlog("Error - btSmallAlignedObjectArray result error! heap = %d, inline = %d\n", heapSum, inlineSum);
+			return 1;
+		}
+	}
+
+	vlog("Timing (%d arrays of %d ints, fill and destroy):\n", NUM_ARRAYS, ARRAY_SIZE);
+	vlog("\t      heap\t    inline\n");
+	vlog("\t%10.2f\t%10.2f\n", TicksToCycles(heapTime) / NUM_ARRAYS, TicksToCycles(inlineTime) / NUM_ARRAYS);
+
+	return 0;
+}
+
+#endif  //BT_USE_SSE
@@ -0,0 +1,20 @@
+//
+//  Test_btAlignedObjectArray.h
+//  BulletTest
+//
+
+#ifndef BulletTest_Test_btAlignedObjectArray_h
+#define BulletTest_Test_btAlignedObjectArray_h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	int Test_btAlignedObjectArray(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,203 @@
+//
+//  Test_btHashMap.cpp
+//  BulletTest
+//
+
+#include "LinearMath/btScalar.h"
+#if defined(BT_USE_SSE_IN_API) || defined(BT_USE_NEON)
+
+#include "Test_btHashMap.h"
+#include "vector.h"
+#include "Utils.h"
+#include "main.h"
+#include <math.h>
+#include <string.h>
+
+#include <LinearMath/btHashMap.h>
+
+#define LOOPCOUNT 10
+#define NUM_KEYS 100000
+
+// reference code for testing purposes: the separate chaining btHashMap used before open addressing
+template <class Key, class Value>
+class btHashMap_ref
+{
+	btAlignedObjectArray<int> m_hashTable;
+	btAlignedObjectArray<int> m_next;
+	btAlignedObjectArray<Value> m_valueArray;
+	btAlignedObjectArray<Key> m_keyArray;
+
+	void growTables()
+	{
+		int newCapacity = m_valueArray.capacity();
+		if (m_hashTable.size() < newCapacity)
+		{
+			int curHashtableSize = m_hashTable.size();
+			m_hashTable.resize(newCapacity);
+			m_next.resize(newCapacity);
+			for (int i = 0; i < newCapacity; ++i)
+			{
+				m_hashTable[i] = BT_HASH_NULL;
+				m_next[i] = BT_HASH_NULL;
+			}
+			for (int i = 0; i < curHashtableSize; i++)
+			{
+				int hashValue = m_keyArray[i].getHash() & (m_valueArray.capacity() - 1);
+				m_next[i] = m_hashTable[hashValue];
+				m_hashTable[hashValue] = i;
+			}
+		}
+	}
+
+	void unlink(int pairIndex, int hash)
+	{
+		int index = m_hashTable[hash];
+		int previous = BT_HASH_NULL;
+		while (index != pairIndex)
+		{
+			previous = index;
+			index = m_next[index];
+		}
+		if (previous != BT_HASH_NULL)
+			m_next[previous] = m_next[pairIndex];
+		else
+			m_hashTable[hash] = m_next[pairIndex];
+	}
+
+public:
+	void insert(const Key& key, const Value& value)
+	{
+		int index = findIndex(key);
+		if (index != BT_HASH_NULL)
+		{
+			m_valueArray[index] = value;
+			return;
+		}
+		int count = m_valueArray.size();
+		int oldCapacity = m_valueArray.capacity();
+		m_valueArray.push_back(value);
+		m_keyArray.push_back(key);
+		if (oldCapacity < m_valueArray.capacity())
+			growTables();
+		int hash = key.getHash() & (m_valueArray.capacity() - 1);
+		m_next[count] = m_hashTable[hash];
+		m_hashTable[hash] = count;
+	}
+
+	void remove(const Key& key)
+	{
+		int pairIndex = findIndex(key);
+		if (pairIndex == BT_HASH_NULL)
+			return;
+		unlink(pairIndex, key.getHash() & (m_valueArray.capacity() - 1));
+		int lastPairIndex = m_valueArray.size() - 1;
+		if (lastPairIndex != pairIndex)
+		{
+			int lastHash = m_keyArray[lastPairIndex].getHash() & (m_valueArray.capacity() - 1);
+			unlink(lastPairIndex, lastHash);
+			m_valueArray[pairIndex] = m_valueArray[lastPairIndex];
+			m_keyArray[pairIndex] = m_keyArray[lastPairIndex];
+			m_next[pairIndex] = m_hashTable[lastHash];
+			m_hashTable[lastHash] = pairIndex;
+		}
+		m_valueArray.pop_back();
+		m_keyArray.pop_back();
+	}
+
+	int size() const
+	{
+		return m_valueArray.size();
+	}
+
+	const Value* find(const Key& key) const
+	{
+		int index = findIndex(key);
+		return index == BT_HASH_NULL ? 0 : &m_valueArray[index];
+	}
+
+	int findIndex(const Key& key) const
+	{
+		unsigned int hash = key.getHash() & (m_valueArray.capacity() - 1);
+		if (hash >= (unsigned int)m_hashTable.size())
+			return BT_HASH_NULL;
+		int index = m_hashTable[hash];
+		while ((index != BT_HASH_NULL) && key.equals(m_keyArray[index]) == false)
+			index = m_next[index];
+		return index;
+	}
+};
+
+// insert all keys, look up every key and as many missing keys, then remove half of them
+template <class Map>
+static uint64_t runMap(Map& map, const btAlignedObjectArray<const void*>& keys, int& checksum)
+{
+	uint64_t startTime = ReadTicks();
+	for (int i = 0; i < keys.size(); i++)
+	{
+		map.insert(btHashPtr(keys[i]), i);
+	}
+	for (int i = 0; i < keys.size(); i++)
+	{
+		const int* value = map.find(btHashPtr(keys[i]));
+		checksum += value ? *value : -1;
+		value = map.find(btHashPtr((const char*)keys[i] + 1));
+		checksum += value ? *value : -1;
+	}
+	for (int i = 0; i < keys.size(); i += 2)
+	{
+		map.remove(btHashPtr(keys[i]));
+	}
+	checksum += map.size();
+	return ReadTicks() - startTime;
+}
+
+int Test_btHashMap(void)
+{
+	// pointer keys with the spacing of heap allocated objects, like the serializer and importer maps
+	btAlignedObjectArray<const void*> keys;
+	keys.resize(NUM_KEYS);
+	for (int i = 0; i < NUM_KEYS; i++)
+	{
+		keys[i] = (const void*)(size_t)(0x10000 + 64 * (size_t)i + 16 * (random_number32() & 3));
+	}
+	for (int i = NUM_KEYS - 1; i > 0; i--)
+	{
+		keys.swap(i, random_number32() % (i + 1));
+	}
+
+	uint64_t chainedTime = -1LL, openTime = -1LL;
+	for (int j = 0; j < LOOPCOUNT; j++)
+	{
+		int chainedSum = 0, openSum = 0;
+		btHashMap_ref<btHashPtr, int> chained;
+		btHashMap<btHashPtr, int> open;
+		uint64_t currentTime = runMap(chained, keys, chainedSum);
+		if (currentTime < chainedTime)
+			chainedTime = currentTime;
+		currentTime = runMap(open, keys, openSum);
+		if (currentTime < openTime)
+			openTime = currentTime;
+
+		if (chainedSum != openSum)
+		{
+			vlog("Error - btHashMap result error! chained = %d, open addressing = %d\n", chainedSum, openSum);
+			return 1;
+		}
+		for (int i = 1; i < keys.size(); i += 2)
+		{
+			if (*open.find(btHashPtr(keys[i])) != i || open.find(btHashPtr(keys[i - 1])))
+			{
+				vlog("Error - btHashMap lookup error after remove @ %d\n", i);
+				return 1;
+			}
+		}
+	}
+
+	vlog("Timing (%d pointer keys, insert, find, remove):\n", NUM_KEYS);
+	vlog("\t   chained\t      open\n");
+	vlog("\t%10.2f\t%10.2f\n", TicksToCycles(chainedTime) / NUM_KEYS, TicksToCycles(openTime) / NUM_KEYS);
+
+	return 0;
+}
+
+#endif  //BT_USE_SSE
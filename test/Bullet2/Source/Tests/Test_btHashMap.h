@@ -0,0 +1,20 @@
+//
+//  Test_btHashMap.h
+//  BulletTest
+//
+
+#ifndef BulletTest_Test_btHashMap_h
+#define BulletTest_Test_btHashMap_h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	int Test_btHashMap(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,194 @@
+//
+//  Test_btMatrixX.cpp
+//  BulletTest
+//
+
+#include "LinearMath/btScalar.h"
+#if defined(BT_USE_SSE_IN_API) || defined(BT_USE_NEON)
+
+#include "Test_btMatrixX.h"
+#include "vector.h"
+#include "Utils.h"
+#include "main.h"
+#include <math.h>
+#include <string.h>
+
+#include <LinearMath/btMatrixX.h>
+#include <BulletDynamics/MLCPSolvers/btDantzigSolver.h>
+#include <BulletDynamics/MLCPSolvers/btLemkeSolver.h>
+
+#define LOOPCOUNT 10
+#define NUM_BODIES 40
+#define NUM_ROWS 120
+
+// reference code for testing purposes: the element by element product btMatrixX used before the blocked kernels
+static void MatrixXmul_ref(const btMatrixXu &a, const btMatrixXu &b, btMatrixXu &res)
+{
+	res.resize(a.rows(), b.cols());
+	res.setZero();
+	for (int j = 0; j < res.cols(); ++j)
+	{
+		for (int i = 0; i < res.rows(); ++i)
+		{
+			btScalar dotProd = 0;
+			for (int v = 0; v < a.cols(); v++)
+			{
+				if (b(v, j) != 0.f)
+				{
+					dotProd += a(i, v) * b(v, j);
+				}
+			}
+			if (dotProd)
+				res.setElem(i, j, dotProd);
+		}
+	}
+}
+
+static btMatrixXu transpose_ref(const btMatrixXu &a)
+{
+	btMatrixXu tr(a.cols(), a.rows());
+	for (int i = 0; i < a.rows(); i++)
+		for (int j = 0; j < a.cols(); j++)
+			tr.setElem(j, i, a(i, j));
+	return tr;
+}
+
+// J has two 6-wide body blocks per row, like a contact constraint between two bodies
+static void initJacobian(btMatrixXu &J, btMatrixXu &Minv)
+{
+	J.resize(NUM_ROWS, 6 * NUM_BODIES);
+	J.setZero();
+	for (int i = 0; i < NUM_ROWS; i++)
+	{
+		int bodyA = random_number32() % NUM_BODIES;
+		int bodyB = (bodyA + 1 + random_number32() % (NUM_BODIES - 1)) % NUM_BODIES;
+		for (int c = 0; c < 6; c++)
+		{
+			J.setElem(i, 6 * bodyA + c, RANDF_m1p1);
+			J.setElem(i, 6 * bodyB + c, RANDF_m1p1);
+		}
+	}
+
+	Minv.resize(6 * NUM_BODIES, 6 * NUM_BODIES);
+	Minv.setZero();
+	for (int b = 0; b < NUM_BODIES; b++)
+	{
+		btScalar invMass = btScalar(0.5) + RANDF_01;
+		for (int r = 0; r < 3; r++)
+		{
+			Minv.setElem(6 * b + r, 6 * b + r, invMass);
+			Minv.setElem(6 * b + 3 + r, 6 * b + 3 + r, btScalar(0.5) + RANDF_01);
+		}
+	}
+}
+
+static int compare(const btMatrixXu &ref, const btMatrixXu &test, const char *name)
+{
+	for (int i = 0; i < ref.rows(); i++)
+	{
+		for (int j = 0; j < ref.cols(); j++)
+		{
+			btScalar tolerance = btScalar(1e-4) * (btScalar(1) + btFabs(ref(i, j)));
+			if (btFabs(ref(i, j) - test(i, j)) > tolerance)
+			{
+				vlog("Error - %s result error! ", name);
+				vlog("failure @ (%d, %d): correct = %10.4f, tested = %10.4f\n", i, j, ref(i, j), test(i, j));
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static double solveTicks(btMLCPSolverInterface &solver, const btMatrixXu &A, const btVectorXu &b, const btVectorXu &lo, const btVectorXu &hi)
+{
+	btAlignedObjectArray<int> limitDependency;
+	limitDependency.resize(A.rows(), -1);
+	btVectorXu x(A.rows());
+
+	uint64_t bestTime = -1LL;
+	for (int j = 0; j < LOOPCOUNT; j++)
+	{
+		x.setZero();
+		uint64_t startTime = ReadTicks();
+		solver.solveMLCP(A, b, x, lo, hi, limitDependency, 10);
+		uint64_t currentTime = ReadTicks() - startTime;
+		if (currentTime < bestTime)
+			bestTime = currentTime;
+	}
+	return TicksToCycles(bestTime);
+}
+
+int Test_btMatrixX(void)
+{
+	btMatrixXu J, Minv;
+	initJacobian(J, Minv);
+
+	// A = J * Minv * J^T, the way btMLCPSolver::createMLCP used to build it
+	btMatrixXu Jt = transpose_ref(J);
+	btMatrixXu tmp_ref, A_ref;
+	MatrixXmul_ref(J, Minv, tmp_ref);
+	MatrixXmul_ref(tmp_ref, Jt, A_ref);
+
+	btMatrixXu tmp = J * Minv;
+	if (compare(tmp_ref, tmp, "btMatrixX::operator*"))
+		return -1;
+
+	btMatrixXu A(NUM_ROWS, NUM_ROWS);
+	A.setZero();
+	A.addProductTransposed(tmp, J, true);
+	A.copyLowerToUpperTriangle();
+	if (compare(A_ref, A, "btMatrixX::addProductTransposed"))
+		return -1;
+
+	uint64_t scalarTime, vectorTime;
+	uint64_t startTime, bestTime, currentTime;
+	bestTime = -1LL;
+	for (int j = 0; j < LOOPCOUNT; j++)
+	{
+		startTime = ReadTicks();
+		MatrixXmul_ref(J, Minv, tmp_ref);
+		MatrixXmul_ref(tmp_ref, Jt, A_ref);
+		currentTime = ReadTicks() - startTime;
+		if (currentTime < bestTime)
+			bestTime = currentTime;
+	}
+	scalarTime = bestTime;
+
+	bestTime = -1LL;
+	for (int j = 0; j < LOOPCOUNT; j++)
+	{
+		startTime = ReadTicks();
+		tmp.setProduct(J, Minv);
+		A.setZero();
+		A.addProductTransposed(tmp, J, true);
+		A.copyLowerToUpperTriangle();
+		currentTime = ReadTicks() - startTime;
+		if (currentTime < bestTime)
+			bestTime = currentTime;
+	}
+	vectorTime = bestTime;
+
+	vlog("Timing (J*Minv*J^T, %d rows, %d bodies):\n", NUM_ROWS, NUM_BODIES);
+	vlog("\t    scalar\t    vector\n");
+	vlog("\t%10.2f\t%10.2f\n", TicksToCycles(scalarTime), TicksToCycles(vectorTime));
+
+	// the assembled matrix is what the Dantzig and Lemke solvers consume
+	btVectorXu b(NUM_ROWS), lo(NUM_ROWS), hi(NUM_ROWS);
+	for (int i = 0; i < NUM_ROWS; i++)
+	{
+		A.setElem(i, i, A(i, i) + btScalar(0.01));
+		b[i] = RANDF_m1p1;
+		lo[i] = 0;
+		hi[i] = BT_INFINITY;
+	}
+	btDantzigSolver dantzig;
+	btLemkeSolver lemke;
+	vlog("Timing (MLCP solve, %d rows):\n", NUM_ROWS);
+	vlog("\t   Dantzig\t     Lemke\n");
+	vlog("\t%10.2f\t%10.2f\n", solveTicks(dantzig, A, b, lo, hi), solveTicks(lemke, A, b, lo, hi));
+
+	return 0;
+}
+
+#endif  //BT_USE_SSE
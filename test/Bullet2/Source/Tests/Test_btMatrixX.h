@@ -0,0 +1,20 @@
+//
+//  Test_btMatrixX.h
+//  BulletTest
+//
+
+#ifndef BulletTest_Test_btMatrixX_h
+#define BulletTest_Test_btMatrixX_h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	int Test_btMatrixX(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,195 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletDynamics/Featherstone/btMultiBody.h>
+#include <BulletDynamics/Featherstone/btMultiBodyConstraintSolver.h>
+#include <BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.h>
+#include <LinearMath/btAllocatorContext.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+// the custom allocator of btAlignedAllocSetCustom, it records the size of the last request
+static int gNumHeapAllocs = 0;
+static size_t gLastAllocSize = 0;
+
+static void* countingAlloc(size_t size)
+{
+	gNumHeapAllocs++;
+	gLastAllocSize = size;
+	return malloc(size);
+}
+
+static void countingFree(void* ptr)
+{
+	free(ptr);
+}
+
+struct NullAction : public btActionInterface
+{
+	virtual void updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep)
+	{
+	}
+
+	virtual void debugDraw(btIDebugDraw* debugDrawer)
+	{
+	}
+};
+
+GTEST_TEST(LinearMath, AllocatorContextBlocks)
+{
+	// without a context a block only stores the real pointer in front of the aligned pointer
+	void* global = btAlignedAlloc(100, 16);
+	EXPECT_EQ(100 + sizeof(void*) + 15, gLastAllocSize);
+
+	btAllocatorContext context;
+	void* ptr;
+	{
+		btAllocatorContextScope scope(&context);
+		EXPECT_EQ(&context, btGetCurrentAllocatorContext());
+
+		// the default context takes its memory from the installed custom allocator
+		const int numHeapAllocs = gNumHeapAllocs;
+		ptr = btAlignedAlloc(100, 16);
+		EXPECT_EQ(numHeapAllocs + 1, gNumHeapAllocs);
+		EXPECT_EQ(100 + 3 * sizeof(void*) + 15, gLastAllocSize);
+		EXPECT_EQ(0u, size_t(ptr) & 15);
+		EXPECT_EQ(1u, context.getNumLiveBlocks());
+		EXPECT_EQ(gLastAllocSize, context.getLiveBytes());
+
+		// a block allocated without a context is freed to the heap, even while a context is current
+		btAlignedFree(global);
+		EXPECT_EQ(1u, context.getNumLiveBlocks());
+	}
+	EXPECT_TRUE(btGetCurrentAllocatorContext() == 0);
+
+	// a block goes back to its context when no context is current, and when another one is
+	const size_t peakBytes = context.getPeakBytes();
+	btAlignedFree(ptr);
+	EXPECT_EQ(0u, context.getNumLiveBlocks());
+	EXPECT_EQ(0u, context.getLiveBytes());
+	EXPECT_EQ(peakBytes, context.getPeakBytes());
+	btAllocatorContext other;
+	{
+		btAllocatorContextScope scope(&context);
+		ptr = btAlignedAlloc(32, 16);
+	}
+	{
+		btAllocatorContextScope scope(&other);
+		btAlignedFree(ptr);
+	}
+	EXPECT_EQ(0u, context.getNumLiveBlocks());
+	EXPECT_EQ(2u, context.getNumAllocations());
+	EXPECT_EQ(0u, other.getNumAllocations());
+	context.resetPeakBytes();
+	EXPECT_EQ(0u, context.getPeakBytes());
+}
+
+GTEST_TEST(BulletDynamics, AllocatorContextWorld)
+{
+	btAllocatorContext context;
+	btMultiBodyDynamicsWorld* world;
+	btCollisionConfiguration* collisionConfiguration;
+	btDispatcher* dispatcher;
+	btBroadphaseInterface* broadphase;
+	btMultiBodyConstraintSolver* solver;
+	btBoxShape* shape;
+	{
+		btAllocatorContextScope scope(&context);
+		collisionConfiguration = new btDefaultCollisionConfiguration();
+		dispatcher = new btCollisionDispatcher(collisionConfiguration);
+		broadphase = new btDbvtBroadphase();
+		solver = new btMultiBodyConstraintSolver();
+		world = new btMultiBodyDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
+		shape = new btBoxShape(btVector3(1, 1, 1));
+	}
+	EXPECT_EQ(&context, world->getAllocatorContext());
+	EXPECT_GT(context.getNumLiveBlocks(), 0u);
+
+	// the world makes its context current while bodies, constraints, actions and multibodies are added,
+	// so the arrays that grow there are charged to the context and not to the global allocator
+	btAlignedObjectArray<btRigidBody*> bodies;
+	btAlignedObjectArray<btTypedConstraint*> constraints;
+	btAlignedObjectArray<NullAction*> actions;
+	btAlignedObjectArray<btMultiBody*> multiBodies;
+	for (int i = 0; i < 40; i++)
+	{
+		btRigidBody* body = new btRigidBody(1, 0, shape);
+		body->getWorldTransform().setOrigin(btVector3(btScalar(i * 3), 0, 0));
+		bodies.push_back(body);
+		actions.push_back(new NullAction());
+		btMultiBody* multiBody = new btMultiBody(0, 1, btVector3(1, 1, 1), false, false);
+		multiBody->finalizeMultiDof();
+		multiBodies.push_back(multiBody);
+	}
+	for (int i = 1; i < bodies.size(); i++)
+	{
+		constraints.push_back(new btPoint2PointConstraint(*bodies[i - 1], *bodies[i], btVector3(btScalar(1.5), 0, 0), btVector3(btScalar(-1.5), 0, 0)));
+	}
+
+	const size_t numContextAllocations = context.getNumAllocations();
+	const int numHeapAllocs = gNumHeapAllocs;
+	for (int i = 0; i < bodies.size(); i++)
+	{
+		world->addRigidBody(bodies[i]);
+	}
+	const size_t numBodyAllocations = context.getNumAllocations();
+	EXPECT_GT(numBodyAllocations, numContextAllocations);
+	for (int i = 0; i < constraints.size(); i++)
+	{
+		world->addConstraint(constraints[i], true);
+	}
+	const size_t numConstraintAllocations = context.getNumAllocations();
+	EXPECT_GT(numConstraintAllocations, numBodyAllocations);
+	for (int i = 0; i < actions.size(); i++)
+	{
+		world->addAction(actions[i]);
+	}
+	const size_t numActionAllocations = context.getNumAllocations();
+	EXPECT_GT(numActionAllocations, numConstraintAllocations);
+	for (int i = 0; i < multiBodies.size(); i++)
+	{
+		world->addMultiBody(multiBodies[i]);
+	}
+	EXPECT_GT(context.getNumAllocations(), numActionAllocations);
+
+	// the context takes its memory from the custom allocator, so both count the same blocks
+	EXPECT_EQ(int(context.getNumAllocations() - numContextAllocations), gNumHeapAllocs - numHeapAllocs);
+
+	world->stepSimulation(btScalar(1. / 60.), 0);
+
+	for (int i = 0; i < multiBodies.size(); i++)
+	{
+		world->removeMultiBody(multiBodies[i]);
+		delete multiBodies[i];
+	}
+	for (int i = 0; i < actions.size(); i++)
+	{
+		world->removeAction(actions[i]);
+		delete actions[i];
+	}
+	for (int i = 0; i < constraints.size(); i++)
+	{
+		world->removeConstraint(constraints[i]);
+		delete constraints[i];
+	}
+	for (int i = 0; i < bodies.size(); i++)
+	{
+		world->removeRigidBody(bodies[i]);
+		delete bodies[i];
+	}
+	delete shape;
+	delete world;
+	delete solver;
+	delete broadphase;
+	delete dispatcher;
+	delete collisionConfiguration;
+
+	// everything the world allocated went back to the context
+	EXPECT_EQ(0u, context.getNumLiveBlocks());
+	EXPECT_EQ(0u, context.getLiveBytes());
+}
+
+int main(int argc, char** argv)
+{
+	btAlignedAllocSetCustom(countingAlloc, countingFree);
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
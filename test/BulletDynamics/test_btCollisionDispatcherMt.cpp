@@ -0,0 +1,376 @@
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <LinearMath/btPoolAllocator.h>
+#include <LinearMath/btThreads.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+// counts the blocks returned to the heap
+static int gNumHeapFrees = 0;
+
+static void* heapAlloc(size_t size)
+{
+	return malloc(size);
+}
+
+static void countingFree(void* ptr)
+{
+	gNumHeapFrees++;
+	free(ptr);
+}
+
+struct DispatcherScene
+{
+	btDefaultCollisionConfiguration m_collisionConfiguration;
+	btCollisionDispatcherMt m_dispatcher;
+	btSphereShape m_shape;
+	btCollisionObject m_object0;
+	btCollisionObject m_object1;
+
+	DispatcherScene(int poolSize)
+		: m_collisionConfiguration(constructionInfo(poolSize)),
+		  m_dispatcher(&m_collisionConfiguration),
+		  m_shape(1)
+	{
+		m_object0.setCollisionShape(&m_shape);
+		m_object1.setCollisionShape(&m_shape);
+	}
+
+	static btDefaultCollisionConstructionInfo constructionInfo(int poolSize)
+	{
+		btDefaultCollisionConstructionInfo info;
+		info.m_defaultMaxPersistentManifoldPoolSize = poolSize;
+		info.m_defaultMaxCollisionAlgorithmPoolSize = poolSize;
+		return info;
+	}
+
+	btPoolAllocator* manifoldPool()
+	{
+		return m_collisionConfiguration.getPersistentManifoldPool();
+	}
+
+	btPoolAllocator* algorithmPool()
+	{
+		return m_collisionConfiguration.getCollisionAlgorithmPool();
+	}
+};
+
+GTEST_TEST(BulletCollision, DispatcherMtManifoldCache)
+{
+	DispatcherScene scene(64);
+	const int batchSize = scene.m_dispatcher.getCacheBatchSize();
+	btAlignedObjectArray<btPersistentManifold*> manifolds;
+	for (int i = 0; i < 200; i++)
+	{
+		manifolds.push_back(scene.m_dispatcher.getNewManifold(&scene.m_object0, &scene.m_object1));
+	}
+	EXPECT_EQ(64, scene.manifoldPool()->getUsedCount());
+	EXPECT_EQ(200 - 64, scene.m_dispatcher.getManifoldPoolOverflows());
+
+	// the heap blocks go straight back to the heap, and the thread list keeps at most two batches
+	const int numFrees = gNumHeapFrees;
+	for (int i = 0; i < manifolds.size(); i++)
+	{
+		scene.m_dispatcher.releaseManifold(manifolds[i]);
+	}
+	EXPECT_EQ(200 - 64, gNumHeapFrees - numFrees);
+	EXPECT_LE(scene.manifoldPool()->getUsedCount(), 2 * batchSize);
+
+	// so new manifolds come from the pool again
+	scene.m_dispatcher.resetPoolOverflows();
+	manifolds.resize(0);
+	for (int i = 0; i < 64; i++)
+	{
+		btPersistentManifold* manifold = scene.m_dispatcher.getNewManifold(&scene.m_object0, &scene.m_object1);
+		EXPECT_TRUE(scene.manifoldPool()->validPtr(manifold));
+		manifolds.push_back(manifold);
+	}
+	EXPECT_EQ(0, scene.m_dispatcher.getManifoldPoolOverflows());
+	for (int i = 0; i < manifolds.size(); i++)
+	{
+		scene.m_dispatcher.releaseManifold(manifolds[i]);
+	}
+
+	scene.m_dispatcher.releaseCachedBlocks();
+	EXPECT_EQ(0, scene.manifoldPool()->getUsedCount());
+}
+
+GTEST_TEST(BulletCollision, DispatcherMtContiguousManifoldPool)
+{
+	// without the heap fallback released manifolds go straight back to the pool, none wait in a thread list
+	DispatcherScene scene(64);
+	scene.m_dispatcher.setDispatcherFlags(scene.m_dispatcher.getDispatcherFlags() | btCollisionDispatcher::CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION);
+	for (int round = 0; round < 2; round++)
+	{
+		btAlignedObjectArray<btPersistentManifold*> manifolds;
+		for (int i = 0; i < 64; i++)
+		{
+			btPersistentManifold* manifold = scene.m_dispatcher.getNewManifold(&scene.m_object0, &scene.m_object1);
+			EXPECT_TRUE(scene.manifoldPool()->validPtr(manifold));
+			manifolds.push_back(manifold);
+		}
+		EXPECT_EQ(64, scene.manifoldPool()->getUsedCount());
+		for (int i = 0; i < manifolds.size(); i++)
+		{
+			scene.m_dispatcher.releaseManifold(manifolds[i]);
+		}
+		EXPECT_EQ(0, scene.manifoldPool()->getUsedCount());
+	}
+	EXPECT_EQ(0, scene.m_dispatcher.getManifoldPoolOverflows());
+}
+
+GTEST_TEST(BulletCollision, DispatcherMtAlgorithmCache)
+{
+	DispatcherScene scene(64);
+	const int elementSize = scene.algorithmPool()->getElementSize();
+
+	// an algorithm larger than a pool block is freed to the heap instead of joining the free list
+	void* large = scene.m_dispatcher.allocateCollisionAlgorithm(elementSize + 16);
+	EXPECT_FALSE(scene.algorithmPool()->validPtr(large));
+	EXPECT_EQ(1, scene.m_dispatcher.getAlgorithmPoolOverflows());
+	const int numFrees = gNumHeapFrees;
+	scene.m_dispatcher.freeCollisionAlgorithm(large);
+	EXPECT_EQ(1, gNumHeapFrees - numFrees);
+
+	void* small = scene.m_dispatcher.allocateCollisionAlgorithm(elementSize);
+	EXPECT_TRUE(scene.algorithmPool()->validPtr(small));
+	scene.m_dispatcher.freeCollisionAlgorithm(small);
+
+	scene.m_dispatcher.releaseCachedBlocks();
+	EXPECT_EQ(0, scene.algorithmPool()->getUsedCount());
+}
+
+struct CompoundContact
+{
+	int m_index0;
+	int m_index1;
+	btVector3 m_position;
+	btScalar m_distance;
+
+	bool operator<(const CompoundContact& other) const
+	{
+		if (m_index0 != other.m_index0)
+			return m_index0 < other.m_index0;
+		if (m_index1 != other.m_index1)
+			return m_index1 < other.m_index1;
+		for (int i = 0; i < 3; i++)
+		{
+			if (m_position[i] != other.m_position[i])
+				return m_position[i] < other.m_position[i];
+		}
+		return false;
+	}
+};
+
+// two compounds of 64 boxes each, overlapping enough that every frame has more than gCompoundCompoundParallelChildPairThreshold child pairs
+static void collideCompounds(btCollisionDispatcher* dispatcher, btCollisionConfiguration* collisionConfiguration, int numFrames, btAlignedObjectArray<CompoundContact>& contacts)
+{
+	btDbvtBroadphase broadphase;
+	btCollisionWorld world(dispatcher, &broadphase, collisionConfiguration);
+	btBoxShape boxShape(btVector3(btScalar(0.5), btScalar(0.5), btScalar(0.5)));
+	btCompoundShape compounds[2];
+	btCollisionObject objects[2];
+	for (int c = 0; c < 2; c++)
+	{
+		for (int i = 0; i < 64; i++)
+		{
+			btTransform childTrans;
+			childTrans.setIdentity();
+			childTrans.setOrigin(btVector3(btScalar(i % 8), btScalar(c), btScalar(i / 8)) * btScalar(0.95));
+			compounds[c].addChildShape(childTrans, &boxShape);
+		}
+		objects[c].setCollisionShape(&compounds[c]);
+		world.addCollisionObject(&objects[c]);
+	}
+
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		objects[1].getWorldTransform().setOrigin(btVector3(btScalar(0.1) * frame, btScalar(-0.1), btScalar(0.05) * frame));
+		objects[1].getWorldTransform().setRotation(btQuaternion(btVector3(0, 1, 0), btScalar(0.02) * frame));
+		world.performDiscreteCollisionDetection();
+	}
+
+	contacts.resize(0);
+	for (int m = 0; m < dispatcher->getNumManifolds(); m++)
+	{
+		const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(m);
+		const bool swapped = manifold->getBody0() != &objects[0];
+		for (int p = 0; p < manifold->getNumContacts(); p++)
+		{
+			const btManifoldPoint& pt = manifold->getContactPoint(p);
+			CompoundContact contact;
+			contact.m_index0 = swapped ? pt.m_index1 : pt.m_index0;
+			contact.m_index1 = swapped ? pt.m_index0 : pt.m_index1;
+			contact.m_position = pt.m_positionWorldOnB;
+			contact.m_distance = pt.getDistance();
+			contacts.push_back(contact);
+		}
+	}
+	contacts.quickSort(btAlignedObjectArray<CompoundContact>::less());
+	world.removeCollisionObject(&objects[0]);
+	world.removeCollisionObject(&objects[1]);
+}
+
+static void expectSameContacts(const btAlignedObjectArray<CompoundContact>& expected, const btAlignedObjectArray<CompoundContact>& actual)
+{
+	ASSERT_EQ(expected.size(), actual.size());
+	for (int i = 0; i < expected.size(); i++)
+	{
+		EXPECT_EQ(expected[i].m_index0, actual[i].m_index0);
+		EXPECT_EQ(expected[i].m_index1, actual[i].m_index1);
+		EXPECT_TRUE(expected[i].m_position == actual[i].m_position);
+		EXPECT_EQ(expected[i].m_distance, actual[i].m_distance);
+	}
+}
+
+GTEST_TEST(BulletCollision, DispatcherMtCompoundChildPairs)
+{
+	// the child pairs are processed after the pairs, with the same contacts as the plain dispatcher
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btAlignedObjectArray<CompoundContact> expected;
+	{
+		btCollisionDispatcher dispatcher(&collisionConfiguration);
+		collideCompounds(&dispatcher, &collisionConfiguration, 4, expected);
+	}
+	EXPECT_GT(expected.size(), 0);
+
+	btAlignedObjectArray<CompoundContact> contacts;
+	{
+		btCollisionDispatcherMt dispatcher(&collisionConfiguration);
+		collideCompounds(&dispatcher, &collisionConfiguration, 4, contacts);
+		dispatcher.releaseCachedBlocks();
+	}
+	expectSameContacts(expected, contacts);
+}
+
+#if BT_THREADSAFE
+// forwards to another scheduler and counts the parallel loops that start while another one is running
+class NestingTaskScheduler : public btITaskScheduler
+{
+	btITaskScheduler* m_scheduler;
+	btSpinMutex m_mutex;
+	int m_numRunning;
+
+public:
+	int m_numLoops;
+	int m_numNestedLoops;
+
+	NestingTaskScheduler(btITaskScheduler* scheduler)
+		: btITaskScheduler("Nesting"), m_scheduler(scheduler), m_numRunning(0), m_numLoops(0), m_numNestedLoops(0)
+	{
+	}
+
+	virtual int getMaxNumThreads() const { return m_scheduler->getMaxNumThreads(); }
+	virtual int getNumThreads() const { return m_scheduler->getNumThreads(); }
+	virtual void setNumThreads(int numThreads) { m_scheduler->setNumThreads(numThreads); }
+
+	virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+	{
+		m_mutex.lock();
+		m_numLoops++;
+		m_numNestedLoops += m_numRunning ? 1 : 0;
+		m_numRunning++;
+		m_mutex.unlock();
+		m_scheduler->parallelFor(iBegin, iEnd, grainSize, body);
+		m_mutex.lock();
+		m_numRunning--;
+		m_mutex.unlock();
+	}
+
+	virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+	{
+		return m_scheduler->parallelSum(iBegin, iEnd, grainSize, body);
+	}
+};
+
+GTEST_TEST(BulletCollision, DispatcherMtCompoundChildPairsThreads)
+{
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (!scheduler)
+	{
+		return;
+	}
+	scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+	NestingTaskScheduler nesting(scheduler);
+	btSetTaskScheduler(&nesting);
+
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btAlignedObjectArray<CompoundContact> expected;
+	{
+		btCollisionDispatcher dispatcher(&collisionConfiguration);
+		collideCompounds(&dispatcher, &collisionConfiguration, 4, expected);
+	}
+	btAlignedObjectArray<CompoundContact> contacts;
+	{
+		btCollisionDispatcherMt dispatcher(&collisionConfiguration);
+		collideCompounds(&dispatcher, &collisionConfiguration, 4, contacts);
+		dispatcher.releaseCachedBlocks();
+	}
+	expectSameContacts(expected, contacts);
+
+	// one loop over the pairs and one over the child pairs per frame, none of them inside another
+	EXPECT_EQ(8, nesting.m_numLoops);
+	EXPECT_EQ(0, nesting.m_numNestedLoops);
+
+	btSetTaskScheduler(previous);
+	delete scheduler;
+}
+
+struct FreeAlgorithmsLoop : public btIParallelForBody
+{
+	btCollisionDispatcherMt* m_dispatcher;
+	void* const* m_algorithms;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			m_dispatcher->freeCollisionAlgorithm(m_algorithms[i]);
+		}
+	}
+};
+
+GTEST_TEST(BulletCollision, DispatcherMtAlgorithmCacheThreads)
+{
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (!scheduler)
+	{
+		return;
+	}
+	scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+	btSetTaskScheduler(scheduler);
+
+	// blocks allocated on the main thread and freed on the workers go back to the pool past two batches per thread
+	DispatcherScene scene(1024);
+	const int batchSize = scene.m_dispatcher.getCacheBatchSize();
+	const int elementSize = scene.algorithmPool()->getElementSize();
+	for (int round = 0; round < 3; round++)
+	{
+		btAlignedObjectArray<void*> algorithms;
+		for (int i = 0; i < 512; i++)
+		{
+			algorithms.push_back(scene.m_dispatcher.allocateCollisionAlgorithm(elementSize));
+		}
+		FreeAlgorithmsLoop loop;
+		loop.m_dispatcher = &scene.m_dispatcher;
+		loop.m_algorithms = &algorithms[0];
+		btParallelFor(0, algorithms.size(), 8, loop);
+		EXPECT_LE(scene.algorithmPool()->getUsedCount(), 2 * batchSize * (scheduler->getNumThreads() + 1));
+	}
+	EXPECT_EQ(0, scene.m_dispatcher.getAlgorithmPoolOverflows());
+	scene.m_dispatcher.releaseCachedBlocks();
+	EXPECT_EQ(0, scene.algorithmPool()->getUsedCount());
+
+	btSetTaskScheduler(previous);
+	delete scheduler;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+	btAlignedAllocSetCustom(heapAlloc, countingFree);
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,139 @@
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/BroadphaseCollision/btDbvt.h>
+#include <gtest/gtest.h>
+
+static void expectVolumeEq(const btDbvtVolume& expected, const btDbvtVolume& actual)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		EXPECT_EQ(expected.Mins()[i], actual.Mins()[i]);
+		EXPECT_EQ(expected.Maxs()[i], actual.Maxs()[i]);
+	}
+}
+
+// checks that every internal node bounds exactly its two children, and returns the number of leaves
+static int checkRefitted(const btDbvtNode* node)
+{
+	if (node->isleaf())
+	{
+		return 1;
+	}
+	btDbvtVolume merged;
+	Merge(node->childs[0]->volume, node->childs[1]->volume, merged);
+	expectVolumeEq(merged, node->volume);
+	return checkRefitted(node->childs[0]) + checkRefitted(node->childs[1]);
+}
+
+static btTransform childTransform(int i, btScalar t)
+{
+	btTransform tr;
+	tr.setIdentity();
+	tr.setOrigin(btVector3(btScalar(i % 8) * 3 + btSin(t * i) * 2, btScalar(i / 8) * 3, btCos(t + i)));
+	tr.setRotation(btQuaternion(btVector3(0, 1, 0), t * btScalar(i + 1)));
+	return tr;
+}
+
+GTEST_TEST(BulletCollision, DbvtRefit)
+{
+	const int numLeaves = 100;
+	btDbvt tree;
+	btDbvt rebuilt;
+	btAlignedObjectArray<btDbvtNode*> leaves;
+	for (int i = 0; i < numLeaves; i++)
+	{
+		const btVector3 center(btScalar(i % 10), btScalar(i / 10), 0);
+		leaves.push_back(tree.insert(btDbvtVolume::FromCE(center, btVector3(btScalar(0.4), btScalar(0.4), btScalar(0.4))), 0));
+	}
+
+	// move the leaves in place, far enough that the old internal volumes no longer bound them
+	for (int i = 0; i < numLeaves; i++)
+	{
+		const btVector3 center(btScalar(i % 10) * 2, btScalar(i / 10) * -3, btScalar(i % 7));
+		leaves[i]->volume = btDbvtVolume::FromCE(center, btVector3(btScalar(0.5), btScalar(0.5), btScalar(0.5)));
+		rebuilt.insert(leaves[i]->volume, 0);
+	}
+	tree.refit();
+
+	EXPECT_EQ(numLeaves, checkRefitted(tree.m_root));
+	// the root of a full rebuild bounds the same leaves
+	expectVolumeEq(rebuilt.m_root->volume, tree.m_root->volume);
+}
+
+GTEST_TEST(BulletCollision, CompoundShapeUpdateChildTransforms)
+{
+	const int numChildren = 64;
+	btBoxShape boxShape(btVector3(btScalar(0.5), btScalar(0.25), 1));
+	btSphereShape sphereShape(btScalar(0.75));
+	btCompoundShape compound;
+	btCompoundShape single;
+	for (int i = 0; i < numChildren; i++)
+	{
+		btCollisionShape* shape = (i & 1) ? (btCollisionShape*)&boxShape : (btCollisionShape*)&sphereShape;
+		compound.addChildShape(childTransform(i, 0), shape);
+		single.addChildShape(childTransform(i, 0), shape);
+	}
+
+	// update every other child in one batch, and the same children one by one on the other compound
+	btAlignedObjectArray<int> indices;
+	btAlignedObjectArray<btTransform> transforms;
+	for (int i = 0; i < numChildren; i += 2)
+	{
+		indices.push_back(i);
+		transforms.push_back(childTransform(i, btScalar(0.7)));
+		single.updateChildTransform(i, transforms[transforms.size() - 1]);
+	}
+	compound.updateChildTransforms(indices.size(), &indices[0], &transforms[0]);
+
+	// a compound built from scratch with the new transforms is the reference
+	btCompoundShape rebuilt;
+	for (int i = 0; i < numChildren; i++)
+	{
+		rebuilt.addChildShape(i & 1 ? childTransform(i, 0) : childTransform(i, btScalar(0.7)), compound.getChildShape(i));
+	}
+
+	ASSERT_EQ(numChildren, compound.getNumChildShapes());
+	for (int i = 0; i < numChildren; i++)
+	{
+		const btCompoundShapeChild& child = compound.getChildList()[i];
+		const btCompoundShapeChild& reference = rebuilt.getChildList()[i];
+		EXPECT_TRUE(child.m_transform == reference.m_transform);
+		EXPECT_TRUE(child.m_transform == single.getChildTransform(i));
+		EXPECT_EQ(i, child.m_node->dataAsInt);
+		expectVolumeEq(reference.m_node->volume, child.m_node->volume);
+	}
+	EXPECT_EQ(numChildren, checkRefitted(compound.getDynamicAabbTree()->m_root));
+
+	btTransform identity;
+	identity.setIdentity();
+	btVector3 aabbMin, aabbMax, rebuiltMin, rebuiltMax, singleMin, singleMax;
+	compound.getAabb(identity, aabbMin, aabbMax);
+	rebuilt.getAabb(identity, rebuiltMin, rebuiltMax);
+	single.getAabb(identity, singleMin, singleMax);
+	for (int i = 0; i < 3; i++)
+	{
+		EXPECT_FLOAT_EQ(rebuiltMin[i], aabbMin[i]);
+		EXPECT_FLOAT_EQ(rebuiltMax[i], aabbMax[i]);
+		EXPECT_FLOAT_EQ(rebuiltMin[i], singleMin[i]);
+		EXPECT_FLOAT_EQ(rebuiltMax[i], singleMax[i]);
+	}
+
+	// without the dynamic aabb tree the local aabb is recomputed from the children
+	btCompoundShape noTree(false);
+	for (int i = 0; i < numChildren; i++)
+	{
+		noTree.addChildShape(childTransform(i, 0), compound.getChildShape(i));
+	}
+	noTree.updateChildTransforms(indices.size(), &indices[0], &transforms[0]);
+	noTree.getAabb(identity, aabbMin, aabbMax);
+	for (int i = 0; i < 3; i++)
+	{
+		EXPECT_FLOAT_EQ(rebuiltMin[i], aabbMin[i]);
+		EXPECT_FLOAT_EQ(rebuiltMax[i], aabbMax[i]);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,235 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletSoftBody/btSoftRigidDynamicsWorld.h>
+#include <BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h>
+#include <BulletSoftBody/btDefaultSoftBodySolver.h>
+#include <BulletSoftBody/btSoftBodyHelpers.h>
+#include <LinearMath/btThreads.h>
+#include <gtest/gtest.h>
+
+struct SoftBodyScene
+{
+	btSoftBodyRigidBodyCollisionConfiguration m_collisionConfiguration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btSequentialImpulseConstraintSolver m_solver;
+	btDefaultSoftBodySolver m_softBodySolver;
+	btSoftRigidDynamicsWorld m_world;
+	btBoxShape m_groundShape;
+	btBoxShape m_boxShape;
+	btRigidBody m_ground;
+	btAlignedObjectArray<btRigidBody*> m_boxes;
+	btAlignedObjectArray<btSoftBody*> m_softBodies;
+
+	// cloths anchored to a shared dynamic box, cloths falling onto each other and free cloths
+	SoftBodyScene(bool useMultithreading, bool useLinkColoring)
+		: m_dispatcher(&m_collisionConfiguration),
+		  m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_collisionConfiguration, &m_softBodySolver),
+		  m_groundShape(btVector3(50, 1, 50)),
+		  m_boxShape(btVector3(1, btScalar(0.25), btScalar(0.25))),
+		  m_ground(0, 0, &m_groundShape)
+	{
+		m_softBodySolver.setUseMultithreading(useMultithreading);
+		m_softBodySolver.setUseLinkColoring(useLinkColoring);
+		m_softBodySolver.setMinLinkColorSize(16);
+
+		m_world.setGravity(btVector3(0, -10, 0));
+		btSoftBodyWorldInfo& worldInfo = m_world.getWorldInfo();
+		worldInfo.m_gravity.setValue(0, -10, 0);
+
+		m_ground.getWorldTransform().setOrigin(btVector3(0, -1, 0));
+		m_world.addRigidBody(&m_ground);
+
+		// two cloths hanging from the same dynamic box form one group
+		btVector3 inertia;
+		m_boxShape.calculateLocalInertia(1, inertia);
+		btRigidBody* box = new btRigidBody(1, 0, &m_boxShape, inertia);
+		box->getWorldTransform().setOrigin(btVector3(0, 4, 0));
+		m_world.addRigidBody(box);
+		m_boxes.push_back(box);
+		for (int i = 0; i < 2; i++)
+		{
+			btScalar x = btScalar(i) - btScalar(1);
+			btSoftBody* cloth = btSoftBodyHelpers::CreatePatch(worldInfo, btVector3(x, 4, -1), btVector3(x + 1, 4, -1),
+															   btVector3(x, 4, 1), btVector3(x + 1, 4, 1), 9, 9, 0, true);
+			cloth->appendAnchor(0, box);
+			cloth->appendAnchor(8, box);
+			addSoftBody(cloth);
+		}
+
+		// a stack of cloths falling onto each other and onto the ground
+		for (int i = 0; i < 3; i++)
+		{
+			btScalar y = btScalar(0.5) + btScalar(i) * btScalar(0.3);
+			btSoftBody* cloth = btSoftBodyHelpers::CreatePatch(worldInfo, btVector3(4, y, -1), btVector3(6, y, -1),
+															   btVector3(4, y, 1), btVector3(6, y, 1), 11, 11, 0, true);
+			cloth->m_cfg.collisions |= btSoftBody::fCollision::VF_SS;
+			addSoftBody(cloth);
+		}
+
+		// independent cloths
+		for (int i = 0; i < 4; i++)
+		{
+			btScalar z = btScalar(4 + 3 * i);
+			btSoftBody* cloth = btSoftBodyHelpers::CreatePatch(worldInfo, btVector3(-1, 2, z), btVector3(1, 2, z),
+															   btVector3(-1, 2, z + 2), btVector3(1, 2, z + 2), 13, 13, 1 + 2, true);
+			addSoftBody(cloth);
+		}
+	}
+
+	void addSoftBody(btSoftBody* psb)
+	{
+		psb->m_cfg.piterations = 4;
+		psb->m_materials[0]->m_kLST = btScalar(0.8);
+		psb->setTotalMass(1);
+		m_world.addSoftBody(psb);
+		m_softBodies.push_back(psb);
+	}
+
+	~SoftBodyScene()
+	{
+		for (int i = 0; i < m_softBodies.size(); i++)
+		{
+			m_world.removeSoftBody(m_softBodies[i]);
+			delete m_softBodies[i];
+		}
+		for (int i = 0; i < m_boxes.size(); i++)
+		{
+			m_world.removeRigidBody(m_boxes[i]);
+			delete m_boxes[i];
+		}
+		m_world.removeRigidBody(&m_ground);
+	}
+
+	void step(int numSteps)
+	{
+		for (int i = 0; i < numSteps; i++)
+		{
+			m_world.stepSimulation(btScalar(1. / 60.), 0);
+		}
+	}
+
+	void getNodePositions(btAlignedObjectArray<btVector3>& positions) const
+	{
+		positions.resize(0);
+		for (int i = 0; i < m_softBodies.size(); i++)
+		{
+			const btSoftBody::tNodeArray& nodes = m_softBodies[i]->m_nodes;
+			for (int j = 0; j < nodes.size(); j++)
+			{
+				positions.push_back(nodes[j].m_x);
+			}
+		}
+	}
+
+	// mean relative deviation of the link lengths from their rest lengths
+	btScalar getLinkStretch() const
+	{
+		btScalar stretch = 0;
+		int numLinks = 0;
+		for (int i = 0; i < m_softBodies.size(); i++)
+		{
+			const btSoftBody::tLinkArray& links = m_softBodies[i]->m_links;
+			for (int j = 0; j < links.size(); j++)
+			{
+				stretch += btFabs((links[j].m_n[0]->m_x - links[j].m_n[1]->m_x).length() - links[j].m_rl) / links[j].m_rl;
+				numLinks++;
+			}
+		}
+		return stretch / btScalar(numLinks);
+	}
+};
+
+static void runScene(bool useMultithreading, bool useLinkColoring, btAlignedObjectArray<btVector3>& positions)
+{
+	SoftBodyScene scene(useMultithreading, useLinkColoring);
+	scene.step(60);
+	scene.getNodePositions(positions);
+}
+
+static void expectSamePositions(const btAlignedObjectArray<btVector3>& expected, const btAlignedObjectArray<btVector3>& actual)
+{
+	ASSERT_EQ(expected.size(), actual.size());
+	for (int i = 0; i < expected.size(); i++)
+	{
+		EXPECT_EQ(expected[i].x(), actual[i].x());
+		EXPECT_EQ(expected[i].y(), actual[i].y());
+		EXPECT_EQ(expected[i].z(), actual[i].z());
+	}
+}
+
+// runs fn with the default task scheduler using 1, 2 and 4 threads, or once when there is no threaded scheduler
+template <typename Fn>
+static void forEachThreadCount(Fn fn)
+{
+#if BT_THREADSAFE
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (scheduler)
+	{
+		btSetTaskScheduler(scheduler);
+		for (int numThreads = 1; numThreads <= 4; numThreads *= 2)
+		{
+			scheduler->setNumThreads(btMin(numThreads, scheduler->getMaxNumThreads()));
+			fn();
+		}
+		btSetTaskScheduler(previous);
+		delete scheduler;
+		return;
+	}
+#endif
+	fn();
+}
+
+struct CompareWithReference
+{
+	bool m_useLinkColoring;
+	const btAlignedObjectArray<btVector3>* m_reference;
+
+	void operator()() const
+	{
+		btAlignedObjectArray<btVector3> positions;
+		runScene(true, m_useLinkColoring, positions);
+		expectSamePositions(*m_reference, positions);
+	}
+};
+
+GTEST_TEST(BulletSoftBody, DefaultSoftBodySolverMultithreading)
+{
+	// grouping coupled bodies keeps the serial order, so the results are bit-exact
+	btAlignedObjectArray<btVector3> serial;
+	runScene(false, false, serial);
+	ASSERT_GT(serial.size(), 0);
+
+	CompareWithReference compare;
+	compare.m_useLinkColoring = false;
+	compare.m_reference = &serial;
+	forEachThreadCount(compare);
+}
+
+GTEST_TEST(BulletSoftBody, DefaultSoftBodySolverLinkColoring)
+{
+	// link coloring changes the update order, so it only has to keep the links as tight as the serial solver
+	SoftBodyScene serial(false, false);
+	SoftBodyScene colored(true, true);
+	serial.step(60);
+	colored.step(60);
+	for (int i = 0; i < colored.m_softBodies.size(); i++)
+	{
+		EXPECT_TRUE(colored.m_softBodies[i]->hasLinkColoring());
+	}
+	EXPECT_LT(colored.getLinkStretch(), serial.getLinkStretch() * btScalar(1.5));
+
+	// but the result does not depend on the thread count
+	btAlignedObjectArray<btVector3> positions;
+	colored.getNodePositions(positions);
+	CompareWithReference compare;
+	compare.m_useLinkColoring = true;
+	compare.m_reference = &positions;
+	forEachThreadCount(compare);
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
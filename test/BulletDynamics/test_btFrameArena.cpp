@@ -0,0 +1,193 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
+#include <BulletCollision/Gimpact/btGImpactShape.h>
+#include <LinearMath/btFrameArena.h>
+#include <LinearMath/btThreads.h>
+#include <gtest/gtest.h>
+
+static size_t getNumAllocations()
+{
+	size_t numAllocations, numBytes;
+	btAlignedAllocGetCounters(&numAllocations, &numBytes);
+	return numAllocations;
+}
+
+GTEST_TEST(LinearMath, FrameArena)
+{
+	btFrameArena arena(1024);
+	for (int i = 0; i < 10; i++)
+	{
+		void* ptr = arena.allocate(100, 16);
+		EXPECT_EQ(0u, size_t(ptr) & 15);
+	}
+	EXPECT_GE(arena.getUsedBytes(), size_t(1000));
+	EXPECT_GE(arena.getCapacityBytes(), arena.getUsedBytes());
+
+	// after a reset the blocks are merged, so the same allocations no longer touch the heap
+	arena.reset();
+	EXPECT_EQ(0u, arena.getUsedBytes());
+	const size_t capacity = arena.getCapacityBytes();
+	const size_t numAllocations = getNumAllocations();
+	for (int i = 0; i < 10; i++)
+	{
+		arena.allocate(100, 16);
+	}
+	EXPECT_EQ(numAllocations, getNumAllocations());
+	EXPECT_EQ(capacity, arena.getCapacityBytes());
+	arena.reset();
+	EXPECT_GE(arena.getHighWaterMark(), size_t(1000));
+
+	// an array uses the arena up to its capacity and moves to the heap beyond that
+	btAlignedObjectArray<int> array;
+	arena.initializeArray(array, 16);
+	array.resize(16);
+	EXPECT_EQ(numAllocations, getNumAllocations());
+	array.push_back(0);
+	EXPECT_EQ(numAllocations + 1, getNumAllocations());
+	array.clear();
+
+	arena.releaseMemory();
+	EXPECT_EQ(0u, arena.getCapacityBytes());
+}
+
+GTEST_TEST(LinearMath, AlignedAllocCounters)
+{
+	size_t numAllocations, numBytes;
+	btAlignedAllocGetCounters(&numAllocations, &numBytes);
+	void* ptr = btAlignedAlloc(100, 16);
+	size_t numAllocationsAfter, numBytesAfter;
+	btAlignedAllocGetCounters(&numAllocationsAfter, &numBytesAfter);
+	btAlignedFree(ptr);
+	EXPECT_EQ(numAllocations + 1, numAllocationsAfter);
+	EXPECT_EQ(numBytes + 100, numBytesAfter);
+}
+
+#if BT_THREADSAFE
+struct AllocateLoop : public btIParallelForBody
+{
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			btAlignedFree(btAlignedAlloc(16, 16));
+		}
+	}
+};
+
+GTEST_TEST(LinearMath, AlignedAllocCountersThreads)
+{
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (!scheduler)
+	{
+		return;
+	}
+	scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+	btSetTaskScheduler(scheduler);
+
+	// no allocation is lost while threads allocate at the same time
+	size_t numAllocations, numBytes;
+	btAlignedAllocGetCounters(&numAllocations, &numBytes);
+	AllocateLoop loop;
+	btParallelFor(0, 100000, 100, loop);
+	size_t numAllocationsAfter, numBytesAfter;
+	btAlignedAllocGetCounters(&numAllocationsAfter, &numBytesAfter);
+	EXPECT_EQ(numAllocations + 100000, numAllocationsAfter);
+	EXPECT_EQ(numBytes + 16 * 100000, numBytesAfter);
+
+	btSetTaskScheduler(previous);
+	delete scheduler;
+}
+#endif
+
+// a grid and a sphere sunk into it, so the GImpact narrowphase takes its scratch arrays from the arena
+static void createMeshes(btTriangleMesh& grid, btTriangleMesh& sphere)
+{
+	const int gridSize = 8;
+	for (int i = 0; i < gridSize; i++)
+	{
+		for (int j = 0; j < gridSize; j++)
+		{
+			btVector3 v[4];
+			for (int k = 0; k < 4; k++)
+			{
+				v[k].setValue(btScalar(i + (k & 1) - gridSize / 2) * btScalar(0.5), 0, btScalar(j + (k >> 1) - gridSize / 2) * btScalar(0.5));
+			}
+			grid.addTriangle(v[0], v[1], v[2]);
+			grid.addTriangle(v[1], v[3], v[2]);
+		}
+	}
+	const int stacks = 8;
+	const int slices = 12;
+	for (int i = 0; i < stacks; i++)
+	{
+		for (int j = 0; j < slices; j++)
+		{
+			btVector3 v[4];
+			for (int k = 0; k < 4; k++)
+			{
+				btScalar theta = SIMD_PI * btScalar(i + (k >> 1)) / btScalar(stacks);
+				btScalar phi = SIMD_2_PI * btScalar(j + (k & 1)) / btScalar(slices);
+				v[k].setValue(btSin(theta) * btCos(phi), btCos(theta), btSin(theta) * btSin(phi));
+			}
+			sphere.addTriangle(v[0], v[2], v[1]);
+			sphere.addTriangle(v[1], v[2], v[3]);
+		}
+	}
+}
+
+GTEST_TEST(BulletDynamics, FrameArenaCollisionDetection)
+{
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	btGImpactCollisionAlgorithm::registerAlgorithm(&dispatcher);
+	btDbvtBroadphase broadphase;
+	btSequentialImpulseConstraintSolver solver;
+	btDiscreteDynamicsWorld world(&dispatcher, &broadphase, &solver, &collisionConfiguration);
+	btFrameArena arena;
+	world.setFrameArena(&arena);
+
+	btTriangleMesh gridMesh;
+	btTriangleMesh sphereMesh;
+	createMeshes(gridMesh, sphereMesh);
+	btGImpactMeshShape gridShape(&gridMesh);
+	btGImpactMeshShape sphereShape(&sphereMesh);
+	gridShape.updateBound();
+	sphereShape.updateBound();
+	btCollisionObject gridObject;
+	gridObject.setCollisionShape(&gridShape);
+	btCollisionObject sphereObject;
+	sphereObject.setCollisionShape(&sphereShape);
+	sphereObject.getWorldTransform().setOrigin(btVector3(btScalar(0.1), btScalar(0.7), btScalar(-0.05)));
+	world.addCollisionObject(&gridObject, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter);
+	world.addCollisionObject(&sphereObject, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter);
+
+	// collision detection without stepping resets the arena every time, so it does not grow
+	size_t capacity = 0;
+	for (int i = 0; i < 10; i++)
+	{
+		world.performDiscreteCollisionDetection();
+		EXPECT_EQ(0u, arena.getUsedBytes());
+		EXPECT_TRUE(world.getDispatchInfo().m_frameArena == 0);
+		if (i == 1)
+		{
+			capacity = arena.getCapacityBytes();
+		}
+		if (i > 1)
+		{
+			EXPECT_EQ(capacity, arena.getCapacityBytes());
+		}
+	}
+	EXPECT_GT(arena.getHighWaterMark(), 0u);
+	EXPECT_GT(dispatcher.getNumManifolds(), 0);
+	EXPECT_GT(dispatcher.getManifoldByIndexInternal(0)->getNumContacts(), 0);
+
+	world.removeCollisionObject(&sphereObject);
+	world.removeCollisionObject(&gridObject);
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
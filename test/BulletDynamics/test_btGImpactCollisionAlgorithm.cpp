@@ -0,0 +1,246 @@
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
+#include <BulletCollision/Gimpact/btGImpactShape.h>
+#include <BulletCollision/Gimpact/btContactProcessing.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h>
+#include <gtest/gtest.h>
+
+struct RecordedContact
+{
+	btVector3 m_normal;
+	btVector3 m_point;
+	btScalar m_depth;
+	int m_index0;
+	int m_index1;
+};
+
+class ContactRecorder : public btManifoldResult
+{
+public:
+	btAlignedObjectArray<RecordedContact> m_contacts;
+
+	ContactRecorder(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap)
+		: btManifoldResult(body0Wrap, body1Wrap)
+	{
+	}
+
+	virtual void addContactPoint(const btVector3& normalOnBInWorld, const btVector3& pointInWorld, btScalar depth)
+	{
+		RecordedContact contact;
+		contact.m_normal = normalOnBInWorld;
+		contact.m_point = pointInWorld;
+		contact.m_depth = depth;
+		contact.m_index0 = m_index0;
+		contact.m_index1 = m_index1;
+		m_contacts.push_back(contact);
+	}
+};
+
+//the former recursive tree traversal, kept here as reference for the explicit stack version
+static void findPairsRecursive(const btGImpactQuantizedBvh* boxset0, const btGImpactQuantizedBvh* boxset1,
+							   btPairSet& pairs, const BT_BOX_BOX_TRANSFORM_CACHE& cache,
+							   int node0, int node1, bool completePrimitiveTests)
+{
+	btAABB box0;
+	boxset0->getNodeBound(node0, box0);
+	btAABB box1;
+	boxset1->getNodeBound(node1, box1);
+	if (!box0.overlapping_trans_cache(box1, cache, completePrimitiveTests)) return;
+
+	if (boxset0->isLeafNode(node0))
+	{
+		if (boxset1->isLeafNode(node1))
+		{
+			pairs.push_pair(boxset0->getNodeData(node0), boxset1->getNodeData(node1));
+			return;
+		}
+		findPairsRecursive(boxset0, boxset1, pairs, cache, node0, boxset1->getLeftNode(node1), false);
+		findPairsRecursive(boxset0, boxset1, pairs, cache, node0, boxset1->getRightNode(node1), false);
+	}
+	else if (boxset1->isLeafNode(node1))
+	{
+		findPairsRecursive(boxset0, boxset1, pairs, cache, boxset0->getLeftNode(node0), node1, false);
+		findPairsRecursive(boxset0, boxset1, pairs, cache, boxset0->getRightNode(node0), node1, false);
+	}
+	else
+	{
+		findPairsRecursive(boxset0, boxset1, pairs, cache, boxset0->getLeftNode(node0), boxset1->getLeftNode(node1), false);
+		findPairsRecursive(boxset0, boxset1, pairs, cache, boxset0->getLeftNode(node0), boxset1->getRightNode(node1), false);
+		findPairsRecursive(boxset0, boxset1, pairs, cache, boxset0->getRightNode(node0), boxset1->getLeftNode(node1), false);
+		findPairsRecursive(boxset0, boxset1, pairs, cache, boxset0->getRightNode(node0), boxset1->getRightNode(node1), false);
+	}
+}
+
+//the former per pair triangle collision of btGImpactCollisionAlgorithm::collide_sat_triangles
+static void collideReference(const btGImpactMeshShapePart* part0, const btTransform& trans0,
+							 const btGImpactMeshShapePart* part1, const btTransform& trans1,
+							 btAlignedObjectArray<RecordedContact>& contacts, btContactArray& triangleContacts)
+{
+	BT_BOX_BOX_TRANSFORM_CACHE cache;
+	cache.calc_from_homogenic(trans0, trans1);
+	btPairSet pairs;
+	findPairsRecursive(part0->getBoxSet(), part1->getBoxSet(), pairs, cache, 0, 0, true);
+
+	part0->lockChildShapes();
+	part1->lockChildShapes();
+	for (int i = 0; i < pairs.size(); i++)
+	{
+		btPrimitiveTriangle ptri0;
+		btPrimitiveTriangle ptri1;
+		part0->getPrimitiveTriangle(pairs[i].m_index1, ptri0);
+		part1->getPrimitiveTriangle(pairs[i].m_index2, ptri1);
+		ptri0.applyTransform(trans0);
+		ptri1.applyTransform(trans1);
+		ptri0.buildTriPlane();
+		ptri1.buildTriPlane();
+
+		GIM_TRIANGLE_CONTACT contactData;
+		if (ptri0.overlap_test_conservative(ptri1) && ptri0.find_triangle_collision_clip_method(ptri1, contactData))
+		{
+			triangleContacts.push_triangle_contacts(contactData, pairs[i].m_index1, pairs[i].m_index2);
+			int j = contactData.m_point_count;
+			while (j--)
+			{
+				RecordedContact contact;
+				contact.m_normal = contactData.m_separating_normal;
+				contact.m_point = contactData.m_points[j];
+				contact.m_depth = -contactData.m_penetration_depth;
+				contact.m_index0 = pairs[i].m_index1;
+				contact.m_index1 = pairs[i].m_index2;
+				contacts.push_back(contact);
+			}
+		}
+	}
+	part0->unlockChildShapes();
+	part1->unlockChildShapes();
+}
+
+//a wavy grid and a sphere sunk into it, so that many triangle pairs overlap
+static void createMeshes(btTriangleMesh& grid, btTriangleMesh& sphere)
+{
+	const int gridSize = 16;
+	for (int i = 0; i < gridSize; i++)
+	{
+		for (int j = 0; j < gridSize; j++)
+		{
+			btVector3 v[4];
+			for (int k = 0; k < 4; k++)
+			{
+				btScalar x = btScalar(i + (k & 1) - gridSize / 2) * btScalar(0.25);
+				btScalar z = btScalar(j + (k >> 1) - gridSize / 2) * btScalar(0.25);
+				v[k].setValue(x, btScalar(0.05) * btSin(x * 3) * btCos(z * 2), z);
+			}
+			grid.addTriangle(v[0], v[1], v[2]);
+			grid.addTriangle(v[1], v[3], v[2]);
+		}
+	}
+
+	const int stacks = 12;
+	const int slices = 16;
+	for (int i = 0; i < stacks; i++)
+	{
+		for (int j = 0; j < slices; j++)
+		{
+			btVector3 v[4];
+			for (int k = 0; k < 4; k++)
+			{
+				btScalar theta = SIMD_PI * btScalar(i + (k >> 1)) / btScalar(stacks);
+				btScalar phi = SIMD_2_PI * btScalar(j + (k & 1)) / btScalar(slices);
+				v[k].setValue(btSin(theta) * btCos(phi), btCos(theta), btSin(theta) * btSin(phi));
+			}
+			sphere.addTriangle(v[0], v[2], v[1]);
+			sphere.addTriangle(v[1], v[2], v[3]);
+		}
+	}
+}
+
+static void collideAlgorithm(btCollisionDispatcher& dispatcher,
+							 const btCollisionObjectWrapper& wrap0, const btCollisionObjectWrapper& wrap1,
+							 btAlignedObjectArray<RecordedContact>& contacts)
+{
+	btCollisionAlgorithm* algorithm = dispatcher.findAlgorithm(&wrap0, &wrap1, 0, BT_CONTACT_POINT_ALGORITHMS);
+	ASSERT_TRUE(algorithm != 0);
+	ContactRecorder recorder(&wrap0, &wrap1);
+	btDispatcherInfo dispatchInfo;
+	algorithm->processCollision(&wrap0, &wrap1, dispatchInfo, &recorder);
+	contacts = recorder.m_contacts;
+	algorithm->~btCollisionAlgorithm();
+	dispatcher.freeCollisionAlgorithm(algorithm);
+}
+
+static void expectSameContacts(const btAlignedObjectArray<RecordedContact>& expected, const btAlignedObjectArray<RecordedContact>& actual)
+{
+	ASSERT_EQ(expected.size(), actual.size());
+	for (int i = 0; i < expected.size(); i++)
+	{
+		EXPECT_EQ(expected[i].m_index0, actual[i].m_index0);
+		EXPECT_EQ(expected[i].m_index1, actual[i].m_index1);
+		EXPECT_NEAR(expected[i].m_depth, actual[i].m_depth, 1e-5);
+		EXPECT_LT((expected[i].m_point - actual[i].m_point).length(), 1e-5);
+		EXPECT_LT((expected[i].m_normal - actual[i].m_normal).length(), 1e-5);
+	}
+}
+
+GTEST_TEST(BulletCollision, GImpactMeshContacts)
+{
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	btGImpactCollisionAlgorithm::registerAlgorithm(&dispatcher);
+
+	btTriangleMesh gridMesh;
+	btTriangleMesh sphereMesh;
+	createMeshes(gridMesh, sphereMesh);
+	btGImpactMeshShape gridShape(&gridMesh);
+	btGImpactMeshShape sphereShape(&sphereMesh);
+	gridShape.updateBound();
+	sphereShape.updateBound();
+
+	btCollisionObject gridObject;
+	gridObject.setCollisionShape(&gridShape);
+	btCollisionObject sphereObject;
+	sphereObject.setCollisionShape(&sphereShape);
+
+	btTransform gridTrans;
+	gridTrans.setIdentity();
+	btTransform sphereTrans(btQuaternion(btVector3(1, 1, 0).normalized(), btScalar(0.3)), btVector3(btScalar(0.1), btScalar(0.8), btScalar(-0.05)));
+
+	btCollisionObjectWrapper gridWrap(0, &gridShape, &gridObject, gridTrans, -1, -1);
+	btCollisionObjectWrapper sphereWrap(0, &sphereShape, &sphereObject, sphereTrans, -1, -1);
+
+	btAlignedObjectArray<RecordedContact> reference;
+	btContactArray referenceContacts;
+	collideReference(gridShape.getMeshPart(0), gridTrans, sphereShape.getMeshPart(0), sphereTrans, reference, referenceContacts);
+	ASSERT_GT(reference.size(), 8);
+
+	//per pair contacts, in the same order as the former implementation
+	btAlignedObjectArray<RecordedContact> contacts;
+	collideAlgorithm(dispatcher, gridWrap, sphereWrap, contacts);
+	expectSameContacts(reference, contacts);
+
+	//merged contacts are the reference contacts reduced by btContactArray::merge_contacts
+	btContactArray mergedContacts;
+	mergedContacts.merge_contacts(referenceContacts);
+	btAlignedObjectArray<RecordedContact> merged;
+	for (int i = 0; i < mergedContacts.size(); i++)
+	{
+		RecordedContact contact;
+		contact.m_normal = mergedContacts[i].m_normal;
+		contact.m_point = mergedContacts[i].m_point;
+		contact.m_depth = -mergedContacts[i].m_depth;
+		contact.m_index0 = mergedContacts[i].m_feature1;
+		contact.m_index1 = mergedContacts[i].m_feature2;
+		merged.push_back(contact);
+	}
+	EXPECT_LT(merged.size(), reference.size());
+
+	gGImpactMergeTriangleContacts = true;
+	collideAlgorithm(dispatcher, gridWrap, sphereWrap, contacts);
+	gGImpactMergeTriangleContacts = false;
+	expectSameContacts(merged, contacts);
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -2,6 +2,7 @@
 
 #include <btBulletDynamicsCommon.h>
 #include <BulletDynamics/Character/btKinematicCharacterController.h>
+#include <BulletDynamics/Character/btKinematicCharacterCrowd.h>
 #include <gtest/gtest.h>
 #include <BulletCollision/CollisionDispatch/btGhostObject.h>
 
@@ -19,6 +20,228 @@ GTEST_TEST(BulletDynamics, KinematicCharacterController)
 	EXPECT_FLOAT_EQ(0, tested->getGravity().z());
 }
 
+enum CharacterStepMode
+{
+	STEP_SERIAL,  // every character runs preStep and playerStep, one after the other
+	STEP_CROWD,
+	STEP_DEFERRED_REVERSED,  // the deferred steps run in reverse order, as a different thread schedule could
+};
+
+// steps a row of characters, neighbours walk towards each other with zSpeed, and returns their final positions
+static void stepCharacters(CharacterStepMode mode, btScalar spacing, btScalar zSpeed, int numSteps, btAlignedObjectArray<btVector3>& positions)
+{
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	btDbvtBroadphase broadphase;
+	btGhostPairCallback ghostPairCallback;
+	broadphase.getOverlappingPairCache()->setInternalGhostPairCallback(&ghostPairCallback);
+	btCollisionWorld world(&dispatcher, &broadphase, &collisionConfiguration);
+
+	btBoxShape groundShape(btVector3(100, 1, 100));
+	btCollisionObject ground;
+	ground.setCollisionShape(&groundShape);
+	ground.getWorldTransform().setOrigin(btVector3(0, -1, 0));
+	world.addCollisionObject(&ground);
+
+	const int numCharacters = 8;
+	btCapsuleShape characterShape(0.5, 1);
+	btPairCachingGhostObject ghosts[numCharacters];
+	btKinematicCharacterController* characters[numCharacters];
+	btKinematicCharacterCrowd crowd;
+	crowd.setGrainSize(1);
+	for (int i = 0; i < numCharacters; i++)
+	{
+		ghosts[i].setCollisionShape(&characterShape);
+		ghosts[i].setCollisionFlags(btCollisionObject::CF_CHARACTER_OBJECT);
+		ghosts[i].getWorldTransform().setOrigin(btVector3(btScalar(i % 2) * btScalar(0.3), 1.5, btScalar(i) * spacing));
+		world.addCollisionObject(&ghosts[i], btBroadphaseProxy::CharacterFilter, btBroadphaseProxy::StaticFilter | btBroadphaseProxy::DefaultFilter | btBroadphaseProxy::CharacterFilter);
+		characters[i] = new btKinematicCharacterController(&ghosts[i], &characterShape, 0.35, btVector3(0, 1, 0));
+		characters[i]->setWalkDirection(btVector3(0.1, 0, (i % 2) ? -zSpeed : zSpeed));
+		crowd.addCharacter(characters[i]);
+	}
+
+	for (int step = 0; step < numSteps; step++)
+	{
+		world.performDiscreteCollisionDetection();
+		switch (mode)
+		{
+			case STEP_SERIAL:
+				for (int i = 0; i < numCharacters; i++)
+				{
+					characters[i]->updateAction(&world, btScalar(1. / 60.));
+				}
+				break;
+			case STEP_CROWD:
+				crowd.updateAction(&world, btScalar(1. / 60.));
+				break;
+			case STEP_DEFERRED_REVERSED:
+				for (int i = numCharacters - 1; i >= 0; i--)
+				{
+					characters[i]->deferredPlayerStep(&world, btScalar(1. / 60.));
+				}
+				for (int i = 0; i < numCharacters; i++)
+				{
+					characters[i]->commitDeferredStep(&world);
+				}
+				break;
+		}
+	}
+
+	positions.resize(numCharacters);
+	for (int i = 0; i < numCharacters; i++)
+	{
+		positions[i] = ghosts[i].getWorldTransform().getOrigin();
+		crowd.removeCharacter(characters[i]);
+		world.removeCollisionObject(&ghosts[i]);
+		delete characters[i];
+	}
+	EXPECT_EQ(0, crowd.getNumCharacters());
+	world.removeCollisionObject(&ground);
+}
+
+GTEST_TEST(BulletDynamics, KinematicCharacterCrowd)
+{
+	// characters far apart do not interact, so the crowd matches stepping each character with playerStep
+	btAlignedObjectArray<btVector3> serial;
+	btAlignedObjectArray<btVector3> crowd;
+	stepCharacters(STEP_SERIAL, 4, 0, 30, serial);
+	stepCharacters(STEP_CROWD, 4, 0, 30, crowd);
+	ASSERT_EQ(serial.size(), crowd.size());
+	for (int i = 0; i < serial.size(); i++)
+	{
+		EXPECT_NEAR(btScalar(3.0) + btScalar(i % 2) * btScalar(0.3), crowd[i].x(), 0.01);
+		EXPECT_NEAR(serial[i].x(), crowd[i].x(), 1e-5);
+		EXPECT_NEAR(serial[i].y(), crowd[i].y(), 1e-5);
+		EXPECT_NEAR(serial[i].z(), crowd[i].z(), 1e-5);
+	}
+}
+
+GTEST_TEST(BulletDynamics, KinematicCharacterCrowdOrderIndependence)
+{
+	// characters that bump into each other: the crowd result does not depend on the order,
+	// or the threads, in which the characters are swept
+	btAlignedObjectArray<btVector3> crowd;
+	btAlignedObjectArray<btVector3> reversed;
+	stepCharacters(STEP_CROWD, btScalar(1.05), btScalar(0.05), 60, crowd);
+	stepCharacters(STEP_DEFERRED_REVERSED, btScalar(1.05), btScalar(0.05), 60, reversed);
+	ASSERT_EQ(crowd.size(), reversed.size());
+	for (int i = 0; i < crowd.size(); i++)
+	{
+		EXPECT_EQ(crowd[i], reversed[i]);
+	}
+
+#if BT_THREADSAFE
+	btITaskScheduler* previousScheduler = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (scheduler)
+	{
+		btSetTaskScheduler(scheduler);
+		for (int numThreads = 1; numThreads <= btMin(4, scheduler->getMaxNumThreads()); numThreads++)
+		{
+			scheduler->setNumThreads(numThreads);
+			btAlignedObjectArray<btVector3> threaded;
+			stepCharacters(STEP_CROWD, btScalar(1.05), btScalar(0.05), 60, threaded);
+			for (int i = 0; i < crowd.size(); i++)
+			{
+				EXPECT_EQ(crowd[i], threaded[i]);
+			}
+		}
+		btSetTaskScheduler(previousScheduler);
+		delete scheduler;
+	}
+#endif
+}
+
+struct DeepestContactCallback : public btCollisionWorld::ContactResultCallback
+{
+	btScalar m_distance;
+
+	DeepestContactCallback()
+		: m_distance(0)
+	{
+	}
+
+	virtual btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap, int partId0, int index0, const btCollisionObjectWrapper* colObj1Wrap, int partId1, int index1)
+	{
+		m_distance = btMin(m_distance, cp.getDistance());
+		return 0;
+	}
+};
+
+// a character walks under a ceiling that is lower than its head plus the step height, so every step up hits the ceiling
+static void walkUnderCeiling(bool useCrowd, btScalar& deepestPenetration, btVector3& position)
+{
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	btDbvtBroadphase broadphase;
+	btGhostPairCallback ghostPairCallback;
+	broadphase.getOverlappingPairCache()->setInternalGhostPairCallback(&ghostPairCallback);
+	btCollisionWorld world(&dispatcher, &broadphase, &collisionConfiguration);
+
+	btBoxShape slabShape(btVector3(10, 1, 10));
+	btCollisionObject ground;
+	ground.setCollisionShape(&slabShape);
+	ground.getWorldTransform().setOrigin(btVector3(0, -1, 0));
+	world.addCollisionObject(&ground);
+	btCollisionObject ceiling;
+	ceiling.setCollisionShape(&slabShape);
+	ceiling.getWorldTransform().setOrigin(btVector3(0, btScalar(2.1), 0));
+	world.addCollisionObject(&ceiling);
+
+	btCapsuleShape characterShape(0.5, 1);
+	btPairCachingGhostObject ghost;
+	ghost.setCollisionShape(&characterShape);
+	ghost.setCollisionFlags(btCollisionObject::CF_CHARACTER_OBJECT);
+	ghost.getWorldTransform().setOrigin(btVector3(0, 0.5, 0));
+	world.addCollisionObject(&ghost, btBroadphaseProxy::CharacterFilter, btBroadphaseProxy::StaticFilter | btBroadphaseProxy::DefaultFilter | btBroadphaseProxy::CharacterFilter);
+	btKinematicCharacterController character(&ghost, &characterShape, 0.35, btVector3(0, 1, 0));
+	character.setWalkDirection(btVector3(0.05, 0, 0));
+	btKinematicCharacterCrowd crowd;
+	crowd.addCharacter(&character);
+
+	deepestPenetration = 0;
+	for (int step = 0; step < 60; step++)
+	{
+		world.performDiscreteCollisionDetection();
+		if (useCrowd)
+		{
+			crowd.updateAction(&world, btScalar(1. / 60.));
+		}
+		else
+		{
+			character.updateAction(&world, btScalar(1. / 60.));
+		}
+		DeepestContactCallback callback;
+		world.contactPairTest(&ghost, &ceiling, callback);
+		deepestPenetration = btMin(deepestPenetration, callback.m_distance);
+	}
+	position = ghost.getWorldTransform().getOrigin();
+
+	crowd.removeCharacter(&character);
+	world.removeCollisionObject(&ghost);
+	world.removeCollisionObject(&ceiling);
+	world.removeCollisionObject(&ground);
+}
+
+GTEST_TEST(BulletDynamics, KinematicCharacterCrowdCeiling)
+{
+	// playerStep recovers from penetration right after stepping up into the ceiling, a deferred step only
+	// recovers in commitDeferredStep. The forward sweep of a deferred step starts from the position in the
+	// ceiling, so the character can settle at a slightly different height, but it walks the same way and
+	// the committed position is out of the ceiling
+	btScalar serialPenetration, crowdPenetration;
+	btVector3 serialPosition, crowdPosition;
+	walkUnderCeiling(false, serialPenetration, serialPosition);
+	walkUnderCeiling(true, crowdPenetration, crowdPosition);
+	const btScalar maxPenetrationDepth = btScalar(0.2);
+	EXPECT_GT(serialPenetration, -maxPenetrationDepth);
+	EXPECT_GT(crowdPenetration, -maxPenetrationDepth);
+	EXPECT_NEAR(3.0, serialPosition.x(), 0.01);
+	EXPECT_NEAR(serialPosition.x(), crowdPosition.x(), 1e-4);
+	EXPECT_NEAR(serialPosition.y(), crowdPosition.y(), 0.05);
+	EXPECT_NEAR(serialPosition.z(), crowdPosition.z(), 1e-4);
+}
+
 int main(int argc, char** argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,162 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletDynamics/MLCPSolvers/btMLCPSolver.h>
+#include <BulletDynamics/MLCPSolvers/btDantzigSolver.h>
+#include <gtest/gtest.h>
+
+extern bool gUseMatrixMultiply;
+
+// checks the block-sparse assembly of createMLCP, and createMLCPFast, against a dense J * M^-1 * J^T
+class btMLCPAssemblyCheckSolver : public btMLCPSolver
+{
+public:
+	int m_numChecks;
+	int m_maxRows;
+	btScalar m_maxErrorA;
+	btScalar m_maxErrorFastA;
+	btScalar m_maxErrorB;
+
+	btMLCPAssemblyCheckSolver(btMLCPSolverInterface* solver)
+		: btMLCPSolver(solver),
+		  m_numChecks(0),
+		  m_maxRows(0),
+		  m_maxErrorA(0),
+		  m_maxErrorFastA(0),
+		  m_maxErrorB(0)
+	{
+	}
+
+	virtual void createMLCP(const btContactSolverInfo& infoGlobal)
+	{
+		btMLCPSolver::createMLCPFast(infoGlobal);
+		btMatrixXu fastA = m_A;
+
+		btMLCPSolver::createMLCP(infoGlobal);
+
+		int numBodies = m_tmpSolverBodyPool.size();
+		int numRows = m_allConstraintPtrArray.size();
+
+		// the former dense assembly, with element-wise products
+		btMatrixXu Minv(6 * numBodies, 6 * numBodies);
+		Minv.setZero();
+		for (int i = 0; i < numBodies; i++)
+		{
+			const btSolverBody& rb = m_tmpSolverBodyPool[i];
+			for (int r = 0; r < 3; r++)
+			{
+				Minv.setElem(i * 6 + r, i * 6 + r, rb.m_invMass[r]);
+				for (int c = 0; c < 3; c++)
+					Minv.setElem(i * 6 + 3 + r, i * 6 + 3 + c, rb.m_originalBody ? rb.m_originalBody->getInvInertiaTensorWorld()[r][c] : 0);
+			}
+		}
+		btMatrixXu J(numRows, 6 * numBodies);
+		J.setZero();
+		for (int i = 0; i < numRows; i++)
+		{
+			const btSolverConstraint& c = *m_allConstraintPtrArray[i];
+			for (int r = 0; r < 3; r++)
+			{
+				if (m_tmpSolverBodyPool[c.m_solverBodyIdA].m_originalBody)
+				{
+					J.setElem(i, 6 * c.m_solverBodyIdA + r, c.m_contactNormal1[r]);
+					J.setElem(i, 6 * c.m_solverBodyIdA + 3 + r, c.m_relpos1CrossNormal[r]);
+				}
+				if (m_tmpSolverBodyPool[c.m_solverBodyIdB].m_originalBody)
+				{
+					J.setElem(i, 6 * c.m_solverBodyIdB + r, c.m_contactNormal2[r]);
+					J.setElem(i, 6 * c.m_solverBodyIdB + 3 + r, c.m_relpos2CrossNormal[r]);
+				}
+			}
+		}
+		btMatrixXu JinvM(numRows, 6 * numBodies);
+		for (int i = 0; i < numRows; i++)
+		{
+			for (int j = 0; j < 6 * numBodies; j++)
+			{
+				btScalar sum = 0;
+				for (int k = 0; k < 6 * numBodies; k++)
+					sum += J(i, k) * Minv(k, j);
+				JinvM.setElem(i, j, sum);
+			}
+		}
+
+		for (int i = 0; i < numRows; i++)
+		{
+			for (int j = 0; j < numRows; j++)
+			{
+				btScalar a = 0;
+				for (int k = 0; k < 6 * numBodies; k++)
+					a += JinvM(i, k) * J(j, k);
+				if (i == j)
+					a += infoGlobal.m_globalCfm / infoGlobal.m_timeStep;
+				btScalar tolerance = btScalar(1e-4) * (btScalar(1) + btFabs(a));
+				m_maxErrorA = btMax(m_maxErrorA, btFabs(m_A(i, j) - a) / tolerance);
+				m_maxErrorFastA = btMax(m_maxErrorFastA, btFabs(fastA(i, j) - a) / tolerance);
+			}
+
+			const btSolverConstraint& c = *m_allConstraintPtrArray[i];
+			btScalar b = c.m_jacDiagABInv ? c.m_rhs / c.m_jacDiagABInv : btScalar(0);
+			m_maxErrorB = btMax(m_maxErrorB, btFabs(m_b[i] - b));
+		}
+
+		m_numChecks++;
+		m_maxRows = btMax(m_maxRows, numRows);
+	}
+};
+
+GTEST_TEST(BulletDynamics, MLCPAssembly)
+{
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	btDbvtBroadphase broadphase;
+	btDantzigSolver mlcp;
+	btMLCPAssemblyCheckSolver solver(&mlcp);
+	btDiscreteDynamicsWorld world(&dispatcher, &broadphase, &solver, &collisionConfiguration);
+
+	btBoxShape groundShape(btVector3(20, 1, 20));
+	btRigidBody ground(0, 0, &groundShape);
+	ground.getWorldTransform().setOrigin(btVector3(0, -1, 0));
+	world.addRigidBody(&ground);
+
+	// a leaning stack of boxes, with a hinge between the two top ones
+	const int numBoxes = 5;
+	btBoxShape boxShape(btVector3(btScalar(0.5), btScalar(0.25), btScalar(0.5)));
+	btVector3 inertia;
+	boxShape.calculateLocalInertia(1, inertia);
+	btRigidBody* boxes[numBoxes];
+	for (int i = 0; i < numBoxes; i++)
+	{
+		boxes[i] = new btRigidBody(btScalar(1 + i), 0, &boxShape, inertia * btScalar(1 + i));
+		boxes[i]->getWorldTransform().setOrigin(btVector3(btScalar(0.05) * btScalar(i), btScalar(0.25) + btScalar(0.5) * btScalar(i), 0));
+		boxes[i]->getWorldTransform().setRotation(btQuaternion(btVector3(0, 1, 0), btScalar(0.2) * btScalar(i)));
+		world.addRigidBody(boxes[i]);
+	}
+	btHingeConstraint hinge(*boxes[numBoxes - 2], *boxes[numBoxes - 1], btVector3(0, btScalar(0.25), 0), btVector3(0, btScalar(-0.25), 0), btVector3(1, 0, 0), btVector3(1, 0, 0));
+	world.addConstraint(&hinge, true);
+
+	gUseMatrixMultiply = true;
+	for (int step = 0; step < 30; step++)
+	{
+		world.stepSimulation(btScalar(1. / 60.), 0);
+	}
+	gUseMatrixMultiply = false;
+
+	EXPECT_GT(solver.m_numChecks, 0);
+	EXPECT_GT(solver.m_maxRows, 20);
+	EXPECT_LT(solver.m_maxErrorA, 1);
+	EXPECT_LT(solver.m_maxErrorFastA, 1);
+	EXPECT_LT(solver.m_maxErrorB, 1e-6);
+
+	world.removeConstraint(&hinge);
+	for (int i = 0; i < numBoxes; i++)
+	{
+		world.removeRigidBody(boxes[i]);
+		delete boxes[i];
+	}
+	world.removeRigidBody(&ground);
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
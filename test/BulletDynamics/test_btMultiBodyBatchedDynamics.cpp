@@ -0,0 +1,137 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletDynamics/Featherstone/btMultiBody.h>
+#include <BulletDynamics/Featherstone/btMultiBodyBatchedDynamics.h>
+#include <BulletDynamics/Featherstone/btMultiBodyConstraintSolver.h>
+#include <BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.h>
+#include <BulletDynamics/Featherstone/btMultiBodyLinkCollider.h>
+#include <gtest/gtest.h>
+
+// fixed base pendulum chains and floating base bodies with a two link arm that land on the ground,
+// so both the forward dynamics and the constraint pass run for the batched bodies
+struct BatchedScene
+{
+	btDefaultCollisionConfiguration m_collisionConfiguration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btMultiBodyConstraintSolver m_solver;
+	btMultiBodyDynamicsWorld m_world;
+	btBoxShape m_groundShape;
+	btBoxShape m_linkShape;
+	btRigidBody m_ground;
+	btAlignedObjectArray<btMultiBody*> m_bodies;
+	btAlignedObjectArray<btMultiBodyLinkCollider*> m_colliders;
+
+	BatchedScene(bool useBatched)
+		: m_dispatcher(&m_collisionConfiguration),
+		  m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_collisionConfiguration),
+		  m_groundShape(btVector3(50, 1, 50)),
+		  m_linkShape(btVector3(btScalar(0.1), btScalar(0.25), btScalar(0.1))),
+		  m_ground(0, 0, &m_groundShape)
+	{
+		m_world.setUseBatchedForwardDynamics(useBatched);
+		m_world.setGravity(btVector3(0, -10, 0));
+		m_ground.getWorldTransform().setOrigin(btVector3(0, -1, 0));
+		m_world.addRigidBody(&m_ground);
+
+		btVector3 inertia;
+		m_linkShape.calculateLocalInertia(1, inertia);
+		for (int i = 0; i < 10; i++)
+		{
+			const bool fixedBase = i < 5;
+			const int numLinks = fixedBase ? 3 : 2;
+			btMultiBody* body = new btMultiBody(numLinks, 1, inertia, fixedBase, false);
+			btVector3 axis = fixedBase ? btVector3(0, 0, 1) : btVector3(1, 0, 0);
+			for (int link = 0; link < numLinks; link++)
+			{
+				body->setupRevolute(link, 1, inertia, link - 1, btQuaternion::getIdentity(), axis, btVector3(0, btScalar(-0.25), 0), btVector3(0, btScalar(-0.25), 0), true);
+			}
+			body->finalizeMultiDof();
+			body->setBaseWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(btScalar(i * 2), fixedBase ? 3 : btScalar(1.5), 0)));
+			body->setJointPos(0, btScalar(0.3) + btScalar(0.1) * i);
+			addCollider(body, -1);
+			for (int link = 0; link < numLinks; link++)
+			{
+				addCollider(body, link);
+			}
+			m_world.addMultiBody(body);
+			m_bodies.push_back(body);
+		}
+		btAlignedObjectArray<btQuaternion> scratch_q;
+		btAlignedObjectArray<btVector3> scratch_v;
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_bodies[i]->forwardKinematics(scratch_q, scratch_v);
+			m_bodies[i]->updateCollisionObjectWorldTransforms(scratch_q, scratch_v);
+		}
+	}
+
+	void addCollider(btMultiBody* body, int link)
+	{
+		btMultiBodyLinkCollider* collider = new btMultiBodyLinkCollider(body, link);
+		collider->setCollisionShape(&m_linkShape);
+		m_world.addCollisionObject(collider, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter & ~btBroadphaseProxy::DefaultFilter);
+		if (link < 0)
+			body->setBaseCollider(collider);
+		else
+			body->getLink(link).m_collider = collider;
+		m_colliders.push_back(collider);
+	}
+
+	~BatchedScene()
+	{
+		for (int i = 0; i < m_colliders.size(); i++)
+		{
+			m_world.removeCollisionObject(m_colliders[i]);
+			delete m_colliders[i];
+		}
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_world.removeMultiBody(m_bodies[i]);
+			delete m_bodies[i];
+		}
+		m_world.removeRigidBody(&m_ground);
+	}
+};
+
+GTEST_TEST(BulletDynamics, MultiBodyBatchedWorldMatchesScalar)
+{
+	BatchedScene scalar(false);
+	BatchedScene batched(true);
+	EXPECT_TRUE(batched.m_world.getUseBatchedForwardDynamics());
+
+	for (int step = 0; step < 120; step++)
+	{
+		scalar.m_world.stepSimulation(btScalar(1. / 60.), 0);
+		batched.m_world.stepSimulation(btScalar(1. / 60.), 0);
+	}
+	EXPECT_EQ(scalar.m_bodies.size(), batched.m_world.getBatchedDynamics().getNumBatchedBodies());
+	EXPECT_EQ(0, batched.m_world.getBatchedDynamics().getNumFallbackBodies());
+
+	for (int i = 0; i < scalar.m_bodies.size(); i++)
+	{
+		const btMultiBody* a = scalar.m_bodies[i];
+		const btMultiBody* b = batched.m_bodies[i];
+		EXPECT_LT((a->getBasePos() - b->getBasePos()).length(), 1e-3);
+		for (int link = 0; link < a->getNumLinks(); link++)
+		{
+			EXPECT_NEAR(a->getJointPos(link), b->getJointPos(link), 1e-3);
+			EXPECT_NEAR(a->getJointVel(link), b->getJointVel(link), 1e-2);
+		}
+	}
+	// the pendulums swing, and the floating bodies came to rest on the ground
+	for (int i = 0; i < 5; i++)
+	{
+		EXPECT_GT(btFabs(batched.m_bodies[i]->getJointPos(0) - (btScalar(0.3) + btScalar(0.1) * i)), btScalar(0.01));
+	}
+	for (int i = 5; i < batched.m_bodies.size(); i++)
+	{
+		EXPECT_LT(batched.m_bodies[i]->getBasePos().y(), btScalar(1.5));
+		EXPECT_GT(batched.m_bodies[i]->getBasePos().y(), btScalar(0));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
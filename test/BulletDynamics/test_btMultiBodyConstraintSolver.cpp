@@ -0,0 +1,165 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletDynamics/Featherstone/btMultiBody.h>
+#include <BulletDynamics/Featherstone/btMultiBodyLinkCollider.h>
+#include <BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.h>
+#include <BulletDynamics/Featherstone/btMultiBodyConstraintSolver.h>
+#include <BulletCollision/CollisionDispatch/btSimulationIslandManager.h>
+#include <LinearMath/btThreads.h>
+#include <gtest/gtest.h>
+
+// records how many rows went through the colored path and the residual of the last iteration
+class btColoringCheckSolver : public btMultiBodyConstraintSolver
+{
+public:
+	int m_maxColoredRows;
+	btScalar m_maxResidual;
+
+	btColoringCheckSolver()
+		: m_maxColoredRows(0),
+		  m_maxResidual(0)
+	{
+	}
+
+	virtual btScalar solveGroupCacheFriendlySetup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
+	{
+		btScalar val = btMultiBodyConstraintSolver::solveGroupCacheFriendlySetup(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
+		int coloredRows = 0;
+		for (int i = 0; i < BT_MULTIBODY_ITEM_TYPE_COUNT; i++)
+		{
+			const btAlignedObjectArray<int>& offsets = m_colorings[i].m_colorOffsets;
+			if (offsets.size())
+			{
+				coloredRows += offsets[offsets.size() - 1];
+			}
+		}
+		m_maxColoredRows = btMax(m_maxColoredRows, coloredRows);
+		return val;
+	}
+
+	virtual btScalar solveGroupCacheFriendlyIterations(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
+	{
+		btScalar val = btMultiBodyConstraintSolver::solveGroupCacheFriendlyIterations(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
+		m_maxResidual = btMax(m_maxResidual, m_leastSquaresResidual);
+		return val;
+	}
+};
+
+struct ColoringStackScene
+{
+	btDefaultCollisionConfiguration m_collisionConfiguration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btColoringCheckSolver m_solver;
+	btMultiBodyDynamicsWorld m_world;
+	btBoxShape m_groundShape;
+	btBoxShape m_boxShape;
+	btRigidBody m_ground;
+	btAlignedObjectArray<btMultiBody*> m_bodies;
+
+	// a grid of two box stacks on a static ground, solved as one island
+	ColoringStackScene(bool useColoring)
+		: m_dispatcher(&m_collisionConfiguration),
+		  m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_collisionConfiguration),
+		  m_groundShape(btVector3(40, 1, 40)),
+		  m_boxShape(btVector3(btScalar(0.5), btScalar(0.5), btScalar(0.5))),
+		  m_ground(0, 0, &m_groundShape)
+	{
+		m_solver.setUseConstraintColoring(useColoring);
+		m_world.getSimulationIslandManager()->setSplitIslands(false);
+		m_world.setGravity(btVector3(0, -10, 0));
+		m_ground.getWorldTransform().setOrigin(btVector3(0, -1, 0));
+		m_world.addRigidBody(&m_ground);
+
+		btVector3 inertia;
+		m_boxShape.calculateLocalInertia(1, inertia);
+		const int gridSize = 8;
+		for (int i = 0; i < gridSize; i++)
+		{
+			for (int j = 0; j < gridSize; j++)
+			{
+				for (int level = 0; level < 2; level++)
+				{
+					btMultiBody* body = new btMultiBody(0, 1, inertia, false, false);
+					btTransform trans(btQuaternion(btVector3(0, 1, 0), btScalar(0.05) * btScalar(i + j + level)),
+									  btVector3(btScalar(i * 2), btScalar(0.5) + btScalar(level) * btScalar(1.01), btScalar(j * 2)));
+					body->setBaseWorldTransform(trans);
+					body->finalizeMultiDof();
+					btMultiBodyLinkCollider* collider = new btMultiBodyLinkCollider(body, -1);
+					collider->setCollisionShape(&m_boxShape);
+					collider->setWorldTransform(trans);
+					m_world.addCollisionObject(collider, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter);
+					body->setBaseCollider(collider);
+					m_world.addMultiBody(body);
+					m_bodies.push_back(body);
+				}
+			}
+		}
+	}
+
+	~ColoringStackScene()
+	{
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_world.removeCollisionObject(m_bodies[i]->getBaseCollider());
+			delete m_bodies[i]->getBaseCollider();
+			m_world.removeMultiBody(m_bodies[i]);
+			delete m_bodies[i];
+		}
+		m_world.removeRigidBody(&m_ground);
+	}
+
+	void step(int numSteps)
+	{
+		for (int i = 0; i < numSteps; i++)
+		{
+			m_world.stepSimulation(btScalar(1. / 60.), 0);
+		}
+	}
+};
+
+static void compareColoredWithSerial()
+{
+	ColoringStackScene serial(false);
+	ColoringStackScene colored(true);
+	serial.step(90);
+	colored.step(90);
+
+	EXPECT_EQ(0, serial.m_solver.m_maxColoredRows);
+	EXPECT_GT(colored.m_solver.m_maxColoredRows, colored.m_solver.getMinColorSize());
+
+	// the row order differs, so the impulses converge to slightly different values
+	EXPECT_LT(colored.m_solver.m_maxResidual, serial.m_solver.m_maxResidual * 2 + btScalar(1e-6));
+	for (int i = 0; i < colored.m_bodies.size(); i++)
+	{
+		btVector3 diff = colored.m_bodies[i]->getBasePos() - serial.m_bodies[i]->getBasePos();
+		EXPECT_LT(diff.length(), 1e-3);
+		EXPECT_LT(colored.m_bodies[i]->getBaseVel().length(), 1e-2);
+	}
+}
+
+GTEST_TEST(BulletDynamics, MultiBodyConstraintColoring)
+{
+	compareColoredWithSerial();
+}
+
+#if BT_THREADSAFE
+GTEST_TEST(BulletDynamics, MultiBodyConstraintColoringThreads)
+{
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (scheduler)
+	{
+		scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+		btSetTaskScheduler(scheduler);
+		compareColoredWithSerial();
+		btSetTaskScheduler(previous);
+		delete scheduler;
+	}
+}
+#endif
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,217 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletDynamics/Featherstone/btMultiBody.h>
+#include <BulletDynamics/Featherstone/btMultiBodyLinkCollider.h>
+#include <BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.h>
+#include <BulletDynamics/Featherstone/btMultiBodyMLCPConstraintSolver.h>
+#include <BulletDynamics/MLCPSolvers/btDantzigSolver.h>
+#include <gtest/gtest.h>
+
+// solves every multibody MLCP a second time in one piece with the MLCP solver, and compares the results
+class btMLCPCompareSolver : public btMultiBodyMLCPConstraintSolver
+{
+public:
+	int m_numCompared;
+	btScalar m_maxVelocityError;
+	btScalar m_maxImpulseError;
+
+	btMLCPCompareSolver(btMLCPSolverInterface* solver)
+		: btMultiBodyMLCPConstraintSolver(solver),
+		  m_numCompared(0),
+		  m_maxVelocityError(0),
+		  m_maxImpulseError(0)
+	{
+	}
+
+	virtual bool solveMLCP(const btContactSolverInfo& infoGlobal)
+	{
+		btVectorXu reference = m_multiBodyX;
+		bool referenceResult = m_multiBodyA.rows() == 0 || m_solver->solveMLCP(m_multiBodyA, m_multiBodyB, reference, m_multiBodyLo, m_multiBodyHi, m_multiBodyLimitDependencies, infoGlobal.m_numIterations);
+
+		bool result = btMultiBodyMLCPConstraintSolver::solveMLCP(infoGlobal);
+		if (!result || !referenceResult || m_multiBodyA.rows() == 0)
+			return result;
+
+		// the relative velocities A x - b are compared, the impulses of redundant contacts are not unique
+		const int n = m_multiBodyA.rows();
+		btScalar scale = 0;
+		for (int i = 0; i < n; i++)
+		{
+			scale = btMax(scale, btFabs(m_multiBodyB[i]));
+		}
+		for (int i = 0; i < n; i++)
+		{
+			btScalar w = -m_multiBodyB[i];
+			btScalar wReference = -m_multiBodyB[i];
+			for (int j = 0; j < n; j++)
+			{
+				w += m_multiBodyA(i, j) * m_multiBodyX[j];
+				wReference += m_multiBodyA(i, j) * reference[j];
+			}
+			m_maxVelocityError = btMax(m_maxVelocityError, btFabs(w - wReference) / (btScalar(1) + scale));
+			m_maxImpulseError = btMax(m_maxImpulseError, btFabs(m_multiBodyX[i] - reference[i]));
+		}
+		m_numCompared++;
+		return result;
+	}
+};
+
+struct MLCPStackScene
+{
+	btDefaultCollisionConfiguration m_collisionConfiguration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btDantzigSolver m_mlcp;
+	btMLCPCompareSolver m_solver;
+	btMultiBodyDynamicsWorld m_world;
+	btBoxShape m_groundShape;
+	btBoxShape m_boxShape;
+	btRigidBody m_ground;
+	btAlignedObjectArray<btMultiBody*> m_bodies;
+
+	// separate stacks of floating base boxes, each stack is an island of the MLCP
+	MLCPStackScene(bool splitIslands, bool activeSetWarmStart)
+		: m_dispatcher(&m_collisionConfiguration),
+		  m_solver(&m_mlcp),
+		  m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_collisionConfiguration),
+		  m_groundShape(btVector3(20, 1, 20)),
+		  m_boxShape(btVector3(btScalar(0.5), btScalar(0.5), btScalar(0.5))),
+		  m_ground(0, 0, &m_groundShape)
+	{
+		m_solver.setSplitIslands(splitIslands);
+		m_solver.setUseActiveSetWarmStart(activeSetWarmStart);
+		m_world.setGravity(btVector3(0, -10, 0));
+		// the four corner contacts of a box are redundant, a little CFM keeps A positive definite for btDantzigSolver
+		m_world.getSolverInfo().m_globalCfm = btScalar(1e-3);
+		m_ground.getWorldTransform().setOrigin(btVector3(0, -1, 0));
+		m_world.addRigidBody(&m_ground);
+
+		btVector3 inertia;
+		m_boxShape.calculateLocalInertia(1, inertia);
+		for (int stack = 0; stack < 3; stack++)
+		{
+			for (int level = 0; level < 2; level++)
+			{
+				btMultiBody* body = new btMultiBody(0, 1, inertia, false, false);
+				btTransform trans(btQuaternion(btVector3(0, 1, 0), btScalar(0.1) * btScalar(stack + level)),
+								  btVector3(btScalar(stack * 4), btScalar(0.5) + btScalar(level) * btScalar(1.01), 0));
+				body->setBaseWorldTransform(trans);
+				body->finalizeMultiDof();
+				btMultiBodyLinkCollider* collider = new btMultiBodyLinkCollider(body, -1);
+				collider->setCollisionShape(&m_boxShape);
+				collider->setWorldTransform(trans);
+				m_world.addCollisionObject(collider, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter);
+				body->setBaseCollider(collider);
+				m_world.addMultiBody(body);
+				m_bodies.push_back(body);
+			}
+		}
+	}
+
+	~MLCPStackScene()
+	{
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_world.removeCollisionObject(m_bodies[i]->getBaseCollider());
+			delete m_bodies[i]->getBaseCollider();
+			m_world.removeMultiBody(m_bodies[i]);
+			delete m_bodies[i];
+		}
+		m_world.removeRigidBody(&m_ground);
+	}
+
+	void step(int numSteps)
+	{
+		for (int i = 0; i < numSteps; i++)
+		{
+			m_world.stepSimulation(btScalar(1. / 60.), 0);
+		}
+	}
+};
+
+GTEST_TEST(BulletDynamics, MultiBodyMLCPDefaults)
+{
+	btDantzigSolver mlcp;
+	btMultiBodyMLCPConstraintSolver solver(&mlcp);
+	EXPECT_FALSE(solver.getSplitIslands());
+	EXPECT_FALSE(solver.getUseActiveSetWarmStart());
+	EXPECT_TRUE(solver.getUseGaussSeidelFallback());
+}
+
+// an MLCP solver that never succeeds
+struct FailingMLCPSolver : public btMLCPSolverInterface
+{
+	virtual bool solveMLCP(const btMatrixXu& A, const btVectorXu& b, btVectorXu& x, const btVectorXu& lo, const btVectorXu& hi, const btAlignedObjectArray<int>& limitDependency, int numIterations, bool useSparsity = true)
+	{
+		return false;
+	}
+};
+
+GTEST_TEST(BulletDynamics, MultiBodyMLCPGaussSeidelFallback)
+{
+	FailingMLCPSolver failing;
+	MLCPStackScene reference(true, false);
+	MLCPStackScene fallback(true, false);
+	MLCPStackScene disabled(true, false);
+	fallback.m_solver.setMLCPSolver(&failing);
+	disabled.m_solver.setMLCPSolver(&failing);
+	disabled.m_solver.setUseGaussSeidelFallback(false);
+	reference.step(60);
+	fallback.step(60);
+	disabled.step(60);
+
+	// every island goes through btSolveProjectedGaussSeidel, the step itself does not fall back
+	EXPECT_EQ(0, reference.m_solver.getNumGaussSeidelFallbacks());
+	EXPECT_GT(fallback.m_solver.getNumGaussSeidelFallbacks(), 0);
+	EXPECT_EQ(0, fallback.m_solver.getNumFallbacks());
+	EXPECT_EQ(0, disabled.m_solver.getNumGaussSeidelFallbacks());
+	EXPECT_GT(disabled.m_solver.getNumFallbacks(), 0);
+	for (int i = 0; i < fallback.m_bodies.size(); i++)
+	{
+		btVector3 diff = fallback.m_bodies[i]->getBasePos() - reference.m_bodies[i]->getBasePos();
+		EXPECT_LT(diff.length(), 1e-2);
+		diff = disabled.m_bodies[i]->getBasePos() - reference.m_bodies[i]->getBasePos();
+		EXPECT_LT(diff.length(), 1e-2);
+	}
+}
+
+GTEST_TEST(BulletDynamics, MultiBodyMLCPIslands)
+{
+	MLCPStackScene monolithic(false, false);
+	MLCPStackScene split(true, false);
+	monolithic.step(60);
+	split.step(60);
+
+	EXPECT_GT(split.m_solver.m_numCompared, 0);
+	EXPECT_LT(split.m_solver.m_maxVelocityError, 1e-4);
+	EXPECT_EQ(0, split.m_solver.getNumFallbacks());
+	EXPECT_EQ(monolithic.m_solver.getNumFallbacks(), split.m_solver.getNumFallbacks());
+	for (int i = 0; i < split.m_bodies.size(); i++)
+	{
+		btVector3 diff = split.m_bodies[i]->getBasePos() - monolithic.m_bodies[i]->getBasePos();
+		EXPECT_LT(diff.length(), 1e-3);
+	}
+}
+
+GTEST_TEST(BulletDynamics, MultiBodyMLCPActiveSetWarmStart)
+{
+	MLCPStackScene monolithic(false, false);
+	MLCPStackScene warmStarted(true, true);
+	monolithic.step(60);
+	warmStarted.step(60);
+
+	EXPECT_GT(warmStarted.m_solver.getNumActiveSetHits(), 0);
+	EXPECT_GT(warmStarted.m_solver.m_numCompared, 0);
+	EXPECT_LT(warmStarted.m_solver.m_maxVelocityError, 1e-3);
+	EXPECT_EQ(0, warmStarted.m_solver.getNumFallbacks());
+	for (int i = 0; i < warmStarted.m_bodies.size(); i++)
+	{
+		btVector3 diff = warmStarted.m_bodies[i]->getBasePos() - monolithic.m_bodies[i]->getBasePos();
+		EXPECT_LT(diff.length(), 1e-2);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,185 @@
+#include <LinearMath/btPoolAllocator.h>
+#include <LinearMath/btThreads.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+static bool gFailAllocations = false;
+
+static void* failingAlloc(size_t size)
+{
+	return gFailAllocations ? 0 : malloc(size);
+}
+
+static void failingFree(void* ptr)
+{
+	free(ptr);
+}
+
+static const int gElementSize = 64;
+static const int gSlabElements = BT_POOL_ALLOCATOR_SLAB_SIZE / gElementSize;
+
+static void allocateElements(btPoolAllocator& pool, int count, btAlignedObjectArray<void*>& elements)
+{
+	for (int i = 0; i < count; i++)
+	{
+		void* ptr = pool.allocate(gElementSize);
+		ASSERT_TRUE(ptr != 0);
+		EXPECT_TRUE(pool.validPtr(ptr));
+		EXPECT_EQ(0u, size_t(ptr) & 15);
+		elements.push_back(ptr);
+	}
+}
+
+GTEST_TEST(LinearMath, PoolAllocatorFixedSize)
+{
+	btPoolAllocator pool(gElementSize, 4);
+	btAlignedObjectArray<void*> elements;
+	allocateElements(pool, 4, elements);
+	EXPECT_TRUE(pool.allocate(gElementSize) == 0);
+	EXPECT_EQ(0, pool.getNumSlabs());
+	EXPECT_EQ(4, pool.getUsedCount());
+	EXPECT_EQ(0, pool.shrink());
+	for (int i = 0; i < elements.size(); i++)
+	{
+		pool.freeMemory(elements[i]);
+	}
+	EXPECT_EQ(4, pool.getFreeCount());
+}
+
+GTEST_TEST(LinearMath, PoolAllocatorGrowAndShrink)
+{
+	btPoolAllocator pool(gElementSize, 4, true);
+	btAlignedObjectArray<void*> elements;
+	allocateElements(pool, 4 + gSlabElements + 1, elements);
+	EXPECT_EQ(2, pool.getNumSlabs());
+	EXPECT_EQ(4 + 2 * gSlabElements, pool.getMaxCount());
+	EXPECT_EQ(elements.size(), pool.getUsedCount());
+	EXPECT_EQ(elements.size(), pool.getHighWaterMark());
+
+	// every element is handed out once
+	elements.quickSort(btAlignedObjectArray<void*>::less());
+	for (int i = 1; i < elements.size(); i++)
+	{
+		EXPECT_TRUE(elements[i - 1] != elements[i]);
+	}
+	int dummy;
+	EXPECT_FALSE(pool.validPtr(&dummy));
+
+	// a slab with one element in use stays, the empty one is released
+	void* last = pool.allocate(gElementSize);
+	for (int i = 0; i < elements.size(); i++)
+	{
+		pool.freeMemory(elements[i]);
+	}
+	EXPECT_EQ(1, pool.shrink());
+	EXPECT_EQ(1, pool.getNumSlabs());
+	EXPECT_EQ(4 + gSlabElements, pool.getMaxCount());
+	EXPECT_EQ(1, pool.getUsedCount());
+	EXPECT_TRUE(pool.validPtr(last));
+
+	// the high-water mark keeps the peak until it is reset
+	EXPECT_EQ(4 + gSlabElements + 2, pool.getHighWaterMark());
+	pool.resetHighWaterMark();
+	EXPECT_EQ(1, pool.getHighWaterMark());
+
+	// the remaining free list only holds elements of live memory
+	elements.resize(0);
+	allocateElements(pool, 3 + gSlabElements, elements);
+	EXPECT_EQ(1, pool.getNumSlabs());
+	EXPECT_EQ(0, pool.getFreeCount());
+	pool.freeMemory(last);
+	for (int i = 0; i < elements.size(); i++)
+	{
+		pool.freeMemory(elements[i]);
+	}
+	EXPECT_EQ(1, pool.shrink());
+	EXPECT_EQ(0, pool.getNumSlabs());
+	EXPECT_EQ(4, pool.getMaxCount());
+	EXPECT_EQ(4, pool.getFreeCount());
+}
+
+GTEST_TEST(LinearMath, PoolAllocatorGrowFailure)
+{
+	btPoolAllocator pool(gElementSize, 4, true);
+	btAlignedObjectArray<void*> elements;
+	allocateElements(pool, 4, elements);
+
+	// a slab that cannot be allocated leaves the pool exhausted but intact
+	gFailAllocations = true;
+	EXPECT_TRUE(pool.allocate(gElementSize) == 0);
+	gFailAllocations = false;
+	EXPECT_EQ(0, pool.getNumSlabs());
+	EXPECT_EQ(4, pool.getMaxCount());
+	EXPECT_EQ(0, pool.getFreeCount());
+
+	allocateElements(pool, 1, elements);
+	EXPECT_EQ(1, pool.getNumSlabs());
+	for (int i = 0; i < elements.size(); i++)
+	{
+		pool.freeMemory(elements[i]);
+	}
+}
+
+#if BT_THREADSAFE
+struct PoolAllocateLoop : public btIParallelForBody
+{
+	btPoolAllocator* m_pool;
+	void** m_elements;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			m_elements[i] = m_pool->allocate(gElementSize);
+			// validPtr searches the slab table while other threads grow it
+			EXPECT_TRUE(m_pool->validPtr(m_elements[i]));
+		}
+	}
+};
+
+GTEST_TEST(LinearMath, PoolAllocatorGrowThreads)
+{
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (!scheduler)
+	{
+		return;
+	}
+	scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+	btSetTaskScheduler(scheduler);
+
+	btPoolAllocator pool(gElementSize, 4, true);
+	btAlignedObjectArray<void*> elements;
+	elements.resize(20 * gSlabElements, 0);
+	PoolAllocateLoop loop;
+	loop.m_pool = &pool;
+	loop.m_elements = &elements[0];
+	btParallelFor(0, elements.size(), 16, loop);
+	EXPECT_EQ(elements.size(), pool.getUsedCount());
+	EXPECT_GE(pool.getNumSlabs(), 20);
+
+	elements.quickSort(btAlignedObjectArray<void*>::less());
+	EXPECT_TRUE(elements[0] != 0);
+	for (int i = 1; i < elements.size(); i++)
+	{
+		EXPECT_TRUE(elements[i - 1] != elements[i]);
+	}
+	for (int i = 0; i < elements.size(); i++)
+	{
+		pool.freeMemory(elements[i]);
+	}
+	const int numSlabs = pool.getNumSlabs();
+	EXPECT_EQ(numSlabs, pool.shrink());
+	EXPECT_EQ(4, pool.getFreeCount());
+
+	btSetTaskScheduler(previous);
+	delete scheduler;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+	btAlignedAllocSetCustom(failingAlloc, failingFree);
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,269 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletDynamics/Vehicle/btRaycastVehicle.h>
+#include <BulletDynamics/Vehicle/btRaycastVehicleFleet.h>
+#include <LinearMath/btThreads.h>
+#include <gtest/gtest.h>
+
+// counts the batched queries, castRay is still used for the single rays
+class CountingVehicleRaycaster : public btDefaultVehicleRaycaster
+{
+public:
+	int m_numRayBatches;
+	int m_numRays;
+
+	CountingVehicleRaycaster(btDynamicsWorld* world)
+		: btDefaultVehicleRaycaster(world),
+		  m_numRayBatches(0),
+		  m_numRays(0)
+	{
+	}
+
+	virtual void castRays(int numRays, const btVector3* from, const btVector3* to, btVehicleRaycasterResult* results, void** objects)
+	{
+		m_numRayBatches++;
+		m_numRays += numRays;
+		btDefaultVehicleRaycaster::castRays(numRays, from, to, results, objects);
+	}
+};
+
+struct VehicleScene
+{
+	btDefaultCollisionConfiguration m_collisionConfiguration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btSequentialImpulseConstraintSolver m_solver;
+	btDiscreteDynamicsWorld m_world;
+	CountingVehicleRaycaster m_raycaster;
+	btRaycastVehicleFleet m_fleet;
+	btRaycastVehicle::btVehicleTuning m_tuning;
+	btBoxShape m_groundShape;
+	btBoxShape m_bumpShape;
+	btBoxShape m_chassisShape;
+	btAlignedObjectArray<btRigidBody*> m_statics;
+	btAlignedObjectArray<btRigidBody*> m_chassis;
+	btAlignedObjectArray<btRaycastVehicle*> m_vehicles;
+	bool m_useFleet;
+
+	// a row of vehicles with different throttle and steering driving over bumps
+	VehicleScene(bool useFleet, int numVehicles)
+		: m_dispatcher(&m_collisionConfiguration),
+		  m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_collisionConfiguration),
+		  m_raycaster(&m_world),
+		  m_fleet(&m_raycaster),
+		  m_groundShape(btVector3(100, 1, 100)),
+		  m_bumpShape(btVector3(btScalar(0.5), btScalar(0.1), btScalar(0.5))),
+		  m_chassisShape(btVector3(1, btScalar(0.25), 2)),
+		  m_useFleet(useFleet)
+	{
+		m_world.setGravity(btVector3(0, -10, 0));
+		addStatic(&m_groundShape, btVector3(0, -1, 0));
+		for (int i = 0; i < numVehicles; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				addStatic(&m_bumpShape, btVector3(btScalar(i * 4) + btScalar(j % 2) * btScalar(0.8) - btScalar(0.4), 0, btScalar(3 + j * 3)));
+			}
+		}
+
+		btVector3 inertia;
+		m_chassisShape.calculateLocalInertia(800, inertia);
+		for (int i = 0; i < numVehicles; i++)
+		{
+			btRigidBody* chassis = new btRigidBody(800, 0, &m_chassisShape, inertia);
+			chassis->getWorldTransform().setOrigin(btVector3(btScalar(i * 4), btScalar(0.7), 0));
+			chassis->setActivationState(DISABLE_DEACTIVATION);
+			m_world.addRigidBody(chassis);
+			m_chassis.push_back(chassis);
+
+			btRaycastVehicle* vehicle = new btRaycastVehicle(m_tuning, chassis, &m_raycaster);
+			vehicle->setCoordinateSystem(0, 1, 2);
+			for (int w = 0; w < 4; w++)
+			{
+				btVector3 connection(w % 2 ? btScalar(0.9) : btScalar(-0.9), btScalar(0.2), w < 2 ? btScalar(1.5) : btScalar(-1.5));
+				btWheelInfo& wheel = vehicle->addWheel(connection, btVector3(0, -1, 0), btVector3(-1, 0, 0), btScalar(0.6), btScalar(0.4), m_tuning, w < 2);
+				wheel.m_suspensionStiffness = 20;
+				wheel.m_wheelsDampingRelaxation = btScalar(2.3);
+				wheel.m_wheelsDampingCompression = btScalar(4.4);
+				wheel.m_frictionSlip = 1000;
+				wheel.m_rollInfluence = btScalar(0.1);
+			}
+			for (int w = 2; w < 4; w++)
+			{
+				vehicle->applyEngineForce(btScalar(1500 + 200 * (i % 5)), w);
+			}
+			for (int w = 0; w < 2; w++)
+			{
+				vehicle->setSteeringValue(btScalar(0.05) * btScalar(i % 3 - 1), w);
+			}
+			m_vehicles.push_back(vehicle);
+			if (useFleet)
+			{
+				m_fleet.addVehicle(vehicle);
+			}
+			else
+			{
+				m_world.addAction(vehicle);
+			}
+		}
+		if (useFleet)
+		{
+			m_fleet.setGrainSize(4);
+			m_world.addAction(&m_fleet);
+		}
+	}
+
+	void addStatic(btCollisionShape* shape, const btVector3& origin)
+	{
+		btRigidBody* body = new btRigidBody(0, 0, shape);
+		body->getWorldTransform().setOrigin(origin);
+		m_world.addRigidBody(body);
+		m_statics.push_back(body);
+	}
+
+	~VehicleScene()
+	{
+		if (m_useFleet)
+		{
+			m_world.removeAction(&m_fleet);
+		}
+		for (int i = 0; i < m_vehicles.size(); i++)
+		{
+			if (!m_useFleet)
+			{
+				m_world.removeAction(m_vehicles[i]);
+			}
+			delete m_vehicles[i];
+			m_world.removeRigidBody(m_chassis[i]);
+			delete m_chassis[i];
+		}
+		for (int i = 0; i < m_statics.size(); i++)
+		{
+			m_world.removeRigidBody(m_statics[i]);
+			delete m_statics[i];
+		}
+	}
+
+	void step(int numSteps)
+	{
+		for (int i = 0; i < numSteps; i++)
+		{
+			m_world.stepSimulation(btScalar(1. / 60.), 0);
+		}
+	}
+};
+
+static void expectSameVehicles(const VehicleScene& expected, const VehicleScene& actual)
+{
+	ASSERT_EQ(expected.m_vehicles.size(), actual.m_vehicles.size());
+	for (int i = 0; i < expected.m_vehicles.size(); i++)
+	{
+		const btTransform& e = expected.m_chassis[i]->getWorldTransform();
+		const btTransform& a = actual.m_chassis[i]->getWorldTransform();
+		for (int k = 0; k < 3; k++)
+		{
+			EXPECT_EQ(e.getOrigin()[k], a.getOrigin()[k]);
+			EXPECT_EQ(e.getRotation()[k], a.getRotation()[k]);
+		}
+		for (int w = 0; w < 4; w++)
+		{
+			const btWheelInfo& ew = expected.m_vehicles[i]->getWheelInfo(w);
+			const btWheelInfo& aw = actual.m_vehicles[i]->getWheelInfo(w);
+			EXPECT_EQ(ew.m_raycastInfo.m_isInContact, aw.m_raycastInfo.m_isInContact);
+			EXPECT_EQ(ew.m_raycastInfo.m_suspensionLength, aw.m_raycastInfo.m_suspensionLength);
+			EXPECT_EQ(ew.m_wheelsSuspensionForce, aw.m_wheelsSuspensionForce);
+		}
+	}
+}
+
+GTEST_TEST(BulletDynamics, RaycastVehicleFleet)
+{
+	const int numVehicles = 12;
+	const int numSteps = 120;
+	VehicleScene vehicles(false, numVehicles);
+	VehicleScene fleet(true, numVehicles);
+	vehicles.step(numSteps);
+	fleet.step(numSteps);
+
+	// the vehicles drove over the bumps, and the fleet matches the per vehicle actions exactly
+	for (int i = 0; i < numVehicles; i++)
+	{
+		EXPECT_GT(vehicles.m_chassis[i]->getWorldTransform().getOrigin().z(), btScalar(3));
+	}
+	expectSameVehicles(vehicles, fleet);
+
+	// one batch of all wheel rays per step
+	EXPECT_EQ(0, vehicles.m_raycaster.m_numRayBatches);
+	EXPECT_EQ(numSteps, fleet.m_raycaster.m_numRayBatches);
+	EXPECT_EQ(numSteps * numVehicles * 4, fleet.m_raycaster.m_numRays);
+
+	// vehicles are added once and can be removed
+	fleet.m_fleet.addVehicle(fleet.m_vehicles[0]);
+	EXPECT_EQ(numVehicles, fleet.m_fleet.getNumVehicles());
+	fleet.m_fleet.removeVehicle(fleet.m_vehicles[0]);
+	EXPECT_EQ(numVehicles - 1, fleet.m_fleet.getNumVehicles());
+	fleet.m_fleet.addVehicle(fleet.m_vehicles[0]);
+}
+
+GTEST_TEST(BulletDynamics, RaycastVehicleFleetWheelSweeps)
+{
+	// on flat ground the sphere touches where the ray ends, so sweeps and rays agree up to the ray test tolerance
+	VehicleScene rays(true, 1);
+	VehicleScene sweeps(true, 1);
+	sweeps.m_fleet.setUseWheelSweeps(true);
+	rays.m_fleet.updateFleet(btScalar(1. / 60.));
+	sweeps.m_fleet.updateFleet(btScalar(1. / 60.));
+	for (int w = 0; w < 4; w++)
+	{
+		const btWheelInfo::RaycastInfo& ray = rays.m_vehicles[0]->getWheelInfo(w).m_raycastInfo;
+		const btWheelInfo::RaycastInfo& sweep = sweeps.m_vehicles[0]->getWheelInfo(w).m_raycastInfo;
+		EXPECT_TRUE(ray.m_isInContact);
+		EXPECT_TRUE(sweep.m_isInContact);
+		EXPECT_NEAR(ray.m_suspensionLength, sweep.m_suspensionLength, 5e-3);
+		EXPECT_LT((ray.m_contactNormalWS - sweep.m_contactNormalWS).length(), 1e-4);
+	}
+	EXPECT_EQ(0, sweeps.m_raycaster.m_numRayBatches);
+
+	// a bump beside the ray is only seen by the sphere
+	VehicleScene bumpRays(true, 1);
+	VehicleScene bumpSweeps(true, 1);
+	bumpSweeps.m_fleet.setUseWheelSweeps(true);
+	const btVector3 wheelPosition(btScalar(-0.9), 0, btScalar(1.5));
+	bumpRays.addStatic(&bumpRays.m_bumpShape, wheelPosition + btVector3(btScalar(-0.65), btScalar(0.1), 0));
+	bumpSweeps.addStatic(&bumpSweeps.m_bumpShape, wheelPosition + btVector3(btScalar(-0.65), btScalar(0.1), 0));
+	bumpRays.m_fleet.updateFleet(btScalar(1. / 60.));
+	bumpSweeps.m_fleet.updateFleet(btScalar(1. / 60.));
+	const btWheelInfo::RaycastInfo& ray = bumpRays.m_vehicles[0]->getWheelInfo(0).m_raycastInfo;
+	const btWheelInfo::RaycastInfo& sweep = bumpSweeps.m_vehicles[0]->getWheelInfo(0).m_raycastInfo;
+	EXPECT_TRUE(ray.m_isInContact);
+	EXPECT_TRUE(sweep.m_isInContact);
+	EXPECT_LT(sweep.m_suspensionLength, ray.m_suspensionLength - btScalar(0.1));
+}
+
+#if BT_THREADSAFE
+GTEST_TEST(BulletDynamics, RaycastVehicleFleetThreads)
+{
+	VehicleScene reference(false, 12);
+	reference.step(60);
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (scheduler)
+	{
+		btSetTaskScheduler(scheduler);
+		for (int numThreads = 1; numThreads <= 4; numThreads *= 2)
+		{
+			scheduler->setNumThreads(btMin(numThreads, scheduler->getMaxNumThreads()));
+			VehicleScene fleet(true, 12);
+			fleet.step(60);
+			expectSameVehicles(reference, fleet);
+		}
+		btSetTaskScheduler(previous);
+		delete scheduler;
+	}
+}
+#endif
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,649 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletSoftBody/btSoftRigidDynamicsWorld.h>
+#include <BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h>
+#include <BulletSoftBody/btSoftBodyHelpers.h>
+#include <BulletSoftBody/btDefaultSoftBodySolver.h>
+#include <BulletSoftBody/btSparseSDF.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <LinearMath/btThreads.h>
+#include <gtest/gtest.h>
+
+// every internal volume is the merge of its children, every leaf contains its node or face
+static void checkTreeVolumes(const btDbvtNode* node, int& numLeaves)
+{
+	if (node->isleaf())
+	{
+		numLeaves++;
+		return;
+	}
+	btDbvtVolume merged;
+	Merge(node->childs[0]->volume, node->childs[1]->volume, merged);
+	for (int i = 0; i < 3; i++)
+	{
+		EXPECT_EQ(merged.Mins()[i], node->volume.Mins()[i]);
+		EXPECT_EQ(merged.Maxs()[i], node->volume.Maxs()[i]);
+	}
+	checkTreeVolumes(node->childs[0], numLeaves);
+	checkTreeVolumes(node->childs[1], numLeaves);
+}
+
+static void checkTrees(const btSoftBody* cloth)
+{
+	const btScalar radius = cloth->m_sst.radmrg;
+	for (int i = 0; i < cloth->m_nodes.size(); i++)
+	{
+		const btSoftBody::Node& n = cloth->m_nodes[i];
+		EXPECT_TRUE(n.m_leaf->volume.Contain(btDbvtVolume::FromCR(n.m_x, radius)));
+	}
+	for (int i = 0; i < cloth->m_faces.size(); i++)
+	{
+		const btSoftBody::Face& f = cloth->m_faces[i];
+		for (int j = 0; j < 3; j++)
+		{
+			EXPECT_TRUE(f.m_leaf->volume.Contain(btDbvtVolume::FromCR(f.m_n[j]->m_x, radius)));
+		}
+	}
+	int numLeaves = 0;
+	checkTreeVolumes(cloth->m_ndbvt.m_root, numLeaves);
+	EXPECT_EQ(cloth->m_nodes.size(), numLeaves);
+	numLeaves = 0;
+	checkTreeVolumes(cloth->m_fdbvt.m_root, numLeaves);
+	EXPECT_EQ(cloth->m_faces.size(), numLeaves);
+}
+
+// checks the trees of the soft bodies when they are used by the collision detection
+class TreeCheckWorld : public btSoftRigidDynamicsWorld
+{
+public:
+	bool m_checkTrees;
+
+	TreeCheckWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration, btSoftBodySolver* softBodySolver)
+		: btSoftRigidDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration, softBodySolver),
+		  m_checkTrees(false)
+	{
+	}
+
+	virtual void performDiscreteCollisionDetection()
+	{
+		if (m_checkTrees)
+		{
+			for (int i = 0; i < getSoftBodyArray().size(); i++)
+			{
+				checkTrees(getSoftBodyArray()[i]);
+			}
+		}
+		btSoftRigidDynamicsWorld::performDiscreteCollisionDetection();
+	}
+};
+
+struct ClothScene
+{
+	btSoftBodyRigidBodyCollisionConfiguration m_collisionConfiguration;
+	btCollisionDispatcher* m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btSequentialImpulseConstraintSolver m_solver;
+	btDefaultSoftBodySolver m_softBodySolver;
+	TreeCheckWorld m_world;
+	btBoxShape m_groundShape;
+	btBoxShape m_boxShape;
+	btRigidBody m_ground;
+	btRigidBody m_box;
+	btAlignedObjectArray<btSoftBody*> m_cloths;
+
+	// cloths pinned at two corners, stacked above a static box
+	ClothScene(int resolution, int numCloths = 1, bool useDispatcherMt = false)
+		: m_dispatcher(createDispatcher(&m_collisionConfiguration, useDispatcherMt)),
+		  m_world(m_dispatcher, &m_broadphase, &m_solver, &m_collisionConfiguration, &m_softBodySolver),
+		  m_groundShape(btVector3(50, 1, 50)),
+		  m_boxShape(btVector3(btScalar(0.5), btScalar(0.5), btScalar(0.5))),
+		  m_ground(0, 0, &m_groundShape),
+		  m_box(0, 0, &m_boxShape)
+	{
+		m_world.setGravity(btVector3(0, -10, 0));
+		btSoftBodyWorldInfo& worldInfo = m_world.getWorldInfo();
+		worldInfo.m_gravity.setValue(0, -10, 0);
+
+		m_ground.getWorldTransform().setOrigin(btVector3(0, -1, 0));
+		m_world.addRigidBody(&m_ground);
+		m_box.getWorldTransform().setOrigin(btVector3(btScalar(0.3), btScalar(0.5), 0));
+		m_world.addRigidBody(&m_box);
+
+		for (int i = 0; i < numCloths; i++)
+		{
+			btScalar y = btScalar(2) + btScalar(i) * btScalar(0.3);
+			btSoftBody* cloth = btSoftBodyHelpers::CreatePatch(worldInfo, btVector3(-1, y, -1), btVector3(1, y, -1),
+															   btVector3(-1, y, 1), btVector3(1, y, 1), resolution, resolution, 1 + 2, true);
+			cloth->m_cfg.piterations = 8;
+			cloth->m_cfg.collisions |= btSoftBody::fCollision::VF_SS;
+			cloth->m_materials[0]->m_kLST = btScalar(0.8);
+			cloth->setTotalMass(1);
+			m_world.addSoftBody(cloth);
+			m_cloths.push_back(cloth);
+		}
+	}
+
+	static btCollisionDispatcher* createDispatcher(btCollisionConfiguration* collisionConfiguration, bool useDispatcherMt)
+	{
+#if BT_THREADSAFE
+		if (useDispatcherMt)
+		{
+			return new btCollisionDispatcherMt(collisionConfiguration, 1);
+		}
+#endif
+		return new btCollisionDispatcher(collisionConfiguration);
+	}
+
+	~ClothScene()
+	{
+		for (int i = 0; i < m_cloths.size(); i++)
+		{
+			m_world.removeSoftBody(m_cloths[i]);
+			delete m_cloths[i];
+		}
+		m_world.removeRigidBody(&m_box);
+		m_world.removeRigidBody(&m_ground);
+		delete m_dispatcher;
+	}
+
+	void step(int numSteps)
+	{
+		for (int i = 0; i < numSteps; i++)
+		{
+			m_world.stepSimulation(btScalar(1. / 60.), 0);
+		}
+	}
+};
+
+static void expectSameNodes(const btSoftBody* expected, const btSoftBody* actual)
+{
+	ASSERT_EQ(expected->m_nodes.size(), actual->m_nodes.size());
+	for (int i = 0; i < expected->m_nodes.size(); i++)
+	{
+		const btSoftBody::Node& a = expected->m_nodes[i];
+		const btSoftBody::Node& b = actual->m_nodes[i];
+		EXPECT_EQ(a.m_x.x(), b.m_x.x());
+		EXPECT_EQ(a.m_x.y(), b.m_x.y());
+		EXPECT_EQ(a.m_x.z(), b.m_x.z());
+		EXPECT_EQ(a.m_v.x(), b.m_v.x());
+		EXPECT_EQ(a.m_v.y(), b.m_v.y());
+		EXPECT_EQ(a.m_v.z(), b.m_v.z());
+	}
+}
+
+static void comparePackedWithLinks(bool useLinkColoring)
+{
+	ClothScene links(25);
+	ClothScene packed(25);
+	packed.m_cloths[0]->setUsePackedSolverData(true);
+	if (useLinkColoring)
+	{
+		links.m_cloths[0]->colorLinks(16);
+		packed.m_cloths[0]->colorLinks(16);
+		ASSERT_TRUE(packed.m_cloths[0]->hasLinkColoring());
+	}
+	links.step(60);
+	packed.step(60);
+
+	// the packed links are released after each solve, the packed nodes are kept
+	EXPECT_EQ(packed.m_cloths[0]->m_nodes.size(), packed.m_cloths[0]->m_packedNodes.size());
+	EXPECT_EQ(0, links.m_cloths[0]->m_packedNodes.size());
+	EXPECT_GT(packed.m_cloths[0]->m_rcontacts.size(), 0);
+	expectSameNodes(links.m_cloths[0], packed.m_cloths[0]);
+}
+
+GTEST_TEST(BulletSoftBody, PackedLinkSolver)
+{
+	// uncolored links are solved in the same order, only the data layout differs
+	comparePackedWithLinks(false);
+}
+
+GTEST_TEST(BulletSoftBody, PackedColoredLinkSolver)
+{
+	// the four-wide kernel solves the links of one color in the same order as the colored loop
+	comparePackedWithLinks(true);
+}
+
+// a rigid contact with the node replaced by its index, so contacts of two scenes can be compared
+struct RecordedRContact
+{
+	int m_node;
+	btVector3 m_normal;
+	btScalar m_offset;
+	btVector3 m_c1;
+	btScalar m_c2;
+	btScalar m_c3;
+};
+
+struct RecordedRContactLess
+{
+	bool operator()(const RecordedRContact& a, const RecordedRContact& b) const
+	{
+		return a.m_node < b.m_node;
+	}
+};
+
+static void recordRContacts(const btSoftBody* cloth, btAlignedObjectArray<RecordedRContact>& contacts)
+{
+	contacts.resize(0);
+	for (int i = 0; i < cloth->m_rcontacts.size(); i++)
+	{
+		const btSoftBody::RContact& c = cloth->m_rcontacts[i];
+		RecordedRContact& contact = contacts.expandNonInitializing();
+		contact.m_node = int(c.m_node - &cloth->m_nodes[0]);
+		contact.m_normal = c.m_cti.m_normal;
+		contact.m_offset = c.m_cti.m_offset;
+		contact.m_c1 = c.m_c1;
+		contact.m_c2 = c.m_c2;
+		contact.m_c3 = c.m_c3;
+	}
+	contacts.quickSort(RecordedRContactLess());
+}
+
+// a soft contact with the node and face replaced by indices, so contacts of two scenes can be compared
+struct RecordedSContact
+{
+	int m_node;
+	int m_face;
+	btVector3 m_normal;
+	btVector3 m_weights;
+	btScalar m_margin;
+};
+
+struct RecordedSContactLess
+{
+	bool operator()(const RecordedSContact& a, const RecordedSContact& b) const
+	{
+		if (a.m_node != b.m_node) return a.m_node < b.m_node;
+		return a.m_face < b.m_face;
+	}
+};
+
+static void recordSContacts(const ClothScene& scene, const btSoftBody* cloth, btAlignedObjectArray<RecordedSContact>& contacts)
+{
+	contacts.resize(0);
+	for (int i = 0; i < cloth->m_scontacts.size(); i++)
+	{
+		const btSoftBody::SContact& c = cloth->m_scontacts[i];
+		RecordedSContact& contact = contacts.expandNonInitializing();
+		contact.m_node = int(c.m_node - &cloth->m_nodes[0]);
+		contact.m_face = -1;
+		for (int j = 0; j < scene.m_cloths.size(); j++)
+		{
+			const btSoftBody::tFaceArray& faces = scene.m_cloths[j]->m_faces;
+			if (c.m_face >= &faces[0] && c.m_face < &faces[0] + faces.size())
+			{
+				contact.m_face = j * faces.size() + int(c.m_face - &faces[0]);
+			}
+		}
+		contact.m_normal = c.m_normal;
+		contact.m_weights = c.m_weights;
+		contact.m_margin = c.m_margin;
+	}
+	contacts.quickSort(RecordedSContactLess());
+}
+
+GTEST_TEST(BulletSoftBody, ContactBuffers)
+{
+	// from the same state, buffered and direct collision find the same contacts, only their order differs
+	ClothScene direct(13, 3);
+	ClothScene buffered(13, 3);
+	direct.step(30);
+	buffered.step(29);
+	buffered.m_softBodySolver.setUseContactBuffers(true);
+	buffered.step(1);
+
+	int numRContacts = 0;
+	int numSContacts = 0;
+	for (int i = 0; i < direct.m_cloths.size(); i++)
+	{
+		btAlignedObjectArray<RecordedRContact> rdirect;
+		btAlignedObjectArray<RecordedRContact> rbuffered;
+		recordRContacts(direct.m_cloths[i], rdirect);
+		recordRContacts(buffered.m_cloths[i], rbuffered);
+		ASSERT_EQ(rdirect.size(), rbuffered.size());
+		for (int j = 0; j < rdirect.size(); j++)
+		{
+			EXPECT_EQ(rdirect[j].m_node, rbuffered[j].m_node);
+			EXPECT_EQ(rdirect[j].m_normal, rbuffered[j].m_normal);
+			EXPECT_EQ(rdirect[j].m_offset, rbuffered[j].m_offset);
+			EXPECT_EQ(rdirect[j].m_c1, rbuffered[j].m_c1);
+			EXPECT_EQ(rdirect[j].m_c2, rbuffered[j].m_c2);
+			EXPECT_EQ(rdirect[j].m_c3, rbuffered[j].m_c3);
+		}
+		numRContacts += rdirect.size();
+
+		btAlignedObjectArray<RecordedSContact> sdirect;
+		btAlignedObjectArray<RecordedSContact> sbuffered;
+		recordSContacts(direct, direct.m_cloths[i], sdirect);
+		recordSContacts(buffered, buffered.m_cloths[i], sbuffered);
+		ASSERT_EQ(sdirect.size(), sbuffered.size());
+		for (int j = 0; j < sdirect.size(); j++)
+		{
+			EXPECT_EQ(sdirect[j].m_node, sbuffered[j].m_node);
+			EXPECT_EQ(sdirect[j].m_face, sbuffered[j].m_face);
+			EXPECT_EQ(sdirect[j].m_normal, sbuffered[j].m_normal);
+			EXPECT_EQ(sdirect[j].m_weights, sbuffered[j].m_weights);
+			EXPECT_EQ(sdirect[j].m_margin, sbuffered[j].m_margin);
+		}
+		numSContacts += sdirect.size();
+	}
+	EXPECT_GT(numRContacts, 0);
+	EXPECT_GT(numSContacts, 0);
+}
+
+struct LeafPair
+{
+	const btDbvtNode* m_a;
+	const btDbvtNode* m_b;
+};
+
+struct LeafPairLess
+{
+	bool operator()(const LeafPair& a, const LeafPair& b) const
+	{
+		if (a.m_a != b.m_a) return a.m_a < b.m_a;
+		return a.m_b < b.m_b;
+	}
+};
+
+struct LeafPairCollector : public btDbvt::ICollide
+{
+	btAlignedObjectArray<LeafPair> m_pairs;
+
+	void Process(const btDbvtNode* a, const btDbvtNode* b)
+	{
+		LeafPair& pair = m_pairs.expandNonInitializing();
+		pair.m_a = a;
+		pair.m_b = b;
+	}
+};
+
+static void gatherLeaves(const btDbvtNode* node, btAlignedObjectArray<const btDbvtNode*>& leaves)
+{
+	if (node->isleaf())
+	{
+		leaves.push_back(node);
+		return;
+	}
+	gatherLeaves(node->childs[0], leaves);
+	gatherLeaves(node->childs[1], leaves);
+}
+
+static void expectSameOverlaps(btDbvt& tree0, btDbvt& tree1)
+{
+	LeafPairCollector collector;
+	tree0.collideTT(tree0.m_root, tree1.m_root, collector);
+	collector.m_pairs.quickSort(LeafPairLess());
+
+	btAlignedObjectArray<const btDbvtNode*> leaves0;
+	btAlignedObjectArray<const btDbvtNode*> leaves1;
+	gatherLeaves(tree0.m_root, leaves0);
+	gatherLeaves(tree1.m_root, leaves1);
+	btAlignedObjectArray<LeafPair> expected;
+	for (int i = 0; i < leaves0.size(); i++)
+	{
+		for (int j = 0; j < leaves1.size(); j++)
+		{
+			if (Intersect(leaves0[i]->volume, leaves1[j]->volume))
+			{
+				LeafPair& pair = expected.expandNonInitializing();
+				pair.m_a = leaves0[i];
+				pair.m_b = leaves1[j];
+			}
+		}
+	}
+	expected.quickSort(LeafPairLess());
+
+	ASSERT_EQ(expected.size(), collector.m_pairs.size());
+	for (int i = 0; i < expected.size(); i++)
+	{
+		EXPECT_EQ(expected[i].m_a, collector.m_pairs[i].m_a);
+		EXPECT_EQ(expected[i].m_b, collector.m_pairs[i].m_b);
+	}
+}
+
+GTEST_TEST(BulletSoftBody, TreeRefit)
+{
+	// the refit trees stay valid while the cloths fall onto the box and onto each other, with a rebuild whenever they get worse
+	ClothScene scene(17, 3);
+	for (int i = 0; i < scene.m_cloths.size(); i++)
+	{
+		scene.m_cloths[i]->setUseTreeRefit(true, 1);
+	}
+	scene.m_world.m_checkTrees = true;
+	scene.step(30);
+
+	// the node and face trees of two cloths report exactly the overlapping leaf pairs
+	for (int i = 0; i < scene.m_cloths.size(); i++)
+	{
+		for (int j = 0; j < scene.m_cloths.size(); j++)
+		{
+			if (i != j)
+			{
+				expectSameOverlaps(scene.m_cloths[i]->m_ndbvt, scene.m_cloths[j]->m_fdbvt);
+			}
+		}
+	}
+
+	// rigid contacts need a node inside the margin, so they do not depend on how fat the leaves are
+	ClothScene incremental(17, 3);
+	ClothScene refit(17, 3);
+	incremental.step(30);
+	refit.step(29);
+	for (int i = 0; i < refit.m_cloths.size(); i++)
+	{
+		refit.m_cloths[i]->setUseTreeRefit(true);
+	}
+	refit.step(1);
+	int numRContacts = 0;
+	for (int i = 0; i < refit.m_cloths.size(); i++)
+	{
+		btAlignedObjectArray<RecordedRContact> rincremental;
+		btAlignedObjectArray<RecordedRContact> rrefit;
+		recordRContacts(incremental.m_cloths[i], rincremental);
+		recordRContacts(refit.m_cloths[i], rrefit);
+		ASSERT_EQ(rincremental.size(), rrefit.size());
+		for (int j = 0; j < rrefit.size(); j++)
+		{
+			EXPECT_EQ(rincremental[j].m_node, rrefit[j].m_node);
+			EXPECT_EQ(rincremental[j].m_normal, rrefit[j].m_normal);
+		}
+		numRContacts += rrefit.size();
+	}
+	EXPECT_GT(numRContacts, 0);
+}
+
+GTEST_TEST(BulletSoftBody, SparseSdfClampZero)
+{
+	// without room for any cell the SDF is reset before every new cell, and still gives the same distances
+	btBoxShape box(btVector3(1, btScalar(0.5), btScalar(0.75)));
+	btSparseSdf<3> reference;
+	reference.Initialize();
+	btSparseSdf<3> sdf;
+	sdf.Initialize(2383, 0);
+	for (int i = 0; i < 64; i++)
+	{
+		const btVector3 point(btScalar(i % 4) - 2, btScalar((i / 4) % 4) - btScalar(1.5), btScalar(i / 16) - btScalar(1.5));
+		btVector3 referenceNormal, normal;
+		const btScalar referenceDistance = reference.Evaluate(point, &box, referenceNormal, btScalar(0.05));
+		const btScalar distance = sdf.Evaluate(point, &box, normal, btScalar(0.05));
+		EXPECT_EQ(referenceDistance, distance);
+		for (int j = 0; j < 3; j++)
+		{
+			EXPECT_EQ(referenceNormal[j], normal[j]);
+		}
+		EXPECT_LE(sdf.ncells, 1);
+	}
+}
+
+#if BT_THREADSAFE
+struct SdfProbeLoop : public btIParallelForBody
+{
+	btSparseSdf<3>* m_sdf;
+	const btCollisionShape* m_shape;
+	btAlignedObjectArray<btVector3>* m_points;
+	btAlignedObjectArray<btVector4>* m_results;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			btVector3 normal;
+			btScalar distance = m_sdf->Evaluate((*m_points)[i], m_shape, normal, btScalar(0.05));
+			(*m_results)[i] = btVector4(normal.x(), normal.y(), normal.z(), distance);
+		}
+	}
+};
+
+GTEST_TEST(BulletSoftBody, SparseSdfThreads)
+{
+	// points around a box, several per cell and several cells per lock stripe
+	btBoxShape box(btVector3(1, btScalar(0.5), btScalar(0.75)));
+	btAlignedObjectArray<btVector3> points;
+	for (int i = 0; i < 16384; i++)
+	{
+		btScalar u = btScalar((i * 7919) % 16384) / btScalar(16384);
+		btScalar v = btScalar((i * 104729) % 16384) / btScalar(16384);
+		btScalar w = btScalar(i) / btScalar(16384);
+		points.push_back(btVector3(u * 4 - 2, v * 3 - btScalar(1.5), w * 3 - btScalar(1.5)));
+	}
+
+	btSparseSdf<3> serialSdf;
+	serialSdf.Initialize();
+	btAlignedObjectArray<btVector4> reference;
+	reference.resize(points.size());
+	SdfProbeLoop loop;
+	loop.m_shape = &box;
+	loop.m_points = &points;
+	loop.m_sdf = &serialSdf;
+	loop.m_results = &reference;
+	loop.forLoop(0, points.size());
+
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (scheduler)
+	{
+		scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+		btSetTaskScheduler(scheduler);
+	}
+	// with a large clamp the cells are built once, with a small one the SDF is reset while other threads read it
+	for (int clampCells = 256 * 1024; clampCells >= 16; clampCells /= 128)
+	{
+		btSparseSdf<3> sdf;
+		sdf.Initialize(2383, clampCells);
+		btAlignedObjectArray<btVector4> results;
+		results.resize(points.size());
+		loop.m_sdf = &sdf;
+		loop.m_results = &results;
+		btParallelFor(0, points.size(), 64, loop);
+		for (int i = 0; i < points.size(); i++)
+		{
+			EXPECT_EQ(reference[i], results[i]);
+		}
+		EXPECT_LE(sdf.ncells, clampCells);
+		if (clampCells > serialSdf.ncells)
+		{
+			EXPECT_EQ(serialSdf.ncells, sdf.ncells);
+		}
+	}
+	btSetTaskScheduler(previous);
+	delete scheduler;
+}
+
+GTEST_TEST(BulletSoftBody, ContactBuffersDispatcherMt)
+{
+	// soft pairs processed in parallel give the same result for any thread count
+	btAlignedObjectArray<btVector3> reference;
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (scheduler)
+	{
+		btSetTaskScheduler(scheduler);
+	}
+	for (int numThreads = 1; numThreads <= 4; numThreads *= 2)
+	{
+		if (scheduler)
+		{
+			scheduler->setNumThreads(btMin(numThreads, scheduler->getMaxNumThreads()));
+		}
+		ClothScene scene(13, 3, true);
+		scene.m_softBodySolver.setUseContactBuffers(true);
+		scene.step(30);
+		btAlignedObjectArray<btVector3> positions;
+		int numSContacts = 0;
+		for (int i = 0; i < scene.m_cloths.size(); i++)
+		{
+			numSContacts += scene.m_cloths[i]->m_scontacts.size();
+			for (int j = 0; j < scene.m_cloths[i]->m_nodes.size(); j++)
+			{
+				positions.push_back(scene.m_cloths[i]->m_nodes[j].m_x);
+			}
+		}
+		EXPECT_GT(numSContacts, 0);
+		if (reference.size() == 0)
+		{
+			reference = positions;
+			continue;
+		}
+		EXPECT_EQ(reference.size(), positions.size());
+		for (int i = 0; i < btMin(reference.size(), positions.size()); i++)
+		{
+			EXPECT_EQ(reference[i], positions[i]);
+		}
+	}
+	btSetTaskScheduler(previous);
+	delete scheduler;
+}
+
+GTEST_TEST(BulletSoftBody, TreeRefitThreads)
+{
+	// the levels are refit in chunks, the result and the rebuilds do not depend on the thread count
+	btAlignedObjectArray<btVector3> reference;
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (scheduler)
+	{
+		btSetTaskScheduler(scheduler);
+	}
+	for (int numThreads = 1; numThreads <= 4; numThreads *= 2)
+	{
+		if (scheduler)
+		{
+			scheduler->setNumThreads(btMin(numThreads, scheduler->getMaxNumThreads()));
+		}
+		ClothScene scene(25, 2);
+		for (int i = 0; i < scene.m_cloths.size(); i++)
+		{
+			scene.m_cloths[i]->setUseTreeRefit(true, 2);
+		}
+		scene.m_world.m_checkTrees = true;
+		scene.step(20);
+		btAlignedObjectArray<btVector3> positions;
+		for (int i = 0; i < scene.m_cloths.size(); i++)
+		{
+			for (int j = 0; j < scene.m_cloths[i]->m_nodes.size(); j++)
+			{
+				positions.push_back(scene.m_cloths[i]->m_nodes[j].m_x);
+			}
+		}
+		if (reference.size() == 0)
+		{
+			reference = positions;
+			continue;
+		}
+		EXPECT_EQ(reference.size(), positions.size());
+		for (int i = 0; i < btMin(reference.size(), positions.size()); i++)
+		{
+			EXPECT_EQ(reference[i], positions[i]);
+		}
+	}
+	btSetTaskScheduler(previous);
+	delete scheduler;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,227 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletSoftBody/btSoftBody.h>
+#include <BulletSoftBody/btSoftBodyHelpers.h>
+#include <gtest/gtest.h>
+#include <string.h>
+
+// a grid of cubes, each split into six tetras around the main diagonal
+static void createTetGrid(int size, btAlignedObjectArray<btScalar>& vertices, btAlignedObjectArray<int>& tetras)
+{
+	const int n = size + 1;
+	for (int z = 0; z < n; z++)
+	{
+		for (int y = 0; y < n; y++)
+		{
+			for (int x = 0; x < n; x++)
+			{
+				vertices.push_back(btScalar(x) * btScalar(0.5));
+				vertices.push_back(btScalar(y) * btScalar(0.5) + btScalar(z) * btScalar(0.01));
+				vertices.push_back(btScalar(z) * btScalar(0.5));
+			}
+		}
+	}
+	static const int paths[6][3] = {{1, 2, 4}, {1, 4, 2}, {2, 1, 4}, {2, 4, 1}, {4, 1, 2}, {4, 2, 1}};
+	for (int z = 0; z < size; z++)
+	{
+		for (int y = 0; y < size; y++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				int corners[8];
+				for (int c = 0; c < 8; c++)
+				{
+					corners[c] = (x + (c & 1)) + (y + ((c >> 1) & 1)) * n + (z + (c >> 2)) * n * n;
+				}
+				for (int t = 0; t < 6; t++)
+				{
+					int c = 0;
+					tetras.push_back(corners[c]);
+					for (int k = 0; k < 3; k++)
+					{
+						c |= paths[t][k];
+						tetras.push_back(corners[c]);
+					}
+				}
+			}
+		}
+	}
+}
+
+static btSoftBody* createTetBody(btSoftBodyWorldInfo& worldInfo)
+{
+	btAlignedObjectArray<btScalar> vertices;
+	btAlignedObjectArray<int> tetras;
+	createTetGrid(4, vertices, tetras);
+	btSoftBody* psb = btSoftBodyHelpers::CreateFromTetMesh(worldInfo, &vertices[0], vertices.size() / 3,
+														   &tetras[0], tetras.size() / 4, false, true, true);
+	psb->setTotalMass(10);
+	psb->m_nodes[0].m_im = 0;
+	return psb;
+}
+
+template <typename T>
+static int nodeIndex(const btSoftBody* psb, const T& element, int i)
+{
+	return int(element.m_n[i] - &psb->m_nodes[0]);
+}
+
+GTEST_TEST(BulletSoftBody, BinaryTetMeshRoundTrip)
+{
+	btSoftBodyWorldInfo worldInfo;
+	btSoftBody* psb = createTetBody(worldInfo);
+	ASSERT_GT(psb->m_links.size(), 0);
+	ASSERT_GT(psb->m_faces.size(), 0);
+	ASSERT_EQ(64 * 6, psb->m_tetras.size());
+
+	btAlignedObjectArray<char> data;
+	btSoftBodyHelpers::ExportAsBinaryTetMesh(psb, data);
+	btSoftBody* loaded = btSoftBodyHelpers::CreateFromBinaryTetMesh(worldInfo, &data[0], data.size());
+	ASSERT_TRUE(loaded != 0);
+
+	// positions and masses are stored as floats, the elements keep their order and orientation
+	ASSERT_EQ(psb->m_nodes.size(), loaded->m_nodes.size());
+	for (int i = 0; i < psb->m_nodes.size(); i++)
+	{
+		const btSoftBody::Node& n = psb->m_nodes[i];
+		const btSoftBody::Node& l = loaded->m_nodes[i];
+		EXPECT_EQ(btScalar(float(n.m_x.x())), l.m_x.x());
+		EXPECT_EQ(btScalar(float(n.m_x.y())), l.m_x.y());
+		EXPECT_EQ(btScalar(float(n.m_x.z())), l.m_x.z());
+		if (n.m_im > 0)
+		{
+			EXPECT_NEAR(n.m_im, l.m_im, n.m_im * 1e-5);
+		}
+		else
+		{
+			EXPECT_EQ(btScalar(0), l.m_im);
+		}
+	}
+	ASSERT_EQ(psb->m_links.size(), loaded->m_links.size());
+	for (int i = 0; i < psb->m_links.size(); i++)
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			EXPECT_EQ(nodeIndex(psb, psb->m_links[i], j), nodeIndex(loaded, loaded->m_links[i], j));
+		}
+	}
+	ASSERT_EQ(psb->m_faces.size(), loaded->m_faces.size());
+	for (int i = 0; i < psb->m_faces.size(); i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			EXPECT_EQ(nodeIndex(psb, psb->m_faces[i], j), nodeIndex(loaded, loaded->m_faces[i], j));
+		}
+	}
+	ASSERT_EQ(psb->m_tetras.size(), loaded->m_tetras.size());
+	for (int i = 0; i < psb->m_tetras.size(); i++)
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			EXPECT_EQ(nodeIndex(psb, psb->m_tetras[i], j), nodeIndex(loaded, loaded->m_tetras[i], j));
+		}
+	}
+
+	// exporting the loaded body again gives the same bytes
+	btAlignedObjectArray<char> reexported;
+	btSoftBodyHelpers::ExportAsBinaryTetMesh(loaded, reexported);
+	ASSERT_EQ(data.size(), reexported.size());
+	EXPECT_EQ(0, memcmp(&data[0], &reexported[0], data.size()));
+
+	delete loaded;
+	delete psb;
+}
+
+GTEST_TEST(BulletSoftBody, BinaryTetMeshRejectsInvalidData)
+{
+	btSoftBodyWorldInfo worldInfo;
+	btSoftBody* psb = createTetBody(worldInfo);
+	btAlignedObjectArray<char> data;
+	btSoftBodyHelpers::ExportAsBinaryTetMesh(psb, data);
+	delete psb;
+
+	EXPECT_TRUE(btSoftBodyHelpers::CreateFromBinaryTetMesh(worldInfo, 0, data.size()) == 0);
+
+	// truncated anywhere in the header or the payload
+	const int sizes[] = {0, 3, 8, 23, 24, 25, data.size() / 2, data.size() - 4, data.size() - 1};
+	for (int i = 0; i < int(sizeof(sizes) / sizeof(sizes[0])); i++)
+	{
+		EXPECT_TRUE(btSoftBodyHelpers::CreateFromBinaryTetMesh(worldInfo, &data[0], sizes[i]) == 0) << sizes[i];
+	}
+
+	// foreign magic and an unknown version
+	btAlignedObjectArray<char> corrupt = data;
+	memcpy(&corrupt[0], "BTXX", 4);
+	EXPECT_TRUE(btSoftBodyHelpers::CreateFromBinaryTetMesh(worldInfo, &corrupt[0], corrupt.size()) == 0);
+	corrupt = data;
+	int version = 2;
+	memcpy(&corrupt[4], &version, sizeof(version));
+	EXPECT_TRUE(btSoftBodyHelpers::CreateFromBinaryTetMesh(worldInfo, &corrupt[0], corrupt.size()) == 0);
+
+	// negative and huge element counts
+	int counts[2] = {-1, 0x7fffffff};
+	for (int i = 0; i < 2; i++)
+	{
+		for (int field = 2; field < 6; field++)
+		{
+			corrupt = data;
+			memcpy(&corrupt[field * 4], &counts[i], sizeof(int));
+			EXPECT_TRUE(btSoftBodyHelpers::CreateFromBinaryTetMesh(worldInfo, &corrupt[0], corrupt.size()) == 0) << field;
+		}
+	}
+
+	// a node index out of range in the last tetra
+	corrupt = data;
+	int index = 1 << 20;
+	memcpy(&corrupt[corrupt.size() - 4], &index, sizeof(index));
+	EXPECT_TRUE(btSoftBodyHelpers::CreateFromBinaryTetMesh(worldInfo, &corrupt[0], corrupt.size()) == 0);
+	index = -1;
+	memcpy(&corrupt[corrupt.size() - 4], &index, sizeof(index));
+	EXPECT_TRUE(btSoftBodyHelpers::CreateFromBinaryTetMesh(worldInfo, &corrupt[0], corrupt.size()) == 0);
+
+	// trailing bytes after a valid mesh are ignored
+	corrupt = data;
+	corrupt.push_back(0);
+	btSoftBody* loaded = btSoftBodyHelpers::CreateFromBinaryTetMesh(worldInfo, &corrupt[0], corrupt.size());
+	EXPECT_TRUE(loaded != 0);
+	delete loaded;
+}
+
+GTEST_TEST(BulletSoftBody, SortTetMeshNodes)
+{
+	btAlignedObjectArray<btScalar> vertices;
+	btAlignedObjectArray<int> tetras;
+	createTetGrid(4, vertices, tetras);
+	btAlignedObjectArray<btScalar> sortedVertices = vertices;
+	btAlignedObjectArray<int> sortedTetras = tetras;
+	btAlignedObjectArray<int> remap;
+	remap.resize(vertices.size() / 3);
+	btSoftBodyHelpers::SortTetMeshNodes(&sortedVertices[0], sortedVertices.size() / 3, &sortedTetras[0], sortedTetras.size() / 4, &remap[0]);
+
+	// remap is a permutation that moves every vertex and tetra corner together
+	btAlignedObjectArray<int> seen;
+	seen.resize(remap.size(), 0);
+	for (int i = 0; i < remap.size(); i++)
+	{
+		ASSERT_GE(remap[i], 0);
+		ASSERT_LT(remap[i], remap.size());
+		seen[remap[i]]++;
+		for (int k = 0; k < 3; k++)
+		{
+			EXPECT_EQ(vertices[i * 3 + k], sortedVertices[remap[i] * 3 + k]);
+		}
+	}
+	for (int i = 0; i < seen.size(); i++)
+	{
+		EXPECT_EQ(1, seen[i]);
+	}
+	for (int i = 0; i < tetras.size(); i++)
+	{
+		EXPECT_EQ(remap[tetras[i]], sortedTetras[i]);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
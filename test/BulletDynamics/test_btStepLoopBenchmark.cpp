@@ -0,0 +1,115 @@
+/// Step loop benchmark for the allocations made while stepping a world.
+/// Six soft ellipsoids with VF_SS soft-soft collisions are stacked on the ground next to 400 boxes,
+/// which exercises the btDbvt traversal stacks, the dispatcher and the solvers. After a warm up the world is
+/// stepped and the time per step and the btAlignedAlloc calls per step are reported.
+/// Use --steps=<n> and --warmup=<n> to change the number of steps, a Release build and --steps=300 give stable numbers.
+
+#include <btBulletDynamicsCommon.h>
+#include <BulletSoftBody/btSoftRigidDynamicsWorld.h>
+#include <BulletSoftBody/btSoftBodyHelpers.h>
+#include <BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h>
+#include <gtest/gtest.h>
+#include "Bullet3Common/b3CommandLineArgs.h"
+#include "LinearMath/btQuickprof.h"
+#include <stdio.h>
+
+int FLAGS_steps = 60;
+int FLAGS_warmup = 60;
+
+static bool isFinite(const btVector3& v)
+{
+	return v.x() == v.x() && v.y() == v.y() && v.z() == v.z() && btFabs(v.x()) < BT_LARGE_FLOAT && btFabs(v.y()) < BT_LARGE_FLOAT && btFabs(v.z()) < BT_LARGE_FLOAT;
+}
+
+GTEST_TEST(BulletSoftBody, StepLoopBenchmark)
+{
+	btSoftBodyRigidBodyCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	btDbvtBroadphase broadphase;
+	btSequentialImpulseConstraintSolver solver;
+	btSoftRigidDynamicsWorld world(&dispatcher, &broadphase, &solver, &collisionConfiguration);
+	world.getWorldInfo().m_sparsesdf.Initialize();
+
+	btBoxShape groundShape(btVector3(50, 1, 50));
+	btRigidBody ground(0, 0, &groundShape);
+	ground.getWorldTransform().setOrigin(btVector3(0, -1, 0));
+	world.addRigidBody(&ground);
+
+	btBoxShape boxShape(btVector3(btScalar(0.5), btScalar(0.5), btScalar(0.5)));
+	btVector3 inertia;
+	boxShape.calculateLocalInertia(1, inertia);
+	btAlignedObjectArray<btRigidBody*> boxes;
+	for (int i = 0; i < 400; i++)
+	{
+		btRigidBody* box = new btRigidBody(1, 0, &boxShape, inertia);
+		box->getWorldTransform().setOrigin(btVector3(btScalar(i % 10) * btScalar(1.1) - 5, 1 + btScalar(i / 100) * btScalar(1.1), btScalar((i / 10) % 10) * btScalar(1.1) + 8));
+		world.addRigidBody(box);
+		boxes.push_back(box);
+	}
+
+	btAlignedObjectArray<btSoftBody*> softBodies;
+	for (int i = 0; i < 6; i++)
+	{
+		btSoftBody* psb = btSoftBodyHelpers::CreateEllipsoid(world.getWorldInfo(), btVector3(0, 2 + btScalar(i) * btScalar(2.2), 0), btVector3(1, 1, 1), 256);
+		psb->m_cfg.collisions = btSoftBody::fCollision::SDF_RS | btSoftBody::fCollision::VF_SS;
+		psb->m_materials[0]->m_kLST = btScalar(0.5);
+		psb->m_cfg.kPR = 500;
+		psb->setTotalMass(1, true);
+		world.addSoftBody(psb);
+		softBodies.push_back(psb);
+	}
+
+	for (int i = 0; i < FLAGS_warmup; i++)
+	{
+		world.stepSimulation(btScalar(1. / 60.), 0);
+	}
+
+	size_t numAllocationsBefore, numBytesBefore;
+	btAlignedAllocGetCounters(&numAllocationsBefore, &numBytesBefore);
+	btClock clock;
+	for (int i = 0; i < FLAGS_steps; i++)
+	{
+		world.stepSimulation(btScalar(1. / 60.), 0);
+	}
+	const double microseconds = double(clock.getTimeMicroseconds());
+	size_t numAllocationsAfter, numBytesAfter;
+	btAlignedAllocGetCounters(&numAllocationsAfter, &numBytesAfter);
+	const int steps = btMax(FLAGS_steps, 1);
+	printf("%d steps: %.1f us/step, %.1f allocations/step, %.0f bytes/step\n", FLAGS_steps, microseconds / steps,
+		   double(numAllocationsAfter - numAllocationsBefore) / steps, double(numBytesAfter - numBytesBefore) / steps);
+
+	// the scene is a load test rather than a stable stack, the bottom ellipsoid is squeezed through the ground
+	// after a few hundred steps, so only check that the simulation did not blow up
+	for (int i = 0; i < softBodies.size(); i++)
+	{
+		for (int n = 0; n < softBodies[i]->m_nodes.size(); n++)
+		{
+			EXPECT_TRUE(isFinite(softBodies[i]->m_nodes[n].m_x));
+		}
+	}
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		EXPECT_TRUE(isFinite(boxes[i]->getWorldTransform().getOrigin()));
+	}
+
+	for (int i = 0; i < softBodies.size(); i++)
+	{
+		world.removeSoftBody(softBodies[i]);
+		delete softBodies[i];
+	}
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		world.removeRigidBody(boxes[i]);
+		delete boxes[i];
+	}
+	world.removeRigidBody(&ground);
+}
+
+int main(int argc, char** argv)
+{
+	b3CommandLineArgs myArgs(argc, argv);
+	myArgs.GetCmdLineArgument("steps", FLAGS_steps);
+	myArgs.GetCmdLineArgument("warmup", FLAGS_warmup);
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
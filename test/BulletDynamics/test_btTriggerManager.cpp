@@ -0,0 +1,167 @@
+#include <btBulletCollisionCommon.h>
+#include <BulletCollision/CollisionDispatch/btTriggerManager.h>
+#include <LinearMath/btThreads.h>
+#include <gtest/gtest.h>
+
+GTEST_TEST(BulletCollision, TriggerEnterStayExit)
+{
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	//btSimpleBroadphase hands out the unique id of the last removed proxy to the next new proxy
+	btSimpleBroadphase broadphase;
+	btCollisionWorld world(&dispatcher, &broadphase, &collisionConfiguration);
+
+	btBoxShape triggerShape(btVector3(2, 2, 2));
+	btSphereShape sphereShape(btScalar(0.5));
+
+	btCollisionObject trigger;
+	trigger.setCollisionShape(&triggerShape);
+	trigger.setCollisionFlags(btCollisionObject::CF_NO_CONTACT_RESPONSE);
+	world.addCollisionObject(&trigger);
+
+	btCollisionObject objectA;
+	objectA.setCollisionShape(&sphereShape);
+	objectA.getWorldTransform().setOrigin(btVector3(1, 0, 0));
+	world.addCollisionObject(&objectA);
+
+	btCollisionObject objectB;
+	objectB.setCollisionShape(&sphereShape);
+	objectB.getWorldTransform().setOrigin(btVector3(1, 0, 0));
+
+	btTriggerManager triggers;
+	triggers.addTrigger(&trigger);
+	EXPECT_TRUE(triggers.isTrigger(&trigger));
+	EXPECT_FALSE(triggers.isTrigger(&objectA));
+
+	//enter
+	world.performDiscreteCollisionDetection();
+	triggers.updateTriggers(&world);
+	ASSERT_EQ(1, triggers.getNumEnterEvents());
+	EXPECT_EQ(0, triggers.getNumExitEvents());
+	EXPECT_EQ(&trigger, triggers.getEnterEvent(0).m_trigger);
+	EXPECT_EQ(&objectA, triggers.getEnterEvent(0).m_object);
+
+	//stay
+	world.performDiscreteCollisionDetection();
+	triggers.updateTriggers(&world);
+	EXPECT_EQ(0, triggers.getNumEnterEvents());
+	EXPECT_EQ(0, triggers.getNumExitEvents());
+	ASSERT_EQ(1, triggers.getNumOverlaps());
+	EXPECT_EQ(&objectA, triggers.getOverlap(0).m_object);
+
+	//replace A by B within one update, B reuses the unique id of A
+	int uidA = objectA.getBroadphaseHandle()->m_uniqueId;
+	world.removeCollisionObject(&objectA);
+	world.addCollisionObject(&objectB);
+	EXPECT_EQ(uidA, objectB.getBroadphaseHandle()->m_uniqueId);
+	world.performDiscreteCollisionDetection();
+	triggers.updateTriggers(&world);
+	ASSERT_EQ(1, triggers.getNumEnterEvents());
+	ASSERT_EQ(1, triggers.getNumExitEvents());
+	EXPECT_EQ(&objectB, triggers.getEnterEvent(0).m_object);
+	EXPECT_EQ(&objectA, triggers.getExitEvent(0).m_object);
+
+	//exit
+	objectB.getWorldTransform().setOrigin(btVector3(10, 0, 0));
+	world.performDiscreteCollisionDetection();
+	triggers.updateTriggers(&world);
+	EXPECT_EQ(0, triggers.getNumEnterEvents());
+	ASSERT_EQ(1, triggers.getNumExitEvents());
+	EXPECT_EQ(&objectB, triggers.getExitEvent(0).m_object);
+	EXPECT_EQ(0, triggers.getNumOverlaps());
+
+	world.removeCollisionObject(&objectB);
+	world.removeCollisionObject(&trigger);
+}
+
+// a sphere trigger and spheres around it, half of them inside the aabb of the trigger but not touching the sphere
+static void checkNarrowphaseConfirmation()
+{
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	btDbvtBroadphase broadphase;
+	btCollisionWorld world(&dispatcher, &broadphase, &collisionConfiguration);
+
+	btSphereShape triggerShape(2);
+	btSphereShape sphereShape(btScalar(0.5));
+
+	btCollisionObject trigger;
+	trigger.setCollisionShape(&triggerShape);
+	trigger.setCollisionFlags(btCollisionObject::CF_NO_CONTACT_RESPONSE);
+	world.addCollisionObject(&trigger);
+
+	const int numObjects = 16;
+	btCollisionObject objects[numObjects];
+	for (int i = 0; i < numObjects; i++)
+	{
+		const btScalar angle = SIMD_2_PI * btScalar(i) / btScalar(numObjects);
+		objects[i].setCollisionShape(&sphereShape);
+		// the odd spheres sit in the corners of the aabb, the even ones touch the trigger
+		const btScalar radius = (i & 1) ? btScalar(2.7) : btScalar(2.2);
+		const btScalar z = (i & 1) ? btScalar(1.5) : btScalar(0);
+		objects[i].getWorldTransform().setOrigin(btVector3(btCos(angle) * radius, btSin(angle) * radius, z));
+		world.addCollisionObject(&objects[i]);
+	}
+
+	btTriggerManager triggers;
+	triggers.addTrigger(&trigger);
+	triggers.setConfirmationGrainSize(2);
+
+	// without confirmation every aabb overlap counts
+	world.performDiscreteCollisionDetection();
+	triggers.updateTriggers(&world);
+	EXPECT_EQ(numObjects, triggers.getNumOverlaps());
+
+	triggers.setNarrowphaseConfirmation(true);
+	world.performDiscreteCollisionDetection();
+	triggers.updateTriggers(&world);
+	ASSERT_EQ(numObjects / 2, triggers.getNumOverlaps());
+	EXPECT_EQ(numObjects / 2, triggers.getNumExitEvents());
+	for (int i = 0; i < triggers.getNumOverlaps(); i++)
+	{
+		EXPECT_EQ(0, int(triggers.getOverlap(i).m_object - &objects[0]) & 1);
+	}
+
+	// an odd sphere moves into the trigger
+	objects[1].getWorldTransform().setOrigin(btVector3(btScalar(1.5), 0, 0));
+	world.performDiscreteCollisionDetection();
+	triggers.updateTriggers(&world);
+	ASSERT_EQ(1, triggers.getNumEnterEvents());
+	EXPECT_EQ(&objects[1], triggers.getEnterEvent(0).m_object);
+	EXPECT_EQ(numObjects / 2 + 1, triggers.getNumOverlaps());
+
+	for (int i = 0; i < numObjects; i++)
+	{
+		world.removeCollisionObject(&objects[i]);
+	}
+	world.removeCollisionObject(&trigger);
+}
+
+GTEST_TEST(BulletCollision, TriggerNarrowphaseConfirmation)
+{
+	// runs serially, also in BT_THREADSAFE builds since no task scheduler is set
+	checkNarrowphaseConfirmation();
+}
+
+#if BT_THREADSAFE
+GTEST_TEST(BulletCollision, TriggerNarrowphaseConfirmationThreads)
+{
+	btITaskScheduler* previous = btGetTaskScheduler();
+	btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (!scheduler)
+	{
+		return;
+	}
+	scheduler->setNumThreads(btMin(4, scheduler->getMaxNumThreads()));
+	btSetTaskScheduler(scheduler);
+	checkNarrowphaseConfirmation();
+	btSetTaskScheduler(previous);
+	delete scheduler;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,93 @@
+// Compares MultiBodyTreeBatch against one MultiBodyTree evaluating the configurations one at a time.
+// Without a task scheduler the batch evaluates the configurations in order on the calling thread.
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../Extras/InverseDynamics/CoilCreator.hpp"
+#include "../Extras/InverseDynamics/DillCreator.hpp"
+#include "../Extras/InverseDynamics/MultiBodyTreeBatch.hpp"
+#include "BulletInverseDynamics/MultiBodyTree.hpp"
+
+using namespace btInverseDynamics;
+
+static const int kNumConfigs = 16;
+
+static idScalar randomValue()
+{
+	return idScalar(rand()) / idScalar(RAND_MAX) * 2 - 1;
+}
+
+static void compareBatch(const MultiBodyTreeCreator& creator)
+{
+	MultiBodyTreeBatch batch;
+	ASSERT_EQ(0, batch.initialize(creator));
+	MultiBodyTree* tree = CreateMultiBodyTree(creator);
+	ASSERT_TRUE(0x0 != tree);
+	const int n = batch.numDoFs();
+	ASSERT_EQ(tree->numDoFs(), n);
+	vec3 gravity;
+	gravity(0) = 0;
+	gravity(1) = 0;
+	gravity(2) = -9.81;
+	ASSERT_EQ(0, batch.setGravityInWorldFrame(gravity));
+	ASSERT_EQ(0, tree->setGravityInWorldFrame(gravity));
+
+	std::vector<idScalar> q(kNumConfigs * n), u(kNumConfigs * n), dot_u(kNumConfigs * n);
+	for (int i = 0; i < kNumConfigs * n; i++)
+	{
+		q[i] = randomValue();
+		u[i] = randomValue();
+		dot_u[i] = randomValue();
+	}
+	std::vector<idScalar> joint_forces(kNumConfigs * n), mass_matrices(kNumConfigs * n * n);
+	EXPECT_EQ(0, batch.calculateInverseDynamics(kNumConfigs, &q[0], &u[0], &dot_u[0], &joint_forces[0]));
+	EXPECT_EQ(0, batch.calculateMassMatrices(kNumConfigs, &q[0], &mass_matrices[0]));
+
+	vecx qi(n), ui(n), dot_ui(n), forces(n);
+	matxx mass(n, n);
+	idScalar max_force_error = 0;
+	idScalar max_mass_error = 0;
+	for (int c = 0; c < kNumConfigs; c++)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			qi(i) = q[c * n + i];
+			ui(i) = u[c * n + i];
+			dot_ui(i) = dot_u[c * n + i];
+		}
+		ASSERT_EQ(0, tree->calculateInverseDynamics(qi, ui, dot_ui, &forces));
+		ASSERT_EQ(0, tree->calculateMassMatrix(qi, &mass));
+		for (int i = 0; i < n; i++)
+		{
+			max_force_error = std::max(max_force_error, std::fabs(forces(i) - joint_forces[c * n + i]));
+			for (int j = 0; j < n; j++)
+			{
+				max_mass_error = std::max(max_mass_error, std::fabs(mass(i, j) - mass_matrices[(c * n + i) * n + j]));
+			}
+		}
+	}
+	EXPECT_LT(max_force_error, 1e-4);
+	EXPECT_LT(max_mass_error, 1e-4);
+	// the calling thread evaluated everything with its own copy of the tree
+	EXPECT_TRUE(0x0 != batch.getThreadTree());
+
+	delete tree;
+}
+
+TEST(InvDynBatch, matchesSingleTree)
+{
+	CoilCreator coil_creator(10);
+	compareBatch(coil_creator);
+	DillCreator dill_creator(3);
+	compareBatch(dill_creator);
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,220 @@
+// Test of the analytic derivatives of inverse and forward dynamics:
+// compare them to central finite differences of the dynamics functions
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <gtest/gtest.h>
+
+#include "../Extras/InverseDynamics/CoilCreator.hpp"
+#include "../Extras/InverseDynamics/DillCreator.hpp"
+#include "../Extras/InverseDynamics/RandomTreeCreator.hpp"
+#include "../Extras/InverseDynamics/SimpleTreeCreator.hpp"
+#include "BulletInverseDynamics/IDMath.hpp"
+#include "BulletInverseDynamics/MultiBodyTree.hpp"
+
+using namespace btInverseDynamics;
+
+const int kLevel = 3;
+const int kNumBodies = 10;
+
+#ifdef BT_ID_USE_DOUBLE_PRECISION
+const idScalar kDelta = 1e-6;
+const idScalar kAcceptableError = 1e-6;
+#else
+const idScalar kDelta = 1e-2;
+const idScalar kAcceptableError = 2e-2;
+#endif
+
+static idScalar randomValue(idScalar max_abs)
+{
+	return max_abs * (2.0 * rand() / RAND_MAX - 1.0);
+}
+
+static void randomState(int num_dofs, vecx* q, vecx* u, vecx* v)
+{
+	for (int i = 0; i < num_dofs; i++)
+	{
+		(*q)(i) = randomValue(BT_ID_PI / 2);
+		(*u)(i) = randomValue(2.0);
+		(*v)(i) = randomValue(4.0);
+	}
+}
+
+// compare to finite differences with respect to q and u,
+// return the maximum difference relative to the largest derivative
+static idScalar inverseDynamicsDerivativesError(const MultiBodyTreeCreator& creator)
+{
+	MultiBodyTree* tree = CreateMultiBodyTree(creator);
+	if (0x0 == tree)
+	{
+		return 1;
+	}
+	const int n = tree->numDoFs();
+	vecx q(n), u(n), dot_u(n), tau_plus(n), tau_minus(n);
+	matxx d_tau_d_q(n, n), d_tau_d_u(n, n);
+	randomState(n, &q, &u, &dot_u);
+
+	if (-1 == tree->calculateInverseDynamicsDerivatives(q, u, dot_u, &d_tau_d_q, &d_tau_d_u))
+	{
+		delete tree;
+		return 1;
+	}
+
+	idScalar max_value = 0;
+	idScalar max_error = 0;
+	for (int k = 0; k < n; k++)
+	{
+		for (int wrt_u = 0; wrt_u < 2; wrt_u++)
+		{
+			vecx& x = wrt_u ? u : q;
+			const idScalar x_k = x(k);
+			x(k) = x_k + kDelta;
+			tree->calculateInverseDynamics(q, u, dot_u, &tau_plus);
+			x(k) = x_k - kDelta;
+			tree->calculateInverseDynamics(q, u, dot_u, &tau_minus);
+			x(k) = x_k;
+			const matxx& analytic = wrt_u ? d_tau_d_u : d_tau_d_q;
+			for (int i = 0; i < n; i++)
+			{
+				const idScalar fd = (tau_plus(i) - tau_minus(i)) / (2.0 * kDelta);
+				max_value = BT_ID_MAX(max_value, BT_ID_FABS(fd));
+				max_error = BT_ID_MAX(max_error, BT_ID_FABS(fd - analytic(i, k)));
+			}
+		}
+	}
+	delete tree;
+	return max_value > 0 ? max_error / max_value : max_error;
+}
+
+// compare forward dynamics derivatives to finite differences,
+// and check that forward dynamics is the inverse of inverse dynamics
+static idScalar forwardDynamicsDerivativesError(const MultiBodyTreeCreator& creator,
+												idScalar* consistency_error)
+{
+	MultiBodyTree* tree = CreateMultiBodyTree(creator);
+	if (0x0 == tree)
+	{
+		return 1;
+	}
+	const int n = tree->numDoFs();
+	vecx q(n), u(n), tau(n), dot_u(n), acc_plus(n), acc_minus(n), tau_check(n);
+	matxx d_acc_d_q(n, n), d_acc_d_u(n, n), d_acc_d_tau(n, n);
+	randomState(n, &q, &u, &tau);
+
+	if (-1 == tree->calculateForwardDynamicsDerivatives(q, u, tau, &dot_u, &d_acc_d_q, &d_acc_d_u,
+														&d_acc_d_tau))
+	{
+		delete tree;
+		return 1;
+	}
+
+	tree->calculateInverseDynamics(q, u, dot_u, &tau_check);
+	*consistency_error = 0;
+	for (int i = 0; i < n; i++)
+	{
+		*consistency_error = BT_ID_MAX(*consistency_error, BT_ID_FABS(tau_check(i) - tau(i)));
+	}
+
+	idScalar max_value = 0;
+	idScalar max_error = 0;
+	for (int k = 0; k < n; k++)
+	{
+		for (int wrt = 0; wrt < 3; wrt++)
+		{
+			vecx& x = 0 == wrt ? q : (1 == wrt ? u : tau);
+			const idScalar x_k = x(k);
+			x(k) = x_k + kDelta;
+			tree->calculateForwardDynamics(q, u, tau, &acc_plus);
+			x(k) = x_k - kDelta;
+			tree->calculateForwardDynamics(q, u, tau, &acc_minus);
+			x(k) = x_k;
+			const matxx& analytic = 0 == wrt ? d_acc_d_q : (1 == wrt ? d_acc_d_u : d_acc_d_tau);
+			for (int i = 0; i < n; i++)
+			{
+				const idScalar fd = (acc_plus(i) - acc_minus(i)) / (2.0 * kDelta);
+				max_value = BT_ID_MAX(max_value, BT_ID_FABS(fd));
+				max_error = BT_ID_MAX(max_error, BT_ID_FABS(fd - analytic(i, k)));
+			}
+		}
+	}
+	delete tree;
+	return max_value > 0 ? max_error / max_value : max_error;
+}
+
+TEST(InvDynDerivatives, inverseDynamics)
+{
+	srand(1234);
+	CoilCreator coil_creator(kNumBodies);
+	DillCreator dill_creator(kLevel);
+	SimpleTreeCreator simple_creator(kNumBodies);
+
+	// serial chain, branched tree and mixed revolute/prismatic joints
+	EXPECT_LT(inverseDynamicsDerivativesError(coil_creator), kAcceptableError);
+	EXPECT_LT(inverseDynamicsDerivativesError(dill_creator), kAcceptableError);
+	EXPECT_LT(inverseDynamicsDerivativesError(simple_creator), kAcceptableError);
+
+	// random trees also contain fixed and floating joints
+	for (int i = 0; i < 5; i++)
+	{
+		RandomTreeCreator random_creator(kNumBodies + 4 * i);
+		EXPECT_LT(inverseDynamicsDerivativesError(random_creator), kAcceptableError);
+	}
+}
+
+TEST(InvDynDerivatives, forwardDynamics)
+{
+	srand(4321);
+	CoilCreator coil_creator(kNumBodies);
+	DillCreator dill_creator(kLevel);
+	SimpleTreeCreator simple_creator(kNumBodies);
+	idScalar consistency_error;
+
+	EXPECT_LT(forwardDynamicsDerivativesError(coil_creator, &consistency_error), kAcceptableError);
+	EXPECT_LT(consistency_error, kAcceptableError);
+	EXPECT_LT(forwardDynamicsDerivativesError(dill_creator, &consistency_error), kAcceptableError);
+	EXPECT_LT(consistency_error, kAcceptableError);
+	EXPECT_LT(forwardDynamicsDerivativesError(simple_creator, &consistency_error), kAcceptableError);
+	EXPECT_LT(consistency_error, kAcceptableError);
+}
+
+TEST(InvDynDerivatives, sphericalJointsRejected)
+{
+	// derivatives are only implemented for fixed, revolute, prismatic and floating joints
+	MultiBodyTree tree;
+	vec3 r, axis, com;
+	mat33 T, inertia;
+	setZero(r);
+	setZero(axis);
+	setZero(com);
+	setZero(T);
+	setZero(inertia);
+	for (int i = 0; i < 3; i++)
+	{
+		T(i, i) = 1.0;
+		inertia(i, i) = 0.1;
+	}
+	r(2) = 1.0;
+	axis(0) = 1.0;
+	ASSERT_EQ(0, tree.addBody(0, -1, REVOLUTE, r, T, axis, 1.0, com, inertia, 0, 0x0));
+	ASSERT_EQ(0, tree.addBody(1, 0, SPHERICAL, r, T, axis, 1.0, com, inertia, 0, 0x0));
+	ASSERT_EQ(0, tree.finalize());
+
+	const int n = tree.numDoFs();
+	vecx q(n), u(n), dot_u(n), tau(n);
+	matxx d_q(n, n), d_u(n, n), d_tau(n, n);
+	randomState(n, &q, &u, &dot_u);
+	setZero(tau);
+	EXPECT_EQ(-1, tree.calculateInverseDynamicsDerivatives(q, u, dot_u, &d_q, &d_u));
+	EXPECT_EQ(-1, tree.calculateForwardDynamicsDerivatives(q, u, tau, &dot_u, &d_q, &d_u, &d_tau));
+}
+
+int main(int argc, char** argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,269 @@
+/// Benchmark for the articulated body algorithm passes of btMultiBody.
+/// Loads a batch of the bundled urdf robots (r2d2, the humanoid and the kuka arm), then repeatedly runs
+///   - computeAccelerationsArticulatedBodyAlgorithmMultiDof (forward dynamics + velocity update)
+///   - calcAccelerationDeltasMultiDof for a unit impulse on the base (as used by the constraint solver)
+///   - stepPositionsMultiDof / forwardKinematics
+/// and reports the number of links processed per second.
+/// The batchedMatchesScalar test runs the same robots through btMultiBodyBatchedDynamics and checks
+/// that the lane-wise results agree with the per-body path.
+/// Use --steps=<n> and --batch=<n> to change the amount of work, --verbose for per-robot numbers.
+
+#include <cmath>
+#include <cstdio>
+
+#include <btBulletDynamicsCommon.h>
+#include <BulletDynamics/Featherstone/btMultiBody.h>
+#include <BulletDynamics/Featherstone/btMultiBodyBatchedDynamics.h>
+#include <gtest/gtest.h>
+#include <btMultiBodyFromURDF.hpp>
+#include "../../examples/Utils/b3ResourcePath.h"
+#include "Bullet3Common/b3CommandLineArgs.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btQuickprof.h"
+
+bool FLAGS_verbose = false;
+int FLAGS_steps = 200;
+int FLAGS_batch = 8;
+
+static btVector3 gravity(0, 0, -10);
+
+static const char *kUrdfFiles[] = {"r2d2.urdf", "humanoid.urdf", "kuka_iiwa/model.urdf"};
+static const int kNumUrdfFiles = sizeof(kUrdfFiles) / sizeof(kUrdfFiles[0]);
+
+/// loads count instances of a bundled urdf robot, the loaders own the bodies
+static bool loadRobots(const char *urdfFile, int count, btAlignedObjectArray<MyBtMultiBodyFromURDF *> &loaders, btAlignedObjectArray<btMultiBody *> &bodies)
+{
+	char relativeFileName[1024];
+	if (!b3ResourcePath::findResourcePath(urdfFile, relativeFileName, 1024, 0))
+	{
+		return false;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		MyBtMultiBodyFromURDF *loader = new MyBtMultiBodyFromURDF(gravity, false);
+		loader->setFileName(relativeFileName);
+		loader->init();
+		loaders.push_back(loader);
+		if (!loader->getBtMultiBody())
+		{
+			return false;
+		}
+		bodies.push_back(loader->getBtMultiBody());
+	}
+	return true;
+}
+
+static void deleteLoaders(btAlignedObjectArray<MyBtMultiBodyFromURDF *> &loaders)
+{
+	for (int i = 0; i < loaders.size(); i++)
+	{
+		delete loaders[i];
+	}
+	loaders.clear();
+}
+
+/// adds gravity and small, varying joint torques so the bodies keep moving
+static void applyForces(btMultiBody *mb, int step, int seed)
+{
+	mb->addBaseForce(gravity * mb->getBaseMass());
+	for (int link = 0; link < mb->getNumLinks(); link++)
+	{
+		mb->addLinkForce(link, gravity * mb->getLinkMass(link));
+		for (int dof = 0; dof < mb->getLink(link).m_dofCount; dof++)
+		{
+			mb->addJointTorqueMultiDof(link, dof, btScalar(0.1) * btSin(btScalar(0.01) * step + link + dof + seed));
+		}
+	}
+}
+
+/// runs the ABA passes on all bodies for FLAGS_steps steps,
+/// @return links per second
+static double stepBatch(btAlignedObjectArray<btMultiBody *> &bodies, int steps, bool *finite)
+{
+	const btScalar dt = btScalar(1. / 240.);
+
+	btAlignedObjectArray<btScalar> scratch_r;
+	btAlignedObjectArray<btVector3> scratch_v;
+	btAlignedObjectArray<btMatrix3x3> scratch_m;
+	btAlignedObjectArray<btQuaternion> scratch_q;
+	btAlignedObjectArray<btScalar> impulse;
+	btAlignedObjectArray<btScalar> deltaVee;
+
+	long long numLinks = 0;
+	*finite = true;
+
+	btClock clock;
+	for (int step = 0; step < steps; step++)
+	{
+		for (int b = 0; b < bodies.size(); b++)
+		{
+			btMultiBody *mb = bodies[b];
+			const int numDofs = mb->getNumDofs() + 6;
+
+			applyForces(mb, step, 0);
+
+			mb->computeAccelerationsArticulatedBodyAlgorithmMultiDof(dt, scratch_r, scratch_v, scratch_m, false, false, false);
+
+			impulse.resize(numDofs);
+			deltaVee.resize(numDofs);
+			for (int i = 0; i < numDofs; i++)
+			{
+				impulse[i] = 0;
+			}
+			impulse[5] = 1;
+			mb->calcAccelerationDeltasMultiDof(&impulse[0], &deltaVee[0], scratch_r, scratch_v);
+			for (int i = 0; i < numDofs; i++)
+			{
+				if (!(deltaVee[i] == deltaVee[i]))
+				{
+					*finite = false;
+				}
+			}
+
+			mb->stepPositionsMultiDof(dt);
+			mb->forwardKinematics(scratch_q, scratch_v);
+			mb->clearForcesAndTorques();
+
+			numLinks += mb->getNumLinks();
+		}
+	}
+	const double seconds = double(clock.getTimeMicroseconds()) * 1e-6;
+
+	for (int b = 0; b < bodies.size(); b++)
+	{
+		const btScalar *vel = bodies[b]->getVelocityVector();
+		for (int i = 0; i < bodies[b]->getNumDofs() + 6; i++)
+		{
+			if (!(vel[i] == vel[i]))
+			{
+				*finite = false;
+			}
+		}
+	}
+
+	return seconds > 0 ? double(numLinks) / seconds : 0;
+}
+
+TEST(MultiBodyABABenchmark, urdfBatch)
+{
+	btAlignedObjectArray<MyBtMultiBodyFromURDF *> loaders;
+	btAlignedObjectArray<btMultiBody *> allBodies;
+
+	for (int f = 0; f < kNumUrdfFiles; f++)
+	{
+		btAlignedObjectArray<btMultiBody *> bodies;
+		ASSERT_TRUE(loadRobots(kUrdfFiles[f], FLAGS_batch, loaders, bodies));
+		for (int i = 0; i < bodies.size(); i++)
+		{
+			allBodies.push_back(bodies[i]);
+		}
+
+		if (FLAGS_verbose)
+		{
+			bool finite;
+			const double linksPerSecond = stepBatch(bodies, FLAGS_steps, &finite);
+			printf("%-24s %3d links x %d bodies: %12.0f links/s\n", kUrdfFiles[f], bodies[0]->getNumLinks(), bodies.size(), linksPerSecond);
+			EXPECT_TRUE(finite);
+		}
+	}
+
+	bool finite;
+	const double linksPerSecond = stepBatch(allBodies, FLAGS_steps, &finite);
+	printf("%d bodies, %d steps: %.0f links/s\n", allBodies.size(), FLAGS_steps, linksPerSecond);
+	EXPECT_TRUE(finite);
+	EXPECT_GT(linksPerSecond, 0);
+
+	deleteLoaders(loaders);
+}
+
+TEST(MultiBodyABABenchmark, batchedMatchesScalar)
+{
+	const btScalar dt = btScalar(1. / 240.);
+	btAlignedObjectArray<MyBtMultiBodyFromURDF *> loaders;
+	btAlignedObjectArray<btMultiBody *> scalarBodies;
+	btAlignedObjectArray<btMultiBody *> batchedBodies;
+
+	for (int f = 0; f < kNumUrdfFiles; f++)
+	{
+		ASSERT_TRUE(loadRobots(kUrdfFiles[f], FLAGS_batch, loaders, scalarBodies));
+		ASSERT_TRUE(loadRobots(kUrdfFiles[f], FLAGS_batch, loaders, batchedBodies));
+	}
+
+	btAlignedObjectArray<btScalar> scratch_r;
+	btAlignedObjectArray<btVector3> scratch_v;
+	btAlignedObjectArray<btMatrix3x3> scratch_m;
+	btAlignedObjectArray<btQuaternion> scratch_q;
+	btAlignedObjectArray<btScalar> impulse, scalarDeltaVee, batchedDeltaVee;
+	btMultiBodyBatchedDynamics batched;
+
+	btScalar maxDiff = 0;
+	double scalarSeconds = 0, batchedSeconds = 0;
+	long long numLinks = 0;
+	for (int step = 0; step < FLAGS_steps; step++)
+	{
+		// give every pair of bodies the same, per-instance different, state and torques
+		for (int b = 0; b < scalarBodies.size(); b++)
+		{
+			applyForces(scalarBodies[b], step, b);
+			applyForces(batchedBodies[b], step, b);
+			numLinks += scalarBodies[b]->getNumLinks();
+		}
+
+		btClock clock;
+		for (int b = 0; b < scalarBodies.size(); b++)
+		{
+			scalarBodies[b]->computeAccelerationsArticulatedBodyAlgorithmMultiDof(dt, scratch_r, scratch_v, scratch_m, false, false, false);
+		}
+		scalarSeconds += double(clock.getTimeMicroseconds()) * 1e-6;
+		clock.reset();
+		batched.computeAccelerations(&batchedBodies[0], batchedBodies.size(), dt);
+		batchedSeconds += double(clock.getTimeMicroseconds()) * 1e-6;
+
+		for (int b = 0; b < scalarBodies.size(); b++)
+		{
+			const int numDofs = scalarBodies[b]->getNumDofs() + 6;
+			impulse.resize(numDofs);
+			scalarDeltaVee.resize(numDofs);
+			batchedDeltaVee.resize(numDofs);
+			for (int i = 0; i < numDofs; i++)
+			{
+				impulse[i] = btScalar(i == 5 || i == numDofs - 1);
+			}
+			scalarBodies[b]->calcAccelerationDeltasMultiDof(&impulse[0], &scalarDeltaVee[0], scratch_r, scratch_v);
+			batchedBodies[b]->calcAccelerationDeltasMultiDof(&impulse[0], &batchedDeltaVee[0], scratch_r, scratch_v);
+			for (int i = 0; i < numDofs; i++)
+			{
+				maxDiff = btMax(maxDiff, btFabs(scalarBodies[b]->getVelocityVector()[i] - batchedBodies[b]->getVelocityVector()[i]));
+				maxDiff = btMax(maxDiff, btFabs(scalarDeltaVee[i] - batchedDeltaVee[i]));
+			}
+
+			btMultiBody *pair[2] = {scalarBodies[b], batchedBodies[b]};
+			for (int p = 0; p < 2; p++)
+			{
+				pair[p]->stepPositionsMultiDof(dt);
+				pair[p]->forwardKinematics(scratch_q, scratch_v);
+				pair[p]->clearForcesAndTorques();
+			}
+		}
+	}
+
+	printf("%d bodies, %d steps: scalar %.0f links/s, batched %.0f links/s (%d batched, %d fallback)\n",
+		   scalarBodies.size(), FLAGS_steps,
+		   scalarSeconds > 0 ? double(numLinks) / scalarSeconds : 0,
+		   batchedSeconds > 0 ? double(numLinks) / batchedSeconds : 0,
+		   batched.getNumBatchedBodies(), batched.getNumFallbackBodies());
+	EXPECT_GT(batched.getNumBatchedBodies(), 0);
+	EXPECT_LT(maxDiff, btScalar(1e-3));
+
+	deleteLoaders(loaders);
+}
+
+int main(int argc, char **argv)
+{
+	b3CommandLineArgs myArgs(argc, argv);
+	FLAGS_verbose = myArgs.CheckCmdLineFlag("verbose");
+	myArgs.GetCmdLineArgument("steps", FLAGS_steps);
+	myArgs.GetCmdLineArgument("batch", FLAGS_batch);
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
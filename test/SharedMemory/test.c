@@ -27,6 +27,7 @@
 #include "SharedMemory/SharedMemoryPublic.h"
 #include "Bullet3Common/b3Logging.h"
 #include <string.h>
+#include <math.h>
 
 #include <stdio.h>
 
@@ -37,6 +38,31 @@
 #define printf
 #endif
 
+//world position of the URDF link frame for the given joint positions
+static void computeLinkFramePosition(b3PhysicsClientHandle sm, int bodyUniqueId, int numJoints, const double* q, int linkIndex, double pos[3])
+{
+	b3SharedMemoryStatusHandle statusHandle;
+	b3SharedMemoryCommandHandle commandHandle;
+	struct b3LinkState linkState;
+	int jointIndex;
+	commandHandle = b3CreatePoseCommandInit(sm, bodyUniqueId);
+	for (jointIndex = 0; jointIndex < numJoints; jointIndex++)
+	{
+		b3CreatePoseCommandSetJointPosition(sm, commandHandle, jointIndex, q[jointIndex]);
+	}
+	statusHandle = b3SubmitClientCommandAndWaitStatus(sm, commandHandle);
+	ASSERT_EQ(b3GetStatusType(statusHandle), CMD_CLIENT_COMMAND_COMPLETED);
+
+	commandHandle = b3RequestActualStateCommandInit(sm, bodyUniqueId);
+	b3RequestActualStateCommandComputeForwardKinematics(commandHandle, 1);
+	statusHandle = b3SubmitClientCommandAndWaitStatus(sm, commandHandle);
+	ASSERT_EQ(b3GetStatusType(statusHandle), CMD_ACTUAL_STATE_UPDATE_COMPLETED);
+	b3GetLinkState(sm, statusHandle, linkIndex, &linkState);
+	pos[0] = linkState.m_worldLinkFramePosition[0];
+	pos[1] = linkState.m_worldLinkFramePosition[1];
+	pos[2] = linkState.m_worldLinkFramePosition[2];
+}
+
 void testSharedMemory(b3PhysicsClientHandle sm)
 {
 	int i, dofCount, posVarCount, ret, numJoints;
@@ -119,6 +145,145 @@ void testSharedMemory(b3PhysicsClientHandle sm)
 
 				ASSERT_EQ(b3GetStatusType(statusHandle), CMD_CLIENT_COMMAND_COMPLETED);
 			}
+
+			//a batched evaluation has to match the single-configuration commands
+			{
+				enum
+				{
+					numConfigs = 3,
+					numDofs = 7
+				};
+				double q[numConfigs * numDofs];
+				double qdot[numConfigs * numDofs];
+				double qddot[numConfigs * numDofs];
+				double forces[numConfigs * numDofs];
+				double linJac[numConfigs * 3 * numDofs];
+				double angJac[numConfigs * 3 * numDofs];
+				double massMatrices[numConfigs * numDofs * numDofs];
+				double singleForces[numDofs];
+				double singleLinJac[3 * numDofs];
+				double singleAngJac[3 * numDofs];
+				double singleMassMatrix[numDofs * numDofs];
+				double localPosition[3] = {0.1, 0, 0.05};
+				double maxDiff = 0;
+				int batchConfigs = 0, batchDofs = 0, singleDofs = 0;
+				int c, j;
+				b3SharedMemoryStatusHandle statusHandle;
+				b3SharedMemoryCommandHandle commandHandle;
+
+				for (j = 0; j < numConfigs * numDofs; j++)
+				{
+					q[j] = 0.1 * (j % 5) - 0.2;
+					qdot[j] = 0.05 * (j % 3);
+					qddot[j] = 0.3 - 0.1 * (j % 4);
+				}
+				commandHandle = b3CalculateDynamicsBatchCommandInit(sm, bodyUniqueId, numConfigs, q, numDofs, qdot, qddot, numDofs);
+				b3CalculateDynamicsBatchRequestInverseDynamics(commandHandle);
+				b3CalculateDynamicsBatchRequestJacobians(commandHandle, numDofs - 1, localPosition);
+				b3CalculateDynamicsBatchRequestMassMatrices(commandHandle);
+				statusHandle = b3SubmitClientCommandAndWaitStatus(sm, commandHandle);
+				ASSERT_EQ(b3GetStatusType(statusHandle), CMD_CALCULATED_DYNAMICS_BATCH_COMPLETED);
+				b3GetStatusDynamicsBatch(sm, statusHandle, &batchConfigs, &batchDofs, forces, linJac, angJac, massMatrices);
+				ASSERT_EQ(batchConfigs, numConfigs);
+				ASSERT_EQ(batchDofs, numDofs);
+
+				for (c = 0; c < numConfigs; c++)
+				{
+					commandHandle = b3CalculateInverseDynamicsCommandInit(sm, bodyUniqueId, &q[c * numDofs], &qdot[c * numDofs], &qddot[c * numDofs]);
+					statusHandle = b3SubmitClientCommandAndWaitStatus(sm, commandHandle);
+					ASSERT_EQ(b3GetStatusType(statusHandle), CMD_CALCULATED_INVERSE_DYNAMICS_COMPLETED);
+					b3GetStatusInverseDynamicsJointForces(statusHandle, 0, &singleDofs, singleForces);
+					for (j = 0; j < numDofs; j++)
+					{
+						double diff = forces[c * numDofs + j] - singleForces[j];
+						maxDiff = diff > maxDiff ? diff : (-diff > maxDiff ? -diff : maxDiff);
+					}
+
+					commandHandle = b3CalculateJacobianCommandInit(sm, bodyUniqueId, numDofs - 1, localPosition, &q[c * numDofs], &qdot[c * numDofs], &qddot[c * numDofs]);
+					statusHandle = b3SubmitClientCommandAndWaitStatus(sm, commandHandle);
+					ASSERT_EQ(b3GetStatusType(statusHandle), CMD_CALCULATED_JACOBIAN_COMPLETED);
+					b3GetStatusJacobian(statusHandle, &singleDofs, singleLinJac, singleAngJac);
+					for (j = 0; j < 3 * numDofs; j++)
+					{
+						double diffLin = linJac[c * 3 * numDofs + j] - singleLinJac[j];
+						double diffAng = angJac[c * 3 * numDofs + j] - singleAngJac[j];
+						maxDiff = diffLin > maxDiff ? diffLin : (-diffLin > maxDiff ? -diffLin : maxDiff);
+						maxDiff = diffAng > maxDiff ? diffAng : (-diffAng > maxDiff ? -diffAng : maxDiff);
+					}
+
+					commandHandle = b3CalculateMassMatrixCommandInit(sm, bodyUniqueId, &q[c * numDofs]);
+					statusHandle = b3SubmitClientCommandAndWaitStatus(sm, commandHandle);
+					ASSERT_EQ(b3GetStatusType(statusHandle), CMD_CALCULATED_MASS_MATRIX_COMPLETED);
+					b3GetStatusMassMatrix(sm, statusHandle, &singleDofs, singleMassMatrix);
+					for (j = 0; j < numDofs * numDofs; j++)
+					{
+						double diff = massMatrices[c * numDofs * numDofs + j] - singleMassMatrix[j];
+						maxDiff = diff > maxDiff ? diff : (-diff > maxDiff ? -diff : maxDiff);
+					}
+				}
+				ASSERT_EQ(maxDiff < 1e-4, 1);
+			}
+
+			//batched inverse kinematics has to reach targets generated by forward kinematics,
+			//and report the remaining distance of the returned joint positions
+			{
+				enum
+				{
+					numTargets = 4,
+					numDofs = 7
+				};
+				double q[numTargets * numDofs];
+				double seeds[numTargets * numDofs];
+				double damping[numDofs];
+				double targets[numTargets * 3];
+				double solutions[numTargets * numDofs];
+				double residuals[numTargets];
+				int iterations[numTargets];
+				int converged[numTargets];
+				double reached[3];
+				int batchTargets = 0, batchDofs = 0;
+				int t, j;
+				b3SharedMemoryStatusHandle statusHandle;
+				b3SharedMemoryCommandHandle commandHandle;
+
+				for (j = 0; j < numTargets * numDofs; j++)
+				{
+					q[j] = 0.15 * (j % 5) - 0.3;
+					seeds[j] = q[j] + 0.1;
+				}
+				for (j = 0; j < numDofs; j++)
+				{
+					damping[j] = 0.01;
+				}
+				for (t = 0; t < numTargets; t++)
+				{
+					computeLinkFramePosition(sm, bodyUniqueId, numDofs, &q[t * numDofs], numDofs - 1, &targets[t * 3]);
+				}
+
+				commandHandle = b3CalculateInverseKinematicsBatchCommandInit(sm, bodyUniqueId, numDofs - 1, numTargets, targets, 0, seeds, numDofs);
+				b3CalculateInverseKinematicsBatchSetJointDamping(commandHandle, numDofs, damping);
+				b3CalculateInverseKinematicsBatchSetMaxNumIterations(commandHandle, 100);
+				b3CalculateInverseKinematicsBatchSetResidualThreshold(commandHandle, 1e-3);
+				statusHandle = b3SubmitClientCommandAndWaitStatus(sm, commandHandle);
+				ASSERT_EQ(b3GetStatusType(statusHandle), CMD_CALCULATE_INVERSE_KINEMATICS_BATCH_COMPLETED);
+				b3GetStatusInverseKinematicsBatch(sm, statusHandle, &batchTargets, &batchDofs, solutions, residuals, iterations, converged);
+				ASSERT_EQ(batchTargets, numTargets);
+				ASSERT_EQ(batchDofs, numDofs);
+
+				for (t = 0; t < numTargets; t++)
+				{
+					double dx, dy, dz, dist;
+					ASSERT_EQ(converged[t], 1);
+					ASSERT_EQ(iterations[t] > 0 && iterations[t] <= 100, 1);
+					computeLinkFramePosition(sm, bodyUniqueId, numDofs, &solutions[t * numDofs], numDofs - 1, reached);
+					dx = reached[0] - targets[t * 3];
+					dy = reached[1] - targets[t * 3 + 1];
+					dz = reached[2] - targets[t * 3 + 2];
+					dist = sqrt(dx * dx + dy * dy + dz * dz);
+					ASSERT_EQ(dist < 2e-3, 1);
+					ASSERT_EQ(fabs(dist - residuals[t]) < 1e-4, 1);
+				}
+			}
 		}
 
 		{